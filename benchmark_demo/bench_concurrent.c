@@ -0,0 +1,401 @@
+//
+// Multi-threaded throughput of the concurrent lists against a LINKED_LIST behind one mutex.
+//
+// Build:
+//   gcc -O2 -pthread -o bench_concurrent bench_concurrent.c ../memory_demo/concurrent_list.c
+//       ../memory_demo/mpmc_queue.c ../memory_demo/linked_list.c ../common/hash_map.c
+//
+// Usage: bench_concurrent [maxThreads] [opsPerThread]
+//
+// queue: half of the threads insert at the end and the other half remove from the front
+// and take the strings, as producers and consumers do. TWO_LOCK_QUEUE and MPMC_QUEUE,
+// one entry at a time and in batches of BATCH, against llist_insert_last and
+// llist_get_ith + llist_remove_first under the mutex. Producers of the MPMC_QUEUE sleep
+// while it is full, and its consumers while it is empty, until the last producer closes it.
+//
+// lookup: every thread runs 90% lookups, 5% adds and 5% removals of random names out of
+// LOOKUP_KEYS. CONCURRENT_LIST against llist_lookup, llist_add and llist_remove under the
+// mutex.
+//
+// The thread counts are the powers of two from 2 up to maxThreads (8 by default).
+//
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include "../memory_demo/linked_list.h"
+#include "../memory_demo/concurrent_list.h"
+#include "../memory_demo/mpmc_queue.h"
+
+#define DEFAULT_MAX_THREADS 8
+#define MAX_THREADS 32
+#define DEFAULT_OPS 200000 // Operations per thread
+#define LOOKUP_KEYS 1000
+#define NAME_SIZE 16
+#define QUEUE_CAPACITY 1024 // Of the MPMC_QUEUE
+#define BATCH 16
+
+// Structures under test
+#define MUTEX_LLIST 0
+#define TWO_LOCK 1
+#define LOCK_FREE 2
+#define MPMC 3
+#define MPMC_BATCH 4
+
+// What every thread of a run shares
+typedef struct RUN
+{
+	int structure;
+	size_t ops; // Per thread
+	pthread_mutex_t lock; // Around list
+	LINKED_LIST* list;
+	TWO_LOCK_QUEUE* queue;
+	MPMC_QUEUE* ring;
+	CONCURRENT_LIST* clist;
+	int producersLeft;
+} RUN;
+
+typedef struct WORKER
+{
+	RUN* run;
+	int producer;
+	unsigned long long seed;
+} WORKER;
+
+/* Returns a monotonic time stamp in seconds. */
+static double now ()
+{
+    struct timespec ts;
+
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* Returns the next number of a 64-bit LCG. */
+static unsigned long long next_random (unsigned long long* seed)
+{
+    *seed = *seed * 6364136223846793005ULL + 1442695040888963407ULL;
+
+    return *seed >> 33;
+}
+
+/* Removes the first entry, or the first BATCH with MPMC_BATCH, of the queue of the run and frees the strings taken from it. It returns the number of entries removed. */
+static int consume (RUN* run)
+{
+    char* name;
+    char* value;
+
+    if (run->structure == MPMC_BATCH)
+    {
+        char* names[BATCH];
+        char* values[BATCH];
+        size_t k = mpmc_dequeue_batch (run->ring, names, values, BATCH);
+        size_t i; // Entry index
+
+        for (i = 0; i < k; i ++)
+        {
+            free (names[i]);
+            free (values[i]);
+        }
+
+        return k;
+    }
+
+    if (run->structure == MPMC)
+    {
+        if (!mpmc_try_dequeue (run->ring, &name, &value))
+        {
+            return 0;
+        }
+    }
+    else if (run->structure == TWO_LOCK)
+    {
+        if (!tlqueue_remove_first (run->queue, &name, &value))
+        {
+            return 0;
+        }
+    }
+    else
+    {
+        pthread_mutex_lock (&(run->lock));
+
+        if (!llist_get_ith (run->list, 0, &name, &value))
+        {
+            pthread_mutex_unlock (&(run->lock));
+            return 0;
+        }
+
+        name = strdup (name);
+        value = strdup (value);
+        llist_remove_first (run->list);
+        pthread_mutex_unlock (&(run->lock));
+    }
+
+    free (name);
+    free (value);
+
+    return 1;
+}
+
+/* A producer or a consumer of the queue workload. */
+static void* queue_worker (void* arg)
+{
+    WORKER* worker = arg;
+    RUN* run = worker->run;
+    size_t i; // Operation index
+
+    if (worker->producer)
+    {
+        char* names[BATCH];
+        char* values[BATCH];
+
+        for (i = 0; i < BATCH; i ++)
+        {
+            names[i] = "name";
+            values[i] = "value";
+        }
+
+        for (i = 0; i < run->ops; i ++)
+        {
+            if (run->structure == MPMC_BATCH)
+            {
+                size_t n = (run->ops - i < BATCH) ? run->ops - i : BATCH;
+                size_t k = 0;
+
+                while ((k += mpmc_enqueue_batch (run->ring, names + k, values + k, n - k)) < n)
+                {
+                    mpmc_enqueue (run->ring, names[k], values[k]); // Full, sleep until there is room
+                    k ++;
+                }
+
+                i += n - 1;
+            }
+            else if (run->structure == MPMC)
+            {
+                mpmc_enqueue (run->ring, "name", "value");
+            }
+            else if (run->structure == TWO_LOCK)
+            {
+                tlqueue_insert_last (run->queue, "name", "value");
+            }
+            else
+            {
+                pthread_mutex_lock (&(run->lock));
+                llist_insert_last (run->list, "name", "value");
+                pthread_mutex_unlock (&(run->lock));
+            }
+        }
+
+        if ((__atomic_sub_fetch (&(run->producersLeft), 1, __ATOMIC_RELEASE) == 0) && (run->structure >= MPMC))
+        {
+            mpmc_close (run->ring);
+        }
+
+        return NULL;
+    }
+
+    if (run->structure >= MPMC) // Sleep while the queue is empty, until it is closed
+    {
+        char* name = NULL;
+        char* value;
+
+        while (consume (run) || mpmc_dequeue (run->ring, &name, &value))
+        {
+            if (name != NULL) // Taken by mpmc_dequeue
+            {
+                free (name);
+                free (value);
+                name = NULL;
+            }
+        }
+
+        return NULL;
+    }
+
+    // Consume until the producers are done and the queue is empty
+    while (consume (run) || (__atomic_load_n (&(run->producersLeft), __ATOMIC_ACQUIRE) > 0))
+    {
+    }
+
+    while (consume (run))
+    {
+    }
+
+    return NULL;
+}
+
+/* A thread of the lookup workload. */
+static void* lookup_worker (void* arg)
+{
+    WORKER* worker = arg;
+    RUN* run = worker->run;
+    CLIST_HANDLE* handle = NULL;
+    char name[NAME_SIZE];
+    char value[NAME_SIZE];
+    size_t i; // Operation index
+
+    if (run->structure == LOCK_FREE)
+    {
+        handle = clist_attach (run->clist);
+        if (handle == NULL)
+        {
+            return NULL;
+        }
+    }
+
+    for (i = 0; i < run->ops; i ++)
+    {
+        unsigned long long r = next_random (&(worker->seed));
+        int op = r % 100;
+
+        snprintf (name, NAME_SIZE, "key%llu", (r >> 8) % LOOKUP_KEYS);
+
+        if (run->structure == LOCK_FREE)
+        {
+            if (op < 90)
+            {
+                clist_lookup (handle, name, value, NAME_SIZE);
+            }
+            else if (op < 95)
+            {
+                clist_add (handle, name, name);
+            }
+            else
+            {
+                clist_remove (handle, name);
+            }
+        }
+        else
+        {
+            pthread_mutex_lock (&(run->lock));
+
+            if (op < 90)
+            {
+                char* found = llist_lookup (run->list, name);
+
+                if (found != NULL)
+                {
+                    strncpy (value, found, NAME_SIZE - 1);
+                }
+            }
+            else if (op < 95)
+            {
+                llist_add (run->list, name, name);
+            }
+            else
+            {
+                llist_remove (run->list, name);
+            }
+
+            pthread_mutex_unlock (&(run->lock));
+        }
+    }
+
+    if (handle != NULL)
+    {
+        clist_detach (handle);
+    }
+
+    return NULL;
+}
+
+/* Runs one workload on one structure with nThreads threads and prints its throughput. */
+static void bench (char* workload, int structure, int nThreads, size_t ops)
+{
+    static char* structureNames[] = { "llist_mutex", "two_lock", "lock_free", "mpmc", "mpmc_batch" };
+    pthread_t threads[MAX_THREADS];
+    WORKER workers[MAX_THREADS];
+    RUN run;
+    char name[NAME_SIZE];
+    int t; // Thread index
+    int queue = (strcmp (workload, "queue") == 0);
+
+    memset (&run, 0, sizeof (RUN));
+    run.structure = structure;
+    run.ops = ops;
+    run.producersLeft = nThreads / 2;
+    pthread_mutex_init (&(run.lock), NULL);
+    run.list = llist_create ();
+    run.queue = tlqueue_create ();
+    run.clist = clist_create ();
+    run.ring = mpmc_create (QUEUE_CAPACITY);
+    if ((run.list == NULL) || (run.queue == NULL) || (run.clist == NULL) || (run.ring == NULL))
+    {
+        exit (1);
+    }
+
+    if (!queue) // Half of the keys to start with
+    {
+        CLIST_HANDLE* handle = clist_attach (run.clist);
+
+        for (t = 0; t < LOOKUP_KEYS; t += 2)
+        {
+            snprintf (name, NAME_SIZE, "key%d", t);
+            llist_add (run.list, name, name);
+            clist_add (handle, name, name);
+        }
+
+        clist_detach (handle);
+    }
+
+    double start = now ();
+
+    for (t = 0; t < nThreads; t ++)
+    {
+        workers[t].run = &run;
+        workers[t].producer = (t % 2 == 0);
+        workers[t].seed = 88172645463325252ULL + t;
+
+        if (pthread_create (&threads[t], NULL, queue ? queue_worker : lookup_worker, &workers[t]) != 0)
+        {
+            exit (1);
+        }
+    }
+
+    for (t = 0; t < nThreads; t ++)
+    {
+        pthread_join (threads[t], NULL);
+    }
+
+    double seconds = now () - start;
+    size_t total = ops * nThreads; // With the queue, half insertions and half removals
+
+    printf ("%-12s %-7s %7d %12zu %10.2f\n", structureNames[structure], workload, nThreads, total,
+            total / seconds / 1e6);
+    fflush (stdout);
+
+    llist_destroy (run.list);
+    tlqueue_destroy (run.queue);
+    clist_destroy (run.clist);
+    mpmc_destroy (run.ring);
+    pthread_mutex_destroy (&(run.lock));
+}
+
+int main (int argc, char** argv)
+{
+    int maxThreads = (argc > 1) ? atoi (argv[1]) : DEFAULT_MAX_THREADS;
+    size_t ops = (argc > 2) ? strtoull (argv[2], NULL, 10) : DEFAULT_OPS;
+    int nThreads;
+
+    if ((maxThreads < 2) || (maxThreads > MAX_THREADS))
+    {
+        printf ("maxThreads must be between 2 and %d\n", MAX_THREADS);
+        return 1;
+    }
+
+    printf ("%-12s %-7s %7s %12s %10s\n", "struct", "work", "threads", "ops", "Mops/s");
+
+    for (nThreads = 2; nThreads <= maxThreads; nThreads *= 2)
+    {
+        bench ("queue", MUTEX_LLIST, nThreads, ops);
+        bench ("queue", TWO_LOCK, nThreads, ops);
+        bench ("queue", MPMC, nThreads, ops);
+        bench ("queue", MPMC_BATCH, nThreads, ops);
+        bench ("lookup", MUTEX_LLIST, nThreads, ops);
+        bench ("lookup", LOCK_FREE, nThreads, ops);
+    }
+
+    return 0;
+}
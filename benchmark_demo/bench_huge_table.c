@@ -0,0 +1,174 @@
+//
+// Lookup and scan throughput of a very large RESIZABLE_TABLE.
+//
+// Build:
+//   gcc -O2 -pthread -o bench_huge_table bench_huge_table.c ../runtime_demo/resizable_table.c
+//       ../runtime_demo/perfect_hash.c ../runtime_demo/huge_array.c ../runtime_demo/timer_wheel.c
+//       ../runtime_demo/value_index.c ../runtime_demo/top_k.c ../runtime_demo/aggregate.c
+//       ../common/hash_map.c
+//
+// Add -DINSTRUMENT ../common/instrument.c to count the operations, see common/instrument.h.
+//
+// Usage: bench_huge_table [nEntries] [hugepages] [bulk]
+//
+// With bulk the table is built by one rtable_bulk_load call instead of nEntries inserts.
+//
+// The default of one million entries runs anywhere. The 1B entry run
+// (bench_huge_table 1000000000 hugepages) needs a large-memory box: about 16 GB for the
+// entry array, 30 GB for the names and another 25 GB while the perfect hash is built.
+//
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "../runtime_demo/resizable_table.h"
+
+#define NUM_PROBES 1000000
+#define NAME_SIZE 32
+
+/* Returns a monotonic time stamp in seconds. */
+static double now ()
+{
+    struct timespec ts;
+
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* Small xorshift generator, so that the probes do not depend on the libc rand. */
+static unsigned long long next_random (unsigned long long* state)
+{
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+
+    return *state;
+}
+
+int main (int argc, char** argv)
+{
+    size_t nEntries = (argc > 1) ? strtoull (argv[1], NULL, 10) : 1000000;
+    int hugePages = (argc > 2) && (strcmp (argv[2], "hugepages") == 0);
+    int bulk = (argc > 3) && (strcmp (argv[3], "bulk") == 0);
+    size_t i; // Entry index
+    char name[NAME_SIZE];
+    char* probeName;
+    void* value;
+    long sum = 0;
+    unsigned long long state = 88172645463325252ULL;
+    double start, elapsed;
+    RTABLE_STATS stats;
+
+    RESIZABLE_TABLE* table = NULL;
+
+    printf ("entries=%zu hugepages=%d bulk=%d\n", nEntries, hugePages, bulk);
+
+    start = now ();
+
+    if (bulk)
+    {
+        // The names are distinct, so the load skips the sort and hands over the copies
+        RESIZABLE_TABLE_ENTRY* entries = malloc (nEntries * sizeof (RESIZABLE_TABLE_ENTRY));
+        if (entries == NULL)
+        {
+            return 1;
+        }
+
+        for (i = 0; i < nEntries; i ++)
+        {
+            snprintf (name, NAME_SIZE, "key%zu", i);
+            entries[i].name = strdup (name);
+            entries[i].value = (void*) (long) i;
+        }
+
+        table = rtable_bulk_load (entries, nEntries, RTABLE_BULK_UNIQUE | RTABLE_BULK_INT | RTABLE_BULK_TAKE | (hugePages ? RTABLE_BULK_HUGE_PAGES : 0));
+        free (entries);
+
+        if (table == NULL)
+        {
+            printf ("bulk load failed\n");
+            return 1;
+        }
+    }
+    else
+    {
+        table = rtable_create ();
+        if (table == NULL)
+        {
+            return 1;
+        }
+
+        rtable_use_huge_pages (table, hugePages);
+        table->intValues = 1; // The values are not strings
+
+        // insert_last does no duplicate check, names are distinct anyway
+        for (i = 0; i < nEntries; i ++)
+        {
+            snprintf (name, NAME_SIZE, "key%zu", i);
+
+            if (rtable_insert_last (table, name, (void*) (long) i) == 0)
+            {
+                printf ("out of memory after %zu entries\n", i);
+                return 1;
+            }
+        }
+    }
+
+    elapsed = now () - start;
+    printf ("insert: %.2f s, %.1f ns/entry\n", elapsed, elapsed * 1e9 / nEntries);
+
+    rtable_stats (table, &stats);
+    printf ("memory: array=%zu MB (%.0f%% used) names=%zu MB malloc overhead=%zu MB\n", stats.arrayBytes >> 20, stats.loadFactor * 100, stats.nameBytes >> 20, stats.overheadBytes >> 20);
+
+    // Sequential scan of every value
+    start = now ();
+
+    for (i = 0; i < nEntries; i ++)
+    {
+        rtable_get_ith (table, i, &probeName, &value);
+        sum += (long) value;
+    }
+
+    elapsed = now () - start;
+    printf ("scan: %.2f s, %.2f ns/entry, %.1f M entries/s (sum=%ld)\n", elapsed, elapsed * 1e9 / nEntries, nEntries / elapsed / 1e6, sum);
+
+    start = now ();
+
+    if (rtable_freeze (table) == 0)
+    {
+        printf ("freeze failed\n");
+        return 1;
+    }
+
+    elapsed = now () - start;
+    printf ("freeze: %.2f s, %.1f ns/entry\n", elapsed, elapsed * 1e9 / nEntries);
+
+    // Random lookups of existing names. The names are generated up front so that only
+    // rtable_lookup is timed.
+    char* probes = malloc ((size_t) NUM_PROBES * NAME_SIZE);
+    if (probes == NULL)
+    {
+        return 1;
+    }
+
+    for (i = 0; i < NUM_PROBES; i ++)
+    {
+        snprintf (probes + i * NAME_SIZE, NAME_SIZE, "key%llu", next_random (&state) % nEntries);
+    }
+
+    sum = 0;
+    start = now ();
+
+    for (i = 0; i < NUM_PROBES; i ++)
+    {
+        sum += (long) rtable_lookup (table, probes + i * NAME_SIZE);
+    }
+
+    elapsed = now () - start;
+    printf ("lookup: %.2f s, %.1f ns/lookup, %.1f M lookups/s (sum=%ld)\n", elapsed, elapsed * 1e9 / NUM_PROBES, NUM_PROBES / elapsed / 1e6, sum);
+
+    free (probes);
+
+    return 0;
+}
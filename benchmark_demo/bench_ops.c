@@ -0,0 +1,956 @@
+//
+// Per-operation micro-benchmarks of RESIZABLE_TABLE and LINKED_LIST at growing sizes and
+// with sequential, uniform and Zipfian key distributions.
+//
+// Build:
+//   gcc -O2 -pthread -o bench_ops bench_ops.c ../runtime_demo/resizable_table.c
+//       ../runtime_demo/perfect_hash.c ../runtime_demo/huge_array.c ../runtime_demo/timer_wheel.c
+//       ../runtime_demo/value_index.c ../runtime_demo/top_k.c ../runtime_demo/aggregate.c
+//       ../memory_demo/linked_list.c ../memory_demo/unrolled_list.c
+//       ../memory_demo/skip_list.c ../common/hash_map.c ../common/kv_store.c
+//       ../common/kv_hash.c ../common/kv_sorted.c -lm
+//
+// Usage: bench_ops [maxEntries] [csv|text] [backends]
+//
+// The sizes are the powers of ten from 1000 up to maxEntries (100000 by default, 1e8 at
+// most). Every operation reports ns/op, millions of ops per second, hardware cache misses
+// per op (through perf_event_open, -1 where the kernel or container does not allow it) and
+// the peak RSS of the process so far. With csv the rows are comma separated values with a
+// header line, for regression tracking.
+//
+// Operations that cost O(n) per call (a lookup in an unfrozen table, any list lookup) run
+// fewer calls at larger sizes, so that every row takes about the same time. 1e8 entries
+// need about 10 GB.
+//
+// backends is a comma separated list of KV_STORE backends (rtable, llist, llist_indexed,
+// llist_inline, ulist, slist, hash, sorted) or all. With it, the same workload runs on each of them through kv_store.h
+// instead of the native table and list operations, and every row of a key operation runs
+// for a fixed time rather than a fixed number of calls, since the backends differ in
+// complexity.
+//
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#if defined __linux__
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+#include "../runtime_demo/resizable_table.h"
+#include "../runtime_demo/huge_array.h"
+#include "../memory_demo/linked_list.h"
+#include "../memory_demo/unrolled_list.h"
+#include "../memory_demo/skip_list.h"
+#include "../common/kv_store.h"
+
+#define MIN_ENTRIES 1000
+#define DEFAULT_MAX_ENTRIES 100000
+#define MAX_ENTRIES 100000000
+#define NAME_SIZE 24
+#define MAX_OPS 1000000 // Calls of an O(1) operation per row
+#define MIN_OPS 20 // Calls of an O(n) operation per row, at the largest sizes
+#define LINEAR_BUDGET 50000000 // Entries an O(n) operation may visit per row
+#define ZIPF_THETA 0.99
+#define ROW_SECONDS 0.2 // Time per row of a KV_STORE key operation
+#define MERGE_PARTS 8 // Lists merged into one, as built by that many threads
+#define READ_FILE "bench_ops.ll" // Written and removed by the read_reuse row
+
+// Key distributions
+#define DIST_SEQUENTIAL 0
+#define DIST_UNIFORM 1
+#define DIST_ZIPFIAN 2
+#define N_DISTS 3
+
+static char* distNames[N_DISTS] = { "sequential", "uniform", "zipfian" };
+
+#define N_BACKENDS 8
+
+static const KV_STORE_OPS* backends[N_BACKENDS + 1] = { &rtable_kv_ops, &llist_kv_ops, &llist_indexed_kv_ops, &llist_inline_kv_ops, &ulist_kv_ops, &slist_kv_ops, &kv_hash_ops, &kv_sorted_ops, NULL };
+
+// Time, cache misses and memory of one measured loop
+typedef struct MEASURE
+{
+    double start; // Seconds
+    int perfFd; // -1 if cache misses cannot be counted
+} MEASURE;
+
+static int csv; // Machine-readable output
+static char* keys; // keys + i * NAME_SIZE is the name of entry i
+static size_t* probes; // Entry indices for the operations that take a key
+
+/* Returns a monotonic time stamp in seconds. */
+static double now ()
+{
+    struct timespec ts;
+
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* Small xorshift generator, so that the runs do not depend on the libc rand. */
+static unsigned long long next_random (unsigned long long* state)
+{
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+
+    return *state;
+}
+
+/* Returns a uniform double in [0, 1). */
+static double next_unit (unsigned long long* state)
+{
+    return (next_random (state) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+/* Opens a counter of the cache misses of this thread, or returns -1. */
+static int open_cache_misses ()
+{
+#if defined __linux__ && defined __NR_perf_event_open
+    struct perf_event_attr attr;
+
+    memset (&attr, 0, sizeof (attr));
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.size = sizeof (attr);
+    attr.config = PERF_COUNT_HW_CACHE_MISSES;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+
+    return (int) syscall (__NR_perf_event_open, &attr, 0, -1, -1, 0);
+#else
+    return -1;
+#endif
+}
+
+static void measure_start (MEASURE* measure)
+{
+    measure->perfFd = open_cache_misses ();
+
+#if defined __linux__
+    if (measure->perfFd != -1)
+    {
+        ioctl (measure->perfFd, PERF_EVENT_IOC_RESET, 0);
+        ioctl (measure->perfFd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+#endif
+
+    measure->start = now ();
+}
+
+/* Stops the measure and prints one row for ops calls of op. */
+static void measure_stop (MEASURE* measure, char* structure, char* op, size_t n, char* dist, size_t ops)
+{
+    double elapsed = now () - measure->start;
+    long long misses = -1;
+    struct rusage usage;
+
+#if defined __linux__
+    if (measure->perfFd != -1)
+    {
+        ioctl (measure->perfFd, PERF_EVENT_IOC_DISABLE, 0);
+
+        if (read (measure->perfFd, &misses, sizeof (misses)) != sizeof (misses))
+        {
+            misses = -1;
+        }
+
+        close (measure->perfFd);
+    }
+#endif
+
+    getrusage (RUSAGE_SELF, &usage);
+
+    double nsPerOp = elapsed * 1e9 / ops;
+    double missesPerOp = (misses >= 0) ? (double) misses / ops : -1;
+
+    if (csv)
+    {
+        printf ("%s,%s,%zu,%s,%zu,%.2f,%.3f,%.3f,%ld\n", structure, op, n, dist, ops, nsPerOp, ops / elapsed / 1e6, missesPerOp, usage.ru_maxrss);
+    }
+    else
+    {
+        printf ("%-13s %-17s %10zu %-10s %9zu %12.1f %10.3f %10.2f %10ld\n", structure, op, n, dist, ops, nsPerOp, ops / elapsed / 1e6, missesPerOp, usage.ru_maxrss);
+    }
+
+    fflush (stdout);
+}
+
+/* Returns the number of calls of an operation that visits about visited entries per call. */
+static size_t ops_for (size_t visited)
+{
+    size_t ops = LINEAR_BUDGET / (visited > 0 ? visited : 1);
+
+    return (ops < MIN_OPS) ? MIN_OPS : ((ops > MAX_OPS) ? MAX_OPS : ops);
+}
+
+/* Fills probes[0..nProbes) with entry indices in [0, n) drawn from the distribution. Zipfian
+ranks use the generator of Gray et al. (as in YCSB), and are scattered over the entries with
+a hash so that the hot names are not all at the front of the table. */
+static void make_probes (size_t n, int dist, size_t nProbes)
+{
+    size_t i; // Probe index
+    unsigned long long state = 88172645463325252ULL;
+    double zetan = 0, zeta2 = 1 + pow (0.5, ZIPF_THETA), alpha = 1 / (1 - ZIPF_THETA), eta = 0;
+
+    if (dist == DIST_ZIPFIAN)
+    {
+        for (i = 1; i <= n; i ++)
+        {
+            zetan += 1 / pow ((double) i, ZIPF_THETA);
+        }
+
+        eta = (1 - pow (2.0 / n, 1 - ZIPF_THETA)) / (1 - zeta2 / zetan);
+    }
+
+    for (i = 0; i < nProbes; i ++)
+    {
+        if (dist == DIST_SEQUENTIAL)
+        {
+            probes[i] = i % n;
+        }
+
+        else if (dist == DIST_UNIFORM)
+        {
+            probes[i] = next_random (&state) % n;
+        }
+
+        else
+        {
+            double u = next_unit (&state);
+            double uz = u * zetan;
+            size_t rank = (uz < 1) ? 0 : ((uz < zeta2) ? 1 : (size_t) (n * pow (eta * u - eta + 1, alpha)));
+
+            probes[i] = ((rank < n ? rank : n - 1) * 0x9e3779b97f4a7c15ULL) % n;
+        }
+    }
+}
+
+static char* key_of (size_t i)
+{
+    return keys + i * NAME_SIZE;
+}
+
+/* Builds a table with the first n keys, the value of key i being i. */
+static RESIZABLE_TABLE* build_table (size_t n)
+{
+    size_t i; // Entry index
+
+    RESIZABLE_TABLE* table = rtable_create ();
+    if (table == NULL)
+    {
+        return NULL;
+    }
+
+    table->intValues = 1;
+
+    for (i = 0; i < n; i ++)
+    {
+        if (rtable_insert_last (table, key_of (i), (void*) (long) i) == 0)
+        {
+            return NULL;
+        }
+    }
+
+    return table;
+}
+
+/* Frees a table built by build_table, frozen or not. The values are ints. */
+static void free_table (RESIZABLE_TABLE* table)
+{
+    size_t i; // Entry index
+
+    for (i = 0; i < table->currentElements; i ++)
+    {
+        free (table->array[i].name);
+    }
+
+    harray_free (table->array, (table->maxElements) * sizeof (RESIZABLE_TABLE_ENTRY));
+    phash_free (table->phash);
+    free (table);
+}
+
+/* Runs every table operation at size n. */
+static void bench_table (size_t n)
+{
+    size_t i; // Call index
+    size_t ops;
+    int dist;
+    long sum = 0;
+    char* name;
+    void* value;
+    MEASURE measure;
+    RTABLE_CURSOR cursor;
+
+    measure_start (&measure);
+    RESIZABLE_TABLE* table = build_table (n);
+    measure_stop (&measure, "rtable", "insert_last", n, "-", n);
+
+    if (table == NULL)
+    {
+        printf ("out of memory at %zu entries\n", n);
+        exit (1);
+    }
+
+    measure_start (&measure);
+    rtable_cursor_begin (table, &cursor);
+
+    while (rtable_cursor_next (&cursor, &name, &value))
+    {
+        sum += (long) value;
+    }
+
+    measure_stop (&measure, "rtable", "cursor", n, "-", n);
+
+    // Both shift the whole array. In pairs, so that the table keeps its size.
+    ops = ops_for (2 * n);
+    measure_start (&measure);
+
+    for (i = 0; i < ops; i ++)
+    {
+        rtable_insert_first (table, "first", (void*) 0L);
+        rtable_remove_first (table);
+    }
+
+    measure_stop (&measure, "rtable", "insert_remove_1st", n, "-", ops);
+
+    for (dist = 0; dist < N_DISTS; dist ++)
+    {
+        make_probes (n, dist, MAX_OPS);
+
+        measure_start (&measure);
+
+        for (i = 0; i < MAX_OPS; i ++)
+        {
+            rtable_get_ith (table, probes[i], &name, &value);
+            sum += (long) value;
+        }
+
+        measure_stop (&measure, "rtable", "get_ith", n, distNames[dist], MAX_OPS);
+
+        ops = ops_for (n / 2);
+        measure_start (&measure);
+
+        for (i = 0; i < ops; i ++)
+        {
+            sum += (long) rtable_lookup (table, key_of (probes[i]));
+        }
+
+        measure_stop (&measure, "rtable", "lookup", n, distNames[dist], ops);
+
+        measure_start (&measure);
+
+        for (i = 0; i < ops; i ++)
+        {
+            rtable_add (table, key_of (probes[i]), (void*) (long) probes[i]);
+        }
+
+        measure_stop (&measure, "rtable", "add_existing", n, distNames[dist], ops);
+
+        // The entry goes back at the end, so the table keeps its size
+        measure_start (&measure);
+
+        for (i = 0; i < ops; i ++)
+        {
+            rtable_remove (table, key_of (probes[i]));
+            rtable_insert_last (table, key_of (probes[i]), (void*) (long) probes[i]);
+        }
+
+        measure_stop (&measure, "rtable", "remove_reinsert", n, distNames[dist], ops);
+    }
+
+    measure_start (&measure);
+    rtable_sort (table, 1);
+    measure_stop (&measure, "rtable", "sort", n, "-", n);
+
+    measure_start (&measure);
+    int frozen = rtable_freeze (table);
+    measure_stop (&measure, "rtable", "freeze", n, "-", n);
+
+    for (dist = 0; frozen && (dist < N_DISTS); dist ++)
+    {
+        make_probes (n, dist, MAX_OPS);
+
+        measure_start (&measure);
+
+        for (i = 0; i < MAX_OPS; i ++)
+        {
+            sum += (long) rtable_lookup (table, key_of (probes[i]));
+        }
+
+        measure_stop (&measure, "rtable", "lookup_frozen", n, distNames[dist], MAX_OPS);
+    }
+
+    free_table (table);
+
+    if (sum == 42) // Keeps the loops from being optimised away
+    {
+        printf ("\n");
+    }
+}
+
+/* Walks the list with a cursor and returns a sum of its values. */
+static long walk_list (LINKED_LIST* list)
+{
+    LLIST_CURSOR cursor;
+    char* name;
+    char* value;
+    long sum = 0;
+
+    llist_cursor_begin (list, &cursor);
+
+    while (llist_cursor_next (&cursor, &name, &value))
+    {
+        sum += value[0];
+    }
+
+    return sum;
+}
+
+/* Walks the unrolled list with a cursor and returns a sum of its values. */
+static long walk_ulist (UNROLLED_LIST* list)
+{
+    ULIST_CURSOR cursor;
+    char* name;
+    char* value;
+    long sum = 0;
+
+    ulist_cursor_begin (list, &cursor);
+
+    while (ulist_cursor_next (&cursor, &name, &value))
+    {
+        sum += value[0];
+    }
+
+    return sum;
+}
+
+/* Runs every list operation at size n. */
+static void bench_list (size_t n)
+{
+    size_t i; // Call index
+    size_t ops;
+    int dist;
+    long sum = 0;
+    char* name;
+    char* value;
+    MEASURE measure;
+    LINKED_LIST* parts[MERGE_PARTS];
+    LLIST_CURSOR cursor;
+    int p; // Part index
+
+    LINKED_LIST* list = llist_create ();
+    if (list == NULL)
+    {
+        exit (1);
+    }
+
+    measure_start (&measure);
+
+    for (i = 0; i < n; i ++)
+    {
+        llist_insert_last (list, key_of (i), key_of (i));
+    }
+
+    measure_stop (&measure, "llist", "insert_last", n, "-", n);
+
+    measure_start (&measure);
+    sum += walk_list (list);
+    measure_stop (&measure, "llist", "cursor", n, "-", n);
+
+    measure_start (&measure);
+
+    for (i = 0; i < MAX_OPS; i ++)
+    {
+        llist_insert_first (list, "first", "0");
+        llist_remove_first (list);
+    }
+
+    measure_stop (&measure, "llist", "insert_remove_1st", n, "-", MAX_OPS);
+
+    measure_start (&measure);
+
+    for (i = 0; i < MAX_OPS; i ++)
+    {
+        llist_insert_last (list, "last", "0");
+        llist_remove_last (list);
+    }
+
+    measure_stop (&measure, "llist", "insert_remove_end", n, "-", MAX_OPS);
+
+    for (dist = 0; dist < N_DISTS; dist ++)
+    {
+        ops = ops_for (n / 2);
+        make_probes (n, dist, ops);
+
+        measure_start (&measure);
+
+        for (i = 0; i < ops; i ++)
+        {
+            llist_get_ith (list, (int) probes[i], &name, &value);
+            sum += value[0];
+        }
+
+        measure_stop (&measure, "llist", "get_ith", n, distNames[dist], ops);
+
+        measure_start (&measure);
+
+        for (i = 0; i < ops; i ++)
+        {
+            char* found = llist_lookup (list, key_of (probes[i]));
+            sum += (found != NULL) ? found[0] : 0;
+        }
+
+        measure_stop (&measure, "llist", "lookup", n, distNames[dist], ops);
+
+        measure_start (&measure);
+
+        for (i = 0; i < ops; i ++)
+        {
+            llist_add (list, key_of (probes[i]), key_of (probes[i]));
+        }
+
+        measure_stop (&measure, "llist", "add_existing", n, distNames[dist], ops);
+
+        measure_start (&measure);
+
+        for (i = 0; i < ops; i ++)
+        {
+            llist_remove (list, key_of (probes[i]));
+            llist_insert_last (list, key_of (probes[i]), key_of (probes[i]));
+        }
+
+        measure_stop (&measure, "llist", "remove_reinsert", n, distNames[dist], ops);
+    }
+
+    measure_start (&measure);
+    llist_sort (list, 1);
+    measure_stop (&measure, "llist", "sort", n, "-", n);
+
+    // By now the nodes are scattered over the heap. A pool moves them into one slab in list
+    // order, so that a walk reads memory sequentially.
+    measure_start (&measure);
+    sum += walk_list (list);
+    measure_stop (&measure, "llist", "cursor_scattered", n, "-", n);
+
+    measure_start (&measure);
+    llist_use_pool (list, 0);
+    measure_stop (&measure, "llist", "use_pool", n, "-", n);
+
+    measure_start (&measure);
+    sum += walk_list (list);
+    measure_stop (&measure, "llist", "cursor_pooled", n, "-", n);
+
+    // Reading a saved list back into it reuses its nodes, and with a name index the check
+    // for a repeated name costs one probe per entry read
+    if (llist_save (list, READ_FILE) && llist_index_names (list))
+    {
+        measure_start (&measure);
+        llist_read (list, READ_FILE);
+        measure_stop (&measure, "llist", "read_reuse", n, "-", n);
+    }
+
+    remove (READ_FILE);
+
+    measure_start (&measure);
+    llist_clear (list);
+    measure_stop (&measure, "llist", "clear_pool", n, "-", n);
+
+    llist_destroy (list);
+
+    list = llist_create ();
+    if ((list == NULL) || !llist_use_pool (list, 0))
+    {
+        exit (1);
+    }
+
+    measure_start (&measure);
+
+    for (i = 0; i < n; i ++)
+    {
+        llist_insert_last (list, key_of (i), key_of (i));
+    }
+
+    measure_stop (&measure, "llist", "insert_last_pool", n, "-", n);
+
+    llist_destroy (list);
+
+    // Partial results merged into one list, by copying every entry and by relinking
+    for (p = 0; p < MERGE_PARTS; p ++)
+    {
+        parts[p] = llist_create ();
+        if (parts[p] == NULL)
+        {
+            exit (1);
+        }
+
+        for (i = p; i < n; i += MERGE_PARTS)
+        {
+            llist_insert_last (parts[p], key_of (i), key_of (i));
+        }
+    }
+
+    list = llist_create ();
+    if (list == NULL)
+    {
+        exit (1);
+    }
+
+    measure_start (&measure);
+
+    for (p = 0; p < MERGE_PARTS; p ++)
+    {
+        llist_cursor_begin (parts[p], &cursor);
+
+        while (llist_cursor_next (&cursor, &name, &value))
+        {
+            llist_insert_last (list, name, value);
+        }
+    }
+
+    measure_stop (&measure, "llist", "merge_copy", n, "-", n);
+
+    llist_destroy (list);
+
+    list = llist_create ();
+    if (list == NULL)
+    {
+        exit (1);
+    }
+
+    measure_start (&measure);
+
+    for (p = 0; p < MERGE_PARTS; p ++)
+    {
+        llist_concat (list, parts[p]);
+    }
+
+    measure_stop (&measure, "llist", "merge_concat", n, "-", n);
+
+    for (p = 0; p < MERGE_PARTS; p ++)
+    {
+        llist_destroy (parts[p]);
+    }
+
+    measure_start (&measure);
+    llist_destroy (list);
+    measure_stop (&measure, "llist", "destroy", n, "-", n);
+
+    if (sum == 42) // Keeps the loops from being optimised away
+    {
+        printf ("\n");
+    }
+}
+
+/* Compares the unrolled list and the skip list with the list at size n, on the operations
+that go to a position. */
+static void bench_positional (size_t n)
+{
+    size_t i; // Call index
+    size_t ops = ops_for (n / 2);
+    long sum = 0;
+    char* name;
+    char* value;
+    MEASURE measure;
+
+    UNROLLED_LIST* list = ulist_create ();
+    if (list == NULL)
+    {
+        exit (1);
+    }
+
+    measure_start (&measure);
+
+    for (i = 0; i < n; i ++)
+    {
+        ulist_insert_last (list, key_of (i), key_of (i));
+    }
+
+    measure_stop (&measure, "ulist", "insert_last", n, "-", n);
+
+    measure_start (&measure);
+    sum += walk_ulist (list);
+    measure_stop (&measure, "ulist", "cursor", n, "-", n);
+
+    make_probes (n, DIST_UNIFORM, ops);
+
+    measure_start (&measure);
+
+    for (i = 0; i < ops; i ++)
+    {
+        ulist_get_ith (list, (int) probes[i], &name, &value);
+        sum += value[0];
+    }
+
+    measure_stop (&measure, "ulist", "get_ith", n, distNames[DIST_UNIFORM], ops);
+
+    measure_start (&measure);
+
+    for (i = 0; i < ops; i ++)
+    {
+        ulist_insert_ith (list, (int) n / 2, "middle", "0");
+        ulist_remove_ith (list, (int) n / 2);
+    }
+
+    measure_stop (&measure, "ulist", "insert_remove_mid", n, "-", ops);
+
+    ulist_destroy (list);
+
+    SKIP_LIST* skip = slist_create ();
+    if (skip == NULL)
+    {
+        exit (1);
+    }
+
+    measure_start (&measure);
+
+    for (i = 0; i < n; i ++)
+    {
+        slist_insert_last (skip, key_of (i), key_of (i));
+    }
+
+    measure_stop (&measure, "slist", "insert_last", n, "-", n);
+
+    make_probes (n, DIST_UNIFORM, MAX_OPS);
+
+    measure_start (&measure);
+
+    for (i = 0; i < MAX_OPS; i ++)
+    {
+        slist_get_ith (skip, (int) probes[i], &name, &value);
+        sum += value[0];
+    }
+
+    measure_stop (&measure, "slist", "get_ith", n, distNames[DIST_UNIFORM], MAX_OPS);
+
+    measure_start (&measure);
+
+    for (i = 0; i < MAX_OPS; i ++)
+    {
+        slist_insert_ith (skip, (int) n / 2, "middle", "0");
+        slist_remove_ith (skip, (int) n / 2);
+    }
+
+    measure_stop (&measure, "slist", "insert_remove_mid", n, "-", MAX_OPS);
+
+    slist_destroy (skip);
+
+    // The same middle insertions on the list, which walks one node per entry
+    LINKED_LIST* llist = llist_create ();
+    if (llist == NULL)
+    {
+        exit (1);
+    }
+
+    for (i = 0; i < n; i ++)
+    {
+        llist_insert_last (llist, key_of (i), key_of (i));
+    }
+
+    measure_start (&measure);
+
+    for (i = 0; i < ops; i ++)
+    {
+        llist_insert_ith (llist, (int) n / 2, "middle", "0");
+        llist_remove_ith (llist, (int) n / 2);
+    }
+
+    measure_stop (&measure, "llist", "insert_remove_mid", n, "-", ops);
+
+    llist_destroy (llist);
+
+    if (sum == 42) // Keeps the loops from being optimised away
+    {
+        printf ("\n");
+    }
+}
+
+/* Runs the KV_STORE workload on the backend ops at size n. */
+static void bench_kv (const KV_STORE_OPS* ops, size_t n)
+{
+    size_t i; // Call index
+    int dist;
+    long sum = 0;
+    char* name;
+    char* value;
+    MEASURE measure;
+
+    KV_STORE* kv = kv_create (ops);
+    if (kv == NULL)
+    {
+        exit (1);
+    }
+
+    // The names are new, so the backends that can append skip the check for duplicates
+    measure_start (&measure);
+
+    for (i = 0; i < n; i ++)
+    {
+        if ((ops->insert_last != NULL) ? !kv_insert_last (kv, key_of (i), key_of (i)) : !kv_add (kv, key_of (i), key_of (i)))
+        {
+            printf ("out of memory at %zu entries\n", n);
+            exit (1);
+        }
+    }
+
+    measure_stop (&measure, ops->name, "fill", n, "-", n);
+
+    for (dist = 0; dist < N_DISTS; dist ++)
+    {
+        make_probes (n, dist, MAX_OPS);
+
+        // Each loop stops after MAX_OPS calls or ROW_SECONDS, checking the time every 64 calls
+        measure_start (&measure);
+
+        for (i = 0; (i < MAX_OPS) && (((i & 63) != 0) || (now () - measure.start < ROW_SECONDS)); i ++)
+        {
+            kv_get_ith (kv, probes[i], &name, &value);
+            sum += value[0];
+        }
+
+        measure_stop (&measure, ops->name, "get_ith", n, distNames[dist], i);
+
+        measure_start (&measure);
+
+        for (i = 0; (i < MAX_OPS) && (((i & 63) != 0) || (now () - measure.start < ROW_SECONDS)); i ++)
+        {
+            char* found = kv_lookup (kv, key_of (probes[i]));
+            sum += (found != NULL) ? found[0] : 0;
+        }
+
+        measure_stop (&measure, ops->name, "lookup", n, distNames[dist], i);
+
+        measure_start (&measure);
+
+        for (i = 0; (i < MAX_OPS) && (((i & 63) != 0) || (now () - measure.start < ROW_SECONDS)); i ++)
+        {
+            kv_add (kv, key_of (probes[i]), key_of (probes[i]));
+        }
+
+        measure_stop (&measure, ops->name, "add_existing", n, distNames[dist], i);
+
+        measure_start (&measure);
+
+        for (i = 0; (i < MAX_OPS) && (((i & 63) != 0) || (now () - measure.start < ROW_SECONDS)); i ++)
+        {
+            kv_remove (kv, key_of (probes[i]));
+            kv_add (kv, key_of (probes[i]), key_of (probes[i]));
+        }
+
+        measure_stop (&measure, ops->name, "remove_add", n, distNames[dist], i);
+    }
+
+    if (ops->sort != NULL)
+    {
+        measure_start (&measure);
+        kv_sort (kv, 1);
+        measure_stop (&measure, ops->name, "sort", n, "-", n);
+    }
+
+    kv_destroy (kv);
+
+    if (sum == 42) // Keeps the loops from being optimised away
+    {
+        printf ("\n");
+    }
+}
+
+/* Fills the NULL-terminated array selected with the backends named in the comma separated
+list, or all of them. It returns 0 if a name is unknown. */
+static int select_backends (char* list, const KV_STORE_OPS** selected)
+{
+    char* name;
+    int nSelected = 0;
+
+    if (strcmp (list, "all") == 0)
+    {
+        memcpy (selected, backends, sizeof (backends));
+        return 1;
+    }
+
+    for (name = strtok (list, ","); (name != NULL) && (nSelected < N_BACKENDS); name = strtok (NULL, ","))
+    {
+        selected[nSelected] = kv_find_backend (backends, name);
+        if (selected[nSelected] == NULL)
+        {
+            printf ("unknown backend %s\n", name);
+            return 0;
+        }
+
+        nSelected ++;
+    }
+
+    selected[nSelected] = NULL;
+
+    return 1;
+}
+
+int main (int argc, char** argv)
+{
+    size_t maxEntries = (argc > 1) ? strtoull (argv[1], NULL, 10) : DEFAULT_MAX_ENTRIES;
+    size_t n; // Size of one run
+    size_t i; // Key index
+    int b; // Backend index
+    const KV_STORE_OPS* selected[N_BACKENDS + 1] = { NULL }; // Backends to compare, none for the native operations
+
+    csv = (argc > 2) && (strcmp (argv[2], "csv") == 0);
+
+    if ((argc > 3) && !select_backends (argv[3], selected))
+    {
+        return 1;
+    }
+
+    if ((maxEntries < MIN_ENTRIES) || (maxEntries > MAX_ENTRIES))
+    {
+        printf ("maxEntries must be between %d and %d\n", MIN_ENTRIES, MAX_ENTRIES);
+        return 1;
+    }
+
+    keys = malloc (maxEntries * NAME_SIZE);
+    probes = malloc (MAX_OPS * sizeof (size_t));
+    if ((keys == NULL) || (probes == NULL))
+    {
+        return 1;
+    }
+
+    for (i = 0; i < maxEntries; i ++)
+    {
+        snprintf (key_of (i), NAME_SIZE, "key%zu", i);
+    }
+
+    if (csv)
+    {
+        printf ("structure,op,size,distribution,ops,ns_per_op,mops_per_s,cache_misses_per_op,peak_rss_kb\n");
+    }
+    else
+    {
+        printf ("%-13s %-17s %10s %-10s %9s %12s %10s %10s %10s\n", "struct", "op", "size", "keys", "ops", "ns/op", "Mops/s", "miss/op", "rss_kb");
+    }
+
+    for (n = MIN_ENTRIES; n <= maxEntries; n *= 10)
+    {
+        if (selected[0] != NULL)
+        {
+            for (b = 0; selected[b] != NULL; b ++)
+            {
+                bench_kv (selected[b], n);
+            }
+        }
+        else
+        {
+            bench_table (n);
+            bench_list (n);
+            bench_positional (n);
+        }
+    }
+
+    free (keys);
+    free (probes);
+
+    return 0;
+}
@@ -0,0 +1,214 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "hash_map.h"
+
+#define SUCCESS 1
+#define FAILURE 0
+#define MIN_SLOTS 16
+
+/* Returns the slot of the key, or the free slot where it would go. */
+static size_t find_slot (HASH_MAP* map, char* key, uint64_t hash)
+{
+    size_t mask = map->nSlots - 1;
+    size_t slot = hash & mask;
+
+    while ((map->slots[slot].key != NULL) &&
+           ((map->slots[slot].hash != hash) || (strcmp (map->slots[slot].key, key) != 0)))
+    {
+        slot = (slot + 1) & mask;
+    }
+
+    return slot;
+}
+
+/* Doubles the number of slots. The stored hashes save hashing the keys again. */
+static int grow (HASH_MAP* map)
+{
+    size_t i; // Slot index
+    HASH_MAP_SLOT* oldSlots = map->slots;
+    size_t oldSize = map->nSlots;
+
+    map->slots = calloc (2 * oldSize, sizeof (HASH_MAP_SLOT));
+    if (map->slots == NULL)
+    {
+        map->slots = oldSlots;
+        return FAILURE;
+    }
+
+    map->nSlots = 2 * oldSize;
+
+    for (i = 0; i < oldSize; i ++)
+    {
+        if (oldSlots[i].key != NULL)
+        {
+            map->slots[find_slot (map, oldSlots[i].key, oldSlots[i].hash)] = oldSlots[i];
+        }
+    }
+
+    free (oldSlots);
+    return SUCCESS;
+}
+
+//
+// It returns the hash the map uses for a key: 64 bit FNV-1a with a final mix, so that
+// the low bits are usable for a power of two table and the high bits for partitioning.
+//
+uint64_t hmap_hash (char* key)
+{
+    uint64_t h = 0xcbf29ce484222325ULL;
+
+    while (*key != '\0')
+    {
+        h = (h ^ (unsigned char) *key) * 0x100000001b3ULL;
+        key ++;
+    }
+
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+
+    return h;
+}
+
+//
+// It returns a new empty map with room for expected keys, or NULL if memory runs out.
+//
+HASH_MAP* hmap_create (size_t expected)
+{
+    HASH_MAP* map = malloc (sizeof (HASH_MAP));
+    if (map == NULL)
+    {
+        return NULL;
+    }
+
+    map->nSlots = MIN_SLOTS;
+    while (map->nSlots < 2 * expected) // At most half full
+    {
+        map->nSlots <<= 1;
+    }
+
+    map->count = 0;
+    map->slots = calloc (map->nSlots, sizeof (HASH_MAP_SLOT));
+    if (map->slots == NULL)
+    {
+        free (map);
+        return NULL;
+    }
+
+    return map;
+}
+
+//
+// It frees the map, but not the keys or the values.
+//
+void hmap_free (HASH_MAP* map)
+{
+    free (map->slots);
+    free (map);
+}
+
+//
+// It maps key to value, replacing the previous value of the key.
+// It will return 1 if successful, or 0 if memory runs out.
+//
+int hmap_put (HASH_MAP* map, char* key, void* value)
+{
+    return hmap_put_hashed (map, key, hmap_hash (key), value);
+}
+
+//
+// Like hmap_put, with the hash of the key already computed by hmap_hash.
+//
+int hmap_put_hashed (HASH_MAP* map, char* key, uint64_t hash, void* value)
+{
+    size_t slot = find_slot (map, key, hash);
+
+    if (map->slots[slot].key == NULL) // New key
+    {
+        if ((2 * (map->count + 1) > map->nSlots) && (grow (map) == FAILURE))
+        {
+            return FAILURE;
+        }
+
+        slot = find_slot (map, key, hash);
+        map->slots[slot].key = key;
+        map->slots[slot].hash = hash;
+        map->count ++;
+    }
+
+    map->slots[slot].value = value;
+
+    return SUCCESS;
+}
+
+//
+// It stores in *value the value of key. It will return 1 if the key is in the map,
+// or 0 otherwise.
+//
+int hmap_get (HASH_MAP* map, char* key, void** value)
+{
+    return hmap_get_hashed (map, key, hmap_hash (key), value);
+}
+
+//
+// Like hmap_get, with the hash of the key already computed by hmap_hash.
+//
+int hmap_get_hashed (HASH_MAP* map, char* key, uint64_t hash, void** value)
+{
+    size_t slot = find_slot (map, key, hash);
+
+    if (map->slots[slot].key == NULL)
+    {
+        return FAILURE;
+    }
+
+    *value = map->slots[slot].value;
+
+    return SUCCESS;
+}
+
+//
+// It removes key from the map. The keys that follow it in its probe sequence move back, so
+// that the map needs no deleted markers and lookups stay as short as before.
+// It will return 1 if the key was in the map, or 0 otherwise.
+//
+int hmap_remove (HASH_MAP* map, char* key)
+{
+    size_t mask = map->nSlots - 1;
+    size_t hole = find_slot (map, key, hmap_hash (key));
+    size_t slot; // Slot after the hole
+
+    if (map->slots[hole].key == NULL)
+    {
+        return FAILURE;
+    }
+
+    for (slot = (hole + 1) & mask; map->slots[slot].key != NULL; slot = (slot + 1) & mask)
+    {
+        size_t home = map->slots[slot].hash & mask;
+
+        // A key can fill the hole unless its home slot lies cyclically in (hole, slot]
+        if (((slot - home) & mask) >= ((slot - hole) & mask))
+        {
+            map->slots[hole] = map->slots[slot];
+            hole = slot;
+        }
+    }
+
+    map->slots[hole].key = NULL;
+    map->count --;
+
+    return SUCCESS;
+}
+
+//
+// It removes every key from the map, keeping its slots.
+//
+void hmap_clear (HASH_MAP* map)
+{
+    memset (map->slots, 0, map->nSlots * sizeof (HASH_MAP_SLOT));
+    map->count = 0;
+}
@@ -0,0 +1,38 @@
+#if !defined HASH_MAP_H
+#define HASH_MAP_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct HASH_MAP_SLOT
+{
+	char* key; // Not owned. NULL for a free slot.
+	uint64_t hash;
+	void* value;
+} HASH_MAP_SLOT;
+
+//
+// A map from strings to pointers with open addressing and linear probing, used as the
+// temporary index of the bulk operations on tables and lists, and by the hash backend of
+// kv_store.h. The keys are not copied, so they must outlive the map. It grows by doubling
+// when it is half full; sizing it with the expected number of keys up front avoids any
+// growth.
+//
+typedef struct HASH_MAP
+{
+	size_t nSlots; // Power of two
+	size_t count;
+	HASH_MAP_SLOT* slots;
+} HASH_MAP;
+
+uint64_t hmap_hash (char* key);
+HASH_MAP* hmap_create (size_t expected);
+void hmap_free (HASH_MAP* map);
+int hmap_put (HASH_MAP* map, char* key, void* value);
+int hmap_put_hashed (HASH_MAP* map, char* key, uint64_t hash, void* value);
+int hmap_get (HASH_MAP* map, char* key, void** value);
+int hmap_get_hashed (HASH_MAP* map, char* key, uint64_t hash, void** value);
+int hmap_remove (HASH_MAP* map, char* key);
+void hmap_clear (HASH_MAP* map);
+
+#endif
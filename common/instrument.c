@@ -0,0 +1,363 @@
+#include "instrument.h"
+
+#if defined INSTRUMENT
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+
+#define SUCCESS 1
+#define FAILURE 0
+
+static __thread INSTR_THREAD* localThread; // Block of the calling thread, NULL until its first operation
+static INSTR_THREAD* threads; // Blocks of every thread, newest first
+static pthread_mutex_t threadsLock = PTHREAD_MUTEX_INITIALIZER;
+
+static char* opNames[INSTR_OPERATIONS] = { "rtable_lookup", "rtable_add", "rtable_remove_ith", "reallocate", "llist_lookup", "llist_add" };
+
+/* Reads a counter of any thread. The owner stores it with a plain (relaxed) store, so the sum
+is slightly stale but never torn. */
+static uint64_t load (uint64_t* counter)
+{
+    return __atomic_load_n (counter, __ATOMIC_RELAXED);
+}
+
+/* Adds n to a counter of the calling thread. Only this thread writes it, so a relaxed load and
+store is enough, and on x86 costs the same as a plain increment. */
+static void add (uint64_t* counter, uint64_t n)
+{
+    __atomic_store_n (counter, __atomic_load_n (counter, __ATOMIC_RELAXED) + n, __ATOMIC_RELAXED);
+}
+
+static uint64_t now_ns ()
+{
+    struct timespec ts;
+
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/* Returns the block of the calling thread, allocating and registering it on first use. */
+static INSTR_THREAD* thread_block ()
+{
+    if (localThread != NULL)
+    {
+        return localThread;
+    }
+
+    INSTR_THREAD* thread = calloc (1, sizeof (INSTR_THREAD));
+    if (thread == NULL)
+    {
+        return NULL;
+    }
+
+    thread->current = INSTR_NONE;
+
+    pthread_mutex_lock (&threadsLock);
+    thread->next = threads;
+    threads = thread;
+    pthread_mutex_unlock (&threadsLock);
+
+    localThread = thread;
+
+    return thread;
+}
+
+/* Returns the latency bucket of ns: exact below 16, then 16 buckets per power of two. */
+static int bucket_of (uint64_t ns)
+{
+    if (ns < INSTR_SUB_BUCKETS)
+    {
+        return (int) ns;
+    }
+
+    int magnitude = 63 - __builtin_clzll (ns); // At least INSTR_SUB_BUCKET_BITS
+    int sub = (int) (ns >> (magnitude - INSTR_SUB_BUCKET_BITS)) & (INSTR_SUB_BUCKETS - 1);
+
+    return (magnitude - INSTR_SUB_BUCKET_BITS + 1) * INSTR_SUB_BUCKETS + sub;
+}
+
+//
+// It starts timing operation op in the calling thread. Use INSTR_SCOPE rather than calling
+// it directly.
+//
+INSTR_SPAN instr_begin (int op)
+{
+    INSTR_SPAN span;
+
+    span.thread = thread_block ();
+    span.op = op;
+    span.outer = INSTR_NONE;
+    span.start = 0;
+
+    if (span.thread != NULL)
+    {
+        span.outer = span.thread->current;
+        span.thread->current = op;
+        span.start = now_ns ();
+    }
+
+    return span;
+}
+
+//
+// It records the call and latency of the operation span times, and makes the operation that
+// was running before it current again.
+//
+void instr_end (INSTR_SPAN* span)
+{
+    if (span->thread == NULL)
+    {
+        return;
+    }
+
+    uint64_t ns = now_ns () - span->start;
+    INSTR_OP_STATS* stats = &(span->thread->ops[span->op]);
+
+    add (&(stats->calls), 1);
+    add (&(stats->totalNs), ns);
+    add (&(stats->latency[bucket_of (ns)]), 1);
+
+    if (ns > stats->maxNs)
+    {
+        __atomic_store_n (&(stats->maxNs), ns, __ATOMIC_RELAXED);
+    }
+
+    span->thread->current = span->outer;
+}
+
+//
+// It adds n to the field (INSTR_COMPARES, INSTR_BYTES_COPIED or INSTR_SHIFTS) of the innermost
+// operation running in the calling thread. Use INSTR_COUNT rather than calling it directly.
+//
+void instr_count (int field, uint64_t n)
+{
+    INSTR_THREAD* thread = localThread;
+
+    if ((thread == NULL) || (thread->current == INSTR_NONE))
+    {
+        return;
+    }
+
+    INSTR_OP_STATS* stats = &(thread->ops[thread->current]);
+
+    if (field == INSTR_COMPARES)
+    {
+        add (&(stats->compares), n);
+    }
+
+    else if (field == INSTR_BYTES_COPIED)
+    {
+        add (&(stats->bytesCopied), n);
+    }
+
+    else
+    {
+        add (&(stats->shifts), n);
+    }
+}
+
+//
+// It fills totals[INSTR_OPERATIONS] with the counters of all threads added up.
+//
+void instr_snapshot (INSTR_OP_STATS* totals)
+{
+    INSTR_THREAD* thread;
+    int op, i; // Operation and bucket indices
+
+    memset (totals, 0, INSTR_OPERATIONS * sizeof (INSTR_OP_STATS));
+
+    pthread_mutex_lock (&threadsLock);
+
+    for (thread = threads; thread != NULL; thread = thread->next)
+    {
+        for (op = 0; op < INSTR_OPERATIONS; op ++)
+        {
+            INSTR_OP_STATS* stats = &(thread->ops[op]);
+            uint64_t maxNs = load (&(stats->maxNs));
+
+            totals[op].calls += load (&(stats->calls));
+            totals[op].compares += load (&(stats->compares));
+            totals[op].bytesCopied += load (&(stats->bytesCopied));
+            totals[op].shifts += load (&(stats->shifts));
+            totals[op].totalNs += load (&(stats->totalNs));
+            totals[op].maxNs = (maxNs > totals[op].maxNs) ? maxNs : totals[op].maxNs;
+
+            for (i = 0; i < INSTR_BUCKETS; i ++)
+            {
+                totals[op].latency[i] += load (&(stats->latency[i]));
+            }
+        }
+    }
+
+    pthread_mutex_unlock (&threadsLock);
+}
+
+//
+// It zeroes the counters of every thread. Operations that run meanwhile may be half counted.
+//
+void instr_reset ()
+{
+    INSTR_THREAD* thread;
+    int op;
+
+    pthread_mutex_lock (&threadsLock);
+
+    for (thread = threads; thread != NULL; thread = thread->next)
+    {
+        for (op = 0; op < INSTR_OPERATIONS; op ++)
+        {
+            // Word by word, so that the owner never sees a torn counter
+            uint64_t* counter = (uint64_t*) &(thread->ops[op]);
+            size_t i;
+
+            for (i = 0; i < sizeof (INSTR_OP_STATS) / sizeof (uint64_t); i ++)
+            {
+                __atomic_store_n (counter + i, 0, __ATOMIC_RELAXED);
+            }
+        }
+    }
+
+    pthread_mutex_unlock (&threadsLock);
+}
+
+//
+// It returns the smallest latency, in ns, that falls into the bucket.
+//
+uint64_t instr_bucket_ns (int bucket)
+{
+    if (bucket < INSTR_SUB_BUCKETS)
+    {
+        return (uint64_t) bucket;
+    }
+
+    int magnitude = bucket / INSTR_SUB_BUCKETS + INSTR_SUB_BUCKET_BITS - 1;
+    uint64_t sub = (uint64_t) (bucket % INSTR_SUB_BUCKETS) + INSTR_SUB_BUCKETS;
+
+    return sub << (magnitude - INSTR_SUB_BUCKET_BITS);
+}
+
+//
+// It returns the latency in ns below which the given percentage (0 to 100) of the calls
+// fall, to the precision of the buckets. It returns 0 if there were no calls.
+//
+uint64_t instr_percentile (INSTR_OP_STATS* stats, double percentile)
+{
+    int i; // Bucket index
+    uint64_t seen = 0;
+    uint64_t wanted = (uint64_t) (stats->calls * percentile / 100.0 + 0.5);
+
+    if (stats->calls == 0)
+    {
+        return 0;
+    }
+
+    for (i = 0; i < INSTR_BUCKETS; i ++)
+    {
+        seen += stats->latency[i];
+
+        if ((seen >= wanted) && (seen > 0))
+        {
+            return instr_bucket_ns (i);
+        }
+    }
+
+    return stats->maxNs;
+}
+
+//
+// It returns the name of operation op, as used in the dumps.
+//
+char* instr_op_name (int op)
+{
+    return ((op >= 0) && (op < INSTR_OPERATIONS)) ? opNames[op] : "unknown";
+}
+
+//
+// It writes one line per operation that was called, with its counters and latency
+// percentiles in ns. It will return 1 if successful, or 0 otherwise.
+//
+int instr_dump_text (FILE* fout)
+{
+    int op;
+
+    INSTR_OP_STATS* totals = malloc (INSTR_OPERATIONS * sizeof (INSTR_OP_STATS));
+    if (totals == NULL)
+    {
+        return FAILURE;
+    }
+
+    instr_snapshot (totals);
+    fprintf (fout, "%-18s %12s %14s %14s %12s %9s %9s %9s %9s %9s %9s\n", "operation", "calls", "compares", "bytes_copied", "shifts", "mean_ns", "p50", "p90", "p99", "p99.9", "max");
+
+    for (op = 0; op < INSTR_OPERATIONS; op ++)
+    {
+        INSTR_OP_STATS* stats = &(totals[op]);
+
+        if (stats->calls == 0)
+        {
+            continue;
+        }
+
+        fprintf (fout, "%-18s %12llu %14llu %14llu %12llu %9llu %9llu %9llu %9llu %9llu %9llu\n", opNames[op],
+                 (unsigned long long) stats->calls, (unsigned long long) stats->compares, (unsigned long long) stats->bytesCopied,
+                 (unsigned long long) stats->shifts, (unsigned long long) (stats->totalNs / stats->calls),
+                 (unsigned long long) instr_percentile (stats, 50), (unsigned long long) instr_percentile (stats, 90),
+                 (unsigned long long) instr_percentile (stats, 99), (unsigned long long) instr_percentile (stats, 99.9),
+                 (unsigned long long) stats->maxNs);
+    }
+
+    free (totals);
+
+    return ferror (fout) ? FAILURE : SUCCESS;
+}
+
+//
+// It writes the counters as one JSON object with a member per operation. The histogram is
+// written sparsely, as [lower bound ns, calls] pairs of the non-empty buckets.
+// It will return 1 if successful, or 0 otherwise.
+//
+int instr_dump_json (FILE* fout)
+{
+    int op, i; // Operation and bucket indices
+
+    INSTR_OP_STATS* totals = malloc (INSTR_OPERATIONS * sizeof (INSTR_OP_STATS));
+    if (totals == NULL)
+    {
+        return FAILURE;
+    }
+
+    instr_snapshot (totals);
+    fprintf (fout, "{");
+
+    for (op = 0; op < INSTR_OPERATIONS; op ++)
+    {
+        INSTR_OP_STATS* stats = &(totals[op]);
+        char* separator = "";
+
+        fprintf (fout, "%s\n  \"%s\": {\"calls\": %llu, \"compares\": %llu, \"bytes_copied\": %llu, \"shifts\": %llu, \"total_ns\": %llu, \"max_ns\": %llu, \"histogram\": [",
+                 (op > 0) ? "," : "", opNames[op], (unsigned long long) stats->calls, (unsigned long long) stats->compares,
+                 (unsigned long long) stats->bytesCopied, (unsigned long long) stats->shifts, (unsigned long long) stats->totalNs,
+                 (unsigned long long) stats->maxNs);
+
+        for (i = 0; i < INSTR_BUCKETS; i ++)
+        {
+            if (stats->latency[i] > 0)
+            {
+                fprintf (fout, "%s[%llu, %llu]", separator, (unsigned long long) instr_bucket_ns (i), (unsigned long long) stats->latency[i]);
+                separator = ", ";
+            }
+        }
+
+        fprintf (fout, "]}");
+    }
+
+    fprintf (fout, "\n}\n");
+    free (totals);
+
+    return ferror (fout) ? FAILURE : SUCCESS;
+}
+
+#endif
@@ -0,0 +1,95 @@
+#if !defined INSTRUMENT_H
+#define INSTRUMENT_H
+
+//
+// Optional instrumentation of the hot table and list operations. Build with -DINSTRUMENT
+// (and instrument.c, -pthread) to turn it on. Without INSTRUMENT every macro below expands
+// to nothing and instrument.c compiles to an empty file, so the operations cost exactly
+// what they did before.
+//
+// Every thread counts into its own INSTR_THREAD block, so the hot path takes no lock and
+// shares no cache line. instr_snapshot adds up the blocks of all threads, including the
+// ones that have exited.
+//
+
+#if defined INSTRUMENT
+
+#include <stdio.h>
+#include <stdint.h>
+
+// Instrumented operations
+#define INSTR_RTABLE_LOOKUP 0
+#define INSTR_RTABLE_ADD 1
+#define INSTR_RTABLE_REMOVE_ITH 2
+#define INSTR_RTABLE_REALLOCATE 3
+#define INSTR_LLIST_LOOKUP 4
+#define INSTR_LLIST_ADD 5
+#define INSTR_OPERATIONS 6
+#define INSTR_NONE -1 // No instrumented operation is running
+
+// Latencies go into log-linear (HDR style) buckets: values below 16 ns have a bucket each,
+// and every power of two above that is split into 16 buckets, so a bucket is at most 1/16
+// wider than its lower bound. That covers the whole uint64_t range in 976 buckets.
+#define INSTR_SUB_BUCKET_BITS 4
+#define INSTR_SUB_BUCKETS (1 << INSTR_SUB_BUCKET_BITS)
+#define INSTR_BUCKETS ((64 - INSTR_SUB_BUCKET_BITS + 1) * INSTR_SUB_BUCKETS)
+
+typedef struct INSTR_OP_STATS
+{
+	uint64_t calls;
+	uint64_t compares; // strcmp calls, or probes of a hash
+	uint64_t bytesCopied; // Bytes moved to grow an array
+	uint64_t shifts; // Entries moved up or down by one position
+	uint64_t totalNs; // Sum of the latencies
+	uint64_t maxNs;
+	uint64_t latency[INSTR_BUCKETS]; // Calls by latency, see instr_bucket_ns
+} INSTR_OP_STATS;
+
+typedef struct INSTR_THREAD
+{
+	INSTR_OP_STATS ops[INSTR_OPERATIONS];
+	int current; // Innermost operation running in this thread, or INSTR_NONE
+	struct INSTR_THREAD* next; // Next thread block
+} INSTR_THREAD;
+
+// One running operation. The cleanup attribute of INSTR_SCOPE records it at every return.
+typedef struct INSTR_SPAN
+{
+	INSTR_THREAD* thread; // NULL if the thread block could not be allocated
+	int op;
+	int outer; // Operation that was running when this one started
+	uint64_t start; // Monotonic time in ns
+} INSTR_SPAN;
+
+INSTR_SPAN instr_begin (int op);
+void instr_end (INSTR_SPAN* span);
+void instr_count (int field, uint64_t n);
+void instr_snapshot (INSTR_OP_STATS* totals);
+void instr_reset ();
+uint64_t instr_bucket_ns (int bucket);
+uint64_t instr_percentile (INSTR_OP_STATS* stats, double percentile);
+char* instr_op_name (int op);
+int instr_dump_text (FILE* fout);
+int instr_dump_json (FILE* fout);
+
+// Fields of INSTR_COUNT
+#define INSTR_COMPARES 0
+#define INSTR_BYTES_COPIED 1
+#define INSTR_SHIFTS 2
+
+// Times the rest of the enclosing block as operation op, and makes op the operation that
+// INSTR_COUNT counts for. Goes after the declarations of a function.
+#define INSTR_SCOPE(op) INSTR_SPAN instrSpan __attribute__ ((cleanup (instr_end))) = instr_begin (op)
+
+// Adds n to a field (INSTR_COMPARES, ...) of the innermost operation running in the thread.
+// It does nothing if no instrumented operation is running.
+#define INSTR_COUNT(field, n) instr_count ((field), (n))
+
+#else
+
+#define INSTR_SCOPE(op)
+#define INSTR_COUNT(field, n)
+
+#endif
+
+#endif
@@ -0,0 +1,255 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "kv_store.h"
+#include "hash_map.h"
+
+#define SUCCESS 1
+#define FAILURE 0
+#define INITIAL_ENTRIES 16
+
+//
+// The kv_hash_ops backend: the entries sit in an array in insertion order, and a HASH_MAP
+// maps every name to its index, so add, lookup and remove cost O(1). A removal leaves a
+// hole in the array instead of shifting it. The holes are squeezed out in one pass when
+// the array is full, or before the first positional access or sort after a removal.
+//
+typedef struct KV_HASH
+{
+	KV_ENTRY* entries;
+	size_t used; // Entries used, holes included
+	size_t maxEntries;
+	size_t count; // Entries that are not holes
+	HASH_MAP* map; // Name to its index in entries. The keys are the names of the entries.
+} KV_HASH;
+
+/* Maps the name of every entry to its index again, after the entries moved. The map only
+ever needs the slots it already has. */
+static void reindex (KV_HASH* hash)
+{
+    size_t i; // Entry index
+
+    hmap_clear (hash->map);
+
+    for (i = 0; i < hash->used; i ++)
+    {
+        hmap_put (hash->map, hash->entries[i].name, (void*) i);
+    }
+}
+
+/* Moves the entries down over the holes, keeping their order. */
+static void compact (KV_HASH* hash)
+{
+    size_t i, j; // Indices of the entry read and of the one written
+
+    if (hash->count == hash->used)
+    {
+        return;
+    }
+
+    for (i = 0, j = 0; i < hash->used; i ++)
+    {
+        if (hash->entries[i].name != NULL)
+        {
+            hash->entries[j ++] = hash->entries[i];
+        }
+    }
+
+    hash->used = j;
+    reindex (hash);
+}
+
+static void* hash_create ()
+{
+    KV_HASH* hash = calloc (1, sizeof (KV_HASH));
+    if (hash == NULL)
+    {
+        return NULL;
+    }
+
+    hash->maxEntries = INITIAL_ENTRIES;
+    hash->entries = malloc (hash->maxEntries * sizeof (KV_ENTRY));
+    hash->map = hmap_create (INITIAL_ENTRIES);
+    if ((hash->entries == NULL) || (hash->map == NULL))
+    {
+        if (hash->map != NULL)
+        {
+            hmap_free (hash->map);
+        }
+
+        free (hash->entries);
+        free (hash);
+        return NULL;
+    }
+
+    return hash;
+}
+
+static void hash_clear (void* store)
+{
+    KV_HASH* hash = store;
+    size_t i; // Entry index
+
+    for (i = 0; i < hash->used; i ++)
+    {
+        free (hash->entries[i].name); // NULL in a hole
+        free (hash->entries[i].value);
+    }
+
+    hash->used = 0;
+    hash->count = 0;
+    hmap_clear (hash->map);
+}
+
+static void hash_destroy (void* store)
+{
+    KV_HASH* hash = store;
+
+    hash_clear (hash);
+    hmap_free (hash->map);
+    free (hash->entries);
+    free (hash);
+}
+
+static int hash_add (void* store, char* name, char* value)
+{
+    KV_HASH* hash = store;
+    void* ith;
+
+    char* valueCopy = strdup (value);
+    if (valueCopy == NULL)
+    {
+        return FAILURE;
+    }
+
+    if (hmap_get (hash->map, name, &ith)) // Replace the value
+    {
+        free (hash->entries[(size_t) ith].value);
+        hash->entries[(size_t) ith].value = valueCopy;
+
+        return SUCCESS;
+    }
+
+    if (hash->used == hash->maxEntries)
+    {
+        if (hash->count <= hash->used / 2) // Squeezing out the holes frees half the array at least
+        {
+            compact (hash);
+        }
+        else
+        {
+            KV_ENTRY* entries = realloc (hash->entries, 2 * hash->maxEntries * sizeof (KV_ENTRY));
+            if (entries == NULL)
+            {
+                free (valueCopy);
+                return FAILURE;
+            }
+
+            hash->entries = entries;
+            hash->maxEntries *= 2;
+        }
+    }
+
+    KV_ENTRY* entry = &(hash->entries[hash->used]);
+
+    entry->name = strdup (name);
+    if ((entry->name == NULL) || (hmap_put (hash->map, entry->name, (void*) hash->used) == FAILURE))
+    {
+        free (entry->name);
+        free (valueCopy);
+        return FAILURE;
+    }
+
+    entry->value = valueCopy;
+    hash->used ++;
+    hash->count ++;
+
+    return SUCCESS;
+}
+
+static char* hash_lookup (void* store, char* name)
+{
+    KV_HASH* hash = store;
+    void* ith;
+
+    if (!hmap_get (hash->map, name, &ith))
+    {
+        return NULL;
+    }
+
+    return hash->entries[(size_t) ith].value;
+}
+
+static int hash_remove (void* store, char* name)
+{
+    KV_HASH* hash = store;
+    void* ith;
+
+    if (!hmap_get (hash->map, name, &ith))
+    {
+        return FAILURE;
+    }
+
+    KV_ENTRY* entry = &(hash->entries[(size_t) ith]);
+
+    hmap_remove (hash->map, name);
+    free (entry->name);
+    free (entry->value);
+    entry->name = NULL;
+    entry->value = NULL;
+    hash->count --;
+
+    // Holes at the end are simply given back
+    while ((hash->used > 0) && (hash->entries[hash->used - 1].name == NULL))
+    {
+        hash->used --;
+    }
+
+    return SUCCESS;
+}
+
+static size_t hash_count (void* store)
+{
+    return ((KV_HASH*) store)->count;
+}
+
+static int hash_get_ith (void* store, size_t ith, char** name, char** value)
+{
+    KV_HASH* hash = store;
+
+    if (ith >= hash->count)
+    {
+        return FAILURE;
+    }
+
+    compact (hash);
+    *name = hash->entries[ith].name;
+    *value = hash->entries[ith].value;
+
+    return SUCCESS;
+}
+
+static int nameSortAsc (const void* entryPtr1, const void* entryPtr2)
+{
+    return strcmp (((KV_ENTRY*) entryPtr1)->name, ((KV_ENTRY*) entryPtr2)->name);
+}
+
+static int nameSortDesc (const void* entryPtr1, const void* entryPtr2)
+{
+    return strcmp (((KV_ENTRY*) entryPtr2)->name, ((KV_ENTRY*) entryPtr1)->name);
+}
+
+static void hash_sort (void* store, int ascending)
+{
+    KV_HASH* hash = store;
+
+    compact (hash);
+    qsort (hash->entries, hash->used, sizeof (KV_ENTRY), ascending ? nameSortAsc : nameSortDesc);
+    reindex (hash);
+}
+
+const KV_STORE_OPS kv_hash_ops =
+{
+    "hash", hash_create, hash_destroy, hash_add, hash_lookup, hash_remove, hash_count, hash_get_ith,
+    NULL, NULL, hash_sort, hash_clear, NULL, NULL
+};
@@ -0,0 +1,203 @@
+#include <stdlib.h>
+#include <string.h>
+#include "kv_store.h"
+
+#define SUCCESS 1
+#define FAILURE 0
+#define INITIAL_ENTRIES 16
+
+//
+// The kv_sorted_ops backend: an array kept sorted by name. lookup is a binary search, and
+// add and remove shift the entries after the name with one memmove, which is cheap next to
+// walking a list. The entries are always in name order; sorting only picks the direction
+// in which get_ith walks them.
+//
+typedef struct KV_SORTED
+{
+	KV_ENTRY* entries; // Ascending by name
+	size_t count;
+	size_t maxEntries;
+	int descending; // Set by a descending sort. get_ith counts from the end.
+} KV_SORTED;
+
+/* Returns the index of name, or where it would go, and sets *found. */
+static size_t find (KV_SORTED* sorted, char* name, int* found)
+{
+    size_t low = 0, high = sorted->count; // The name is in [low, high)
+
+    while (low < high)
+    {
+        size_t middle = low + (high - low) / 2;
+        int cmp = strcmp (sorted->entries[middle].name, name);
+
+        if (cmp == 0)
+        {
+            *found = 1;
+            return middle;
+        }
+
+        if (cmp < 0)
+        {
+            low = middle + 1;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+
+    *found = 0;
+
+    return low;
+}
+
+static void* sorted_create ()
+{
+    KV_SORTED* sorted = calloc (1, sizeof (KV_SORTED));
+    if (sorted == NULL)
+    {
+        return NULL;
+    }
+
+    sorted->maxEntries = INITIAL_ENTRIES;
+    sorted->entries = malloc (sorted->maxEntries * sizeof (KV_ENTRY));
+    if (sorted->entries == NULL)
+    {
+        free (sorted);
+        return NULL;
+    }
+
+    return sorted;
+}
+
+static void sorted_clear (void* store)
+{
+    KV_SORTED* sorted = store;
+    size_t i; // Entry index
+
+    for (i = 0; i < sorted->count; i ++)
+    {
+        free (sorted->entries[i].name);
+        free (sorted->entries[i].value);
+    }
+
+    sorted->count = 0;
+}
+
+static void sorted_destroy (void* store)
+{
+    KV_SORTED* sorted = store;
+
+    sorted_clear (sorted);
+    free (sorted->entries);
+    free (sorted);
+}
+
+static int sorted_add (void* store, char* name, char* value)
+{
+    KV_SORTED* sorted = store;
+    int found;
+    size_t ith = find (sorted, name, &found);
+
+    char* valueCopy = strdup (value);
+    if (valueCopy == NULL)
+    {
+        return FAILURE;
+    }
+
+    if (found) // Replace the value
+    {
+        free (sorted->entries[ith].value);
+        sorted->entries[ith].value = valueCopy;
+
+        return SUCCESS;
+    }
+
+    if (sorted->count == sorted->maxEntries)
+    {
+        KV_ENTRY* entries = realloc (sorted->entries, 2 * sorted->maxEntries * sizeof (KV_ENTRY));
+        if (entries == NULL)
+        {
+            free (valueCopy);
+            return FAILURE;
+        }
+
+        sorted->entries = entries;
+        sorted->maxEntries *= 2;
+    }
+
+    char* nameCopy = strdup (name);
+    if (nameCopy == NULL)
+    {
+        free (valueCopy);
+        return FAILURE;
+    }
+
+    memmove (&(sorted->entries[ith + 1]), &(sorted->entries[ith]), (sorted->count - ith) * sizeof (KV_ENTRY));
+    sorted->entries[ith].name = nameCopy;
+    sorted->entries[ith].value = valueCopy;
+    sorted->count ++;
+
+    return SUCCESS;
+}
+
+static char* sorted_lookup (void* store, char* name)
+{
+    KV_SORTED* sorted = store;
+    int found;
+    size_t ith = find (sorted, name, &found);
+
+    return found ? sorted->entries[ith].value : NULL;
+}
+
+static int sorted_remove (void* store, char* name)
+{
+    KV_SORTED* sorted = store;
+    int found;
+    size_t ith = find (sorted, name, &found);
+
+    if (!found)
+    {
+        return FAILURE;
+    }
+
+    free (sorted->entries[ith].name);
+    free (sorted->entries[ith].value);
+    memmove (&(sorted->entries[ith]), &(sorted->entries[ith + 1]), (sorted->count - ith - 1) * sizeof (KV_ENTRY));
+    sorted->count --;
+
+    return SUCCESS;
+}
+
+static size_t sorted_count (void* store)
+{
+    return ((KV_SORTED*) store)->count;
+}
+
+static int sorted_get_ith (void* store, size_t ith, char** name, char** value)
+{
+    KV_SORTED* sorted = store;
+
+    if (ith >= sorted->count)
+    {
+        return FAILURE;
+    }
+
+    KV_ENTRY* entry = &(sorted->entries[sorted->descending ? sorted->count - 1 - ith : ith]);
+
+    *name = entry->name;
+    *value = entry->value;
+
+    return SUCCESS;
+}
+
+static void sorted_sort (void* store, int ascending)
+{
+    ((KV_SORTED*) store)->descending = !ascending;
+}
+
+const KV_STORE_OPS kv_sorted_ops =
+{
+    "sorted", sorted_create, sorted_destroy, sorted_add, sorted_lookup, sorted_remove, sorted_count, sorted_get_ith,
+    NULL, NULL, sorted_sort, sorted_clear, NULL, NULL
+};
@@ -0,0 +1,272 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "kv_store.h"
+
+#define MAXLINE 512
+#define SUCCESS 1
+#define FAILURE 0
+#define NEWLINE '\n'
+#define TERMINATING_NULL_BYTE '\0'
+#define READ_MODE "r"
+#define WRITE_MODE "w"
+
+//
+// It returns a new empty store of the backend ops, or NULL if memory runs out.
+//
+KV_STORE* kv_create (const KV_STORE_OPS* ops)
+{
+    KV_STORE* kv = malloc (sizeof (KV_STORE));
+    if (kv == NULL)
+    {
+        return NULL;
+    }
+
+    kv->ops = ops;
+    kv->store = ops->create ();
+    if (kv->store == NULL)
+    {
+        free (kv);
+        return NULL;
+    }
+
+    return kv;
+}
+
+//
+// It frees the store with all its names and values.
+//
+void kv_destroy (KV_STORE* kv)
+{
+    kv->ops->destroy (kv->store);
+    free (kv);
+}
+
+//
+// It adds name with a copy of value, or replaces the value if name is already there.
+// It will return 1 if successful, or 0 otherwise.
+//
+int kv_add (KV_STORE* kv, char* name, char* value)
+{
+    return kv->ops->add (kv->store, name, value);
+}
+
+//
+// It returns the value of name, or NULL if name is not in the store.
+//
+char* kv_lookup (KV_STORE* kv, char* name)
+{
+    return kv->ops->lookup (kv->store, name);
+}
+
+//
+// It removes name and its value. It will return 1 if successful, or 0 if name is not there.
+//
+int kv_remove (KV_STORE* kv, char* name)
+{
+    return kv->ops->remove (kv->store, name);
+}
+
+//
+// It returns the number of names in the store.
+//
+size_t kv_count (KV_STORE* kv)
+{
+    return kv->ops->count (kv->store);
+}
+
+//
+// It returns in *name and *value the ith entry in the order of the store.
+// It will return 1 if successful, or 0 otherwise.
+//
+int kv_get_ith (KV_STORE* kv, size_t ith, char** name, char** value)
+{
+    return kv->ops->get_ith (kv->store, ith, name, value);
+}
+
+//
+// It inserts name and value before the first entry, without checking for name. It will
+// return 1 if successful, or 0 if memory runs out or the backend keeps its own order.
+//
+int kv_insert_first (KV_STORE* kv, char* name, char* value)
+{
+    if (kv->ops->insert_first == NULL)
+    {
+        return FAILURE;
+    }
+
+    return kv->ops->insert_first (kv->store, name, value);
+}
+
+//
+// Like kv_insert_first, after the last entry.
+//
+int kv_insert_last (KV_STORE* kv, char* name, char* value)
+{
+    if (kv->ops->insert_last == NULL)
+    {
+        return FAILURE;
+    }
+
+    return kv->ops->insert_last (kv->store, name, value);
+}
+
+//
+// It sorts the entries by name. It will return 1 if successful, or 0 if the backend
+// cannot be sorted.
+//
+int kv_sort (KV_STORE* kv, int ascending)
+{
+    if (kv->ops->sort == NULL)
+    {
+        return FAILURE;
+    }
+
+    kv->ops->sort (kv->store, ascending);
+
+    return SUCCESS;
+}
+
+//
+// It removes every entry.
+//
+void kv_clear (KV_STORE* kv)
+{
+    kv->ops->clear (kv->store);
+}
+
+//
+// It saves the store in file_name, in the format of rtable_save_str and llist_save.
+// It will return 1 if successful, or 0 otherwise.
+//
+int kv_save (KV_STORE* kv, char* file_name)
+{
+    if (kv->ops->save == NULL)
+    {
+        return kv_save_generic (kv->ops, kv->store, file_name);
+    }
+
+    return kv->ops->save (kv->store, file_name);
+}
+
+//
+// It replaces the entries of the store with the ones in file_name, as saved by kv_save.
+// It will return 1 if successful, or 0 otherwise.
+//
+int kv_read (KV_STORE* kv, char* file_name)
+{
+    if (kv->ops->read == NULL)
+    {
+        return kv_read_generic (kv->ops, kv->store, file_name);
+    }
+
+    return kv->ops->read (kv->store, file_name);
+}
+
+//
+// It saves any store through get_ith, in the format of rtable_save_str:
+//
+// name1\n
+// value1\n
+// \n
+// name2\n
+// ...
+//
+// It will return 1 if successful, or 0 otherwise.
+//
+int kv_save_generic (const KV_STORE_OPS* ops, void* store, char* file_name)
+{
+    size_t i; // Entry index
+    size_t n = ops->count (store);
+    char* name;
+    char* value;
+
+    FILE* fout = fopen (file_name, WRITE_MODE);
+    if (fout == NULL)
+    {
+        return FAILURE;
+    }
+
+    for (i = 0; i < n; i ++)
+    {
+        if (ops->get_ith (store, i, &name, &value) == FAILURE)
+        {
+            fclose (fout);
+            return FAILURE;
+        }
+
+        fprintf (fout, "%s\n%s\n\n", name, value);
+    }
+
+    return (fclose (fout) == 0) ? SUCCESS : FAILURE;
+}
+
+/* Reads one line without its newline. It will return 1 if successful, or 0 at the end of the file. */
+static int read_line (FILE* fin, char* line)
+{
+    if (fgets (line, MAXLINE + 1, fin) == NULL)
+    {
+        return FAILURE;
+    }
+
+    size_t len = strlen (line);
+
+    if ((len > 0) && (line[len - 1] == NEWLINE))
+    {
+        line[len - 1] = TERMINATING_NULL_BYTE;
+    }
+
+    return SUCCESS;
+}
+
+//
+// It clears any store and adds the entries of a file saved by kv_save_generic, in order.
+// It will return 1 if successful, or 0 otherwise.
+//
+int kv_read_generic (const KV_STORE_OPS* ops, void* store, char* file_name)
+{
+    char name[MAXLINE + 1];
+    char value[MAXLINE + 1];
+    char separator[MAXLINE + 1];
+
+    FILE* fin = fopen (file_name, READ_MODE);
+    if (fin == NULL)
+    {
+        return FAILURE;
+    }
+
+    ops->clear (store);
+
+    while (read_line (fin, name))
+    {
+        if ((read_line (fin, value) == FAILURE) || (read_line (fin, separator) == FAILURE) ||
+            (ops->add (store, name, value) == FAILURE))
+        {
+            fclose (fin);
+            return FAILURE;
+        }
+    }
+
+    fclose (fin);
+
+    return SUCCESS;
+}
+
+//
+// It returns the backend called name in the NULL-terminated array backends, or NULL if
+// there is none.
+//
+const KV_STORE_OPS* kv_find_backend (const KV_STORE_OPS** backends, char* name)
+{
+    size_t i; // Backend index
+
+    for (i = 0; backends[i] != NULL; i ++)
+    {
+        if (strcmp (backends[i]->name, name) == 0)
+        {
+            return backends[i];
+        }
+    }
+
+    return NULL;
+}
@@ -0,0 +1,70 @@
+#if !defined KV_STORE_H
+#define KV_STORE_H
+
+#include <stddef.h>
+
+//
+// A common interface to the name/value stores, so that an application or a benchmark can
+// pick one at runtime and run the same workload on any of them. Every store keeps its own
+// copies of the names and the string values.
+//
+// The backends are rtable_kv_ops (resizable_table.h), llist_kv_ops (linked_list.h), and
+// the two below: kv_hash_ops, a hash table that keeps the insertion order, and
+// kv_sorted_ops, an array kept sorted by name.
+//
+// An operation that a backend cannot offer is NULL, and its kv_ function fails. The
+// positional insertions make no sense for a store that decides the order itself.
+//
+typedef struct KV_STORE_OPS
+{
+	char* name; // Name of the backend, for kv_find_backend
+	void* (*create) ();
+	void (*destroy) (void* store);
+	int (*add) (void* store, char* name, char* value); // Adds name or replaces its value
+	char* (*lookup) (void* store, char* name);
+	int (*remove) (void* store, char* name);
+	size_t (*count) (void* store);
+	int (*get_ith) (void* store, size_t ith, char** name, char** value);
+	int (*insert_first) (void* store, char* name, char* value); // No check for duplicate names
+	int (*insert_last) (void* store, char* name, char* value);
+	void (*sort) (void* store, int ascending); // By name
+	void (*clear) (void* store);
+	int (*save) (void* store, char* file_name); // NULL to use kv_save_generic
+	int (*read) (void* store, char* file_name); // NULL to use kv_read_generic
+} KV_STORE_OPS;
+
+// Entry of the kv_hash_ops and kv_sorted_ops stores
+typedef struct KV_ENTRY
+{
+	char* name; // NULL in a hole left by a removal
+	char* value;
+} KV_ENTRY;
+
+// One store and the backend it belongs to
+typedef struct KV_STORE
+{
+	const KV_STORE_OPS* ops;
+	void* store;
+} KV_STORE;
+
+extern const KV_STORE_OPS kv_hash_ops;
+extern const KV_STORE_OPS kv_sorted_ops;
+
+KV_STORE* kv_create (const KV_STORE_OPS* ops);
+void kv_destroy (KV_STORE* kv);
+int kv_add (KV_STORE* kv, char* name, char* value);
+char* kv_lookup (KV_STORE* kv, char* name);
+int kv_remove (KV_STORE* kv, char* name);
+size_t kv_count (KV_STORE* kv);
+int kv_get_ith (KV_STORE* kv, size_t ith, char** name, char** value);
+int kv_insert_first (KV_STORE* kv, char* name, char* value);
+int kv_insert_last (KV_STORE* kv, char* name, char* value);
+int kv_sort (KV_STORE* kv, int ascending);
+void kv_clear (KV_STORE* kv);
+int kv_save (KV_STORE* kv, char* file_name);
+int kv_read (KV_STORE* kv, char* file_name);
+int kv_save_generic (const KV_STORE_OPS* ops, void* store, char* file_name);
+int kv_read_generic (const KV_STORE_OPS* ops, void* store, char* file_name);
+const KV_STORE_OPS* kv_find_backend (const KV_STORE_OPS** backends, char* name);
+
+#endif
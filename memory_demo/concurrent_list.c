@@ -0,0 +1,581 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "concurrent_list.h"
+
+#define SUCCESS 1
+#define FAILURE 0
+#define MARK ((uintptr_t) 1) // Bit of CLIST_NODE.next set once the node is removed
+#define HAZARD_NODE 0 // Slots of CLIST_HANDLE.hazards
+#define HAZARD_PREVIOUS 1
+#define HAZARD_VALUE 2
+
+//
+// It returns a new empty queue, or NULL if memory runs out.
+//
+TWO_LOCK_QUEUE* tlqueue_create ()
+{
+    TWO_LOCK_QUEUE* queue;
+
+    if (posix_memalign ((void**) &queue, CACHE_LINE, sizeof (TWO_LOCK_QUEUE)) != 0)
+    {
+        return NULL;
+    }
+
+    queue->head = calloc (1, sizeof (TLQUEUE_NODE));
+    if (queue->head == NULL)
+    {
+        free (queue);
+        return NULL;
+    }
+
+    queue->tail = queue->head;
+    queue->nElements = 0;
+    pthread_mutex_init (&(queue->headLock), NULL);
+    pthread_mutex_init (&(queue->tailLock), NULL);
+
+    return queue;
+}
+
+//
+// It frees the queue with the entries left in it. No other thread may use it any more.
+//
+void tlqueue_destroy (TWO_LOCK_QUEUE* queue)
+{
+    TLQUEUE_NODE* node = queue->head;
+
+    while (node != NULL)
+    {
+        TLQUEUE_NODE* next = node->next;
+
+        free (node->name); // NULL in the dummy node
+        free (node->value);
+        free (node);
+        node = next;
+    }
+
+    pthread_mutex_destroy (&(queue->headLock));
+    pthread_mutex_destroy (&(queue->tailLock));
+    free (queue);
+}
+
+//
+// It adds copies of name and value at the end of the queue, holding only the tail lock.
+// It will return 1 if successful, or 0 if memory runs out.
+//
+int tlqueue_insert_last (TWO_LOCK_QUEUE* queue, char* name, char* value)
+{
+    TLQUEUE_NODE* node = malloc (sizeof (TLQUEUE_NODE));
+    if (node == NULL)
+    {
+        return FAILURE;
+    }
+
+    node->name = strdup (name);
+    node->value = strdup (value);
+    node->next = NULL;
+    if ((node->name == NULL) || (node->value == NULL))
+    {
+        free (node->name);
+        free (node->value);
+        free (node);
+        return FAILURE;
+    }
+
+    pthread_mutex_lock (&(queue->tailLock));
+    __atomic_store_n (&((queue->tail)->next), node, __ATOMIC_RELEASE); // A consumer may be reading it
+    queue->tail = node;
+    pthread_mutex_unlock (&(queue->tailLock));
+
+    __atomic_add_fetch (&(queue->nElements), 1, __ATOMIC_RELAXED);
+
+    return SUCCESS;
+}
+
+//
+// It removes the first entry of the queue, holding only the head lock, and hands its name
+// and value over in *name and *value, to be freed by the caller.
+// It will return 1 if successful, or 0 if the queue is empty.
+//
+int tlqueue_remove_first (TWO_LOCK_QUEUE* queue, char** name, char** value)
+{
+    pthread_mutex_lock (&(queue->headLock));
+
+    TLQUEUE_NODE* dummy = queue->head;
+    TLQUEUE_NODE* first = __atomic_load_n (&(dummy->next), __ATOMIC_ACQUIRE);
+
+    if (first == NULL)
+    {
+        pthread_mutex_unlock (&(queue->headLock));
+        return FAILURE;
+    }
+
+    // The first node becomes the dummy, so the tail never points to a freed node
+    *name = first->name;
+    *value = first->value;
+    first->name = NULL;
+    first->value = NULL;
+    queue->head = first;
+
+    pthread_mutex_unlock (&(queue->headLock));
+
+    __atomic_sub_fetch (&(queue->nElements), 1, __ATOMIC_RELAXED);
+    free (dummy);
+
+    return SUCCESS;
+}
+
+//
+// It returns the number of entries in the queue, which other threads may be changing.
+//
+int tlqueue_number_elements (TWO_LOCK_QUEUE* queue)
+{
+    return __atomic_load_n (&(queue->nElements), __ATOMIC_RELAXED);
+}
+
+//
+// It returns a new empty lock-free list, or NULL if memory runs out.
+//
+CONCURRENT_LIST* clist_create ()
+{
+    CONCURRENT_LIST* list;
+
+    if (posix_memalign ((void**) &list, CACHE_LINE, sizeof (CONCURRENT_LIST)) != 0)
+    {
+        return NULL;
+    }
+
+    memset (list, 0, sizeof (CONCURRENT_LIST));
+
+    return list;
+}
+
+/* Frees a retired node with its strings, or a retired value. */
+static void free_retired (CLIST_RETIRED* retired)
+{
+    if (retired->isNode)
+    {
+        CLIST_NODE* node = retired->pointer;
+
+        free (node->name);
+        free (node->value);
+    }
+
+    free (retired->pointer);
+}
+
+//
+// It frees the list with its entries and every pointer still retired. No thread may be
+// attached any more.
+//
+void clist_destroy (CONCURRENT_LIST* list)
+{
+    int i, j; // Handle and retired pointer indices
+    CLIST_NODE* node = (CLIST_NODE*) list->head.next;
+
+    while (node != NULL)
+    {
+        CLIST_NODE* next = (CLIST_NODE*) (node->next & ~MARK);
+
+        free (node->name);
+        free (node->value);
+        free (node);
+        node = next;
+    }
+
+    for (i = 0; i < CLIST_MAX_THREADS; i ++)
+    {
+        for (j = 0; j < list->handles[i].nRetired; j ++)
+        {
+            free_retired (&(list->handles[i].retired[j]));
+        }
+
+        free (list->handles[i].retired);
+    }
+
+    free (list);
+}
+
+//
+// It gives the calling thread a handle on the list, for the other clist_ functions, until
+// clist_detach. It returns NULL if CLIST_MAX_THREADS threads are attached already or memory
+// runs out.
+//
+CLIST_HANDLE* clist_attach (CONCURRENT_LIST* list)
+{
+    int i; // Handle index
+
+    for (i = 0; i < CLIST_MAX_THREADS; i ++)
+    {
+        CLIST_HANDLE* handle = &(list->handles[i]);
+        int idle = 0;
+
+        if (__atomic_compare_exchange_n (&(handle->active), &idle, 1, 0, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+        {
+            if (handle->retired == NULL)
+            {
+                handle->retired = malloc (CLIST_RETIRE_LIMIT * sizeof (CLIST_RETIRED));
+                if (handle->retired == NULL)
+                {
+                    __atomic_store_n (&(handle->active), 0, __ATOMIC_RELEASE);
+                    return NULL;
+                }
+            }
+
+            handle->list = list;
+
+            return handle;
+        }
+    }
+
+    return NULL;
+}
+
+//
+// It gives the handle back. Its retired pointers wait for the next thread that takes it,
+// or for clist_destroy.
+//
+void clist_detach (CLIST_HANDLE* handle)
+{
+    int i; // Hazard index
+
+    for (i = 0; i < CLIST_HAZARDS; i ++)
+    {
+        __atomic_store_n (&(handle->hazards[i]), NULL, __ATOMIC_RELEASE);
+    }
+
+    __atomic_store_n (&(handle->active), 0, __ATOMIC_RELEASE);
+}
+
+/* Publishes pointer in a hazard slot of handle. The store is sequentially consistent, so that a thread scanning the hazards afterwards sees it. */
+static void protect (CLIST_HANDLE* handle, int slot, void* pointer)
+{
+    __atomic_store_n (&(handle->hazards[slot]), pointer, __ATOMIC_SEQ_CST);
+}
+
+/* Frees every retired pointer of handle that no thread holds in a hazard pointer. */
+static void scan (CLIST_HANDLE* handle)
+{
+    void* hazards[CLIST_MAX_THREADS * CLIST_HAZARDS];
+    int nHazards = 0;
+    int i, j, kept = 0; // Handle or retired pointer index, hazard index
+
+    for (i = 0; i < CLIST_MAX_THREADS; i ++)
+    {
+        for (j = 0; j < CLIST_HAZARDS; j ++)
+        {
+            void* hazard = __atomic_load_n (&(handle->list->handles[i].hazards[j]), __ATOMIC_SEQ_CST);
+
+            if (hazard != NULL)
+            {
+                hazards[nHazards ++] = hazard;
+            }
+        }
+    }
+
+    for (i = 0; i < handle->nRetired; i ++)
+    {
+        for (j = 0; (j < nHazards) && (hazards[j] != handle->retired[i].pointer); j ++)
+        {
+        }
+
+        if (j < nHazards) // Still in use
+        {
+            handle->retired[kept ++] = handle->retired[i];
+        }
+        else
+        {
+            free_retired (&(handle->retired[i]));
+        }
+    }
+
+    handle->nRetired = kept;
+}
+
+/* Hands pointer, no longer reachable from the list, over to be freed once no hazard pointer holds it. */
+static void retire (CLIST_HANDLE* handle, void* pointer, int isNode)
+{
+    handle->retired[handle->nRetired].pointer = pointer;
+    handle->retired[handle->nRetired].isNode = isNode;
+    handle->nRetired ++;
+
+    // At most CLIST_MAX_THREADS * CLIST_HAZARDS stay after a scan, half the slots
+    if (handle->nRetired == CLIST_RETIRE_LIMIT)
+    {
+        scan (handle);
+    }
+}
+
+/* Searches the list for name, unlinking the removed nodes it meets. On return *previous is the link that points to *current, the first node whose name is not less than name (or NULL), and both nodes are held by hazard pointers. It returns 1 if *current is called name. */
+static int find (CLIST_HANDLE* handle, char* name, uintptr_t** previous, CLIST_NODE** current)
+{
+    uintptr_t* link;
+    CLIST_NODE* node;
+
+retry:
+    link = &(handle->list->head.next);
+    node = (CLIST_NODE*) __atomic_load_n (link, __ATOMIC_ACQUIRE);
+
+    while (node != NULL)
+    {
+        protect (handle, HAZARD_NODE, node);
+
+        if (__atomic_load_n (link, __ATOMIC_ACQUIRE) != (uintptr_t) node) // Changed before the hazard was seen
+        {
+            goto retry;
+        }
+
+        uintptr_t next = __atomic_load_n (&(node->next), __ATOMIC_ACQUIRE);
+
+        if (next & MARK) // Removed: unlink it on the way
+        {
+            uintptr_t expected = (uintptr_t) node;
+
+            if (!__atomic_compare_exchange_n (link, &expected, next & ~MARK, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+            {
+                goto retry;
+            }
+
+            retire (handle, node, 1);
+        }
+
+        else
+        {
+            int cmp = strcmp (node->name, name);
+
+            if (__atomic_load_n (link, __ATOMIC_ACQUIRE) != (uintptr_t) node)
+            {
+                goto retry;
+            }
+
+            if (cmp >= 0)
+            {
+                *previous = link;
+                *current = node;
+
+                return cmp == 0;
+            }
+
+            link = &(node->next);
+            protect (handle, HAZARD_PREVIOUS, node);
+        }
+
+        node = (CLIST_NODE*) (next & ~MARK);
+    }
+
+    *previous = link;
+    *current = NULL;
+
+    return 0;
+}
+
+/* Clears the hazard pointers of handle once an operation is over. */
+static void release (CLIST_HANDLE* handle)
+{
+    int i; // Hazard index
+
+    for (i = 0; i < CLIST_HAZARDS; i ++)
+    {
+        __atomic_store_n (&(handle->hazards[i]), NULL, __ATOMIC_RELEASE);
+    }
+}
+
+//
+// It adds copies of name and value, or replaces the value if name is already in the list.
+// It will return 1 if successful, or 0 if memory runs out.
+//
+int clist_add (CLIST_HANDLE* handle, char* name, char* value)
+{
+    uintptr_t* link;
+    CLIST_NODE* current;
+
+    char* valueCopy = strdup (value);
+    if (valueCopy == NULL)
+    {
+        return FAILURE;
+    }
+
+    CLIST_NODE* node = NULL;
+
+    while (1)
+    {
+        if (find (handle, name, &link, &current)) // Replace the value. The old one may still be read.
+        {
+            char* old = __atomic_exchange_n (&(current->value), valueCopy, __ATOMIC_ACQ_REL);
+
+            retire (handle, old, 0);
+
+            if (__atomic_load_n (&(current->next), __ATOMIC_ACQUIRE) & MARK) // Removed since find: the copy goes with the node, so insert a new one
+            {
+                valueCopy = strdup (value);
+                if (valueCopy == NULL)
+                {
+                    release (handle);
+
+                    if (node != NULL)
+                    {
+                        free (node->name);
+                        free (node);
+                    }
+
+                    return FAILURE;
+                }
+
+                if (node != NULL)
+                {
+                    node->value = valueCopy;
+                }
+
+                continue;
+            }
+
+            release (handle);
+
+            if (node != NULL) // Made on an earlier try, before name went in
+            {
+                free (node->name);
+                free (node);
+            }
+
+            return SUCCESS;
+        }
+
+        if (node == NULL)
+        {
+            node = malloc (sizeof (CLIST_NODE));
+            if ((node == NULL) || ((node->name = strdup (name)) == NULL))
+            {
+                release (handle);
+                free (node);
+                free (valueCopy);
+                return FAILURE;
+            }
+
+            node->value = valueCopy;
+        }
+
+        node->next = (uintptr_t) current;
+
+        uintptr_t expected = (uintptr_t) current;
+
+        if (__atomic_compare_exchange_n (link, &expected, (uintptr_t) node, 0, __ATOMIC_RELEASE, __ATOMIC_RELAXED))
+        {
+            release (handle);
+            __atomic_add_fetch (&(handle->list->nElements), 1, __ATOMIC_RELAXED);
+
+            return SUCCESS;
+        }
+    }
+}
+
+//
+// It copies the value of name into value, size bytes at most with the null byte, without
+// taking a lock. It will return 1 if successful, or 0 if name is not in the list.
+//
+int clist_lookup (CLIST_HANDLE* handle, char* name, char* value, size_t size)
+{
+    uintptr_t* link;
+    CLIST_NODE* current;
+    char* found;
+
+    if (!find (handle, name, &link, &current))
+    {
+        release (handle);
+        return FAILURE;
+    }
+
+    do // Hold the value, checking that clist_add did not replace it in between
+    {
+        found = __atomic_load_n (&(current->value), __ATOMIC_ACQUIRE);
+        protect (handle, HAZARD_VALUE, found);
+    }
+    while (__atomic_load_n (&(current->value), __ATOMIC_ACQUIRE) != found);
+
+    if (size > 0)
+    {
+        strncpy (value, found, size - 1);
+        value[size - 1] = '\0';
+    }
+
+    release (handle);
+
+    return SUCCESS;
+}
+
+//
+// It removes name from the list. The node is marked first, so that no insertion can
+// follow it, and then unlinked, by this thread or by the next one that passes it.
+// It will return 1 if successful, or 0 if name is not in the list.
+//
+int clist_remove (CLIST_HANDLE* handle, char* name)
+{
+    uintptr_t* link;
+    CLIST_NODE* current;
+
+    while (1)
+    {
+        if (!find (handle, name, &link, &current))
+        {
+            release (handle);
+            return FAILURE;
+        }
+
+        uintptr_t next = __atomic_load_n (&(current->next), __ATOMIC_ACQUIRE);
+
+        if (next & MARK) // Another thread removed it first
+        {
+            continue;
+        }
+
+        if (!__atomic_compare_exchange_n (&(current->next), &next, next | MARK, 0, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED))
+        {
+            continue;
+        }
+
+        __atomic_sub_fetch (&(handle->list->nElements), 1, __ATOMIC_RELAXED);
+
+        uintptr_t expected = (uintptr_t) current;
+
+        if (__atomic_compare_exchange_n (link, &expected, next, 0, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED))
+        {
+            retire (handle, current, 1);
+        }
+        else // Let find unlink it
+        {
+            find (handle, name, &link, &current);
+        }
+
+        release (handle);
+
+        return SUCCESS;
+    }
+}
+
+//
+// It returns the number of entries in the list, which other threads may be changing.
+//
+int clist_number_elements (CONCURRENT_LIST* list)
+{
+    return __atomic_load_n (&(list->nElements), __ATOMIC_RELAXED);
+}
+
+//
+// It prints the list in the format of llist_print. No other thread may change it meanwhile.
+//
+void clist_print (CONCURRENT_LIST* list)
+{
+    CLIST_NODE* node;
+
+    printf ("===== List =====\n");
+    printf ("nElements=%d\n", list->nElements);
+
+    for (node = (CLIST_NODE*) list->head.next; node != NULL; node = (CLIST_NODE*) (node->next & ~MARK))
+    {
+        if (!(node->next & MARK))
+        {
+            printf ("name=\"%s\" value=\"%s\"\n", node->name, node->value);
+        }
+    }
+
+    printf ("======== End List =======\n");
+}
@@ -0,0 +1,96 @@
+#if !defined CONCURRENT_LIST_H
+#define CONCURRENT_LIST_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <pthread.h>
+
+#define CACHE_LINE 64
+
+//
+// Two lists of name/value pairs that many threads can use at once without a lock around
+// the whole list, for the two ways a shared LINKED_LIST is used. Both keep their own copies
+// of the names and values, like llist_insert_last. Link with -pthread.
+//
+// TWO_LOCK_QUEUE is the two-lock queue of Michael and Scott, for producers calling
+// insert_last and consumers calling remove_first: the head and the tail have a lock each,
+// so a producer and a consumer never wait for each other.
+//
+// CONCURRENT_LIST is the lock-free list of Harris, as refined by Michael, for lookups by
+// name: the entries are kept sorted by name, a removal first marks the link of the node
+// and then unlinks it, and a lookup takes no lock and writes no shared memory. Removed
+// nodes and replaced values are freed through hazard pointers, once no thread can still
+// be reading them. Every thread attaches to the list first, to get a CLIST_HANDLE that
+// holds its hazard pointers.
+//
+
+// Entry of a TWO_LOCK_QUEUE
+typedef struct TLQUEUE_NODE
+{
+	char* name;
+	char* value;
+	struct TLQUEUE_NODE* next; // Written under the tail lock and read under the head lock
+} TLQUEUE_NODE;
+
+typedef struct TWO_LOCK_QUEUE
+{
+	TLQUEUE_NODE* head; // A dummy node, whose next is the first entry
+	pthread_mutex_t headLock;
+	TLQUEUE_NODE* tail __attribute__ ((aligned (CACHE_LINE))); // Apart from the head, so that producers and consumers do not share a line
+	pthread_mutex_t tailLock;
+	int nElements __attribute__ ((aligned (CACHE_LINE))); // Updated atomically
+} TWO_LOCK_QUEUE;
+
+#define CLIST_MAX_THREADS 32 // Threads attached to one CONCURRENT_LIST at a time
+#define CLIST_HAZARDS 3 // Hazard pointers per thread: the current node, its predecessor and a value
+#define CLIST_RETIRE_LIMIT (2 * CLIST_HAZARDS * CLIST_MAX_THREADS) // Retired pointers a thread keeps before freeing
+
+// Entry of a CONCURRENT_LIST. The lowest bit of next marks the node as removed.
+typedef struct CLIST_NODE
+{
+	char* name; // Never changes
+	char* value; // Replaced atomically by clist_add
+	uintptr_t next;
+} CLIST_NODE;
+
+// A node or a replaced value waiting until no hazard pointer holds it
+typedef struct CLIST_RETIRED
+{
+	void* pointer;
+	int isNode; // A CLIST_NODE, freed with its name and value, or else a value string
+} CLIST_RETIRED;
+
+// What one thread needs to use a CONCURRENT_LIST, see clist_attach
+typedef struct CLIST_HANDLE
+{
+	struct CONCURRENT_LIST* list;
+	int active; // Taken by an attached thread
+	void* hazards[CLIST_HAZARDS]; // Read by every thread that frees retired pointers
+	CLIST_RETIRED* retired; // CLIST_RETIRE_LIMIT slots, kept for the next thread on detach
+	int nRetired;
+} __attribute__ ((aligned (CACHE_LINE))) CLIST_HANDLE;
+
+typedef struct CONCURRENT_LIST
+{
+	CLIST_NODE head; // Dummy node before the first entry
+	int nElements; // Updated atomically
+	CLIST_HANDLE handles[CLIST_MAX_THREADS];
+} CONCURRENT_LIST;
+
+TWO_LOCK_QUEUE* tlqueue_create ();
+void tlqueue_destroy (TWO_LOCK_QUEUE* queue);
+int tlqueue_insert_last (TWO_LOCK_QUEUE* queue, char* name, char* value);
+int tlqueue_remove_first (TWO_LOCK_QUEUE* queue, char** name, char** value);
+int tlqueue_number_elements (TWO_LOCK_QUEUE* queue);
+
+CONCURRENT_LIST* clist_create ();
+void clist_destroy (CONCURRENT_LIST* list);
+CLIST_HANDLE* clist_attach (CONCURRENT_LIST* list);
+void clist_detach (CLIST_HANDLE* handle);
+int clist_add (CLIST_HANDLE* handle, char* name, char* value);
+int clist_lookup (CLIST_HANDLE* handle, char* name, char* value, size_t size);
+int clist_remove (CLIST_HANDLE* handle, char* name);
+int clist_number_elements (CONCURRENT_LIST* list);
+void clist_print (CONCURRENT_LIST* list);
+
+#endif
@@ -3,6 +3,8 @@
 #include <stdio.h>
 #include <string.h>
 #include "linked_list.h"
+#include "../common/hash_map.h"
+#include "../common/instrument.h"
 
 #define SUCCESS 1
 #define FAILURE 0
@@ -37,6 +39,14 @@ LINKED_LIST* llist_create ()
 	
     // Initialise LINKED_LIST elements
 	list->nElements = 0;
+	list->cursors = NULL;
+	list->index = NULL;
+	list->pool = NULL;
+	list->inlineStrings = 0;
+	list->nameBytes = 0;
+	list->valueBytes = 0;
+	list->stringOverhead = 0;
+	memset (list->keyLengths, 0, sizeof (list->keyLengths));
     
     // Initialise dummy node elements
     (list->head)->name = NULL;
@@ -76,6 +86,390 @@ void llist_print (LINKED_LIST* list)
     printf ("======== End List =======\n");
 }
 
+/* Estimated bytes that malloc adds to a block of size bytes, with the header, 16 byte rounding and 32 byte minimum of glibc. */
+static size_t malloc_overhead (size_t size)
+{
+    size_t chunk = (size + sizeof (size_t) + 15) & ~((size_t) 15);
+    
+    return ((chunk < 32) ? 32 : chunk) - size;
+}
+
+/* Adds (add is 1) or subtracts (add is 0) the size of str to *bytes and its malloc overhead to the list's. */
+static void count_string (LINKED_LIST* list, char* str, size_t* bytes, int add)
+{
+    size_t size = strlen (str) + 1;
+    
+    if (add)
+    {
+        *bytes += size;
+        list->stringOverhead += malloc_overhead (size);
+    }
+    else
+    {
+        *bytes -= size;
+        list->stringOverhead -= malloc_overhead (size);
+    }
+}
+
+/* Returns where an inline node keeps its value when the value fits, right after the name. */
+static char* inline_value (LINKED_LIST_ENTRY* node)
+{
+    return ((LLIST_INLINE_ENTRY*) node)->strings + strlen (node->name) + 1;
+}
+
+/* Adds (add is 1) or subtracts (add is 0) the strings of an inline node to the counters of llist_stats. The whole block of the node is overhead but for the strings, and a value that outgrew its room is a malloc of its own. */
+static void count_inline (LINKED_LIST* list, LINKED_LIST_ENTRY* node, int add)
+{
+    size_t capacity = ((LLIST_INLINE_ENTRY*) node)->valueCapacity;
+    size_t nameSize = strlen (node->name) + 1;
+    size_t valueSize = strlen (node->value) + 1;
+    size_t overhead = malloc_overhead (sizeof (LLIST_INLINE_ENTRY) + nameSize + capacity);
+    
+    if (node->value == inline_value (node))
+    {
+        overhead += capacity - valueSize;
+    }
+    else
+    {
+        overhead += capacity + malloc_overhead (valueSize);
+    }
+    
+    if (add)
+    {
+        list->nameBytes += nameSize;
+        list->valueBytes += valueSize;
+        list->stringOverhead += overhead;
+    }
+    else
+    {
+        list->nameBytes -= nameSize;
+        list->valueBytes -= valueSize;
+        list->stringOverhead -= overhead;
+    }
+}
+
+/* Adds (add is 1) or subtracts (add is 0) the name and value of node to the counters of llist_stats. */
+static void count_entry (LINKED_LIST* list, LINKED_LIST_ENTRY* node, int add)
+{
+    size_t length = strlen (node->name);
+    int bucket = 0;
+    
+    while ((length > 0) && (bucket < LLIST_KEY_LENGTH_BUCKETS - 1))
+    {
+        length >>= 1;
+        bucket ++;
+    }
+    
+    list->keyLengths[bucket] += add ? 1 : -1;
+    
+    if (list->inlineStrings)
+    {
+        count_inline (list, node, add);
+        return;
+    }
+    
+    count_string (list, node->name, &(list->nameBytes), add);
+    count_string (list, node->value, &(list->valueBytes), add);
+}
+
+/* Replaces the value of node with a copy of value. An inline node overwrites its value in place when the new one fits, and else keeps it in an allocation of its own. It will return 1 if successful, or 0 if memory runs out. */
+static int replace_value (LINKED_LIST* list, LINKED_LIST_ENTRY* node, char* value)
+{
+    size_t size = strlen (value) + 1;
+    char* old = node->value;
+    char* copy;
+    int external = !list->inlineStrings || (old != inline_value (node)); // old is a malloc of its own
+    
+    if (list->inlineStrings && (size <= ((LLIST_INLINE_ENTRY*) node)->valueCapacity))
+    {
+        copy = inline_value (node);
+    }
+    else
+    {
+        copy = malloc (size);
+        if (copy == NULL)
+        {
+            return FAILURE;
+        }
+    }
+    
+    count_entry (list, node, 0);
+    memmove (copy, value, size); // value may be the old value itself
+    node->value = copy;
+    count_entry (list, node, 1);
+    
+    if (external)
+    {
+        free (old);
+    }
+    
+    return SUCCESS;
+}
+
+/* Adds a slab of nNodes nodes to the pool and puts them on the free list, so that they are handed out in address order. */
+static LLIST_SLAB* add_slab (LLIST_POOL* pool, size_t nNodes)
+{
+    size_t i; // Node index
+    
+    LLIST_SLAB* slab = malloc (sizeof (LLIST_SLAB) + nNodes * sizeof (LINKED_LIST_ENTRY));
+    if (slab == NULL)
+    {
+        return NULL;
+    }
+    
+    slab->nNodes = nNodes;
+    slab->next = pool->slabs;
+    pool->slabs = slab;
+    pool->nSlabs ++;
+    pool->totalNodes += nNodes;
+    
+    for (i = nNodes; i > 0; i --)
+    {
+        slab->nodes[i - 1].next = pool->freeNodes;
+        pool->freeNodes = &(slab->nodes[i - 1]);
+    }
+    
+    return slab;
+}
+
+/* Frees every slab of the pool, and the pool. */
+static void free_pool (LLIST_POOL* pool)
+{
+    LLIST_SLAB* slab = pool->slabs;
+    
+    while (slab != NULL)
+    {
+        LLIST_SLAB* next = slab->next;
+        
+        free (slab);
+        slab = next;
+    }
+    
+    free (pool);
+}
+
+/* Returns a new node, from the pool of the list if it has one, or NULL if memory runs out. */
+static LINKED_LIST_ENTRY* alloc_node (LINKED_LIST* list)
+{
+    LLIST_POOL* pool = list->pool;
+    
+    if (pool == NULL)
+    {
+        return malloc (sizeof (LINKED_LIST_ENTRY));
+    }
+    
+    if ((pool->freeNodes == NULL) && (add_slab (pool, pool->slabNodes) == NULL))
+    {
+        return NULL;
+    }
+    
+    LINKED_LIST_ENTRY* node = pool->freeNodes;
+    pool->freeNodes = node->next;
+    
+    return node;
+}
+
+/* Gives node back to the pool of the list, or to malloc. */
+static void free_node (LINKED_LIST* list, LINKED_LIST_ENTRY* node)
+{
+    if (list->pool == NULL)
+    {
+        free (node);
+        return;
+    }
+    
+    node->next = list->pool->freeNodes;
+    list->pool->freeNodes = node;
+}
+
+/* Returns a new node with copies of name and value, not linked yet, or NULL if memory runs out. A list with inline strings makes it one malloc, rounded up to 16 bytes, the slack going to the value. */
+static LINKED_LIST_ENTRY* new_node (LINKED_LIST* list, char* name, char* value)
+{
+    size_t nameSize = strlen (name) + 1;
+    size_t valueSize = strlen (value) + 1;
+    
+    if (list->inlineStrings)
+    {
+        size_t bytes = (sizeof (LLIST_INLINE_ENTRY) + nameSize + valueSize + 15) & ~((size_t) 15);
+        
+        LLIST_INLINE_ENTRY* inlineNode = malloc (bytes);
+        if (inlineNode == NULL)
+        {
+            return NULL;
+        }
+        
+        inlineNode->valueCapacity = bytes - sizeof (LLIST_INLINE_ENTRY) - nameSize;
+        memcpy (inlineNode->strings, name, nameSize);
+        memcpy (inlineNode->strings + nameSize, value, valueSize);
+        inlineNode->entry.name = inlineNode->strings;
+        inlineNode->entry.value = inlineNode->strings + nameSize;
+        
+        return &(inlineNode->entry);
+    }
+    
+    LINKED_LIST_ENTRY* node = alloc_node (list);
+    if (node == NULL)
+    {
+        return NULL;
+    }
+    
+    node->name = malloc (nameSize);
+    node->value = malloc (valueSize);
+    if ((node->name == NULL) || (node->value == NULL))
+    {
+        free (node->name);
+        free (node->value);
+        free_node (list, node);
+        return NULL;
+    }
+    
+    memcpy (node->name, name, nameSize);
+    memcpy (node->value, value, valueSize);
+    
+    return node;
+}
+
+/* Frees node, not linked any more, with its name and value. */
+static void delete_node (LINKED_LIST* list, LINKED_LIST_ENTRY* node)
+{
+    if (list->inlineStrings)
+    {
+        if (node->value != inline_value (node)) // The value outgrew its room
+        {
+            free (node->value);
+        }
+        
+        free (node);
+        return;
+    }
+    
+    free (node->name);
+    free (node->value);
+    free_node (list, node);
+}
+
+/* Returns the first node with that name, or NULL. With a name index this is one hash probe instead of a walk. */
+static LINKED_LIST_ENTRY* find_node (LINKED_LIST* list, char* name)
+{
+    LINKED_LIST_ENTRY* node = (list->head)->next;
+    void* found;
+    
+    if (list->index != NULL)
+    {
+        INSTR_COUNT (INSTR_COMPARES, 1);
+        
+        return hmap_get (list->index, name, &found) ? found : NULL;
+    }
+    
+    while (node != list->head)
+    {
+        INSTR_COUNT (INSTR_COMPARES, 1);
+        
+        if (strcmp(node->name, name) == 0)
+        {
+            return node;
+        }
+        
+        node = node->next;
+    }
+    
+    return NULL;
+}
+
+/* Adds node, about to be linked before every other node with its name (first is 1) or not, to the name index. A name that is already in the list keeps its node, unless the new node goes before it. */
+static int index_node (LINKED_LIST* list, LINKED_LIST_ENTRY* node, int first)
+{
+    void* found;
+    
+    if (list->index == NULL)
+    {
+        return SUCCESS;
+    }
+    
+    if (hmap_get (list->index, node->name, &found))
+    {
+        if (first)
+        {
+            // Removed and put again, because the map keeps the key of the old node. The
+            // count ends where it was, so the map cannot need to grow.
+            hmap_remove (list->index, node->name);
+            hmap_put (list->index, node->name, node);
+        }
+        
+        return SUCCESS;
+    }
+    
+    return hmap_put (list->index, node->name, node);
+}
+
+/* Removes node, which is still linked, from the name index. If it was the first node with its name, the next node with that name takes its place. */
+static void unindex_node (LINKED_LIST* list, LINKED_LIST_ENTRY* node)
+{
+    LINKED_LIST_ENTRY* other;
+    void* found;
+    
+    if ((list->index == NULL) || (!hmap_get (list->index, node->name, &found)) || (found != node))
+    {
+        return;
+    }
+    
+    hmap_remove (list->index, node->name);
+    
+    if (list->index->count + 1 == (size_t) list->nElements) // Every name was unique
+    {
+        return;
+    }
+    
+    for (other = node->next; other != list->head; other = other->next)
+    {
+        if (strcmp (other->name, node->name) == 0)
+        {
+            hmap_put (list->index, other->name, other);
+            break;
+        }
+    }
+}
+
+/* Puts every name of the list into map, mapped to its node. If the list has the same name
+more than once the map keeps the first node. */
+static int fill_map (LINKED_LIST* list, HASH_MAP* map)
+{
+    void* found;
+    LINKED_LIST_ENTRY* node = (list->head)->next;
+    
+    while (node != list->head)
+    {
+        uint64_t hash = hmap_hash (node->name);
+        
+        if ((!hmap_get_hashed (map, node->name, hash, &found)) && (hmap_put_hashed (map, node->name, hash, node) == FAILURE))
+        {
+            return FAILURE;
+        }
+        
+        node = node->next;
+    }
+    
+    return SUCCESS;
+}
+
+/* Returns a new map from every name of the list to its first node, or NULL. */
+static HASH_MAP* map_names (LINKED_LIST* list)
+{
+    HASH_MAP* map = hmap_create ((size_t) list->nElements);
+    if (map == NULL)
+    {
+        return NULL;
+    }
+    
+    if (fill_map (list, map) == FAILURE)
+    {
+        hmap_free (map);
+        return NULL;
+    }
+    
+    return map;
+}
+
 //
 // Adds one pair name/value to the END of the list. If the name already exists it will
 // substitute its value. Otherwise, it will store name/value in a new entry.
@@ -84,20 +478,14 @@ void llist_print (LINKED_LIST* list)
 //
 int llist_add (LINKED_LIST* list, char* name, char* value) 
 {
-    LINKED_LIST_ENTRY* node = (list->head)->next;
+    INSTR_SCOPE (INSTR_LLIST_ADD);
     
     // See if name already exists in list
-    while (node != list->head)
+    LINKED_LIST_ENTRY* node = find_node (list, name);
+    
+    if (node != NULL)
     {
-        if (strcmp(node->name, name) == 0)
-        {
-            free (node->value);
-            node->value = strdup (value);
-            
-            return SUCCESS;
-        }
-        
-        node = node->next;
+        return replace_value (list, node, value);
     }
 
     // At this point, did not find name in list
@@ -110,19 +498,42 @@ int llist_add (LINKED_LIST* list, char* name, char* value)
 //
 char* llist_lookup (LINKED_LIST* list, char* name) 
 {
-    LINKED_LIST_ENTRY* node = (list->head)->next;
+    INSTR_SCOPE (INSTR_LLIST_LOOKUP);
     
-    while (node != list->head)
+    LINKED_LIST_ENTRY* node = find_node (list, name);
+	
+    return (node != NULL) ? node->value : NULL;
+}
+
+/* Unlinks node from the list and frees it, with its name and value. Cursors on the node move on to the node that followed it. */
+static void remove_entry (LINKED_LIST* list, LINKED_LIST_ENTRY* node)
+{
+    LLIST_CURSOR* cursor;
+    
+    for (cursor = list->cursors; cursor != NULL; cursor = cursor->nextCursor)
     {
-        if (strcmp(node->name, name) == 0)
+        if (cursor->current == node)
         {
-            return node->value;
+            cursor->current = NULL;
         }
         
-        node = node->next;
+        if (cursor->next == node)
+        {
+            cursor->next = node->next;
+        }
     }
-	
-    return NULL;
+    
+    count_entry (list, node, 0);
+    unindex_node (list, node);
+    
+    // Update list pointers
+    (node->previous)->next = node->next;
+    (node->next)->previous = node->previous;
+    
+    delete_node (list, node);
+    
+    // Update nElements
+    list->nElements --;
 }
 
 //
@@ -131,382 +542,1562 @@ char* llist_lookup (LINKED_LIST* list, char* name)
 //
 int llist_remove (LINKED_LIST* list, char* name) 
 {
-    LINKED_LIST_ENTRY* node = (list->head)->next;
+    LINKED_LIST_ENTRY* node = find_node (list, name);
     
-    while (node != list->head)
+    if (node != NULL)
     {
-        if (strcmp(node->name, name) == 0)
-        {
-            // Update list pointers
-            (node->previous)->next = node->next;
-            (node->next)->previous = node->previous;
-            
-            free (node->name);
-            free (node->value);
-            free (node);
-            
-            // Update nElements
-            list->nElements --;
-            
-            return SUCCESS;
-        }
+        remove_entry (list, node);
         
-        node = node->next;
+        return SUCCESS;
     }
     
     // At this point, could not find name in list
 	return FAILURE;
 }
 
-//
-// It returns in *name and *value the name and value that correspond to
-// the ith entry. It will return 1 if successful, or 0 otherwise.
-//
-int llist_get_ith (LINKED_LIST* list, int ith, char** name, char** value)
+/* Returns the node at position ith, walking from the nearer end of the list, or NULL if ith is out of bounds. */
+static LINKED_LIST_ENTRY* nth_node (LINKED_LIST* list, int ith)
 {
-    int i = 0; // List index
-
-	LINKED_LIST_ENTRY* node = (list->head)->next;
+    LINKED_LIST_ENTRY* node = list->head;
+    int i; // Nodes to walk
+    
+    if ((ith < 0) || (ith >= list->nElements))
+    {
+        return NULL;
+    }
+    
+    if (ith < list->nElements / 2)
+    {
+        for (i = 0; i <= ith; i ++)
+        {
+            node = node->next;
+        }
+    }
+    else
+    {
+        for (i = list->nElements; i > ith; i --)
+        {
+            node = node->previous;
+        }
+    }
+    
+    return node;
+}
+
+//
+// It returns in *name and *value the name and value that correspond to
+// the ith entry. It will return 1 if successful, or 0 otherwise.
+//
+int llist_get_ith (LINKED_LIST* list, int ith, char** name, char** value)
+{
+	LINKED_LIST_ENTRY* node = nth_node (list, ith);
+    
+    if (node != NULL)
+    {
+        *name = node->name;
+        *value = node->value;
+        
+        return SUCCESS;
+    }
+    
+    // At this point, ith entry was out of bounds
+	return FAILURE;
+}
+
+//
+// It removes the ith entry from the list.
+// Also the name/value strings are freed.
+//
+int llist_remove_ith (LINKED_LIST* list, int ith)
+{
+	LINKED_LIST_ENTRY* node = nth_node (list, ith); // Never the dummy head node
+    
+    if (node != NULL)
+    {
+        remove_entry (list, node);
+        
+        return SUCCESS;
+    }
+    
+    // At this point, ith entry was out of bounds
+	return FAILURE;
+}
+
+//
+// It returns the number of elements in the list.
+//
+int llist_number_elements (LINKED_LIST* list) 
+{
+	return list->nElements;
+}
+
+/* Links node, with its name and value set, at the end of the list. It will return 1 if successful, or 0 if the name index runs out of memory, with node not linked. */
+static int link_last (LINKED_LIST* list, LINKED_LIST_ENTRY* node)
+{
+    if (index_node (list, node, 0) == FAILURE)
+    {
+        return FAILURE;
+    }
+    
+    count_entry (list, node, 1);
+    
+    // Update list pointers
+    ((list->head)->previous)->next = node;
+    node->previous = (list->head)->previous;
+    ((list->head)->previous) = node;
+    node->next = list->head;
+    
+    // Update nElements only if actually adding a new element.
+    list->nElements ++;
+    
+    return SUCCESS;
+}
+
+/* Empties the list in O(1) without freeing anything, and returns its nodes chained through next and ended by NULL. The counters of llist_stats and the name index start over, and every cursor is at the end. */
+static LINKED_LIST_ENTRY* detach_nodes (LINKED_LIST* list)
+{
+    LINKED_LIST_ENTRY* head = list->head;
+    LINKED_LIST_ENTRY* chain = (list->nElements > 0) ? head->next : NULL;
+    LLIST_CURSOR* cursor;
+    
+    (head->previous)->next = NULL;
+    head->next = head;
+    head->previous = head;
+    
+    list->nElements = 0;
+    list->nameBytes = 0;
+    list->valueBytes = 0;
+    list->stringOverhead = 0;
+    memset (list->keyLengths, 0, sizeof (list->keyLengths));
+    
+    if (list->index != NULL)
+    {
+        hmap_clear (list->index);
+    }
+    
+    for (cursor = list->cursors; cursor != NULL; cursor = cursor->nextCursor)
+    {
+        cursor->next = head;
+        cursor->current = NULL;
+    }
+    
+    return chain;
+}
+
+/* Frees every node of a chain ended by NULL that holds all the nodes of the list, with their names and values. Nodes from a pool are left to the pool, which takes back all of them at once. */
+static void free_chain (LINKED_LIST* list, LINKED_LIST_ENTRY* chain)
+{
+    while (chain != NULL)
+    {
+        LINKED_LIST_ENTRY* next = chain->next;
+        
+        if (list->pool != NULL)
+        {
+            free (chain->name);
+            free (chain->value);
+        }
+        else
+        {
+            delete_node (list, chain);
+        }
+        
+        chain = next;
+    }
+}
+
+/* Puts every node of every slab back on the free list of the pool, once the list uses none of them, so that they are handed out again in address order from the oldest slab. */
+static void reset_pool (LLIST_POOL* pool)
+{
+    LLIST_SLAB* slab;
+    size_t i; // Node index
+    
+    pool->freeNodes = NULL;
+    
+    for (slab = pool->slabs; slab != NULL; slab = slab->next)
+    {
+        for (i = slab->nNodes; i > 0; i --)
+        {
+            slab->nodes[i - 1].next = pool->freeNodes;
+            pool->freeNodes = &(slab->nodes[i - 1]);
+        }
+    }
+}
+
+//
+// It removes every entry of the list and frees their names and values in one pass, without
+// unlinking the nodes one by one. A list with a pool keeps its slabs, with every node free
+// again. The name index, if any, stays and is empty. Cursors on the list are at the end.
+//
+void llist_clear (LINKED_LIST* list)
+{
+    free_chain (list, detach_nodes (list));
+    
+    if (list->pool != NULL)
+    {
+        reset_pool (list->pool);
+    }
+}
+
+//
+// It frees the list with all its entries, its name index and its pool. The slabs of a pool
+// are freed whole, without giving their nodes back one by one. The walks of the cursors
+// still on the list are over.
+//
+void llist_destroy (LINKED_LIST* list)
+{
+    LLIST_CURSOR* cursor;
+    
+    free_chain (list, detach_nodes (list));
+    
+    for (cursor = list->cursors; cursor != NULL; cursor = cursor->nextCursor)
+    {
+        cursor->list = NULL;
+    }
+    
+    llist_drop_index (list);
+    
+    if (list->pool != NULL)
+    {
+        free_pool (list->pool);
+    }
+    
+    free (list->head);
+    free (list);
+}
+
+//
+// It saves the list in a file called file_name. The format of the
+// file is as follows:
+//
+// name1\n
+// value1\n
+// \n
+// name2\n
+// value2\n
+// ...
+//
+// Notice that there is an empty line between each name/value pair.
+//
+int llist_save (LINKED_LIST* list, char* file_name)
+{
+    FILE* fout = fopen (file_name, WRITE_MODE);
+    if (fout == NULL) // fopen failed
+    {
+        return FAILURE;
+    }
+    
+    LINKED_LIST_ENTRY* node = (list->head)->next;
+    
+    while (node != list->head)
+    {
+        fprintf (fout, "%s\n", node->name);
+        fprintf (fout, "%s\n\n", node->value);
+        
+        node = node->next;
+    }
+
+	fclose (fout);
+    
+	return SUCCESS;
+}
+
+/* Removes newline character from the end of input strings. */
+static void sanitise (char* str)
+{
+    int len = strlen (str);
+    
+    if ((len > 0) && (str[len - 1] == NEWLINE))
+    {
+        str[len - 1] = TERMINATING_NULL_BYTE;
+    }
+}
+
+/* Puts copies of name and value into node, a node of the list that is not linked, reusing its memory. A node with inline strings is only reused if both fit in its block. It will return 1 if successful, or 0 if not, with node still whole. */
+static int refill_node (LINKED_LIST* list, LINKED_LIST_ENTRY* node, char* name, char* value)
+{
+    size_t nameSize = strlen (name) + 1;
+    size_t valueSize = strlen (value) + 1;
+    char* str;
+    
+    if (list->inlineStrings)
+    {
+        LLIST_INLINE_ENTRY* inlineNode = (LLIST_INLINE_ENTRY*) node;
+        size_t room = strlen (node->name) + 1 + inlineNode->valueCapacity;
+        
+        if (nameSize + valueSize > room)
+        {
+            return FAILURE;
+        }
+        
+        if (node->value != inline_value (node)) // The value outgrew its room
+        {
+            free (node->value);
+        }
+        
+        memcpy (inlineNode->strings, name, nameSize);
+        memcpy (inlineNode->strings + nameSize, value, valueSize);
+        node->value = inlineNode->strings + nameSize;
+        inlineNode->valueCapacity = room - nameSize;
+        
+        return SUCCESS;
+    }
+    
+    str = realloc (node->name, nameSize);
+    if (str == NULL)
+    {
+        return FAILURE;
+    }
+    
+    node->name = memcpy (str, name, nameSize);
+    
+    str = realloc (node->value, valueSize);
+    if (str == NULL)
+    {
+        return FAILURE;
+    }
+    
+    node->value = memcpy (str, value, valueSize);
+    
+    return SUCCESS;
+}
+
+//
+// It reads the list from the file_name indicated, in the format of llist_save. The entries
+// the list already has are replaced: their nodes are taken off the list in O(1) and reused
+// for the entries read, and the ones left over are freed. A name read twice keeps the
+// last value, like llist_add. It will return 1 if successful, or 0 if the file cannot be
+// opened, if it ends in the middle of an entry or if memory runs out.
+//
+int llist_read (LINKED_LIST* list, char* file_name)
+{
+	char name[MAXLINE + 1]; // Temporary buffers to store name/value read in from file
+	char value[MAXLINE + 1];
+	char separator[MAXLINE + 1];
+    LINKED_LIST_ENTRY* spare; // Nodes of the old entries, not reused yet
+    LINKED_LIST_ENTRY* node;
+    int result = SUCCESS;
+    
+    FILE* fin = fopen (file_name, READ_MODE);
+    if (fin == NULL) // fopen failed
+    {
+        return FAILURE;
+    }
+    
+    spare = detach_nodes (list);
+    
+    while (fgets (name, MAXLINE + 1, fin) != NULL) // Read in name
+    {
+        // Read in value, and the empty line separating name/value pairs
+        if ((fgets (value, MAXLINE + 1, fin) == NULL) || (fgets (separator, MAXLINE + 1, fin) == NULL))
+        {
+            result = FAILURE;
+            break;
+        }
+        
+        // Remove newline character at the end of input strings
+        sanitise (name);
+        sanitise (value);
+        
+        node = find_node (list, name);
+        if (node != NULL)
+        {
+            if (replace_value (list, node, value) == FAILURE)
+            {
+                result = FAILURE;
+                break;
+            }
+            
+            continue;
+        }
+        
+        if ((spare != NULL) && refill_node (list, spare, name, value))
+        {
+            node = spare;
+            spare = spare->next;
+        }
+        else
+        {
+            node = new_node (list, name, value);
+        }
+        
+        if (node == NULL)
+        {
+            result = FAILURE;
+            break;
+        }
+        
+        if (link_last (list, node) == FAILURE)
+        {
+            delete_node (list, node);
+            result = FAILURE;
+            break;
+        }
+    }
+    
+    while (spare != NULL)
+    {
+        node = spare->next;
+        delete_node (list, spare);
+        spare = node;
+    }
+    
+    fclose (fin);
+    
+    return result;
+}
+
+/* Compares two entries by name, ascending if *context is 1 and descending if it is 0. */
+static int compare_names (char* name1, char* value1, char* name2, char* value2, void* context)
+{
+    int cmp = strcmp (name1, name2);
+    
+    (void) value1;
+    (void) value2;
+    
+    return *((int*) context) ? cmp : -cmp;
+}
+
+/* Compares two entries by value, ascending if *context is 1 and descending if it is 0. */
+static int compare_values (char* name1, char* value1, char* name2, char* value2, void* context)
+{
+    int cmp = strcmp (value1, value2);
+    
+    (void) name1;
+    (void) name2;
+    
+    return *((int*) context) ? cmp : -cmp;
+}
+
+/* Cuts the chain of next links after its first length nodes, and returns the rest of it, or NULL. */
+static LINKED_LIST_ENTRY* cut_run (LINKED_LIST_ENTRY* run, size_t length)
+{
+    while ((run != NULL) && (length > 1))
+    {
+        run = run->next;
+        length --;
+    }
+    
+    if (run == NULL)
+    {
+        return NULL;
+    }
+    
+    LINKED_LIST_ENTRY* rest = run->next;
+    run->next = NULL;
+    
+    return rest;
+}
+
+/* Merges the sorted runs left and right onto *tail, taking from left on ties so that the sort is stable, and returns the next link of the last node merged. */
+static LINKED_LIST_ENTRY** merge_runs (LINKED_LIST_ENTRY* left, LINKED_LIST_ENTRY* right, LINKED_LIST_ENTRY** tail, LLIST_COMPARE_FUNC compare, void* context)
+{
+    while ((left != NULL) && (right != NULL))
+    {
+        if (compare (right->name, right->value, left->name, left->value, context) < 0)
+        {
+            *tail = right;
+            right = right->next;
+        }
+        else
+        {
+            *tail = left;
+            left = left->next;
+        }
+        
+        tail = &((*tail)->next);
+    }
+    
+    *tail = (left != NULL) ? left : right;
+    
+    while (*tail != NULL)
+    {
+        tail = &((*tail)->next);
+    }
+    
+    return tail;
+}
+
+//
+// It sorts the list with compare, which returns less than, equal to or more than 0 like
+// strcmp, and is given context. The sort is a bottom-up merge sort on the node links: it
+// is stable, takes O(n log n) comparisons, and allocates nothing. The nodes themselves do
+// not move, so cursors and the name index stay valid, though a cursor goes on from the new
+// place of its next node.
+//
+void llist_sort_with (LINKED_LIST* list, LLIST_COMPARE_FUNC compare, void* context)
+{
+    LINKED_LIST_ENTRY* head = list->head;
+    LINKED_LIST_ENTRY* chain; // The nodes, chained through next and ended by NULL
+    LINKED_LIST_ENTRY* node;
+    size_t width; // Length of the sorted runs merged in this pass
+    
+    if (list->nElements < 2)
+    {
+        return;
+    }
+    
+    (head->previous)->next = NULL;
+    chain = head->next;
+    
+    for (width = 1; width < (size_t) list->nElements; width *= 2)
+    {
+        LINKED_LIST_ENTRY* rest = chain;
+        LINKED_LIST_ENTRY** tail = &chain;
+        
+        while (rest != NULL)
+        {
+            LINKED_LIST_ENTRY* left = rest;
+            LINKED_LIST_ENTRY* right = cut_run (left, width);
+            
+            rest = cut_run (right, width);
+            tail = merge_runs (left, right, tail, compare, context);
+        }
+    }
+    
+    // Rebuild the previous links and close the circle through the head
+    head->next = chain;
+    
+    for (node = head; node->next != NULL; node = node->next)
+    {
+        (node->next)->previous = node;
+    }
+    
+    node->next = head;
+    head->previous = node;
+    
+    // A repeated name may have a new first node. The map already has a slot for every name.
+    if ((list->index != NULL) && (list->index->count < (size_t) list->nElements))
+    {
+        hmap_clear (list->index);
+        fill_map (list, list->index);
+    }
+}
+
+//
+// It sorts the list according to the name. The parameter ascending determines if the
+// order is ascending (1) or descending(0). Entries with the same name keep their order.
+//
+void llist_sort (LINKED_LIST* list, int ascending)
+{
+    if ((ascending != 0) && (ascending != 1)) // Invalid input!
+    {
+        return;
+    }
+    
+    llist_sort_with (list, compare_names, &ascending);
+}
+
+//
+// Like llist_sort, by value.
+//
+void llist_sort_by_value (LINKED_LIST* list, int ascending)
+{
+    if ((ascending != 0) && (ascending != 1)) // Invalid input!
+    {
+        return;
+    }
+    
+    llist_sort_with (list, compare_values, &ascending);
+}
+
+//
+// It removes the first entry in the list, in O(1).
+// All entries are moved down one position.
+// It also frees memory allocated for name and value.
+//
+int llist_remove_first (LINKED_LIST* list) 
+{
+	if (list->nElements > 0)
+    {
+        remove_entry (list, (list->head)->next);
+        
+        return SUCCESS;
+    }
+    
+    // If reached this point, no elements to remove
+    return FAILURE;
+}
+
+//
+// It removes the last entry in the list, in O(1) through head->previous.
+// It also frees memory allocated for name and value.
+//
+int llist_remove_last (LINKED_LIST* list) 
+{
+	if (list->nElements > 0)
+    {
+        remove_entry (list, (list->head)->previous);
+        
+        return SUCCESS;
+    }
+    
+    // If reached this point, no elements to remove
+    return FAILURE;
+}
+
+//
+// Insert a name/value pair at the beginning of the list.
+// There is no check if the name already exists. The entry is added
+// at the beginning of the list.
+//
+int llist_insert_first (LINKED_LIST* list, char* name, char* value)
+{
+    LINKED_LIST_ENTRY* node = new_node (list, name, value);
+    if (node == NULL)
+    {
+        return FAILURE;
+    }
+    
+    if (index_node (list, node, 1) == FAILURE)
+    {
+        delete_node (list, node);
+        return FAILURE;
+    }
+    
+    count_entry (list, node, 1);
+    
+    // Update list pointers
+    node->next = (list->head)->next;
+    node->previous = (list->head);
+    (node->next)->previous = node;
+    (node->previous)->next = node;
+    
+    // Update nElements
+    list->nElements ++;
+    
+	return 0;
+}
+
+//
+// Insert a name/value pair at the end of the list.
+// There is no check if the name already exists. The entry is added
+// at the end of the list.
+//
+int llist_insert_last (LINKED_LIST* list, char* name, char* value) 
+{
+    // Allocate memory for a new node.
+    LINKED_LIST_ENTRY* node = new_node (list, name, value);
+    if (node == NULL)
+    {
+        return FAILURE;
+    }
+    
+    if (link_last (list, node) == FAILURE)
+    {
+        delete_node (list, node);
+        return FAILURE;
+    }
+    
+    return SUCCESS;
+}
+
+//
+// Insert a name/value pair so that it becomes the entry at position ith, from 0 to
+// nElements. There is no check if the name already exists. Finding the position walks ith
+// nodes. It will return 1 if successful, or 0 if ith is out of bounds or memory runs out.
+//
+int llist_insert_ith (LINKED_LIST* list, int ith, char* name, char* value)
+{
+    LINKED_LIST_ENTRY* at = (list->head)->next; // The new node goes before it
+    void* found = NULL;
+    int before = 1; // No node with that name precedes the new one
+    int i; // List index
+    
+    if ((ith < 0) || (ith > list->nElements))
+    {
+        return FAILURE;
+    }
+    
+    if (list->index != NULL)
+    {
+        hmap_get (list->index, name, &found);
+    }
+    
+    for (i = 0; i < ith; i ++)
+    {
+        if (at == found)
+        {
+            before = 0;
+        }
+        
+        at = at->next;
+    }
+    
+    LINKED_LIST_ENTRY* node = new_node (list, name, value);
+    if (node == NULL)
+    {
+        return FAILURE;
+    }
+    
+    if (index_node (list, node, before) == FAILURE)
+    {
+        delete_node (list, node);
+        return FAILURE;
+    }
+    
+    count_entry (list, node, 1);
+    
+    node->next = at;
+    node->previous = at->previous;
+    (at->previous)->next = node;
+    at->previous = node;
+    
+    list->nElements ++;
+    
+    return SUCCESS;
+}
+
+//
+// It merges src into dest in O(N + M), with one temporary hash table over the names of
+// dest. Names only in src are added at the end of dest. For a name in both lists, dest
+// keeps a copy of the value returned by resolve, or of the value in src if resolve is NULL
+// (last writer wins). It will return 1 if successful, or 0 if memory runs out.
+//
+int llist_merge (LINKED_LIST* dest, LINKED_LIST* src, LLIST_MERGE_FUNC resolve, void* context)
+{
+    void* found;
+    
+    HASH_MAP* map = map_names (dest);
+    if (map == NULL)
+    {
+        return FAILURE;
+    }
+    
+    LINKED_LIST_ENTRY* node = (src->head)->next;
+    
+    while (node != src->head)
+    {
+        uint64_t hash = hmap_hash (node->name);
+        
+        if (hmap_get_hashed (map, node->name, hash, &found))
+        {
+            LINKED_LIST_ENTRY* destNode = found;
+            char* value = (resolve != NULL) ? resolve (node->name, destNode->value, node->value, context) : node->value;
+            
+            if ((value != destNode->value) && (replace_value (dest, destNode, value) == FAILURE))
+            {
+                hmap_free (map);
+                return FAILURE;
+            }
+        }
+        
+        else if ((llist_insert_last (dest, node->name, node->value) == FAILURE) ||
+                 (hmap_put_hashed (map, ((dest->head)->previous)->name, hash, (dest->head)->previous) == FAILURE))
+        {
+            hmap_free (map);
+            return FAILURE;
+        }
+        
+        node = node->next;
+    }
+    
+    hmap_free (map);
+    return SUCCESS;
+}
+
+//
+// It reports through report every name added, removed or changed from oldList to newList,
+// in O(N + M), with one temporary hash table over the names of oldList. Changes and
+// additions come in the order of newList, then removals in the order of oldList.
+// It will return 1 if successful, or 0 if memory runs out.
+//
+int llist_diff (LINKED_LIST* oldList, LINKED_LIST* newList, LLIST_DIFF_FUNC report, void* context)
+{
+    void* found;
+    
+    HASH_MAP* map = map_names (oldList);
+    if (map == NULL)
+    {
+        return FAILURE;
+    }
+    
+    // Names of newList that oldList also has
+    HASH_MAP* seen = hmap_create ((size_t) oldList->nElements);
+    if (seen == NULL)
+    {
+        hmap_free (map);
+        return FAILURE;
+    }
+    
+    LINKED_LIST_ENTRY* node = (newList->head)->next;
+    
+    while (node != newList->head)
+    {
+        uint64_t hash = hmap_hash (node->name);
+        
+        if (!hmap_get_hashed (map, node->name, hash, &found))
+        {
+            report (LLIST_DIFF_ADDED, node->name, NULL, node->value, context);
+        }
+        
+        else
+        {
+            LINKED_LIST_ENTRY* oldNode = found;
+            
+            if (hmap_put_hashed (seen, oldNode->name, hash, oldNode) == FAILURE)
+            {
+                hmap_free (seen);
+                hmap_free (map);
+                return FAILURE;
+            }
+            
+            if (strcmp (oldNode->value, node->value) != 0)
+            {
+                report (LLIST_DIFF_CHANGED, node->name, oldNode->value, node->value, context);
+            }
+        }
+        
+        node = node->next;
+    }
+    
+    node = (oldList->head)->next;
+    
+    while (node != oldList->head)
+    {
+        // Only the first node of a name is in map; the others are covered by it
+        if ((!hmap_get (seen, node->name, &found)) && hmap_get (map, node->name, &found) && (found == node))
+        {
+            report (LLIST_DIFF_REMOVED, node->name, node->value, NULL, context);
+        }
+        
+        node = node->next;
+    }
+    
+    hmap_free (seen);
+    hmap_free (map);
+    return SUCCESS;
+}
+
+//
+// It calls emit with every pair of entries, one from left and one from right, that have
+// the same name, in O(N + M) with one temporary hash table over left. The pairs come in
+// the order of right. It will return 1 if successful, or 0 if memory runs out.
+//
+int llist_join (LINKED_LIST* left, LINKED_LIST* right, LLIST_JOIN_FUNC emit, void* context)
+{
+    int i; // Index of a node of left
+    size_t k;
+    void* found;
+    
+    // The map gives the index + 1 of the first node of a name, and next chains the others
+    HASH_MAP* map = hmap_create ((size_t) left->nElements);
+    LINKED_LIST_ENTRY** nodes = malloc ((left->nElements + 1) * sizeof (LINKED_LIST_ENTRY*));
+    size_t* next = malloc ((left->nElements + 1) * sizeof (size_t));
+    
+    if ((map == NULL) || (nodes == NULL) || (next == NULL))
+    {
+        if (map != NULL)
+        {
+            hmap_free (map);
+        }
+        
+        free (nodes);
+        free (next);
+        return FAILURE;
+    }
+    
+    LINKED_LIST_ENTRY* node = (left->head)->previous;
+    
+    for (i = left->nElements - 1; i >= 0; i --) // Backwards, so that each chain runs in list order
+    {
+        uint64_t hash = hmap_hash (node->name);
+        
+        nodes[i] = node;
+        next[i] = hmap_get_hashed (map, node->name, hash, &found) ? (size_t) found : 0;
+        
+        if (hmap_put_hashed (map, node->name, hash, (void*) (size_t) (i + 1)) == FAILURE)
+        {
+            hmap_free (map);
+            free (nodes);
+            free (next);
+            return FAILURE;
+        }
+        
+        node = node->previous;
+    }
+    
+    node = (right->head)->next;
+    
+    while (node != right->head)
+    {
+        if (hmap_get (map, node->name, &found))
+        {
+            for (k = (size_t) found; k != 0; k = next[k - 1])
+            {
+                emit (node->name, nodes[k - 1]->value, node->value, context);
+            }
+        }
+        
+        node = node->next;
+    }
+    
+    hmap_free (map);
+    free (nodes);
+    free (next);
+    return SUCCESS;
+}
+
+//
+// It starts a walk over the entries of the list in cursor, which the caller provides.
+// Every llist_cursor_next call returns the next entry in O(1), where llist_get_ith would
+// walk the list from the start. Entries removed during the walk are skipped if they were
+// not reached yet, and entries inserted at the end are returned. A sort during the walk
+// continues from the entry reached in the new order. A cursor that is not walked to the
+// end has to be ended with llist_cursor_end.
+//
+void llist_cursor_begin (LINKED_LIST* list, LLIST_CURSOR* cursor)
+{
+    cursor->list = list;
+    cursor->next = (list->head)->next;
+    cursor->current = NULL;
+    cursor->nextCursor = list->cursors;
+    list->cursors = cursor;
+}
+
+//
+// It returns in *name and *value the next entry of the walk. It will return 1 if
+// successful, or 0 at the end of the list, which also ends the walk.
+//
+int llist_cursor_next (LLIST_CURSOR* cursor, char** name, char** value)
+{
+    if (cursor->list == NULL) // The walk is over
+    {
+        return FAILURE;
+    }
+    
+    if (cursor->next == (cursor->list)->head)
+    {
+        llist_cursor_end (cursor);
+        return FAILURE;
+    }
+    
+    cursor->current = cursor->next;
+    cursor->next = (cursor->next)->next;
+    
+    *name = (cursor->current)->name;
+    *value = (cursor->current)->value;
+    
+    return SUCCESS;
+}
+
+//
+// It returns in *name and *value the entry llist_cursor_next returned last. It will return
+// 1 if successful, or 0 if that entry has been removed or the walk is over.
+//
+int llist_cursor_get (LLIST_CURSOR* cursor, char** name, char** value)
+{
+    if (cursor->current == NULL)
+    {
+        return FAILURE;
+    }
+    
+    *name = (cursor->current)->name;
+    *value = (cursor->current)->value;
+    
+    return SUCCESS;
+}
+
+//
+// It removes the entry llist_cursor_next returned last and frees its name and value. The
+// next llist_cursor_next call returns the entry that followed it. It will return 1 if
+// successful, or 0 if there is no such entry.
+//
+int llist_cursor_erase (LLIST_CURSOR* cursor)
+{
+    if (cursor->current == NULL)
+    {
+        return FAILURE;
+    }
+    
+    remove_entry (cursor->list, cursor->current);
+    
+    return SUCCESS;
+}
+
+//
+// It ends the walk of cursor before it reaches the end of the list. It does nothing if
+// the walk is already over.
+//
+void llist_cursor_end (LLIST_CURSOR* cursor)
+{
+    LLIST_CURSOR** link;
+    
+    if (cursor->list == NULL)
+    {
+        return;
+    }
+    
+    for (link = &((cursor->list)->cursors); *link != NULL; link = &((*link)->nextCursor))
+    {
+        if (*link == cursor)
+        {
+            *link = cursor->nextCursor;
+            break;
+        }
+    }
+    
+    cursor->list = NULL;
+    cursor->current = NULL;
+}
+
+/* Returns 1 if node is one of the nodes from first to the end of the list. */
+static int in_tail (LINKED_LIST* list, LINKED_LIST_ENTRY* first, LINKED_LIST_ENTRY* node)
+{
+    for (; first != list->head; first = first->next)
+    {
+        if (first == node)
+        {
+            return 1;
+        }
+    }
+    
+    return 0;
+}
+
+/* Adds the nodes from first to the end of src, about to be linked into dest before the node before, to the name index of dest. A name the index has already keeps its node, and *refill is set if the nodes may go before it. It will return 1 if successful, or 0 if memory runs out, with the index as it was. */
+static int index_tail (LINKED_LIST* dest, LINKED_LIST_ENTRY* before, LINKED_LIST* src, LINKED_LIST_ENTRY* first, int* refill)
+{
+    LINKED_LIST_ENTRY* node;
+    void* found;
+    
+    for (node = first; node != src->head; node = node->next)
+    {
+        if (hmap_get (dest->index, node->name, &found))
+        {
+            *refill |= (before != dest->head);
+        }
+        else if (hmap_put (dest->index, node->name, node) == FAILURE)
+        {
+            for (; first != node; first = first->next)
+            {
+                if (hmap_get (dest->index, first->name, &found) && (found == first))
+                {
+                    hmap_remove (dest->index, first->name);
+                }
+            }
+            
+            return FAILURE;
+        }
+    }
+    
+    return SUCCESS;
+}
+
+/* Moves every cursor of src whose next entry is among the moved nodes, from first to the end of src, over to dest, but for stay, which ends up at the end of src. A cursor loses its current entry if that entry is not in its list any more. */
+static void move_cursors (LINKED_LIST* dest, LINKED_LIST* src, LINKED_LIST_ENTRY* first, LLIST_CURSOR* stay)
+{
+    LLIST_CURSOR** link = &(src->cursors);
+    int whole = (first == (src->head)->next);
+    
+    while (*link != NULL)
+    {
+        LLIST_CURSOR* cursor = *link;
+        int moves = (cursor != stay) && (whole ? (cursor->next != src->head) : in_tail (src, first, cursor->next));
+        int currentMoves = (cursor->current != NULL) && (whole || in_tail (src, first, cursor->current));
+        
+        if (moves != currentMoves)
+        {
+            cursor->current = NULL;
+        }
+        
+        if (!moves)
+        {
+            if (cursor == stay)
+            {
+                cursor->next = src->head;
+            }
+            
+            link = &(cursor->nextCursor);
+            continue;
+        }
+        
+        *link = cursor->nextCursor;
+        cursor->list = dest;
+        cursor->nextCursor = dest->cursors;
+        dest->cursors = cursor;
+    }
+}
+
+/* Moves the nodes from first to the end of src into dest, before the node before, without copying them. Moving the whole of src takes O(1), and with it the counters of llist_stats. A part of src has its nodes counted again, one by one. Cursors on the moved nodes go with them, but for stay. It will return 1 if successful, or 0 if memory runs out, with both lists as they were. */
+static int move_tail (LINKED_LIST* dest, LINKED_LIST_ENTRY* before, LINKED_LIST* src, LINKED_LIST_ENTRY* first, LLIST_CURSOR* stay)
+{
+    LINKED_LIST_ENTRY* last = (src->head)->previous;
+    LINKED_LIST_ENTRY* node;
+    int whole = (first == (src->head)->next);
+    int refill = 0; // The name index of dest needs to be filled again
+    int count = 0;
+    int i; // Key length bucket
+    void* found;
+    
+    if (first == src->head) // Nothing to move
+    {
+        return SUCCESS;
+    }
+    
+    if ((dest->index != NULL) && (index_tail (dest, before, src, first, &refill) == FAILURE))
+    {
+        return FAILURE;
+    }
+    
+    move_cursors (dest, src, first, stay);
     
-    while (node != list->head)
+    if (whole)
     {
-        if (i == ith)
+        count = src->nElements;
+        dest->nameBytes += src->nameBytes;
+        dest->valueBytes += src->valueBytes;
+        dest->stringOverhead += src->stringOverhead;
+        src->nameBytes = 0;
+        src->valueBytes = 0;
+        src->stringOverhead = 0;
+        
+        for (i = 0; i < LLIST_KEY_LENGTH_BUCKETS; i ++)
         {
-            *name = node->name;
-            *value = node->value;
-            
-            return SUCCESS;
+            dest->keyLengths[i] += src->keyLengths[i];
+            src->keyLengths[i] = 0;
         }
         
-        node = node->next;
-        i ++;
+        if (src->index != NULL)
+        {
+            hmap_clear (src->index);
+        }
     }
-    
-    // At this point, ith entry was out of bounds
-	return FAILURE;
-}
-
-//
-// It removes the ith entry from the list.
-// Also the name/value strings are freed.
-//
-int llist_remove_ith (LINKED_LIST* list, int ith)
-{
-	int i = 0; // List index
-
-	LINKED_LIST_ENTRY* node = (list->head)->next; // Ensures you never remove dummy head node.
-    
-    while (node != list->head)
+    else
     {
-        if (i == ith)
+        for (node = first; node != src->head; node = node->next)
         {
-            // Update list pointers
-            (node->previous)->next = node->next;
-            (node->next)->previous = node->previous;
-            
-            free (node->name);
-            free (node->value);
-            free (node);
-            
-            // Update nElements
-            list->nElements --;
+            count_entry (src, node, 0);
+            count_entry (dest, node, 1);
+            count ++;
             
-            return SUCCESS;
+            // Nodes before the tail come first, so the index of src has a moved node only
+            // for the names that are in the tail alone
+            if ((src->index != NULL) && hmap_get (src->index, node->name, &found) && (found == node))
+            {
+                hmap_remove (src->index, node->name);
+            }
         }
-        
-        node = node->next;
-        i ++;
     }
     
-    // At this point, ith entry was out of bounds
-	return FAILURE;
+    // Cut the tail out of src
+    (first->previous)->next = src->head;
+    (src->head)->previous = first->previous;
+    
+    // And link it in before before
+    first->previous = before->previous;
+    (before->previous)->next = first;
+    last->next = before;
+    before->previous = last;
+    
+    src->nElements -= count;
+    dest->nElements += count;
+    
+    // A repeated name may have a new first node. The map already has a slot for every name.
+    if (refill)
+    {
+        hmap_clear (dest->index);
+        fill_map (dest, dest->index);
+    }
+    
+    return SUCCESS;
 }
 
-//
-// It returns the number of elements in the list.
-//
-int llist_number_elements (LINKED_LIST* list) 
+/* Returns 1 if nodes can move from src to dest: two lists that allocate their nodes the same way, with no pool, which owns the nodes of one list. */
+static int can_move (LINKED_LIST* dest, LINKED_LIST* src)
 {
-	return list->nElements;
+    return (dest != src) && (dest->pool == NULL) && (src->pool == NULL) && (dest->inlineStrings == src->inlineStrings);
 }
 
 //
-// It saves the list in a file called file_name. The format of the
-// file is as follows:
-//
-// name1\n
-// value1\n
-// \n
-// name2\n
-// value2\n
-// ...
+// It moves every entry of src into dest, before the entry at position ith, or at the end
+// if ith is the number of elements of dest. The nodes are relinked, not copied, so src is
+// left empty in O(1) plus the walk to position ith from the nearer end of dest. Cursors on
+// the moved entries go on walking them in dest. A name index of dest is kept up to date
+// with one probe per moved entry, or filled again when a name moved in front of the
+// same name in dest.
 //
-// Notice that there is an empty line between each name/value pair.
+// The two lists must be different, have no pool and both have inline strings or not.
+// It will return 1 if successful, or 0 if not or if memory runs out, with both lists as
+// they were.
 //
-int llist_save (LINKED_LIST* list, char* file_name)
+int llist_splice (LINKED_LIST* dest, int ith, LINKED_LIST* src)
 {
-    FILE* fout = fopen (file_name, WRITE_MODE);
-    if (fout == NULL) // fopen failed
+    LINKED_LIST_ENTRY* before;
+    
+    if (!can_move (dest, src) || (ith < 0) || (ith > dest->nElements))
     {
         return FAILURE;
     }
     
-    LINKED_LIST_ENTRY* node = (list->head)->next;
+    before = (ith == dest->nElements) ? dest->head : nth_node (dest, ith);
     
-    while (node != list->head)
-    {
-        fprintf (fout, "%s\n", node->name);
-        fprintf (fout, "%s\n\n", node->value);
-        
-        node = node->next;
-    }
+    return move_tail (dest, before, src, (src->head)->next, NULL);
+}
 
-	fclose (fout);
-    
-	return SUCCESS;
+//
+// It moves every entry of src to the end of dest, like llist_splice, in O(1). This is how
+// lists built by different threads are merged into one.
+//
+int llist_concat (LINKED_LIST* dest, LINKED_LIST* src)
+{
+    return llist_splice (dest, dest->nElements, src);
 }
 
-/* Removes newline character from the end of input strings. */
-void sanitise (char* str)
+//
+// It moves the entries of the list of cursor that the walk has not reached yet, from the
+// one the next llist_cursor_next would return to the end, to the end of dest. The walk of
+// cursor is then at the end of its list. The nodes are relinked, not copied, in O(k) for k
+// entries moved, which are counted again for llist_stats. The lists must be as for
+// llist_splice. It will return 1 if successful, or 0 if not, if the walk is over or if
+// memory runs out.
+//
+int llist_split_at_cursor (LLIST_CURSOR* cursor, LINKED_LIST* dest)
 {
-    int len = strlen (str);
-    
-    if (str[len - 1] == NEWLINE)
+    if ((cursor->list == NULL) || !can_move (dest, cursor->list))
     {
-        str[len - 1] = TERMINATING_NULL_BYTE;
+        return FAILURE;
     }
+    
+    return move_tail (dest, dest->head, cursor->list, cursor->next, cursor);
 }
 
 //
-// It reads the list from the file_name indicated. If the list already has entries, it will
-// clear the entries.
+// It fills stats with the memory used by the list in O(1), from counters that every
+// change of the list keeps up to date. With a pool it also looks at every slab.
 //
-int llist_read (LINKED_LIST* list, char* file_name)
+void llist_stats (LINKED_LIST* list, LLIST_STATS* stats)
 {
-    int i; // List index
-	char line[MAXLINE + 1]; // Temporary buffer to store name/value read in from file
-    char* name = NULL; // Temporarily store input name
-    char* value = NULL; // Temporarily store input value 
+    size_t nEntries = (size_t) list->nElements + 1; // With the head
     
-    FILE* fin = fopen (file_name, READ_MODE);
-    if (fin == NULL) // fopen failed
-    {
-        return FAILURE;
-    }
+    stats->entries = list->nElements;
+    stats->entryBytes = nEntries * sizeof (LINKED_LIST_ENTRY);
+    stats->nameBytes = list->nameBytes;
+    stats->valueBytes = list->valueBytes;
+    stats->overheadBytes = list->stringOverhead + nEntries * malloc_overhead (sizeof (LINKED_LIST_ENTRY));
     
-    if (list->nElements > 0) // List already has elements
+    if (list->inlineStrings) // The node blocks are counted with their strings
     {
-        for (i = 0; i < list->nElements; i ++)
-        {
-            llist_remove_ith (list, i);
-        }
+        stats->entryBytes = list->nElements * sizeof (LLIST_INLINE_ENTRY) + sizeof (LINKED_LIST_ENTRY);
+        stats->overheadBytes = list->stringOverhead + malloc_overhead (sizeof (LINKED_LIST_ENTRY));
     }
     
-    while (fgets(line, MAXLINE + 1, fin) != NULL) // Read in name
+    if (list->pool != NULL) // One malloc per slab, and the head
     {
-        // Remove newline character at the end of input string
-        sanitise (line);
+        stats->entryBytes = (list->pool->totalNodes + 1) * sizeof (LINKED_LIST_ENTRY) + list->pool->nSlabs * sizeof (LLIST_SLAB);
+        stats->overheadBytes = list->stringOverhead + malloc_overhead (sizeof (LINKED_LIST_ENTRY));
         
-        name = strdup (line);
-        
-        // Read in value
-        if (fgets(line, MAXLINE + 1, fin) == NULL)
-        {
-            fclose (fin);
-            return FAILURE;
-        }
-        
-        // Remove newline character at the end of input string
-        sanitise (line);
-        
-        value = strdup (line);
-        
-        // Read in empty line separating name/value pairs
-        if (fgets(line, MAXLINE + 1, fin) == NULL)
+        for (LLIST_SLAB* slab = list->pool->slabs; slab != NULL; slab = slab->next)
         {
-            fclose (fin);
-            return FAILURE;
+            stats->overheadBytes += malloc_overhead (sizeof (LLIST_SLAB) + slab->nNodes * sizeof (LINKED_LIST_ENTRY));
         }
-        
-        if (llist_add (list, name, value) == FAILURE)
-        {
-            return FAILURE;
-        }        
     }
     
-    fclose (fin);
-    return SUCCESS;
+    stats->indexBytes = (list->index != NULL) ? sizeof (HASH_MAP) + list->index->nSlots * sizeof (HASH_MAP_SLOT) : 0;
+    stats->meanKeyLength = (list->nElements > 0) ? (double) (list->nameBytes - list->nElements) / list->nElements : 0;
+    memcpy (stats->keyLengths, list->keyLengths, sizeof (stats->keyLengths));
 }
 
-// Causes qsort to sort names in ascending order
-int nameSortAsc (const void* namePtr1, const void* namePtr2)
+//
+// It builds a hash index over the names, so that llist_add, llist_lookup and llist_remove
+// cost O(1) instead of a walk of the list, and llist_read becomes linear. Every insertion,
+// removal and sort keeps it up to date; the order of the list does not change. A name that
+// is in the list more than once is indexed by its first node, which is the one the walks
+// would find. It will return 1 if successful, or 0 if memory runs out.
+//
+int llist_index_names (LINKED_LIST* list)
 {
-    char* name1 = *((char**) namePtr1);
-    char* name2 = *((char**) namePtr2);
+    if (list->index != NULL)
+    {
+        return SUCCESS;
+    }
     
-    return strcmp (name1, name2);
-}
-
-// Causes qsort to sort names in descending order
-int nameSortDesc (const void* namePtr1, const void* namePtr2)
-{
-    return nameSortAsc (namePtr2, namePtr1);
+    list->index = map_names (list);
+    
+    return (list->index != NULL) ? SUCCESS : FAILURE;
 }
 
 //
-// It sorts the list according to the name. The parameter ascending determines if the
-// order is ascending (1) or descending(0).
+// It frees the name index, if the list has one.
 //
-void llist_sort (LINKED_LIST* list, int ascending)
+void llist_drop_index (LINKED_LIST* list)
 {
-    if ((ascending != 0) && (ascending != 1)) // Invalid input!
+    if (list->index != NULL)
     {
-        return;
+        hmap_free (list->index);
+        list->index = NULL;
     }
+}
+
+/* Moves every node, in list order, into one new slab of the pool, so that a walk reads memory
+sequentially. The old nodes are freed with free if they came from malloc (fromMalloc is 1),
+or else with the old slabs. The cursors and the name index follow their nodes. */
+static int relocate (LINKED_LIST* list, int fromMalloc)
+{
+    LLIST_POOL* pool = list->pool;
+    LLIST_SLAB* oldSlabs = pool->slabs;
+    LINKED_LIST_ENTRY* head = list->head;
+    LINKED_LIST_ENTRY* node;
+    LINKED_LIST_ENTRY* next;
+    LLIST_CURSOR* cursor;
+    size_t n = (size_t) list->nElements;
+    size_t i; // Node index
     
-    int i = 0; // Array index
-    
-    char* names[list->nElements]; // Store only the names.
-    
-    LINKED_LIST_ENTRY* node = (list->head)->next;
+    LLIST_SLAB* slab = malloc (sizeof (LLIST_SLAB) + n * sizeof (LINKED_LIST_ENTRY));
+    if (slab == NULL)
+    {
+        return FAILURE;
+    }
     
-    // Create new list to store entries of original list, in sorted order.
-    LINKED_LIST* sortedList = llist_create ();
+    slab->nNodes = n;
+    slab->next = NULL;
     
-    while (node != list->head)
+    // The previous field of every old node is free for a forwarding pointer to its copy
+    for (node = head->next, i = 0; node != head; node = node->next, i ++)
     {
-        names[i] = node->name;
-        
-        node = node->next;
-        i ++;
+        slab->nodes[i].name = node->name;
+        slab->nodes[i].value = node->value;
+        slab->nodes[i].previous = (i > 0) ? &(slab->nodes[i - 1]) : head;
+        slab->nodes[i].next = (i + 1 < n) ? &(slab->nodes[i + 1]) : head;
+        node->previous = &(slab->nodes[i]);
     }
     
-    if (ascending == 1)
+    for (cursor = list->cursors; cursor != NULL; cursor = cursor->nextCursor)
     {
-        qsort (names, list->nElements, sizeof (char*), nameSortAsc);
+        if (cursor->next != head)
+        {
+            cursor->next = (cursor->next)->previous;
+        }
+        
+        if (cursor->current != NULL)
+        {
+            cursor->current = (cursor->current)->previous;
+        }
     }
     
-    else
+    // The old nodes are still chained through next
+    for (node = head->next; fromMalloc && (node != head); node = next)
     {
-        qsort (names, list->nElements, sizeof (char*), nameSortDesc);
+        next = node->next;
+        free (node);
     }
     
-    // Array 'names' is now sorted.
-    
-    // Transfer entries from original list to new list, in sorted order
-    for (i = 0; i < list->nElements; i ++)
+    while (oldSlabs != NULL)
     {
-        // Reset original node pointer to point to first node (after dummy head node) in original list
-        node = (list->head)->next;
+        LLIST_SLAB* nextSlab = oldSlabs->next;
         
-        while (node != list->head)
-        {
-            if (node->name == names[i]) // Comparing addresses
-            {
-                // Decouple node from original list, without actually freeing any memory
-                (node->previous)->next = node->next;
-                (node->next)->previous = node->previous;
-                
-                // Attach node to (end of) new list, without actually allocating any memory
-                ((sortedList->head)->previous)->next = node;
-                node->previous = (sortedList->head)->previous;
-                ((sortedList->head)->previous) = node;
-                node->next = sortedList->head;
-                
-                break;
-            }
-            
-            node = node->next; // Advance to next node in original list
-        }
+        free (oldSlabs);
+        oldSlabs = nextSlab;
     }
     
-    // Completely free old list->head. list still exists, so list->nElements is unaffected.
-    free (list->head);
+    head->next = (n > 0) ? &(slab->nodes[0]) : head;
+    head->previous = (n > 0) ? &(slab->nodes[n - 1]) : head;
+    
+    pool->slabs = slab;
+    pool->freeNodes = NULL;
+    pool->nSlabs = 1;
+    pool->totalNodes = n;
     
-    /* Caller has only given us a COPY of LINKED_LIST pointer 'list', and expects that pointer to still be valid after this function is done. Thus, cannot free 'list' and cannot redirect 'list' to point to 'sortedList'. Instead, redirect 'list->head' to point to 'sortedList->head' and free 'sortedList'. */
+    // The names did not move, so the map keeps its keys and only needs the new nodes
+    if (list->index != NULL)
+    {
+        hmap_clear (list->index);
+        fill_map (list, list->index);
+    }
     
-    list->head = sortedList->head;
-    free (sortedList);
+    return SUCCESS;
 }
 
 //
-// It removes the first entry in the list.
-// All entries are moved down one position.
-// It also frees memory allocated for name and value.
+// It makes the list allocate its nodes from slabs of slabNodes nodes (LLIST_POOL_SLAB_NODES
+// if 0) with a free list, instead of one malloc per node. The nodes the list already has
+// move into one slab, in list order. Removed nodes go back to the free list, and only
+// llist_compact gives memory back. It will return 1 if successful, or 0 if memory runs out
+// or the list has inline strings.
 //
-int llist_remove_first (LINKED_LIST* list) 
+int llist_use_pool (LINKED_LIST* list, size_t slabNodes)
 {
-	return llist_remove_ith (list, 0);
+    if (list->pool != NULL)
+    {
+        return SUCCESS;
+    }
+    
+    if (list->inlineStrings) // Its nodes are not all of one size
+    {
+        return FAILURE;
+    }
+    
+    list->pool = calloc (1, sizeof (LLIST_POOL));
+    if (list->pool == NULL)
+    {
+        return FAILURE;
+    }
+    
+    list->pool->slabNodes = (slabNodes > 0) ? slabNodes : LLIST_POOL_SLAB_NODES;
+    
+    if (relocate (list, 1) == FAILURE)
+    {
+        free (list->pool);
+        list->pool = NULL;
+        return FAILURE;
+    }
+    
+    return SUCCESS;
 }
 
 //
-// It removes the last entry in the list
-// It also frees memory allocated for name and value.
+// It moves the nodes of a list that uses a pool into one slab, in list order, and frees
+// the old slabs with their free nodes. After many insertions and removals the nodes are
+// scattered over the slabs; compacted, a walk of the list reads memory in order.
+// It will return 1 if successful, or 0 if the list has no pool or memory runs out.
 //
-int llist_remove_last (LINKED_LIST* list) 
+int llist_compact (LINKED_LIST* list)
 {
-	if (list->nElements > 0)
+    if (list->pool == NULL)
     {
-        return llist_remove_ith (list, list->nElements - 1);
+        return FAILURE;
     }
     
-    // If reached this point, no elements to remove
-    return FAILURE;
+    return relocate (list, 0);
 }
 
 //
-// Insert a name/value pair at the beginning of the list.
-// There is no check if the name already exists. The entry is added
-// at the beginning of the list.
+// It makes every node of an empty list one allocation that holds the node, its name and its
+// value, instead of three. A walk that compares names then touches one cache line per node
+// instead of two, and an insertion or removal calls malloc and free once. A new value that
+// fits where the old one was overwrites it in place; a longer one gets an allocation of its
+// own. It will return 1 if successful, or 0 if the list is not empty or has a pool.
 //
-int llist_insert_first (LINKED_LIST* list, char* name, char* value)
+int llist_use_inline_strings (LINKED_LIST* list)
 {
-    LINKED_LIST_ENTRY* node = malloc (sizeof (LINKED_LIST_ENTRY));
-    if (node == NULL)
+    if ((list->nElements > 0) || (list->pool != NULL))
     {
         return FAILURE;
     }
     
-    node->name = strdup (name);
-    node->value = strdup (value);
+    list->inlineStrings = 1;
     
-    // Update list pointers
-    node->next = (list->head)->next;
-    node->previous = (list->head);
-    (node->next)->previous = node;
-    (node->previous)->next = node;
+    return SUCCESS;
+}
+
+/* The functions of llist_kv_ops and its variants. */
+static void* kv_list_create ()
+{
+    return llist_create ();
+}
+
+static void* kv_list_create_inline ()
+{
+    LINKED_LIST* list = llist_create ();
     
-    // Update nElements
-    list->nElements ++;
+    if (list != NULL)
+    {
+        llist_use_inline_strings (list); // Cannot fail on a new list
+    }
     
-	return 0;
+    return list;
 }
 
-//
-// Insert a name/value pair at the end of the list.
-// There is no check if the name already exists. The entry is added
-// at the end of the list.
-//
-int llist_insert_last (LINKED_LIST* list, char* name, char* value) 
+static void* kv_list_create_indexed ()
 {
-    // Allocate memory for a new node.
-    LINKED_LIST_ENTRY* node = malloc (sizeof (LINKED_LIST_ENTRY));
-    if (node == NULL)
+    LINKED_LIST* list = llist_create ();
+    
+    if ((list != NULL) && (llist_index_names (list) == FAILURE))
     {
-        return FAILURE;
+        free (list->head);
+        free (list);
+        return NULL;
     }
     
-    node->name = strdup (name);
-    node->value = strdup (value);
+    return list;
+}
+
+static void kv_list_clear (void* store)
+{
+    llist_clear ((LINKED_LIST*) store);
+}
+
+static void kv_list_destroy (void* store)
+{
+    llist_destroy ((LINKED_LIST*) store);
+}
+
+static int kv_list_add (void* store, char* name, char* value)
+{
+    return llist_add ((LINKED_LIST*) store, name, value);
+}
+
+static char* kv_list_lookup (void* store, char* name)
+{
+    return llist_lookup ((LINKED_LIST*) store, name);
+}
+
+static int kv_list_remove (void* store, char* name)
+{
+    return llist_remove ((LINKED_LIST*) store, name);
+}
+
+static size_t kv_list_count (void* store)
+{
+    return (size_t) llist_number_elements ((LINKED_LIST*) store);
+}
+
+static int kv_list_get_ith (void* store, size_t ith, char** name, char** value)
+{
+    LINKED_LIST* list = store;
     
-    // Update list pointers
-    ((list->head)->previous)->next = node;
-    node->previous = (list->head)->previous;
-    ((list->head)->previous) = node;
-    node->next = list->head;
+    if (ith >= (size_t) list->nElements)
+    {
+        return FAILURE;
+    }
     
-    // Update nElements only if actually adding a new element.
-    list->nElements ++;
+    return llist_get_ith (list, (int) ith, name, value);
+}
+
+/* llist_insert_first returns 0 either way, so success shows in the number of elements. */
+static int kv_list_insert_first (void* store, char* name, char* value)
+{
+    LINKED_LIST* list = store;
+    int nElements = list->nElements;
     
-    return SUCCESS;
-}
\ No newline at end of file
+    llist_insert_first (list, name, value);
+    
+    return (list->nElements > nElements) ? SUCCESS : FAILURE;
+}
+
+static int kv_list_insert_last (void* store, char* name, char* value)
+{
+    return llist_insert_last ((LINKED_LIST*) store, name, value);
+}
+
+static void kv_list_sort (void* store, int ascending)
+{
+    llist_sort ((LINKED_LIST*) store, ascending);
+}
+
+static int kv_list_save (void* store, char* file_name)
+{
+    return llist_save ((LINKED_LIST*) store, file_name);
+}
+
+static int kv_list_read (void* store, char* file_name)
+{
+    return llist_read ((LINKED_LIST*) store, file_name);
+}
+
+const KV_STORE_OPS llist_kv_ops =
+{
+    "llist", kv_list_create, kv_list_destroy, kv_list_add, kv_list_lookup, kv_list_remove, kv_list_count, kv_list_get_ith,
+    kv_list_insert_first, kv_list_insert_last, kv_list_sort, kv_list_clear, kv_list_save, kv_list_read
+};
+
+const KV_STORE_OPS llist_indexed_kv_ops =
+{
+    "llist_indexed", kv_list_create_indexed, kv_list_destroy, kv_list_add, kv_list_lookup, kv_list_remove, kv_list_count, kv_list_get_ith,
+    kv_list_insert_first, kv_list_insert_last, kv_list_sort, kv_list_clear, kv_list_save, kv_list_read
+};
+
+const KV_STORE_OPS llist_inline_kv_ops =
+{
+    "llist_inline", kv_list_create_inline, kv_list_destroy, kv_list_add, kv_list_lookup, kv_list_remove, kv_list_count, kv_list_get_ith,
+    kv_list_insert_first, kv_list_insert_last, kv_list_sort, kv_list_clear, kv_list_save, kv_list_read
+};
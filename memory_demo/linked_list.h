@@ -1,6 +1,9 @@
 #if !defined LINKED_LIST_H
 #define LINKED_LIST_H
 
+#include "../common/kv_store.h"
+#include "../common/hash_map.h"
+
 typedef struct LINKED_LIST_ENTRY 
 {
 	char* name; // name associated with this entry
@@ -9,14 +12,98 @@ typedef struct LINKED_LIST_ENTRY
 	struct LINKED_LIST_ENTRY* previous; // pointer to the previous entry in the list
 } LINKED_LIST_ENTRY;
 
+// A node of a list with inline strings, see llist_use_inline_strings. The name and value of
+// entry point into strings, so that one allocation holds the whole entry.
+typedef struct LLIST_INLINE_ENTRY
+{
+	LINKED_LIST_ENTRY entry;
+	size_t valueCapacity; // Bytes of strings after the name, for the value and its null byte
+	char strings[]; // The name, then the value. A value too long for valueCapacity is allocated apart.
+} LLIST_INLINE_ENTRY;
+
+// Returns the value that a name in both lists keeps after llist_merge. The list stores a
+// copy of the string returned, which stays owned by the caller.
+typedef char* (*LLIST_MERGE_FUNC) (char* name, char* destValue, char* srcValue, void* context);
+
+// Kinds of changes reported by llist_diff
+#define LLIST_DIFF_ADDED 1 // Only in the new list. oldValue is NULL.
+#define LLIST_DIFF_REMOVED 2 // Only in the old list. newValue is NULL.
+#define LLIST_DIFF_CHANGED 3 // In both, with different values
+
+typedef void (*LLIST_DIFF_FUNC) (int change, char* name, char* oldValue, char* newValue, void* context);
+
+// Orders two entries for llist_sort_with: less than, equal to or more than 0, like strcmp.
+typedef int (*LLIST_COMPARE_FUNC) (char* name1, char* value1, char* name2, char* value2, void* context);
+
+// Called by llist_join with every pair of entries that have the same name.
+typedef void (*LLIST_JOIN_FUNC) (char* name, char* leftValue, char* rightValue, void* context);
+
+#define LLIST_KEY_LENGTH_BUCKETS 8
+
+// Memory used by a list, see llist_stats. A list allocates one entry at a time, so unlike a
+// table it has no spare capacity, unless it uses a pool.
+typedef struct LLIST_STATS
+{
+	int entries; // nElements
+	size_t entryBytes; // The LINKED_LIST_ENTRY of every element and of the head, or with a pool of every slab node
+	size_t nameBytes; // Name strings, with their null bytes
+	size_t valueBytes; // Value strings, with their null bytes
+	size_t overheadBytes; // Estimated malloc headers and rounding of the entries and strings
+	size_t indexBytes; // Name index, see llist_index_names
+	double meanKeyLength; // Mean length of the names
+	size_t keyLengths[LLIST_KEY_LENGTH_BUCKETS]; // keyLengths[0] counts the empty names and keyLengths[i] the names
+	// of 2^(i-1) to 2^i - 1 bytes. The last bucket also counts every longer name.
+} LLIST_STATS;
+
+// Walks the entries of a list in order, see llist_cursor_begin. The list keeps every
+// cursor on its entries while entries are removed during the walk.
+typedef struct LLIST_CURSOR
+{
+	struct LINKED_LIST* list; // NULL once the walk is over
+	LINKED_LIST_ENTRY* next; // Entry the next llist_cursor_next returns, the head at the end
+	LINKED_LIST_ENTRY* current; // Entry it returned last, or NULL
+	struct LLIST_CURSOR* nextCursor; // Next cursor of the same list
+} LLIST_CURSOR;
+
+#define LLIST_POOL_SLAB_NODES 256 // Nodes per slab when llist_use_pool is given 0
+
+// A block of nodes of a pool
+typedef struct LLIST_SLAB
+{
+	struct LLIST_SLAB* next; // Next slab of the pool
+	size_t nNodes;
+	LINKED_LIST_ENTRY nodes[];
+} LLIST_SLAB;
+
+// Allocates the nodes of one list from slabs, see llist_use_pool. Free nodes are chained
+// through their next field, and are handed out again most recently freed first.
+typedef struct LLIST_POOL
+{
+	LLIST_SLAB* slabs;
+	LINKED_LIST_ENTRY* freeNodes; // Free list
+	size_t slabNodes; // Nodes of every new slab
+	size_t nSlabs;
+	size_t totalNodes; // Nodes in all slabs, free or in use
+} LLIST_POOL;
+
 typedef struct LINKED_LIST 
 {
 	int nElements; // Number of elements stored in the list
 	LINKED_LIST_ENTRY* head; /* Points to a dummy entry that simplifies implementation.
  This entry is not used to stored data. It is only used to delimit the list. */
+	LLIST_CURSOR* cursors; // Cursors walking the list, or NULL
+	HASH_MAP* index; // Set by llist_index_names. Maps every name to its first node, or NULL.
+	LLIST_POOL* pool; // Set by llist_use_pool. The nodes come from its slabs instead of malloc, or NULL.
+	int inlineStrings; // Set by llist_use_inline_strings. Every node is an LLIST_INLINE_ENTRY.
+	size_t nameBytes; // Counters behind llist_stats, kept up to date by every change
+	size_t valueBytes;
+	size_t stringOverhead;
+	size_t keyLengths[LLIST_KEY_LENGTH_BUCKETS];
 } LINKED_LIST;
 
 LINKED_LIST* llist_create();
+void llist_clear (LINKED_LIST* list);
+void llist_destroy (LINKED_LIST* list);
 void llist_print (LINKED_LIST* list);
 int llist_add (LINKED_LIST* list, char* name, char* value);
 char* llist_lookup (LINKED_LIST* list, char* name);
@@ -27,9 +114,35 @@ int llist_number_elements (LINKED_LIST* list);
 int llist_save (LINKED_LIST* list, char* file_name);
 int llist_read (LINKED_LIST* list, char* file_name);
 void llist_sort (LINKED_LIST* list, int ascending);
+void llist_sort_by_value (LINKED_LIST* list, int ascending);
+void llist_sort_with (LINKED_LIST* list, LLIST_COMPARE_FUNC compare, void* context);
 int llist_remove_first (LINKED_LIST* list);
 int llist_remove_last (LINKED_LIST* list);
 int llist_insert_first (LINKED_LIST* list, char* name, char* value);
 int llist_insert_last (LINKED_LIST* list, char* name, char* value);
+int llist_insert_ith (LINKED_LIST* list, int ith, char* name, char* value);
+int llist_merge (LINKED_LIST* dest, LINKED_LIST* src, LLIST_MERGE_FUNC resolve, void* context);
+int llist_diff (LINKED_LIST* oldList, LINKED_LIST* newList, LLIST_DIFF_FUNC report, void* context);
+int llist_join (LINKED_LIST* left, LINKED_LIST* right, LLIST_JOIN_FUNC emit, void* context);
+void llist_cursor_begin (LINKED_LIST* list, LLIST_CURSOR* cursor);
+int llist_cursor_next (LLIST_CURSOR* cursor, char** name, char** value);
+int llist_cursor_get (LLIST_CURSOR* cursor, char** name, char** value);
+int llist_cursor_erase (LLIST_CURSOR* cursor);
+void llist_cursor_end (LLIST_CURSOR* cursor);
+int llist_splice (LINKED_LIST* dest, int ith, LINKED_LIST* src);
+int llist_concat (LINKED_LIST* dest, LINKED_LIST* src);
+int llist_split_at_cursor (LLIST_CURSOR* cursor, LINKED_LIST* dest);
+void llist_stats (LINKED_LIST* list, LLIST_STATS* stats);
+int llist_index_names (LINKED_LIST* list);
+void llist_drop_index (LINKED_LIST* list);
+int llist_use_pool (LINKED_LIST* list, size_t slabNodes);
+int llist_compact (LINKED_LIST* list);
+int llist_use_inline_strings (LINKED_LIST* list);
+
+// The list as a KV_STORE backend, called "llist", with a name index, "llist_indexed", and
+// with inline strings, "llist_inline"
+extern const KV_STORE_OPS llist_kv_ops;
+extern const KV_STORE_OPS llist_indexed_kv_ops;
+extern const KV_STORE_OPS llist_inline_kv_ops;
 
 #endif
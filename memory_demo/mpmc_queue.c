@@ -0,0 +1,441 @@
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <sched.h>
+#if defined __linux__
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#endif
+#include "mpmc_queue.h"
+
+#define SUCCESS 1
+#define FAILURE 0
+#define BATCH 64 // Strings copied at a time by mpmc_enqueue_batch before claiming slots
+#define SPINS_BEFORE_YIELD 128
+
+/* Sleeps while *word is expected, or until woken. Without futexes it only yields. */
+static void futex_wait (int* word, int expected)
+{
+#if defined __linux__
+    syscall (SYS_futex, word, FUTEX_WAIT_PRIVATE, expected, NULL, NULL, 0);
+#else
+    (void) word;
+    (void) expected;
+    sched_yield ();
+#endif
+}
+
+/* Wakes up to n threads asleep on word. */
+static void futex_wake (int* word, int n)
+{
+#if defined __linux__
+    syscall (SYS_futex, word, FUTEX_WAKE_PRIVATE, n, NULL, NULL, 0);
+#else
+    (void) word;
+    (void) n;
+#endif
+}
+
+/* Waits until slot has sequence, which the thread that claimed the slot one step earlier is about to store. */
+static void wait_sequence (MPMC_SLOT* slot, size_t sequence)
+{
+    int spins = 0;
+
+    while (__atomic_load_n (&(slot->sequence), __ATOMIC_ACQUIRE) != sequence)
+    {
+        if (++ spins == SPINS_BEFORE_YIELD) // That thread may have been preempted
+        {
+            sched_yield ();
+            spins = 0;
+        }
+#if defined __x86_64__ || defined __i386__
+        else
+        {
+            __builtin_ia32_pause ();
+        }
+#endif
+    }
+}
+
+//
+// It returns a new empty queue of capacity slots, rounded up to a power of two, or NULL if
+// memory runs out.
+//
+MPMC_QUEUE* mpmc_create (size_t capacity)
+{
+    MPMC_QUEUE* queue;
+    size_t slots = 2;
+    size_t i; // Slot index
+
+    while (slots < capacity)
+    {
+        slots *= 2;
+    }
+
+    if (posix_memalign ((void**) &queue, MPMC_CACHE_LINE, sizeof (MPMC_QUEUE)) != 0)
+    {
+        return NULL;
+    }
+
+    memset (queue, 0, sizeof (MPMC_QUEUE));
+    queue->mask = slots - 1;
+    queue->slots = malloc (slots * sizeof (MPMC_SLOT));
+    if (queue->slots == NULL)
+    {
+        free (queue);
+        return NULL;
+    }
+
+    for (i = 0; i < slots; i ++)
+    {
+        queue->slots[i].sequence = i;
+    }
+
+    return queue;
+}
+
+//
+// It frees the queue with the entries left in it. No other thread may use it any more.
+//
+void mpmc_destroy (MPMC_QUEUE* queue)
+{
+    size_t pos;
+
+    for (pos = queue->dequeuePos; pos != queue->enqueuePos; pos ++)
+    {
+        free (queue->slots[pos & queue->mask].name);
+        free (queue->slots[pos & queue->mask].value);
+    }
+
+    free (queue->slots);
+    free (queue);
+}
+
+/* Claims up to n consecutive positions to write (enqueue is 1) or to read with one compare-and-swap, and returns how many, the first one in *first. A producer only claims the positions that the consumers of the previous lap have claimed, and a consumer the ones that producers have claimed, so every claimed slot is ready or about to be. */
+static size_t claim (MPMC_QUEUE* queue, int enqueue, size_t n, size_t* first)
+{
+    size_t* pos = enqueue ? &(queue->enqueuePos) : &(queue->dequeuePos);
+    size_t current = __atomic_load_n (pos, __ATOMIC_RELAXED);
+    size_t available, k;
+
+    while (1)
+    {
+        if (enqueue)
+        {
+            available = queue->mask + 1 - (current - __atomic_load_n (&(queue->dequeuePos), __ATOMIC_ACQUIRE));
+        }
+        else
+        {
+            available = __atomic_load_n (&(queue->enqueuePos), __ATOMIC_ACQUIRE) - current;
+        }
+
+        if ((available == 0) || (available > queue->mask + 1)) // Full or empty, or current is stale
+        {
+            size_t latest = __atomic_load_n (pos, __ATOMIC_RELAXED);
+
+            if (latest == current)
+            {
+                return 0;
+            }
+
+            current = latest;
+            continue;
+        }
+
+        k = (available < n) ? available : n;
+
+        if (__atomic_compare_exchange_n (pos, &current, current + k, 1, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED))
+        {
+            *first = current;
+
+            return k;
+        }
+    }
+}
+
+/* Wakes the threads asleep on word if waiters says there are any, after n slots changed hands. The fence orders the slots written before against the read of waiters, which pairs with the fence in wait_on. */
+static void wake (int* word, int* waiters, size_t n)
+{
+    __atomic_thread_fence (__ATOMIC_SEQ_CST);
+
+    if (__atomic_load_n (waiters, __ATOMIC_RELAXED) > 0)
+    {
+        __atomic_add_fetch (word, 1, __ATOMIC_SEQ_CST);
+        futex_wake (word, (n < INT_MAX) ? (int) n : INT_MAX);
+    }
+}
+
+/* Puts n names and values that the queue now owns into as many slots as are free, and returns how many went in. */
+static size_t put (MPMC_QUEUE* queue, char** names, char** values, size_t n)
+{
+    size_t first, i;
+    size_t k = claim (queue, 1, n, &first);
+
+    for (i = 0; i < k; i ++)
+    {
+        MPMC_SLOT* slot = &(queue->slots[(first + i) & queue->mask]);
+
+        wait_sequence (slot, first + i);
+        slot->name = names[i];
+        slot->value = values[i];
+        __atomic_store_n (&(slot->sequence), first + i + 1, __ATOMIC_RELEASE);
+    }
+
+    if (k > 0)
+    {
+        wake (&(queue->notEmpty), &(queue->dequeueWaiters), k);
+    }
+
+    return k;
+}
+
+/* Takes up to n entries out of the queue, handing their strings over, and returns how many. */
+static size_t take (MPMC_QUEUE* queue, char** names, char** values, size_t n)
+{
+    size_t first, i;
+    size_t k = claim (queue, 0, n, &first);
+
+    for (i = 0; i < k; i ++)
+    {
+        MPMC_SLOT* slot = &(queue->slots[(first + i) & queue->mask]);
+
+        wait_sequence (slot, first + i + 1);
+        names[i] = slot->name;
+        values[i] = slot->value;
+        __atomic_store_n (&(slot->sequence), first + i + queue->mask + 1, __ATOMIC_RELEASE);
+    }
+
+    if (k > 0)
+    {
+        wake (&(queue->notFull), &(queue->enqueueWaiters), k);
+    }
+
+    return k;
+}
+
+/* Copies n names and values into the arrays of copies. It will return 1 if successful, or 0 if memory runs out, with nothing left allocated. */
+static int copy_strings (char** names, char** values, size_t n, char** nameCopies, char** valueCopies)
+{
+    size_t i; // Entry index
+
+    for (i = 0; i < n; i ++)
+    {
+        nameCopies[i] = strdup (names[i]);
+        valueCopies[i] = strdup (values[i]);
+
+        if ((nameCopies[i] == NULL) || (valueCopies[i] == NULL))
+        {
+            for (n = 0; n <= i; n ++)
+            {
+                free (nameCopies[n]);
+                free (valueCopies[n]);
+            }
+
+            return FAILURE;
+        }
+    }
+
+    return SUCCESS;
+}
+
+/* Frees n copied names and values. */
+static void free_strings (char** names, char** values, size_t n)
+{
+    size_t i; // Entry index
+
+    for (i = 0; i < n; i ++)
+    {
+        free (names[i]);
+        free (values[i]);
+    }
+}
+
+//
+// It adds copies of as many of the n names and values as fit, in order, and returns how
+// many. Every BATCH entries take one compare-and-swap. It stops early if memory runs out.
+//
+size_t mpmc_enqueue_batch (MPMC_QUEUE* queue, char** names, char** values, size_t n)
+{
+    char* nameCopies[BATCH];
+    char* valueCopies[BATCH];
+    size_t done = 0;
+
+    while (done < n)
+    {
+        size_t chunk = (n - done < BATCH) ? n - done : BATCH;
+
+        if (mpmc_size (queue) > queue->mask) // Full, no point in copying
+        {
+            break;
+        }
+
+        if (!copy_strings (names + done, values + done, chunk, nameCopies, valueCopies))
+        {
+            break;
+        }
+
+        size_t k = put (queue, nameCopies, valueCopies, chunk);
+
+        done += k;
+
+        if (k < chunk) // Full
+        {
+            free_strings (nameCopies + k, valueCopies + k, chunk - k);
+            break;
+        }
+    }
+
+    return done;
+}
+
+//
+// It takes up to n entries out of the queue with one compare-and-swap, and returns how
+// many. The names and values are the caller's to free.
+//
+size_t mpmc_dequeue_batch (MPMC_QUEUE* queue, char** names, char** values, size_t n)
+{
+    return take (queue, names, values, n);
+}
+
+//
+// It adds copies of name and value without waiting.
+// It will return 1 if successful, or 0 if the queue is full or memory runs out.
+//
+int mpmc_try_enqueue (MPMC_QUEUE* queue, char* name, char* value)
+{
+    return mpmc_enqueue_batch (queue, &name, &value, 1) == 1;
+}
+
+//
+// It takes the first entry out of the queue without waiting, and hands its name and value
+// over in *name and *value. It will return 1 if successful, or 0 if the queue is empty.
+//
+int mpmc_try_dequeue (MPMC_QUEUE* queue, char** name, char** value)
+{
+    return take (queue, name, value, 1) == 1;
+}
+
+/* Sleeps on word until the queue may have changed, unless ready says the wait is over already. The waiters count goes up before the last check, see wake. */
+static int wait_on (MPMC_QUEUE* queue, int* word, int* waiters, int (*ready) (MPMC_QUEUE* queue, void* context), void* context)
+{
+    __atomic_add_fetch (waiters, 1, __ATOMIC_SEQ_CST);
+    __atomic_thread_fence (__ATOMIC_SEQ_CST);
+
+    int seen = __atomic_load_n (word, __ATOMIC_SEQ_CST);
+    int done = ready (queue, context);
+
+    if (!done && !__atomic_load_n (&(queue->closed), __ATOMIC_ACQUIRE))
+    {
+        futex_wait (word, seen);
+    }
+
+    __atomic_sub_fetch (waiters, 1, __ATOMIC_RELAXED);
+
+    return done;
+}
+
+/* The entry that mpmc_enqueue or mpmc_dequeue is moving, for wait_on */
+typedef struct ENTRY
+{
+	char* name;
+	char* value;
+} ENTRY;
+
+/* Tries to put the entry in context, which the queue owns if it goes in. */
+static int ready_put (MPMC_QUEUE* queue, void* context)
+{
+    ENTRY* entry = context;
+
+    return put (queue, &(entry->name), &(entry->value), 1) == 1;
+}
+
+/* Tries to take the first entry into context. */
+static int ready_take (MPMC_QUEUE* queue, void* context)
+{
+    ENTRY* entry = context;
+
+    return take (queue, &(entry->name), &(entry->value), 1) == 1;
+}
+
+//
+// It adds copies of name and value, sleeping while the queue is full.
+// It will return 1 if successful, or 0 if the queue is closed or memory runs out.
+//
+int mpmc_enqueue (MPMC_QUEUE* queue, char* name, char* value)
+{
+    ENTRY entry;
+
+    if (!copy_strings (&name, &value, 1, &(entry.name), &(entry.value)))
+    {
+        return FAILURE;
+    }
+
+    while (!__atomic_load_n (&(queue->closed), __ATOMIC_ACQUIRE))
+    {
+        if (ready_put (queue, &entry) || wait_on (queue, &(queue->notFull), &(queue->enqueueWaiters), ready_put, &entry))
+        {
+            return SUCCESS;
+        }
+    }
+
+    free_strings (&(entry.name), &(entry.value), 1);
+
+    return FAILURE;
+}
+
+//
+// It takes the first entry out of the queue, sleeping while the queue is empty, and hands
+// its name and value over in *name and *value.
+// It will return 1 if successful, or 0 once the queue is closed and empty.
+//
+int mpmc_dequeue (MPMC_QUEUE* queue, char** name, char** value)
+{
+    ENTRY entry;
+
+    while (!ready_take (queue, &entry))
+    {
+        if (__atomic_load_n (&(queue->closed), __ATOMIC_ACQUIRE))
+        {
+            if (!ready_take (queue, &entry)) // Last entries added before mpmc_close
+            {
+                return FAILURE;
+            }
+
+            break;
+        }
+
+        if (wait_on (queue, &(queue->notEmpty), &(queue->dequeueWaiters), ready_take, &entry))
+        {
+            break;
+        }
+    }
+
+    *name = entry.name;
+    *value = entry.value;
+
+    return SUCCESS;
+}
+
+//
+// It closes the queue: mpmc_enqueue fails from now on, and mpmc_dequeue once the queue is
+// empty. Every sleeping thread wakes up.
+//
+void mpmc_close (MPMC_QUEUE* queue)
+{
+    __atomic_store_n (&(queue->closed), 1, __ATOMIC_RELEASE);
+    __atomic_add_fetch (&(queue->notEmpty), 1, __ATOMIC_SEQ_CST);
+    __atomic_add_fetch (&(queue->notFull), 1, __ATOMIC_SEQ_CST);
+    futex_wake (&(queue->notEmpty), INT_MAX);
+    futex_wake (&(queue->notFull), INT_MAX);
+}
+
+//
+// It returns the number of entries in the queue, which other threads may be changing.
+//
+size_t mpmc_size (MPMC_QUEUE* queue)
+{
+    size_t dequeuePos = __atomic_load_n (&(queue->dequeuePos), __ATOMIC_ACQUIRE);
+
+    return __atomic_load_n (&(queue->enqueuePos), __ATOMIC_ACQUIRE) - dequeuePos;
+}
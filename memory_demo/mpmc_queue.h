@@ -0,0 +1,51 @@
+#if !defined MPMC_QUEUE_H
+#define MPMC_QUEUE_H
+
+#include <stddef.h>
+
+#define MPMC_CACHE_LINE 64
+
+//
+// A bounded queue of name/value pairs for many producers and many consumers, for the
+// LINKED_LIST used as a FIFO between threads (llist_insert_last on one side,
+// llist_remove_first on the other). It is the ring buffer of Vyukov: every slot has a
+// sequence number that tells whether it is ready to be written or read at the current lap,
+// so a producer or a consumer claims a slot with one compare-and-swap and takes no lock.
+//
+// Like llist_insert_last, the queue stores copies of the strings it is given. A dequeue
+// hands the name and value over to the caller, who frees them. The batch functions claim
+// several slots with one compare-and-swap. The blocking functions sleep on a futex while
+// the queue is full or empty, until mpmc_close. Link with -pthread.
+//
+typedef struct MPMC_SLOT
+{
+	size_t sequence; // The position that may use the slot next: p to write it, p + 1 to read it
+	char* name;
+	char* value;
+} MPMC_SLOT;
+
+typedef struct MPMC_QUEUE
+{
+	MPMC_SLOT* slots;
+	size_t mask; // Capacity less one, the capacity being a power of two
+	size_t enqueuePos __attribute__ ((aligned (MPMC_CACHE_LINE))); // Next position to write
+	size_t dequeuePos __attribute__ ((aligned (MPMC_CACHE_LINE))); // Next position to read
+	int notEmpty __attribute__ ((aligned (MPMC_CACHE_LINE))); // Futex words, bumped to wake the waiters
+	int notFull;
+	int enqueueWaiters; // Producers asleep on notFull
+	int dequeueWaiters; // Consumers asleep on notEmpty
+	int closed;
+} MPMC_QUEUE;
+
+MPMC_QUEUE* mpmc_create (size_t capacity);
+void mpmc_destroy (MPMC_QUEUE* queue);
+int mpmc_try_enqueue (MPMC_QUEUE* queue, char* name, char* value);
+int mpmc_try_dequeue (MPMC_QUEUE* queue, char** name, char** value);
+size_t mpmc_enqueue_batch (MPMC_QUEUE* queue, char** names, char** values, size_t n);
+size_t mpmc_dequeue_batch (MPMC_QUEUE* queue, char** names, char** values, size_t n);
+int mpmc_enqueue (MPMC_QUEUE* queue, char* name, char* value);
+int mpmc_dequeue (MPMC_QUEUE* queue, char** name, char** value);
+void mpmc_close (MPMC_QUEUE* queue);
+size_t mpmc_size (MPMC_QUEUE* queue);
+
+#endif
@@ -0,0 +1,509 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "skip_list.h"
+
+#define SUCCESS 1
+#define FAILURE 0
+#define WRITE_MODE "w"
+#define SEED 88172645463325252ULL
+
+//
+// It returns a new empty skip list, or NULL if memory runs out.
+//
+SKIP_LIST* slist_create ()
+{
+    int i; // Level
+
+    SKIP_LIST* list = malloc (sizeof (SKIP_LIST));
+    if (list == NULL)
+    {
+        return NULL;
+    }
+
+    list->head = malloc (sizeof (SLIST_NODE) + SLIST_MAX_LEVEL * sizeof (SLIST_LINK));
+    if (list->head == NULL)
+    {
+        free (list);
+        return NULL;
+    }
+
+    list->nElements = 0;
+    list->level = 1;
+    list->seed = SEED;
+    (list->head)->name = NULL;
+    (list->head)->value = NULL;
+    (list->head)->level = SLIST_MAX_LEVEL;
+
+    for (i = 0; i < SLIST_MAX_LEVEL; i ++)
+    {
+        (list->head)->links[i].next = NULL;
+        (list->head)->links[i].span = 0;
+    }
+
+    return list;
+}
+
+/* Returns the level of a new node: 1, and one more with a chance of 1/4 each time. */
+static int random_level (SKIP_LIST* list)
+{
+    int level = 1;
+
+    // xorshift64
+    list->seed ^= list->seed << 13;
+    list->seed ^= list->seed >> 7;
+    list->seed ^= list->seed << 17;
+
+    for (unsigned long long bits = list->seed; ((bits & 3) == 0) && (level < SLIST_MAX_LEVEL); bits >>= 2)
+    {
+        level ++;
+    }
+
+    return level;
+}
+
+/* Fills update[level] with the last node at each level before position ith, and rank[level] with its position plus one, the head being 0. */
+static void find_before (SKIP_LIST* list, int ith, SLIST_NODE** update, int* rank)
+{
+    SLIST_NODE* node = list->head;
+    int traversed = 0; // Position of node plus one
+    int level;
+
+    for (level = list->level - 1; level >= 0; level --)
+    {
+        while ((node->links[level].next != NULL) && (traversed + node->links[level].span <= ith))
+        {
+            traversed += node->links[level].span;
+            node = node->links[level].next;
+        }
+
+        update[level] = node;
+        rank[level] = traversed;
+    }
+}
+
+/* Unlinks the node at position ith, whose predecessors are in update, and frees it with its strings. */
+static void remove_node (SKIP_LIST* list, SLIST_NODE** update)
+{
+    SLIST_NODE* node = update[0]->links[0].next;
+    int level;
+
+    for (level = 0; level < list->level; level ++)
+    {
+        if (update[level]->links[level].next == node)
+        {
+            update[level]->links[level].span += node->links[level].span - 1;
+            update[level]->links[level].next = node->links[level].next;
+        }
+        else
+        {
+            update[level]->links[level].span --;
+        }
+    }
+
+    while ((list->level > 1) && ((list->head)->links[list->level - 1].next == NULL))
+    {
+        list->level --;
+    }
+
+    list->nElements --;
+
+    free (node->name);
+    free (node->value);
+    free (node);
+}
+
+//
+// It removes every entry and frees them, keeping the list itself.
+//
+void slist_clear (SKIP_LIST* list)
+{
+    SLIST_NODE* node = (list->head)->links[0].next;
+    int i; // Level
+
+    while (node != NULL)
+    {
+        SLIST_NODE* next = node->links[0].next;
+
+        free (node->name);
+        free (node->value);
+        free (node);
+        node = next;
+    }
+
+    for (i = 0; i < SLIST_MAX_LEVEL; i ++)
+    {
+        (list->head)->links[i].next = NULL;
+        (list->head)->links[i].span = 0;
+    }
+
+    list->nElements = 0;
+    list->level = 1;
+}
+
+//
+// It frees the list with all its entries.
+//
+void slist_destroy (SKIP_LIST* list)
+{
+    slist_clear (list);
+    free (list->head);
+    free (list);
+}
+
+//
+// It prints the list in the format of llist_print.
+//
+void slist_print (SKIP_LIST* list)
+{
+    SLIST_NODE* node;
+
+    printf ("===== List =====\n");
+    printf ("nElements=%d\n", list->nElements);
+
+    for (node = (list->head)->links[0].next; node != NULL; node = node->links[0].next)
+    {
+        printf ("name=\"%s\" value=\"%s\"\n", node->name, node->value);
+    }
+
+    printf ("======== End List =======\n");
+}
+
+/* Returns the first node called name and its position in *ith, or NULL. */
+static SLIST_NODE* find (SKIP_LIST* list, char* name, int* ith)
+{
+    SLIST_NODE* node = (list->head)->links[0].next;
+    int i = 0; // Position of node
+
+    while (node != NULL)
+    {
+        if (strcmp (node->name, name) == 0)
+        {
+            *ith = i;
+            return node;
+        }
+
+        node = node->links[0].next;
+        i ++;
+    }
+
+    return NULL;
+}
+
+//
+// Like llist_add, it replaces the value of the first entry called name, or else adds
+// name/value at the end of the list. The list stores copies of both strings.
+// It will return 1 if successful, or 0 if memory runs out.
+//
+int slist_add (SKIP_LIST* list, char* name, char* value)
+{
+    int ith;
+    SLIST_NODE* node = find (list, name, &ith);
+
+    if (node != NULL)
+    {
+        char* copy = strdup (value);
+        if (copy == NULL)
+        {
+            return FAILURE;
+        }
+
+        free (node->value);
+        node->value = copy;
+
+        return SUCCESS;
+    }
+
+    return slist_insert_last (list, name, value);
+}
+
+//
+// It returns the value of the first entry called name, or NULL if there is none.
+//
+char* slist_lookup (SKIP_LIST* list, char* name)
+{
+    int ith;
+    SLIST_NODE* node = find (list, name, &ith);
+
+    return (node != NULL) ? node->value : NULL;
+}
+
+//
+// It removes the first entry called name. It will return 1 if successful, or 0 if there is
+// none.
+//
+int slist_remove (SKIP_LIST* list, char* name)
+{
+    int ith;
+
+    if (find (list, name, &ith) == NULL)
+    {
+        return FAILURE;
+    }
+
+    return slist_remove_ith (list, ith);
+}
+
+//
+// It returns in *name and *value the entry at position ith, in O(log n).
+// It will return 1 if successful, or 0 if ith is out of bounds.
+//
+int slist_get_ith (SKIP_LIST* list, int ith, char** name, char** value)
+{
+    SLIST_NODE* update[SLIST_MAX_LEVEL];
+    int rank[SLIST_MAX_LEVEL];
+
+    if ((ith < 0) || (ith >= list->nElements))
+    {
+        return FAILURE;
+    }
+
+    find_before (list, ith, update, rank);
+
+    SLIST_NODE* node = update[0]->links[0].next;
+
+    *name = node->name;
+    *value = node->value;
+
+    return SUCCESS;
+}
+
+//
+// It removes the entry at position ith, in O(log n). It will return 1 if successful, or 0
+// if ith is out of bounds.
+//
+int slist_remove_ith (SKIP_LIST* list, int ith)
+{
+    SLIST_NODE* update[SLIST_MAX_LEVEL];
+    int rank[SLIST_MAX_LEVEL];
+
+    if ((ith < 0) || (ith >= list->nElements))
+    {
+        return FAILURE;
+    }
+
+    find_before (list, ith, update, rank);
+    remove_node (list, update);
+
+    return SUCCESS;
+}
+
+//
+// It inserts name/value so that it becomes the entry at position ith, from 0 to nElements,
+// in O(log n). There is no check if the name already exists.
+// It will return 1 if successful, or 0 if ith is out of bounds or memory runs out.
+//
+int slist_insert_ith (SKIP_LIST* list, int ith, char* name, char* value)
+{
+    SLIST_NODE* update[SLIST_MAX_LEVEL];
+    int rank[SLIST_MAX_LEVEL];
+    int level;
+
+    if ((ith < 0) || (ith > list->nElements))
+    {
+        return FAILURE;
+    }
+
+    int nodeLevel = random_level (list);
+
+    SLIST_NODE* node = malloc (sizeof (SLIST_NODE) + nodeLevel * sizeof (SLIST_LINK));
+    if (node == NULL)
+    {
+        return FAILURE;
+    }
+
+    node->name = strdup (name);
+    node->value = strdup (value);
+    if ((node->name == NULL) || (node->value == NULL))
+    {
+        free (node->name);
+        free (node->value);
+        free (node);
+        return FAILURE;
+    }
+
+    node->level = nodeLevel;
+    find_before (list, ith, update, rank);
+
+    for (level = list->level; level < nodeLevel; level ++) // New levels start at the head and span the whole list
+    {
+        update[level] = list->head;
+        rank[level] = 0;
+        (list->head)->links[level].span = list->nElements;
+    }
+
+    if (nodeLevel > list->level)
+    {
+        list->level = nodeLevel;
+    }
+
+    for (level = 0; level < nodeLevel; level ++)
+    {
+        int before = rank[0] - rank[level]; // Positions from update[level] to the new node, less one
+
+        node->links[level].next = update[level]->links[level].next;
+        node->links[level].span = update[level]->links[level].span - before;
+        update[level]->links[level].next = node;
+        update[level]->links[level].span = before + 1;
+    }
+
+    for (level = nodeLevel; level < list->level; level ++) // Links above the node skip it too
+    {
+        update[level]->links[level].span ++;
+    }
+
+    list->nElements ++;
+
+    return SUCCESS;
+}
+
+//
+// It returns the number of elements in the list.
+//
+int slist_number_elements (SKIP_LIST* list)
+{
+    return list->nElements;
+}
+
+//
+// It saves the list in file_name, in the format of llist_save.
+// It will return 1 if successful, or 0 otherwise.
+//
+int slist_save (SKIP_LIST* list, char* file_name)
+{
+    SLIST_NODE* node;
+
+    FILE* fout = fopen (file_name, WRITE_MODE);
+    if (fout == NULL)
+    {
+        return FAILURE;
+    }
+
+    for (node = (list->head)->links[0].next; node != NULL; node = node->links[0].next)
+    {
+        fprintf (fout, "%s\n%s\n\n", node->name, node->value);
+    }
+
+    return (fclose (fout) == 0) ? SUCCESS : FAILURE;
+}
+
+//
+// It removes the first entry, whose predecessor is the head at every level, without a search.
+// It will return 1 if successful, or 0 if the list is empty.
+//
+int slist_remove_first (SKIP_LIST* list)
+{
+    SLIST_NODE* update[SLIST_MAX_LEVEL];
+    int level;
+
+    if (list->nElements == 0)
+    {
+        return FAILURE;
+    }
+
+    for (level = 0; level < list->level; level ++)
+    {
+        update[level] = list->head;
+    }
+
+    remove_node (list, update);
+
+    return SUCCESS;
+}
+
+//
+// It removes the last entry, in O(log n). It will return 1 if successful, or 0 if the list
+// is empty.
+//
+int slist_remove_last (SKIP_LIST* list)
+{
+    return slist_remove_ith (list, list->nElements - 1);
+}
+
+//
+// It inserts name/value before the first entry, without checking whether name is in the
+// list. It will return 1 if successful, or 0 if memory runs out.
+//
+int slist_insert_first (SKIP_LIST* list, char* name, char* value)
+{
+    return slist_insert_ith (list, 0, name, value);
+}
+
+//
+// It inserts name/value after the last entry, without checking whether name is in the list.
+// It will return 1 if successful, or 0 if memory runs out.
+//
+int slist_insert_last (SKIP_LIST* list, char* name, char* value)
+{
+    return slist_insert_ith (list, list->nElements, name, value);
+}
+
+/* The slist_kv_ops functions. */
+static void* kv_slist_create ()
+{
+    return slist_create ();
+}
+
+static void kv_slist_destroy (void* store)
+{
+    slist_destroy ((SKIP_LIST*) store);
+}
+
+static int kv_slist_add (void* store, char* name, char* value)
+{
+    return slist_add ((SKIP_LIST*) store, name, value);
+}
+
+static char* kv_slist_lookup (void* store, char* name)
+{
+    return slist_lookup ((SKIP_LIST*) store, name);
+}
+
+static int kv_slist_remove (void* store, char* name)
+{
+    return slist_remove ((SKIP_LIST*) store, name);
+}
+
+static size_t kv_slist_count (void* store)
+{
+    return (size_t) slist_number_elements ((SKIP_LIST*) store);
+}
+
+static int kv_slist_get_ith (void* store, size_t ith, char** name, char** value)
+{
+    SKIP_LIST* list = store;
+
+    if (ith >= (size_t) list->nElements)
+    {
+        return FAILURE;
+    }
+
+    return slist_get_ith (list, (int) ith, name, value);
+}
+
+static int kv_slist_insert_first (void* store, char* name, char* value)
+{
+    return slist_insert_first ((SKIP_LIST*) store, name, value);
+}
+
+static int kv_slist_insert_last (void* store, char* name, char* value)
+{
+    return slist_insert_last ((SKIP_LIST*) store, name, value);
+}
+
+static void kv_slist_clear (void* store)
+{
+    slist_clear ((SKIP_LIST*) store);
+}
+
+static int kv_slist_save (void* store, char* file_name)
+{
+    return slist_save ((SKIP_LIST*) store, file_name);
+}
+
+// The skip list keeps the order of insertion only, so it has no sort
+const KV_STORE_OPS slist_kv_ops =
+{
+    "slist", kv_slist_create, kv_slist_destroy, kv_slist_add, kv_slist_lookup, kv_slist_remove, kv_slist_count, kv_slist_get_ith,
+    kv_slist_insert_first, kv_slist_insert_last, NULL, kv_slist_clear, kv_slist_save, NULL
+};
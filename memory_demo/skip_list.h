@@ -0,0 +1,56 @@
+#if !defined SKIP_LIST_H
+#define SKIP_LIST_H
+
+#include "../common/kv_store.h"
+
+#define SLIST_MAX_LEVEL 24 // Enough for 4^24 entries with a promotion chance of 1/4
+
+// One link of a skip list node, span being the number of positions it skips
+typedef struct SLIST_LINK
+{
+	struct SLIST_NODE* next; // NULL after the last node
+	int span; // Positions from this node to next, or to the end of the list if next is NULL
+} SLIST_LINK;
+
+// An entry of a skip list with its links, one per level it takes part in
+typedef struct SLIST_NODE
+{
+	char* name;
+	char* value;
+	int level;
+	SLIST_LINK links[];
+} SLIST_NODE;
+
+// A list of name/value pairs like LINKED_LIST, in insertion order, that finds the entry at
+// any position in O(log n): an indexable skip list, in which every link counts the entries
+// it skips. llist_get_ith and llist_remove_ith walk the list to the position instead. The
+// operations by name still walk the entries in order, as in a LINKED_LIST.
+typedef struct SKIP_LIST
+{
+	int nElements;
+	int level; // Levels in use, 1 at least
+	SLIST_NODE* head; // Has SLIST_MAX_LEVEL links and no entry
+	unsigned long long seed; // State of the generator of node levels
+} SKIP_LIST;
+
+SKIP_LIST* slist_create ();
+void slist_destroy (SKIP_LIST* list);
+void slist_clear (SKIP_LIST* list);
+void slist_print (SKIP_LIST* list);
+int slist_add (SKIP_LIST* list, char* name, char* value);
+char* slist_lookup (SKIP_LIST* list, char* name);
+int slist_remove (SKIP_LIST* list, char* name);
+int slist_get_ith (SKIP_LIST* list, int ith, char** name, char** value);
+int slist_remove_ith (SKIP_LIST* list, int ith);
+int slist_insert_ith (SKIP_LIST* list, int ith, char* name, char* value);
+int slist_number_elements (SKIP_LIST* list);
+int slist_save (SKIP_LIST* list, char* file_name);
+int slist_remove_first (SKIP_LIST* list);
+int slist_remove_last (SKIP_LIST* list);
+int slist_insert_first (SKIP_LIST* list, char* name, char* value);
+int slist_insert_last (SKIP_LIST* list, char* name, char* value);
+
+// The skip list as a KV_STORE backend, called "slist"
+extern const KV_STORE_OPS slist_kv_ops;
+
+#endif
@@ -1,7 +1,13 @@
+#include <assert.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
 #include "linked_list.h"
+#include "unrolled_list.h"
+#include "skip_list.h"
+#include "concurrent_list.h"
+#include "mpmc_queue.h"
+#include "../common/instrument.h"
 
 void test1() {
 	LINKED_LIST *ll;
@@ -368,6 +374,819 @@ void test12() {
 
 
 
+void print_change(int change, char * name, char * oldValue, char * newValue, void * context) {
+	(void) context;
+	printf("%s %s: %s -> %s\n", (change == LLIST_DIFF_ADDED) ? "added" : (change == LLIST_DIFF_REMOVED) ? "removed" : "changed",
+		name, oldValue ? oldValue : "-", newValue ? newValue : "-");
+}
+
+void print_pair(char * name, char * leftValue, char * rightValue, void * context) {
+	(*(int *) context) ++;
+	printf("%s: %s | %s\n", name, leftValue, rightValue);
+}
+
+char * keep_dest(char * name, char * destValue, char * srcValue, void * context) {
+	(void) name;
+	(void) srcValue;
+	(void) context;
+	return destValue;
+}
+
+void test13() {
+	LINKED_LIST *ll1;
+	LINKED_LIST *ll2;
+	int pairs = 0;
+
+	ll1 = llist_create();
+	ll2 = llist_create();
+
+	llist_add(ll1, "George", "23 Oak St");
+	llist_add(ll1, "Peter", "27 Oak St");
+	llist_add(ll1, "Mary", "5 Elm St");
+	llist_add(ll2, "Peter", "28 Oak St");
+	llist_add(ll2, "Mary", "5 Elm St");
+	llist_add(ll2, "Ann", "1 Main St");
+
+	printf("Diff\n");
+	llist_diff(ll1, ll2, print_change, NULL);
+
+	printf("Join\n");
+	llist_join(ll1, ll2, print_pair, &pairs);
+	printf("pairs=%d\n", pairs);
+
+	printf("Merge keeping dest values\n");
+	llist_merge(ll1, ll2, keep_dest, NULL);
+	llist_print(ll1);
+
+	printf("Merge, last writer wins\n");
+	llist_merge(ll1, ll2, NULL, NULL);
+	llist_print(ll1);
+}
+
+void test14() {
+	LINKED_LIST *ll;
+	LLIST_CURSOR cursor;
+	char * name;
+	char * value;
+	int visited = 0;
+
+	ll = llist_create();
+	llist_add(ll, "George", "23 Oak St");
+	llist_add(ll, "Peter", "27 Oak St");
+	llist_add(ll, "Mary", "5 Elm St");
+	llist_add(ll, "Ann", "1 Main St");
+	llist_add(ll, "Bob", "9 Elm St");
+
+	printf("Walk erasing Peter, removing Ann when Mary is reached\n");
+	llist_cursor_begin(ll, &cursor);
+	while (llist_cursor_next(&cursor, &name, &value)) {
+		visited++;
+		if (strcmp(name, "Peter") == 0) {
+			llist_cursor_erase(&cursor);
+			assert(llist_cursor_get(&cursor, &name, &value) == 0);
+		}
+		else if (strcmp(name, "Mary") == 0) {
+			llist_remove(ll, "Ann");
+			llist_insert_last(ll, "Zoe", "3 Pine St");
+		}
+	}
+	printf("visited=%d\n", visited);
+	llist_print(ll);
+
+	printf("Stop after the first entry, sort, and walk again\n");
+	llist_cursor_begin(ll, &cursor);
+	llist_cursor_next(&cursor, &name, &value);
+	llist_cursor_end(&cursor);
+	assert(ll->cursors == NULL);
+	llist_sort(ll, 1);
+	llist_cursor_begin(ll, &cursor);
+	while (llist_cursor_next(&cursor, &name, &value)) {
+		printf("%s ", name);
+	}
+	printf("\n");
+}
+
+void test15() {
+	LINKED_LIST *ll;
+	LLIST_STATS stats;
+
+	ll = llist_create();
+	llist_add(ll, "George", "23 Oak St");
+	llist_add(ll, "Peter", "27 Oak St");
+	llist_add(ll, "Mary", "5 Elm St");
+	llist_add(ll, "Peter", "28 Oak Street");
+	llist_remove(ll, "Mary");
+
+	llist_stats(ll, &stats);
+	printf("entries=%d entryBytes=%zu names=%zu values=%zu overhead=%zu mean key=%.1f\n", stats.entries,
+		stats.entryBytes, stats.nameBytes, stats.valueBytes, stats.overheadBytes, stats.meanKeyLength);
+	assert(stats.nameBytes == 7 + 6 && stats.valueBytes == 10 + 14 && stats.keyLengths[3] == 2);
+}
+
+void test16() {
+#if defined INSTRUMENT
+	LINKED_LIST *ll;
+	INSTR_OP_STATS totals[INSTR_OPERATIONS];
+
+	instr_reset();
+	ll = llist_create();
+	llist_add(ll, "George", "23 Oak St");
+	llist_add(ll, "Peter", "27 Oak St");
+	llist_add(ll, "Mary", "5 Elm St");
+	llist_lookup(ll, "Mary");
+	llist_lookup(ll, "Ann");
+
+	instr_snapshot(totals);
+	printf("adds=%llu lookups=%llu compares=%llu\n", (unsigned long long) totals[INSTR_LLIST_ADD].calls,
+		(unsigned long long) totals[INSTR_LLIST_LOOKUP].calls, (unsigned long long) totals[INSTR_LLIST_LOOKUP].compares);
+	assert(totals[INSTR_LLIST_ADD].compares == 3 && totals[INSTR_LLIST_LOOKUP].compares == 6);
+	instr_dump_text(stdout);
+#else
+	printf("Instrumentation is compiled out, build with -DINSTRUMENT\n");
+#endif
+}
+
+void test17() {
+	KV_STORE *kv;
+	char *name, *value;
+	int i;
+
+	kv = kv_create(&llist_kv_ops);
+	kv_add(kv, "George", "23 Oak St");
+	kv_add(kv, "Peter", "27 Oak St");
+	kv_insert_first(kv, "Mary", "5 Elm St");
+	kv_add(kv, "Peter", "28 Oak Street");
+	assert(kv_count(kv) == 3 && strcmp(kv_lookup(kv, "Peter"), "28 Oak Street") == 0);
+	assert(kv_save(kv, "kv.ll"));
+	kv_add(kv, "Ann", "1 Pine St");
+	assert(kv_read(kv, "kv.ll") && kv_count(kv) == 3 && kv_lookup(kv, "Ann") == NULL);
+	for (i = 0; kv_get_ith(kv, i, &name, &value); i++) {
+		printf("%d: %s=%s\n", i, name, value);
+	}
+	kv_destroy(kv);
+	remove("kv.ll");
+}
+
+void test18() {
+	LINKED_LIST *ll;
+	LLIST_STATS stats;
+	char *name, *value;
+	int i;
+
+	ll = llist_create();
+	llist_add(ll, "George", "23 Oak St");
+	llist_add(ll, "Peter", "27 Oak St");
+	assert(llist_index_names(ll));
+	llist_add(ll, "Mary", "5 Elm St");
+	llist_insert_last(ll, "George", "1 Main St");
+	llist_add(ll, "George", "24 Oak St");
+	assert(strcmp(llist_lookup(ll, "George"), "24 Oak St") == 0);
+	llist_insert_first(ll, "Mary", "6 Elm St");
+	assert(strcmp(llist_lookup(ll, "Mary"), "6 Elm St") == 0);
+	llist_remove(ll, "George");
+	assert(strcmp(llist_lookup(ll, "George"), "1 Main St") == 0);
+	llist_sort(ll, 0);
+	assert(strcmp(llist_lookup(ll, "Mary"), "6 Elm St") == 0);
+	assert(llist_remove(ll, "Ann") == 0);
+	llist_print(ll);
+
+	llist_stats(ll, &stats);
+	assert(stats.indexBytes > 0);
+	llist_drop_index(ll);
+	llist_stats(ll, &stats);
+	assert(stats.indexBytes == 0);
+	for (i = 0; llist_get_ith(ll, i, &name, &value); i++) {
+		assert(llist_lookup(ll, name) != NULL);
+	}
+}
+
+void test19() {
+	LINKED_LIST *ll;
+	LLIST_STATS stats;
+	LLIST_CURSOR cursor;
+	char name[20];
+	char *n, *v;
+	int i;
+
+	ll = llist_create();
+	llist_add(ll, "George", "23 Oak St");
+	llist_add(ll, "Peter", "27 Oak St");
+	llist_cursor_begin(ll, &cursor);
+	llist_cursor_next(&cursor, &n, &v);
+	assert(llist_compact(ll) == 0);
+	assert(llist_use_pool(ll, 4));
+	assert(llist_cursor_get(&cursor, &n, &v) && strcmp(n, "George") == 0);
+	for (i = 0; i < 10; i++) {
+		sprintf(name, "name%d", i);
+		llist_insert_last(ll, name, "value");
+	}
+	for (i = 0; i < 10; i += 2) {
+		sprintf(name, "name%d", i);
+		llist_remove(ll, name);
+	}
+	llist_stats(ll, &stats);
+	printf("slabs=%zu nodes=%zu entryBytes=%zu\n", ll->pool->nSlabs, ll->pool->totalNodes, stats.entryBytes);
+	assert(llist_compact(ll));
+	llist_stats(ll, &stats);
+	printf("slabs=%zu nodes=%zu entryBytes=%zu\n", ll->pool->nSlabs, ll->pool->totalNodes, stats.entryBytes);
+	assert(llist_cursor_next(&cursor, &n, &v) && strcmp(n, "Peter") == 0);
+	llist_cursor_end(&cursor);
+	llist_print(ll);
+}
+
+void test20() {
+	LINKED_LIST *ll;
+	LLIST_STATS stats;
+	char *v;
+
+	ll = llist_create();
+	assert(llist_use_inline_strings(ll));
+	assert(llist_use_pool(ll, 0) == 0);
+	llist_add(ll, "George", "23 Oak St");
+	llist_insert_first(ll, "Rachael", "34 Elm St");
+	llist_add(ll, "Peter", "27 Oak St");
+	v = llist_lookup(ll, "George");
+	llist_add(ll, "George", "2 Oak St");
+	assert(llist_lookup(ll, "George") == v); // Overwritten in place
+	llist_add(ll, "Peter", "127 Oak Street, Apartment 4");
+	llist_stats(ll, &stats);
+	printf("entries=%d nameBytes=%zu valueBytes=%zu\n", stats.entries, stats.nameBytes, stats.valueBytes);
+	llist_remove(ll, "Rachael");
+	llist_sort(ll, 1);
+	llist_print(ll);
+}
+
+void test21() {
+	LINKED_LIST *ll;
+	UNROLLED_LIST *ul;
+	ULIST_CURSOR cursor;
+	char name[20], value[20];
+	char *n1, *v1, *n2, *v2;
+	unsigned int seed = 7;
+	int i, ith;
+
+	ll = llist_create();
+	ul = ulist_create();
+	llist_index_names(ll);
+	for (i = 0; i < 2000; i++) {
+		seed = seed * 1103515245 + 12345;
+		ith = (seed >> 8) % (ulist_number_elements(ul) + 1);
+		sprintf(name, "name%d", (seed >> 4) % 50);
+		if ((seed >> 20) % 3 != 0) {
+			assert(llist_insert_ith(ll, ith, name, "value"));
+			assert(ulist_insert_ith(ul, ith, name, "value"));
+		}
+		else if (ulist_number_elements(ul) > 0) {
+			ith = ith % ulist_number_elements(ul);
+			assert(llist_remove_ith(ll, ith));
+			assert(ulist_remove_ith(ul, ith));
+		}
+		if (i % 5 == 0) {
+			assert(llist_remove(ll, name) == ulist_remove(ul, name));
+		}
+	}
+	assert(llist_number_elements(ll) == ulist_number_elements(ul));
+	ulist_cursor_begin(ul, &cursor);
+	for (i = 0; i < llist_number_elements(ll); i++) {
+		assert(llist_get_ith(ll, i, &n1, &v1) && ulist_cursor_next(&cursor, &n2, &v2));
+		assert(strcmp(n1, n2) == 0);
+	}
+	assert(!ulist_cursor_next(&cursor, &n2, &v2));
+	assert(ul->nBlocks <= 2 * ulist_number_elements(ul) / (ULIST_BLOCK_ENTRIES / 2) + 1);
+
+	// Both sorts keep the order of entries with the same name
+	llist_clear(ll);
+	ulist_clear(ul);
+	for (i = 0; i < 200; i++) {
+		sprintf(name, "dup%d", (i * 3) % 7);
+		sprintf(value, "%d", i);
+		llist_insert_last(ll, name, value);
+		ulist_insert_last(ul, name, value);
+	}
+	for (ith = 1; ith >= 0; ith--) {
+		llist_sort(ll, ith);
+		assert(ulist_sort(ul, ith));
+		ulist_cursor_begin(ul, &cursor);
+		for (i = 0; llist_get_ith(ll, i, &n1, &v1); i++) {
+			assert(ulist_cursor_next(&cursor, &n2, &v2));
+			assert(strcmp(n1, n2) == 0 && strcmp(v1, v2) == 0);
+		}
+	}
+
+	ulist_clear(ul);
+	ulist_insert_first(ul, "Peter", "27 Oak St");
+	ulist_insert_last(ul, "George", "23 Oak St");
+	ulist_add(ul, "Rachael", "34 Elm St");
+	ulist_add(ul, "Peter", "2 Oak St");
+	ulist_insert_ith(ul, 1, "Mary", "5 Pine St");
+	ulist_remove_last(ul);
+	ulist_sort(ul, 1);
+	ulist_print(ul);
+	ulist_destroy(ul);
+}
+
+void test22() {
+	LINKED_LIST *ll;
+	SKIP_LIST *sl;
+	char name[20];
+	char *n1, *v1, *n2, *v2;
+	unsigned int seed = 11;
+	int i, ith;
+
+	ll = llist_create();
+	sl = slist_create();
+	for (i = 0; i < 3000; i++) {
+		seed = seed * 1103515245 + 12345;
+		ith = (seed >> 8) % (slist_number_elements(sl) + 1);
+		sprintf(name, "name%d", i);
+		switch ((seed >> 20) % 8) {
+		case 0:
+			assert(llist_remove_first(ll) == slist_remove_first(sl));
+			break;
+		case 1:
+			assert(llist_remove_last(ll) == slist_remove_last(sl));
+			break;
+		case 2:
+			assert(llist_remove_ith(ll, ith) == slist_remove_ith(sl, ith));
+			break;
+		default:
+			assert(llist_insert_ith(ll, ith, name, name));
+			assert(slist_insert_ith(sl, ith, name, name));
+		}
+	}
+	assert(llist_number_elements(ll) == slist_number_elements(sl));
+	for (i = 0; i < llist_number_elements(ll); i++) {
+		assert(llist_get_ith(ll, i, &n1, &v1) && slist_get_ith(sl, i, &n2, &v2));
+		assert(strcmp(n1, n2) == 0);
+	}
+	assert(!slist_get_ith(sl, i, &n2, &v2));
+
+	slist_clear(sl);
+	slist_insert_first(sl, "Peter", "27 Oak St");
+	slist_insert_last(sl, "George", "23 Oak St");
+	slist_add(sl, "Rachael", "34 Elm St");
+	slist_add(sl, "Peter", "2 Oak St");
+	slist_insert_ith(sl, 1, "Mary", "5 Pine St");
+	slist_remove(sl, "George");
+	slist_print(sl);
+	slist_destroy(sl);
+}
+
+/* Orders entries by the length of their value. */
+static int by_value_length(char *name1, char *value1, char *name2, char *value2, void *context) {
+	(void) name1;
+	(void) name2;
+	(void) context;
+	return (int) strlen(value1) - (int) strlen(value2);
+}
+
+void test23() {
+	LINKED_LIST *ll;
+	char name[20];
+	char *n, *v, *prev;
+	int i;
+
+	ll = llist_create();
+	llist_sort(ll, 1);
+	llist_insert_last(ll, "Peter", "27 Oak St");
+	llist_insert_last(ll, "George", "2 Oak St");
+	llist_insert_last(ll, "Rachael", "34 Elm Street");
+	llist_insert_last(ll, "Peter", "5 Pine St");
+	llist_insert_last(ll, "Mary", "27 Oak St");
+	llist_sort(ll, 0);
+	llist_print(ll);
+	llist_sort_by_value(ll, 1);
+	llist_print(ll);
+	llist_sort_with(ll, by_value_length, NULL);
+	llist_print(ll);
+
+	for (i = 0; i < 1000; i++) {
+		sprintf(name, "name%d", (i * 7919) % 1000);
+		llist_insert_first(ll, name, "value");
+	}
+	llist_sort(ll, 1);
+	prev = "";
+	for (i = 0; i < llist_number_elements(ll); i++) {
+		assert(llist_get_ith(ll, i, &n, &v));
+		assert(strcmp(prev, n) <= 0);
+		prev = n;
+	}
+	assert(llist_get_ith(ll, i - 1, &n, &v) && strcmp(n, "name999") == 0);
+}
+
+#define TEST24_THREADS 4
+#define TEST24_ITEMS 5000
+
+static TWO_LOCK_QUEUE *test24Queue;
+static CONCURRENT_LIST *test24List;
+static int test24Consumed;
+
+/* Inserts TEST24_ITEMS entries, then removes as many as it can. */
+static void *test24_queue_thread(void *arg) {
+	char name[20], *n, *v;
+	int i, got = 0;
+
+	for (i = 0; i < TEST24_ITEMS; i++) {
+		sprintf(name, "t%ld-%d", (long) arg, i);
+		assert(tlqueue_insert_last(test24Queue, name, "value"));
+	}
+	while (tlqueue_remove_first(test24Queue, &n, &v)) {
+		free(n);
+		free(v);
+		got++;
+	}
+	__atomic_add_fetch(&test24Consumed, got, __ATOMIC_RELAXED);
+	return NULL;
+}
+
+/* Adds its share of the names, looks up all of them and removes every other one of its own. */
+static void *test24_list_thread(void *arg) {
+	CLIST_HANDLE *handle = clist_attach(test24List);
+	char name[20], value[20];
+	int i;
+
+	assert(handle != NULL);
+	for (i = (int) (long) arg; i < TEST24_ITEMS; i += TEST24_THREADS) {
+		sprintf(name, "name%05d", i);
+		assert(clist_add(handle, name, "first"));
+		assert(clist_add(handle, name, name));
+	}
+	for (i = 0; i < TEST24_ITEMS; i++) {
+		sprintf(name, "name%05d", i);
+		if (clist_lookup(handle, name, value, sizeof(value))) {
+			assert(strcmp(value, "first") == 0 || strcmp(value, name) == 0);
+		}
+	}
+	for (i = (int) (long) arg; i < TEST24_ITEMS; i += 2 * TEST24_THREADS) {
+		sprintf(name, "name%05d", i);
+		assert(clist_remove(handle, name));
+		assert(!clist_lookup(handle, name, value, sizeof(value)));
+	}
+	clist_detach(handle);
+	return NULL;
+}
+
+/* Removes and adds back the same name as the other threads. Its last operation is an add. */
+static void *test24_churn_thread(void *arg) {
+	CLIST_HANDLE *handle = clist_attach(test24List);
+	char value[20];
+	int i;
+
+	assert(handle != NULL);
+	sprintf(value, "t%ld", (long) arg);
+	for (i = 0; i < TEST24_ITEMS; i++) {
+		clist_remove(handle, "shared");
+		assert(clist_add(handle, "shared", value));
+	}
+	clist_detach(handle);
+	return NULL;
+}
+
+void test24() {
+	pthread_t threads[TEST24_THREADS];
+	CLIST_HANDLE *handle;
+	char *n, *v, value[20];
+	long t;
+
+	test24Queue = tlqueue_create();
+	for (t = 0; t < TEST24_THREADS; t++) {
+		pthread_create(&threads[t], NULL, test24_queue_thread, (void *) t);
+	}
+	for (t = 0; t < TEST24_THREADS; t++) {
+		pthread_join(threads[t], NULL);
+	}
+	while (tlqueue_remove_first(test24Queue, &n, &v)) {
+		free(n);
+		free(v);
+		test24Consumed++;
+	}
+	printf("queue consumed=%d left=%d\n", test24Consumed, tlqueue_number_elements(test24Queue));
+	tlqueue_destroy(test24Queue);
+
+	test24List = clist_create();
+	for (t = 0; t < TEST24_THREADS; t++) {
+		pthread_create(&threads[t], NULL, test24_list_thread, (void *) t);
+	}
+	for (t = 0; t < TEST24_THREADS; t++) {
+		pthread_join(threads[t], NULL);
+	}
+	printf("list nElements=%d\n", clist_number_elements(test24List));
+	handle = clist_attach(test24List);
+	assert(clist_lookup(handle, "name00005", value, sizeof(value)) && strcmp(value, "name00005") == 0);
+	assert(!clist_lookup(handle, "name00000", value, sizeof(value)));
+	assert(!clist_remove(handle, "name00000"));
+	clist_detach(handle);
+	clist_destroy(test24List);
+
+	// The last operation of every thread is an add, so no add may be lost to a remove
+	test24List = clist_create();
+	for (t = 0; t < TEST24_THREADS; t++) {
+		pthread_create(&threads[t], NULL, test24_churn_thread, (void *) t);
+	}
+	for (t = 0; t < TEST24_THREADS; t++) {
+		pthread_join(threads[t], NULL);
+	}
+	handle = clist_attach(test24List);
+	assert(clist_lookup(handle, "shared", value, sizeof(value)));
+	assert(clist_number_elements(test24List) == 1);
+	clist_detach(handle);
+	clist_destroy(test24List);
+
+	test24List = clist_create();
+	handle = clist_attach(test24List);
+	clist_add(handle, "Peter", "27 Oak St");
+	clist_add(handle, "George", "23 Oak St");
+	clist_add(handle, "Rachael", "34 Elm St");
+	clist_add(handle, "Peter", "2 Oak St");
+	clist_remove(handle, "George");
+	clist_detach(handle);
+	clist_print(test24List);
+	clist_destroy(test24List);
+}
+
+#define TEST25_PRODUCERS 2
+#define TEST25_CONSUMERS 2
+#define TEST25_ITEMS 20000 // Per producer
+
+static MPMC_QUEUE *test25Queue;
+static long test25Sum;
+
+/* Enqueues its numbers one at a time and in batches of 7, sleeping when the queue is full. */
+static void *test25_producer(void *arg) {
+	char name[20], value[20], names[7][20], values[7][20];
+	char *np[7], *vp[7];
+	int i, j;
+
+	for (i = 0; i < TEST25_ITEMS / 2; i++) {
+		sprintf(name, "p%ld", (long) arg);
+		sprintf(value, "%d", i);
+		assert(mpmc_enqueue(test25Queue, name, value));
+	}
+	while (i < TEST25_ITEMS) {
+		for (j = 0; j < 7 && i + j < TEST25_ITEMS; j++) {
+			sprintf(names[j], "p%ld", (long) arg);
+			sprintf(values[j], "%d", i + j);
+			np[j] = names[j];
+			vp[j] = values[j];
+		}
+		i += mpmc_enqueue_batch(test25Queue, np, vp, j);
+	}
+	return NULL;
+}
+
+/* Dequeues until the queue is closed and empty, checking that every producer's numbers come in order. */
+static void *test25_consumer(void *arg) {
+	char *n, *v;
+	int last[TEST25_PRODUCERS];
+	long sum = 0;
+	int p;
+
+	(void) arg;
+	for (p = 0; p < TEST25_PRODUCERS; p++) {
+		last[p] = -1;
+	}
+	while (mpmc_dequeue(test25Queue, &n, &v)) {
+		p = atoi(n + 1);
+		assert(atoi(v) > last[p]);
+		last[p] = atoi(v);
+		sum += atoi(v);
+		free(n);
+		free(v);
+	}
+	__atomic_add_fetch(&test25Sum, sum, __ATOMIC_RELAXED);
+	return NULL;
+}
+
+void test25() {
+	pthread_t threads[TEST25_PRODUCERS + TEST25_CONSUMERS];
+	MPMC_QUEUE *queue = mpmc_create(5);
+	char *names[] = { "a", "b", "c", "d", "e", "f", "g", "h", "i", "j" };
+	char *n[10], *v[10];
+	size_t i, k;
+	long t;
+
+	// Capacity rounds up to 8: full, empty and wrapping around
+	assert(mpmc_try_dequeue(queue, &n[0], &v[0]) == 0);
+	assert(mpmc_enqueue_batch(queue, names, names, 10) == 8);
+	assert(mpmc_try_enqueue(queue, "x", "x") == 0);
+	assert(mpmc_size(queue) == 8);
+	for (k = 0; k < 20; k++) {
+		assert(mpmc_try_dequeue(queue, &n[0], &v[0]));
+		assert(strcmp(n[0], names[k % 8]) == 0);
+		free(n[0]);
+		free(v[0]);
+		assert(mpmc_try_enqueue(queue, names[(k + 8) % 8], "v"));
+	}
+	k = mpmc_dequeue_batch(queue, n, v, 10);
+	printf("batch of %zu:", k);
+	for (i = 0; i < k; i++) {
+		printf(" %s", n[i]);
+		free(n[i]);
+		free(v[i]);
+	}
+	printf("\n");
+	assert(mpmc_size(queue) == 0);
+	assert(mpmc_try_enqueue(queue, "left", "behind"));
+	mpmc_close(queue);
+	assert(!mpmc_enqueue(queue, "late", "late"));
+	assert(mpmc_dequeue(queue, &n[0], &v[0]) && strcmp(v[0], "behind") == 0);
+	free(n[0]);
+	free(v[0]);
+	assert(!mpmc_dequeue(queue, &n[0], &v[0]));
+	assert(mpmc_try_enqueue(queue, "freed", "by destroy"));
+	mpmc_destroy(queue);
+
+	// Blocking producers and consumers through a small queue
+	test25Queue = mpmc_create(16);
+	for (t = 0; t < TEST25_PRODUCERS + TEST25_CONSUMERS; t++) {
+		pthread_create(&threads[t], NULL, t < TEST25_PRODUCERS ? test25_producer : test25_consumer, (void *) t);
+	}
+	for (t = 0; t < TEST25_PRODUCERS; t++) {
+		pthread_join(threads[t], NULL);
+	}
+	mpmc_close(test25Queue);
+	for (; t < TEST25_PRODUCERS + TEST25_CONSUMERS; t++) {
+		pthread_join(threads[t], NULL);
+	}
+	assert(test25Sum == (long) TEST25_PRODUCERS * TEST25_ITEMS * (TEST25_ITEMS - 1) / 2);
+	printf("mpmc sum=%ld size=%zu\n", test25Sum, mpmc_size(test25Queue));
+	mpmc_destroy(test25Queue);
+}
+
+/* Checks that the counters of llist_stats of ll match those of a copy built entry by entry. */
+static void test26_check_stats(LINKED_LIST *ll) {
+	LINKED_LIST *copy = llist_create();
+	LLIST_STATS s1, s2;
+	char *n, *v;
+	int i;
+
+	if (ll->inlineStrings) {
+		llist_use_inline_strings(copy);
+	}
+	for (i = 0; llist_get_ith(ll, i, &n, &v); i++) {
+		llist_insert_last(copy, n, v);
+	}
+	llist_stats(ll, &s1);
+	llist_stats(copy, &s2);
+	assert(s1.entries == s2.entries && s1.nameBytes == s2.nameBytes && s1.valueBytes == s2.valueBytes);
+	assert(s1.overheadBytes == s2.overheadBytes);
+	assert(memcmp(s1.keyLengths, s2.keyLengths, sizeof(s1.keyLengths)) == 0);
+	llist_destroy(copy);
+}
+
+void test26() {
+	LINKED_LIST *parts[4], *all, *rest;
+	LLIST_CURSOR cursor, other;
+	char name[20], *n, *v, *before;
+	int i, t;
+
+	// Per-thread results merged into one list without copying
+	all = llist_create();
+	llist_index_names(all);
+	for (t = 0; t < 4; t++) {
+		parts[t] = llist_create();
+		for (i = 0; i < 5; i++) {
+			sprintf(name, "t%d-%d", t, i);
+			llist_insert_last(parts[t], name, name);
+		}
+	}
+	llist_get_ith(parts[2], 0, &n, &v);
+	before = n;
+	for (t = 0; t < 4; t++) {
+		assert(llist_concat(all, parts[t]));
+		assert(llist_number_elements(parts[t]) == 0);
+	}
+	assert(llist_number_elements(all) == 20);
+	assert(llist_get_ith(all, 10, &n, &v) && n == before); // The same node
+	assert(llist_lookup(all, "t3-4") != NULL);
+	test26_check_stats(all);
+
+	// Splice in the middle, in front of a name that is already there
+	llist_insert_last(parts[0], "new", "1");
+	llist_insert_last(parts[0], "t3-0", "spliced");
+	llist_cursor_begin(parts[0], &cursor);
+	assert(llist_cursor_next(&cursor, &n, &v) && strcmp(n, "new") == 0);
+	assert(llist_splice(all, 5, parts[0]));
+	assert(cursor.list == all);
+	assert(llist_cursor_next(&cursor, &n, &v) && strcmp(v, "spliced") == 0);
+	assert(llist_cursor_next(&cursor, &n, &v) && strcmp(n, "t1-0") == 0);
+	llist_cursor_end(&cursor);
+	assert(strcmp(llist_lookup(all, "t3-0"), "spliced") == 0);
+	assert(!llist_splice(all, 23, parts[0]));
+	assert(!llist_concat(all, all));
+	test26_check_stats(all);
+
+	// Split after the first 8 entries
+	rest = llist_create();
+	llist_insert_last(rest, "r", "r");
+	llist_cursor_begin(all, &cursor);
+	for (i = 0; i < 8; i++) {
+		llist_cursor_next(&cursor, &n, &v);
+	}
+	llist_cursor_begin(all, &other);
+	for (i = 0; i < 12; i++) {
+		llist_cursor_next(&other, &n, &v);
+	}
+	assert(llist_split_at_cursor(&cursor, rest));
+	assert(llist_number_elements(all) == 8 && llist_number_elements(rest) == 15);
+	assert(llist_cursor_get(&cursor, &n, &v)); // Still on the 8th
+	assert(!llist_cursor_next(&cursor, &n, &v));
+	assert(other.list == rest && llist_cursor_get(&other, &n, &v) && strcmp(n, "t1-4") == 0);
+	assert(llist_cursor_next(&other, &n, &v) && strcmp(n, "t2-0") == 0);
+	llist_cursor_end(&other);
+	assert(llist_lookup(all, "t3-0") != NULL && strcmp(llist_lookup(all, "t3-0"), "spliced") == 0);
+	assert(llist_lookup(all, "t3-4") == NULL);
+	test26_check_stats(all);
+	test26_check_stats(rest);
+	llist_print(all);
+
+	// Lists that allocate nodes differently
+	llist_use_pool(parts[1], 0);
+	llist_use_inline_strings(parts[2]);
+	llist_insert_last(parts[1], "a", "b");
+	llist_insert_last(parts[2], "a", "b");
+	assert(!llist_concat(all, parts[1]));
+	assert(!llist_concat(all, parts[2]));
+	assert(!llist_concat(parts[2], parts[1]));
+	llist_use_inline_strings(parts[3]);
+	assert(llist_concat(parts[3], parts[2]));
+	test26_check_stats(parts[3]);
+	for (t = 0; t < 4; t++) {
+		llist_destroy(parts[t]);
+	}
+	llist_destroy(all);
+	llist_destroy(rest);
+}
+
+void test27() {
+	LINKED_LIST *ll, *src;
+	LLIST_CURSOR cursor;
+	LLIST_STATS stats, other;
+	FILE *f;
+	char name[20], *n, *v;
+	int i, mode;
+
+	src = llist_create();
+	for (i = 0; i < 50; i++) {
+		sprintf(name, "name%d", i);
+		llist_insert_last(src, name, i % 2 ? "odd" : "an even value");
+	}
+	llist_insert_last(src, "name7", "repeated");
+	assert(llist_save(src, "test27.ll"));
+
+	// Plain, indexed, pooled and inline lists, read into with more and with fewer entries
+	for (mode = 0; mode < 4; mode++) {
+		ll = llist_create();
+		if (mode == 1) {
+			llist_index_names(ll);
+		} else if (mode == 2) {
+			llist_use_pool(ll, 16);
+		} else if (mode == 3) {
+			llist_use_inline_strings(ll);
+		}
+		for (i = 0; i < 80; i++) {
+			sprintf(name, "old%d", i);
+			llist_insert_last(ll, name, i % 3 ? "x" : "a much longer old value");
+		}
+		llist_cursor_begin(ll, &cursor);
+		llist_cursor_next(&cursor, &n, &v);
+		assert(llist_read(ll, "test27.ll"));
+		assert(!llist_cursor_get(&cursor, &n, &v) && !llist_cursor_next(&cursor, &n, &v));
+		assert(llist_number_elements(ll) == 50);
+		assert(llist_lookup(ll, "old0") == NULL);
+		assert(strcmp(llist_lookup(ll, "name7"), "repeated") == 0);
+		assert(llist_get_ith(ll, 49, &n, &v) && strcmp(n, "name49") == 0);
+		if (mode >= 2) { // Slabs and reused blocks have overheads of their own, so only the strings match
+			llist_stats(ll, &stats);
+			llist_stats(src, &other);
+			assert(stats.nameBytes == other.nameBytes - 6 && stats.valueBytes == other.valueBytes - 4);
+		} else {
+			test26_check_stats(ll);
+		}
+
+		llist_clear(ll);
+		llist_stats(ll, &stats);
+		assert(llist_number_elements(ll) == 0 && stats.nameBytes == 0 && stats.valueBytes == 0);
+		llist_insert_last(ll, "a", "b");
+		assert(llist_read(ll, "test27.ll") && llist_number_elements(ll) == 50);
+		if (mode != 2) {
+			test26_check_stats(ll);
+		}
+		llist_cursor_begin(ll, &cursor);
+		llist_destroy(ll);
+		assert(!llist_cursor_next(&cursor, &n, &v));
+	}
+
+	// A file cut in the middle of an entry
+	f = fopen("test27.ll", "w");
+	fprintf(f, "George\n23 Oak St\n\nPeter\n");
+	fclose(f);
+	assert(!llist_read(src, "test27.ll"));
+	llist_print(src);
+	remove("test27.ll");
+	llist_destroy(src);
+}
+
 int main(int argc, char ** argv) {
 
     test1();
@@ -382,11 +1201,26 @@ int main(int argc, char ** argv) {
     test10();
     test11();
     test12();
+    test13();
+    test14();
+    test15();
+    test16();
+    test17();
+    test18();
+    test19();
+    test20();
+    test21();
+    test22();
+    test23();
+    test24();
+    test25();
+    test26();
+    test27();
 
 	/* char * test;
 	
 	if (argc <2) {
-		printf("Usage: test_linked_list test1|test2|...test12\n");
+		printf("Usage: test_linked_list test1|test2|...test27\n");
 		exit(1);
 	}
 
@@ -428,6 +1262,51 @@ int main(int argc, char ** argv) {
 	else if (strcmp(test, "test12")==0) {
 		test12();
 	}
+	else if (strcmp(test, "test13")==0) {
+		test13();
+	}
+	else if (strcmp(test, "test14")==0) {
+		test14();
+	}
+	else if (strcmp(test, "test15")==0) {
+		test15();
+	}
+	else if (strcmp(test, "test16")==0) {
+		test16();
+	}
+	else if (strcmp(test, "test17")==0) {
+		test17();
+	}
+	else if (strcmp(test, "test18")==0) {
+		test18();
+	}
+	else if (strcmp(test, "test19")==0) {
+		test19();
+	}
+	else if (strcmp(test, "test20")==0) {
+		test20();
+	}
+	else if (strcmp(test, "test21")==0) {
+		test21();
+	}
+	else if (strcmp(test, "test22")==0) {
+		test22();
+	}
+	else if (strcmp(test, "test23")==0) {
+		test23();
+	}
+	else if (strcmp(test, "test24")==0) {
+		test24();
+	}
+	else if (strcmp(test, "test25")==0) {
+		test25();
+	}
+	else if (strcmp(test, "test26")==0) {
+		test26();
+	}
+	else if (strcmp(test, "test27")==0) {
+		test27();
+	}
 	else {
 		printf("Test not found!!n");
 		exit(1);
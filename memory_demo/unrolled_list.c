@@ -0,0 +1,772 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "unrolled_list.h"
+
+#define SUCCESS 1
+#define FAILURE 0
+#define NEWLINE '\n'
+#define TERMINATING_NULL_BYTE '\0'
+#define MAXLINE 512
+#define READ_MODE "r"
+#define WRITE_MODE "w"
+#define HALF_BLOCK (ULIST_BLOCK_ENTRIES / 2)
+
+//
+// It returns a new empty unrolled list, or NULL if memory runs out.
+//
+UNROLLED_LIST* ulist_create ()
+{
+    return calloc (1, sizeof (UNROLLED_LIST));
+}
+
+/* Returns a new empty block linked after the block after, or first if after is NULL, or NULL if memory runs out. */
+static ULIST_BLOCK* new_block (UNROLLED_LIST* list, ULIST_BLOCK* after)
+{
+    ULIST_BLOCK* block = malloc (sizeof (ULIST_BLOCK));
+    if (block == NULL)
+    {
+        return NULL;
+    }
+
+    block->count = 0;
+    block->previous = after;
+    block->next = (after != NULL) ? after->next : list->first;
+
+    if (block->previous != NULL)
+    {
+        (block->previous)->next = block;
+    }
+    else
+    {
+        list->first = block;
+    }
+
+    if (block->next != NULL)
+    {
+        (block->next)->previous = block;
+    }
+    else
+    {
+        list->last = block;
+    }
+
+    list->nBlocks ++;
+
+    return block;
+}
+
+/* Unlinks block from the list and frees it, but not its strings. */
+static void free_block (UNROLLED_LIST* list, ULIST_BLOCK* block)
+{
+    if (block->previous != NULL)
+    {
+        (block->previous)->next = block->next;
+    }
+    else
+    {
+        list->first = block->next;
+    }
+
+    if (block->next != NULL)
+    {
+        (block->next)->previous = block->previous;
+    }
+    else
+    {
+        list->last = block->previous;
+    }
+
+    list->nBlocks --;
+    free (block);
+}
+
+/* Moves count entries of from, starting at its offset start, to the end of to. */
+static void move_entries (ULIST_BLOCK* from, int start, int count, ULIST_BLOCK* to)
+{
+    memcpy (&(to->names[to->count]), &(from->names[start]), count * sizeof (char*));
+    memcpy (&(to->values[to->count]), &(from->values[start]), count * sizeof (char*));
+    to->count += count;
+    from->count -= count;
+}
+
+/* Returns the block of entry ith, 0 <= ith < nElements, and its index in the block in *offset. The walk starts from the nearer end of the list and skips a whole block per step. */
+static ULIST_BLOCK* locate (UNROLLED_LIST* list, int ith, int* offset)
+{
+    ULIST_BLOCK* block;
+
+    if (ith < list->nElements / 2)
+    {
+        block = list->first;
+
+        while (ith >= block->count)
+        {
+            ith -= block->count;
+            block = block->next;
+        }
+
+        *offset = ith;
+
+        return block;
+    }
+
+    int left = list->nElements - ith; // Entries from ith to the end
+
+    block = list->last;
+
+    while (left > block->count)
+    {
+        left -= block->count;
+        block = block->previous;
+    }
+
+    *offset = block->count - left;
+
+    return block;
+}
+
+/* Returns the block with the first entry called name and its index in *offset, or NULL. */
+static ULIST_BLOCK* find (UNROLLED_LIST* list, char* name, int* offset)
+{
+    ULIST_BLOCK* block;
+    int i; // Entry index in the block
+
+    for (block = list->first; block != NULL; block = block->next)
+    {
+        for (i = 0; i < block->count; i ++)
+        {
+            if (strcmp (block->names[i], name) == 0)
+            {
+                *offset = i;
+                return block;
+            }
+        }
+    }
+
+    return NULL;
+}
+
+/* Puts copies of name and value at offset of block, from 0 to block->count, or in a new block if the list is empty (block is NULL). An entry that goes at either end of a full block moves to the neighbouring block if it has room, and otherwise starts a new block, so that filling the list from either end leaves full blocks. Anywhere else a full block splits in two. */
+static int insert_at (UNROLLED_LIST* list, ULIST_BLOCK* block, int offset, char* name, char* value)
+{
+    char* nameCopy = strdup (name);
+    char* valueCopy = strdup (value);
+
+    if ((nameCopy == NULL) || (valueCopy == NULL))
+    {
+        free (nameCopy);
+        free (valueCopy);
+        return FAILURE;
+    }
+
+    if ((block != NULL) && (block->count == ULIST_BLOCK_ENTRIES))
+    {
+        if ((offset == 0) && (block->previous != NULL) && ((block->previous)->count < ULIST_BLOCK_ENTRIES))
+        {
+            block = block->previous;
+            offset = block->count;
+        }
+
+        else if ((offset == ULIST_BLOCK_ENTRIES) && (block->next != NULL) && ((block->next)->count < ULIST_BLOCK_ENTRIES))
+        {
+            block = block->next;
+            offset = 0;
+        }
+
+        else
+        {
+            ULIST_BLOCK* newBlock = new_block (list, (offset == 0) ? block->previous : block);
+            if (newBlock == NULL)
+            {
+                free (nameCopy);
+                free (valueCopy);
+                return FAILURE;
+            }
+
+            if ((offset > 0) && (offset < ULIST_BLOCK_ENTRIES)) // Split: the upper half moves to the new block
+            {
+                move_entries (block, HALF_BLOCK, ULIST_BLOCK_ENTRIES - HALF_BLOCK, newBlock);
+
+                if (offset > HALF_BLOCK)
+                {
+                    offset -= HALF_BLOCK;
+                    block = newBlock;
+                }
+            }
+
+            else
+            {
+                block = newBlock;
+                offset = 0;
+            }
+        }
+    }
+
+    else if (block == NULL)
+    {
+        block = new_block (list, NULL);
+        if (block == NULL)
+        {
+            free (nameCopy);
+            free (valueCopy);
+            return FAILURE;
+        }
+    }
+
+    memmove (&(block->names[offset + 1]), &(block->names[offset]), (block->count - offset) * sizeof (char*));
+    memmove (&(block->values[offset + 1]), &(block->values[offset]), (block->count - offset) * sizeof (char*));
+    block->names[offset] = nameCopy;
+    block->values[offset] = valueCopy;
+    block->count ++;
+    list->nElements ++;
+
+    return SUCCESS;
+}
+
+/* Removes the entry at offset of block and frees its strings. A block left empty is freed, and one less than half full merges with a neighbour if both fit in one block. */
+static void remove_at (UNROLLED_LIST* list, ULIST_BLOCK* block, int offset)
+{
+    free (block->names[offset]);
+    free (block->values[offset]);
+
+    memmove (&(block->names[offset]), &(block->names[offset + 1]), (block->count - offset - 1) * sizeof (char*));
+    memmove (&(block->values[offset]), &(block->values[offset + 1]), (block->count - offset - 1) * sizeof (char*));
+    block->count --;
+    list->nElements --;
+
+    if (block->count == 0)
+    {
+        free_block (list, block);
+    }
+
+    else if (block->count < HALF_BLOCK)
+    {
+        ULIST_BLOCK* next = block->next;
+        ULIST_BLOCK* previous = block->previous;
+
+        if ((next != NULL) && (block->count + next->count <= ULIST_BLOCK_ENTRIES))
+        {
+            move_entries (next, 0, next->count, block);
+            free_block (list, next);
+        }
+
+        else if ((previous != NULL) && (previous->count + block->count <= ULIST_BLOCK_ENTRIES))
+        {
+            move_entries (block, 0, block->count, previous);
+            free_block (list, block);
+        }
+    }
+}
+
+//
+// It removes every entry and frees them, keeping the list itself.
+//
+void ulist_clear (UNROLLED_LIST* list)
+{
+    int i; // Entry index in the block
+
+    while (list->first != NULL)
+    {
+        ULIST_BLOCK* block = list->first;
+
+        for (i = 0; i < block->count; i ++)
+        {
+            free (block->names[i]);
+            free (block->values[i]);
+        }
+
+        free_block (list, block);
+    }
+
+    list->nElements = 0;
+}
+
+//
+// It frees the list with all its entries.
+//
+void ulist_destroy (UNROLLED_LIST* list)
+{
+    ulist_clear (list);
+    free (list);
+}
+
+//
+// It prints the list in the format of llist_print.
+//
+void ulist_print (UNROLLED_LIST* list)
+{
+    ULIST_BLOCK* block;
+    int i; // Entry index in the block
+
+    printf ("===== List =====\n");
+    printf ("nElements=%d\n", list->nElements);
+
+    for (block = list->first; block != NULL; block = block->next)
+    {
+        for (i = 0; i < block->count; i ++)
+        {
+            printf ("name=\"%s\" value=\"%s\"\n", block->names[i], block->values[i]);
+        }
+    }
+
+    printf ("======== End List =======\n");
+}
+
+//
+// Like llist_add, it replaces the value of the first entry called name, or else adds
+// name/value at the end of the list. The list stores copies of both strings.
+// It will return 1 if successful, or 0 if memory runs out.
+//
+int ulist_add (UNROLLED_LIST* list, char* name, char* value)
+{
+    int offset;
+    ULIST_BLOCK* block = find (list, name, &offset);
+
+    if (block != NULL)
+    {
+        char* copy = strdup (value);
+        if (copy == NULL)
+        {
+            return FAILURE;
+        }
+
+        free (block->values[offset]);
+        block->values[offset] = copy;
+
+        return SUCCESS;
+    }
+
+    return ulist_insert_last (list, name, value);
+}
+
+//
+// It returns the value of the first entry called name, or NULL if there is none.
+//
+char* ulist_lookup (UNROLLED_LIST* list, char* name)
+{
+    int offset;
+    ULIST_BLOCK* block = find (list, name, &offset);
+
+    return (block != NULL) ? block->values[offset] : NULL;
+}
+
+//
+// It removes the first entry called name. It will return 1 if successful, or 0 if there is
+// none.
+//
+int ulist_remove (UNROLLED_LIST* list, char* name)
+{
+    int offset;
+    ULIST_BLOCK* block = find (list, name, &offset);
+
+    if (block == NULL)
+    {
+        return FAILURE;
+    }
+
+    remove_at (list, block, offset);
+
+    return SUCCESS;
+}
+
+//
+// It returns in *name and *value the entry at position ith, in O(nBlocks).
+// It will return 1 if successful, or 0 if ith is out of bounds.
+//
+int ulist_get_ith (UNROLLED_LIST* list, int ith, char** name, char** value)
+{
+    int offset;
+
+    if ((ith < 0) || (ith >= list->nElements))
+    {
+        return FAILURE;
+    }
+
+    ULIST_BLOCK* block = locate (list, ith, &offset);
+
+    *name = block->names[offset];
+    *value = block->values[offset];
+
+    return SUCCESS;
+}
+
+//
+// It removes the entry at position ith. It will return 1 if successful, or 0 if ith is out
+// of bounds.
+//
+int ulist_remove_ith (UNROLLED_LIST* list, int ith)
+{
+    int offset;
+
+    if ((ith < 0) || (ith >= list->nElements))
+    {
+        return FAILURE;
+    }
+
+    ULIST_BLOCK* block = locate (list, ith, &offset);
+
+    remove_at (list, block, offset);
+
+    return SUCCESS;
+}
+
+//
+// It returns the number of elements in the list.
+//
+int ulist_number_elements (UNROLLED_LIST* list)
+{
+    return list->nElements;
+}
+
+//
+// It saves the list in file_name, in the format of llist_save.
+// It will return 1 if successful, or 0 otherwise.
+//
+int ulist_save (UNROLLED_LIST* list, char* file_name)
+{
+    ULIST_BLOCK* block;
+    int i; // Entry index in the block
+
+    FILE* fout = fopen (file_name, WRITE_MODE);
+    if (fout == NULL)
+    {
+        return FAILURE;
+    }
+
+    for (block = list->first; block != NULL; block = block->next)
+    {
+        for (i = 0; i < block->count; i ++)
+        {
+            fprintf (fout, "%s\n%s\n\n", block->names[i], block->values[i]);
+        }
+    }
+
+    return (fclose (fout) == 0) ? SUCCESS : FAILURE;
+}
+
+/* Reads one line without its newline. It will return 1 if successful, or 0 at the end of the file. */
+static int read_line (FILE* fin, char* line)
+{
+    if (fgets (line, MAXLINE + 1, fin) == NULL)
+    {
+        return FAILURE;
+    }
+
+    size_t len = strlen (line);
+
+    if ((len > 0) && (line[len - 1] == NEWLINE))
+    {
+        line[len - 1] = TERMINATING_NULL_BYTE;
+    }
+
+    return SUCCESS;
+}
+
+//
+// It replaces the entries of the list with the ones in file_name, saved by ulist_save or
+// llist_save, adding them with ulist_add. It will return 1 if successful, or 0 otherwise.
+//
+int ulist_read (UNROLLED_LIST* list, char* file_name)
+{
+    char name[MAXLINE + 1];
+    char value[MAXLINE + 1];
+    char separator[MAXLINE + 1];
+
+    FILE* fin = fopen (file_name, READ_MODE);
+    if (fin == NULL)
+    {
+        return FAILURE;
+    }
+
+    ulist_clear (list);
+
+    while (read_line (fin, name))
+    {
+        if ((read_line (fin, value) == FAILURE) || (read_line (fin, separator) == FAILURE) ||
+            (ulist_add (list, name, value) == FAILURE))
+        {
+            fclose (fin);
+            return FAILURE;
+        }
+    }
+
+    fclose (fin);
+
+    return SUCCESS;
+}
+
+/* Merges the sorted runs entries[left..middle) and entries[middle..right) into merged, taking from the left run on equal names so that the merge is stable. */
+static void merge_runs (KV_ENTRY* entries, KV_ENTRY* merged, size_t left, size_t middle, size_t right, int ascending)
+{
+    size_t i = left, j = middle, k = left;
+
+    while ((i < middle) && (j < right))
+    {
+        int cmp = strcmp (entries[i].name, entries[j].name);
+
+        merged[k ++] = ((ascending ? cmp : -cmp) <= 0) ? entries[i ++] : entries[j ++];
+    }
+
+    while (i < middle)
+    {
+        merged[k ++] = entries[i ++];
+    }
+
+    while (j < right)
+    {
+        merged[k ++] = entries[j ++];
+    }
+}
+
+//
+// It sorts the list by name, in ascending (1) or descending (0) order. Entries with the
+// same name keep their order, like llist_sort. The entries are merge sorted bottom up in an
+// array and put back into the same blocks.
+// It will return 1 if successful, or 0 if memory runs out.
+//
+int ulist_sort (UNROLLED_LIST* list, int ascending)
+{
+    ULIST_BLOCK* block;
+    size_t n = (size_t) list->nElements;
+    size_t width, left; // Length of the runs merged in this pass, and start of a pair of runs
+    int i, j = 0; // Entry index in the block and in the array
+
+    if (n < 2)
+    {
+        return SUCCESS;
+    }
+
+    KV_ENTRY* entries = malloc (2 * n * sizeof (KV_ENTRY)); // The entries, then room to merge them
+    if (entries == NULL)
+    {
+        return FAILURE;
+    }
+
+    KV_ENTRY* from = entries;
+    KV_ENTRY* to = entries + n;
+
+    for (block = list->first; block != NULL; block = block->next)
+    {
+        for (i = 0; i < block->count; i ++, j ++)
+        {
+            entries[j].name = block->names[i];
+            entries[j].value = block->values[i];
+        }
+    }
+
+    for (width = 1; width < n; width *= 2)
+    {
+        for (left = 0; left < n; left += 2 * width)
+        {
+            size_t middle = (left + width < n) ? left + width : n;
+            size_t right = (left + 2 * width < n) ? left + 2 * width : n;
+
+            merge_runs (from, to, left, middle, right, ascending);
+        }
+
+        KV_ENTRY* swap = from;
+        from = to;
+        to = swap;
+    }
+
+    for (block = list->first, j = 0; block != NULL; block = block->next)
+    {
+        for (i = 0; i < block->count; i ++, j ++)
+        {
+            block->names[i] = from[j].name;
+            block->values[i] = from[j].value;
+        }
+    }
+
+    free (entries);
+
+    return SUCCESS;
+}
+
+//
+// It removes the first entry, in O(1). It will return 1 if successful, or 0 if the list is
+// empty.
+//
+int ulist_remove_first (UNROLLED_LIST* list)
+{
+    if (list->first == NULL)
+    {
+        return FAILURE;
+    }
+
+    remove_at (list, list->first, 0);
+
+    return SUCCESS;
+}
+
+//
+// It removes the last entry, in O(1). It will return 1 if successful, or 0 if the list is
+// empty.
+//
+int ulist_remove_last (UNROLLED_LIST* list)
+{
+    if (list->last == NULL)
+    {
+        return FAILURE;
+    }
+
+    remove_at (list, list->last, (list->last)->count - 1);
+
+    return SUCCESS;
+}
+
+//
+// It inserts name/value before the first entry, without checking whether name is in the
+// list. It will return 1 if successful, or 0 if memory runs out.
+//
+int ulist_insert_first (UNROLLED_LIST* list, char* name, char* value)
+{
+    return insert_at (list, list->first, 0, name, value);
+}
+
+//
+// It inserts name/value after the last entry, without checking whether name is in the list.
+// It will return 1 if successful, or 0 if memory runs out.
+//
+int ulist_insert_last (UNROLLED_LIST* list, char* name, char* value)
+{
+    return insert_at (list, list->last, (list->last != NULL) ? (list->last)->count : 0, name, value);
+}
+
+//
+// It inserts name/value so that it becomes the entry at position ith, from 0 to nElements,
+// without checking whether name is in the list. Finding the position costs O(nBlocks) and
+// the insertion moves at most one block of entries.
+// It will return 1 if successful, or 0 if ith is out of bounds or memory runs out.
+//
+int ulist_insert_ith (UNROLLED_LIST* list, int ith, char* name, char* value)
+{
+    int offset;
+
+    if ((ith < 0) || (ith > list->nElements))
+    {
+        return FAILURE;
+    }
+
+    if (ith == list->nElements)
+    {
+        return ulist_insert_last (list, name, value);
+    }
+
+    ULIST_BLOCK* block = locate (list, ith, &offset);
+
+    return insert_at (list, block, offset, name, value);
+}
+
+//
+// It starts a walk of the list from the first entry.
+//
+void ulist_cursor_begin (UNROLLED_LIST* list, ULIST_CURSOR* cursor)
+{
+    cursor->block = list->first;
+    cursor->offset = 0;
+}
+
+//
+// It returns in *name and *value the next entry of the walk, and moves past it.
+// It will return 1 if successful, or 0 at the end of the list.
+//
+int ulist_cursor_next (ULIST_CURSOR* cursor, char** name, char** value)
+{
+    ULIST_BLOCK* block = cursor->block;
+
+    if (block == NULL)
+    {
+        return FAILURE;
+    }
+
+    *name = block->names[cursor->offset];
+    *value = block->values[cursor->offset];
+
+    if (++ cursor->offset == block->count)
+    {
+        cursor->block = block->next;
+        cursor->offset = 0;
+    }
+
+    return SUCCESS;
+}
+
+/* The ulist_kv_ops functions. */
+static void* kv_ulist_create ()
+{
+    return ulist_create ();
+}
+
+static void kv_ulist_destroy (void* store)
+{
+    ulist_destroy ((UNROLLED_LIST*) store);
+}
+
+static int kv_ulist_add (void* store, char* name, char* value)
+{
+    return ulist_add ((UNROLLED_LIST*) store, name, value);
+}
+
+static char* kv_ulist_lookup (void* store, char* name)
+{
+    return ulist_lookup ((UNROLLED_LIST*) store, name);
+}
+
+static int kv_ulist_remove (void* store, char* name)
+{
+    return ulist_remove ((UNROLLED_LIST*) store, name);
+}
+
+static size_t kv_ulist_count (void* store)
+{
+    return (size_t) ulist_number_elements ((UNROLLED_LIST*) store);
+}
+
+static int kv_ulist_get_ith (void* store, size_t ith, char** name, char** value)
+{
+    UNROLLED_LIST* list = store;
+
+    if (ith >= (size_t) list->nElements)
+    {
+        return FAILURE;
+    }
+
+    return ulist_get_ith (list, (int) ith, name, value);
+}
+
+static int kv_ulist_insert_first (void* store, char* name, char* value)
+{
+    return ulist_insert_first ((UNROLLED_LIST*) store, name, value);
+}
+
+static int kv_ulist_insert_last (void* store, char* name, char* value)
+{
+    return ulist_insert_last ((UNROLLED_LIST*) store, name, value);
+}
+
+static void kv_ulist_sort (void* store, int ascending)
+{
+    ulist_sort ((UNROLLED_LIST*) store, ascending);
+}
+
+static void kv_ulist_clear (void* store)
+{
+    ulist_clear ((UNROLLED_LIST*) store);
+}
+
+static int kv_ulist_save (void* store, char* file_name)
+{
+    return ulist_save ((UNROLLED_LIST*) store, file_name);
+}
+
+static int kv_ulist_read (void* store, char* file_name)
+{
+    return ulist_read ((UNROLLED_LIST*) store, file_name);
+}
+
+const KV_STORE_OPS ulist_kv_ops =
+{
+    "ulist", kv_ulist_create, kv_ulist_destroy, kv_ulist_add, kv_ulist_lookup, kv_ulist_remove, kv_ulist_count, kv_ulist_get_ith,
+    kv_ulist_insert_first, kv_ulist_insert_last, kv_ulist_sort, kv_ulist_clear, kv_ulist_save, kv_ulist_read
+};
@@ -0,0 +1,67 @@
+#if !defined UNROLLED_LIST_H
+#define UNROLLED_LIST_H
+
+#include "../common/kv_store.h"
+
+// Entries per block. 14 name/value pairs and the block header fit in four cache lines.
+#if !defined ULIST_BLOCK_ENTRIES
+#define ULIST_BLOCK_ENTRIES 14
+#endif
+
+// A block of up to ULIST_BLOCK_ENTRIES consecutive entries of an unrolled list. The names
+// are kept apart from the values, so that a search for a name scans one array.
+typedef struct ULIST_BLOCK
+{
+	struct ULIST_BLOCK* next; // NULL in the last block
+	struct ULIST_BLOCK* previous; // NULL in the first block
+	int count; // Entries used, at the start of names and values
+	char* names[ULIST_BLOCK_ENTRIES];
+	char* values[ULIST_BLOCK_ENTRIES];
+} ULIST_BLOCK;
+
+// A list of name/value pairs like LINKED_LIST, with the same operations and order, that
+// stores its entries in blocks instead of one node each. A walk of the list then follows
+// one pointer per block instead of one per entry. A full block splits in two when an entry
+// goes into it, and a block less than half full merges with a neighbour when they fit in
+// one block, so that the blocks stay at least about half full.
+typedef struct UNROLLED_LIST
+{
+	int nElements;
+	int nBlocks;
+	ULIST_BLOCK* first; // NULL if the list is empty
+	ULIST_BLOCK* last;
+} UNROLLED_LIST;
+
+// Walks the entries of an unrolled list in order, see ulist_cursor_begin. The list must not
+// change during the walk.
+typedef struct ULIST_CURSOR
+{
+	ULIST_BLOCK* block; // Block of the next entry, NULL at the end
+	int offset; // Index of the next entry in block
+} ULIST_CURSOR;
+
+UNROLLED_LIST* ulist_create ();
+void ulist_destroy (UNROLLED_LIST* list);
+void ulist_clear (UNROLLED_LIST* list);
+void ulist_print (UNROLLED_LIST* list);
+int ulist_add (UNROLLED_LIST* list, char* name, char* value);
+char* ulist_lookup (UNROLLED_LIST* list, char* name);
+int ulist_remove (UNROLLED_LIST* list, char* name);
+int ulist_get_ith (UNROLLED_LIST* list, int ith, char** name, char** value);
+int ulist_remove_ith (UNROLLED_LIST* list, int ith);
+int ulist_number_elements (UNROLLED_LIST* list);
+int ulist_save (UNROLLED_LIST* list, char* file_name);
+int ulist_read (UNROLLED_LIST* list, char* file_name);
+int ulist_sort (UNROLLED_LIST* list, int ascending);
+int ulist_remove_first (UNROLLED_LIST* list);
+int ulist_remove_last (UNROLLED_LIST* list);
+int ulist_insert_first (UNROLLED_LIST* list, char* name, char* value);
+int ulist_insert_last (UNROLLED_LIST* list, char* name, char* value);
+int ulist_insert_ith (UNROLLED_LIST* list, int ith, char* name, char* value);
+void ulist_cursor_begin (UNROLLED_LIST* list, ULIST_CURSOR* cursor);
+int ulist_cursor_next (ULIST_CURSOR* cursor, char** name, char** value);
+
+// The unrolled list as a KV_STORE backend, called "ulist"
+extern const KV_STORE_OPS ulist_kv_ops;
+
+#endif
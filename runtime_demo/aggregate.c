@@ -0,0 +1,417 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "aggregate.h"
+
+#if defined __x86_64__ && (defined __GNUC__ || defined __clang__)
+#define AGGREGATE_X86 1
+#include <immintrin.h>
+#endif
+
+#define SUCCESS 1
+#define FAILURE 0
+
+/* What one thread computes over its part of the column. */
+typedef struct PARTIAL
+{
+    __int128 sum;
+    int64_t min;
+    int64_t max;
+    size_t countInRange;
+    size_t* histogram;
+} PARTIAL;
+
+typedef void (*KERNEL) (const int64_t* values, size_t n, int64_t low, int64_t high, PARTIAL* partial);
+
+typedef struct WORKER
+{
+    AGGREGATE* agg;
+    KERNEL kernel;
+    const char* first;
+    size_t stride;
+    size_t begin;
+    size_t end;
+    PARTIAL partial;
+    int status;
+} WORKER;
+
+/* Reference kernel. The vector kernels must give the same results. */
+static void kernel_scalar (const int64_t* values, size_t n, int64_t low, int64_t high, PARTIAL* partial)
+{
+    size_t i; // Column index
+
+    for (i = 0; i < n; i ++)
+    {
+        int64_t v = values[i];
+
+        partial->sum += v;
+
+        if (v < partial->min)
+        {
+            partial->min = v;
+        }
+
+        if (v > partial->max)
+        {
+            partial->max = v;
+        }
+
+        partial->countInRange += (v >= low) && (v <= high);
+    }
+}
+
+#if defined AGGREGATE_X86
+
+/* Every lane keeps its sum modulo 2^64 and counts how often it wrapped, which makes the sum
+exact: lane total = sum + carries * 2^64. A lane wraps when both operands differ in sign from the result. */
+__attribute__ ((target ("avx2")))
+static void kernel_avx2 (const int64_t* values, size_t n, int64_t low, int64_t high, PARTIAL* partial)
+{
+    __m256i sum = _mm256_setzero_si256 ();
+    __m256i carries = _mm256_setzero_si256 ();
+    __m256i min = _mm256_set1_epi64x (partial->min);
+    __m256i max = _mm256_set1_epi64x (partial->max);
+    __m256i inRange = _mm256_setzero_si256 ();
+    __m256i zero = _mm256_setzero_si256 ();
+    __m256i lowV = _mm256_set1_epi64x (low);
+    __m256i highV = _mm256_set1_epi64x (high);
+    int64_t lanes[4];
+    size_t i; // Column index
+    int lane;
+
+    for (i = 0; i + 4 <= n; i += 4)
+    {
+        __m256i v = _mm256_loadu_si256 ((const __m256i*) (values + i));
+        __m256i next = _mm256_add_epi64 (sum, v);
+        __m256i wrapped = _mm256_cmpgt_epi64 (zero, _mm256_and_si256 (_mm256_xor_si256 (sum, next), _mm256_xor_si256 (v, next)));
+        __m256i negative = _mm256_cmpgt_epi64 (zero, v);
+
+        // +1 for a lane that wrapped upwards, -1 for one that wrapped downwards
+        carries = _mm256_sub_epi64 (carries, wrapped);
+        carries = _mm256_add_epi64 (carries, _mm256_slli_epi64 (_mm256_and_si256 (wrapped, negative), 1));
+        sum = next;
+
+        min = _mm256_blendv_epi8 (min, v, _mm256_cmpgt_epi64 (min, v));
+        max = _mm256_blendv_epi8 (max, v, _mm256_cmpgt_epi64 (v, max));
+
+        // low <= v <= high is !(low > v) && !(v > high); the masks are -1, so subtract them
+        __m256i outside = _mm256_or_si256 (_mm256_cmpgt_epi64 (lowV, v), _mm256_cmpgt_epi64 (v, highV));
+        inRange = _mm256_sub_epi64 (inRange, _mm256_andnot_si256 (outside, _mm256_set1_epi64x (-1)));
+    }
+
+    _mm256_storeu_si256 ((__m256i*) lanes, sum);
+    for (lane = 0; lane < 4; lane ++)
+    {
+        partial->sum += lanes[lane];
+    }
+
+    _mm256_storeu_si256 ((__m256i*) lanes, carries);
+    for (lane = 0; lane < 4; lane ++)
+    {
+        partial->sum += (__int128) lanes[lane] * ((__int128) 1 << 64);
+    }
+
+    _mm256_storeu_si256 ((__m256i*) lanes, min);
+    for (lane = 0; lane < 4; lane ++)
+    {
+        partial->min = (lanes[lane] < partial->min) ? lanes[lane] : partial->min;
+    }
+
+    _mm256_storeu_si256 ((__m256i*) lanes, max);
+    for (lane = 0; lane < 4; lane ++)
+    {
+        partial->max = (lanes[lane] > partial->max) ? lanes[lane] : partial->max;
+    }
+
+    _mm256_storeu_si256 ((__m256i*) lanes, inRange);
+    for (lane = 0; lane < 4; lane ++)
+    {
+        partial->countInRange += (size_t) lanes[lane];
+    }
+
+    kernel_scalar (values + i, n - i, low, high, partial); // Last 0..3 values
+}
+
+/* The same as kernel_avx2 with two lanes. 64 bit compares need SSE4.2. */
+__attribute__ ((target ("sse4.2")))
+static void kernel_sse42 (const int64_t* values, size_t n, int64_t low, int64_t high, PARTIAL* partial)
+{
+    __m128i sum = _mm_setzero_si128 ();
+    __m128i carries = _mm_setzero_si128 ();
+    __m128i min = _mm_set1_epi64x (partial->min);
+    __m128i max = _mm_set1_epi64x (partial->max);
+    __m128i inRange = _mm_setzero_si128 ();
+    __m128i zero = _mm_setzero_si128 ();
+    __m128i lowV = _mm_set1_epi64x (low);
+    __m128i highV = _mm_set1_epi64x (high);
+    int64_t lanes[2];
+    size_t i; // Column index
+    int lane;
+
+    for (i = 0; i + 2 <= n; i += 2)
+    {
+        __m128i v = _mm_loadu_si128 ((const __m128i*) (values + i));
+        __m128i next = _mm_add_epi64 (sum, v);
+        __m128i wrapped = _mm_cmpgt_epi64 (zero, _mm_and_si128 (_mm_xor_si128 (sum, next), _mm_xor_si128 (v, next)));
+        __m128i negative = _mm_cmpgt_epi64 (zero, v);
+
+        carries = _mm_sub_epi64 (carries, wrapped);
+        carries = _mm_add_epi64 (carries, _mm_slli_epi64 (_mm_and_si128 (wrapped, negative), 1));
+        sum = next;
+
+        min = _mm_blendv_epi8 (min, v, _mm_cmpgt_epi64 (min, v));
+        max = _mm_blendv_epi8 (max, v, _mm_cmpgt_epi64 (v, max));
+
+        __m128i outside = _mm_or_si128 (_mm_cmpgt_epi64 (lowV, v), _mm_cmpgt_epi64 (v, highV));
+        inRange = _mm_sub_epi64 (inRange, _mm_andnot_si128 (outside, _mm_set1_epi64x (-1)));
+    }
+
+    _mm_storeu_si128 ((__m128i*) lanes, sum);
+    partial->sum += (__int128) lanes[0] + lanes[1];
+
+    _mm_storeu_si128 ((__m128i*) lanes, carries);
+    partial->sum += ((__int128) lanes[0] + lanes[1]) * ((__int128) 1 << 64);
+
+    _mm_storeu_si128 ((__m128i*) lanes, min);
+    for (lane = 0; lane < 2; lane ++)
+    {
+        partial->min = (lanes[lane] < partial->min) ? lanes[lane] : partial->min;
+    }
+
+    _mm_storeu_si128 ((__m128i*) lanes, max);
+    for (lane = 0; lane < 2; lane ++)
+    {
+        partial->max = (lanes[lane] > partial->max) ? lanes[lane] : partial->max;
+    }
+
+    _mm_storeu_si128 ((__m128i*) lanes, inRange);
+    partial->countInRange += (size_t) lanes[0] + (size_t) lanes[1];
+
+    kernel_scalar (values + i, n - i, low, high, partial); // Last value, if n is odd
+}
+
+#endif
+
+/* Picks the widest kernel the CPU runs. */
+static KERNEL pick_kernel (AGGREGATE* agg)
+{
+#if defined AGGREGATE_X86
+    if (!(agg->scalarOnly))
+    {
+        __builtin_cpu_init ();
+
+        if (__builtin_cpu_supports ("avx2"))
+        {
+            return kernel_avx2;
+        }
+
+        if (__builtin_cpu_supports ("sse4.2"))
+        {
+            return kernel_sse42;
+        }
+    }
+#else
+    (void) agg;
+#endif
+
+    return kernel_scalar;
+}
+
+/* Counts the values of a block in the histogram of a partial. */
+static void add_to_histogram (AGGREGATE* agg, const int64_t* values, size_t n, size_t* histogram)
+{
+    size_t i; // Column index
+
+    for (i = 0; i < n; i ++)
+    {
+        // Unsigned difference: no overflow for any pair of int64 values
+        uint64_t offset = (uint64_t) values[i] - (uint64_t) agg->histLow;
+
+        if ((values[i] >= agg->histLow) && (offset / (uint64_t) agg->histWidth < agg->nBuckets))
+        {
+            histogram[offset / (uint64_t) agg->histWidth] ++;
+        }
+    }
+}
+
+/* Aggregates the values begin..end-1 of a worker. A strided column is copied a block at a time
+into a buffer that stays in L1, so that the kernels always read contiguous values. */
+static void* run_worker (void* workerPtr)
+{
+    WORKER* worker = workerPtr;
+    AGGREGATE* agg = worker->agg;
+    int64_t buffer[AGGREGATE_BLOCK];
+    size_t i; // Column index
+    size_t j; // Block index
+
+    for (i = worker->begin; i < worker->end; i += AGGREGATE_BLOCK)
+    {
+        size_t n = (worker->end - i < AGGREGATE_BLOCK) ? worker->end - i : AGGREGATE_BLOCK;
+        const int64_t* block = (const int64_t*) (worker->first + i * worker->stride);
+
+        if (worker->stride != sizeof (int64_t))
+        {
+            for (j = 0; j < n; j ++)
+            {
+                memcpy (&buffer[j], worker->first + (i + j) * worker->stride, sizeof (int64_t));
+            }
+
+            block = buffer;
+        }
+
+        worker->kernel (block, n, agg->rangeLow, agg->rangeHigh, &(worker->partial));
+
+        if (agg->nBuckets > 0)
+        {
+            add_to_histogram (agg, block, n, worker->partial.histogram);
+        }
+    }
+
+    return NULL;
+}
+
+//
+// It sets the inputs of agg so that it computes only the count, sum, min and max.
+//
+void aggregate_init (AGGREGATE* agg)
+{
+    memset (agg, 0, sizeof (AGGREGATE));
+    agg->rangeLow = 1; // Empty range
+    agg->rangeHigh = 0;
+    agg->histWidth = 1;
+}
+
+//
+// It aggregates n values that are stride bytes apart, starting at first, into the outputs
+// of agg. It will return 1 if successful, or 0 if the histogram has a width under 1 or
+// memory runs out.
+//
+int aggregate_strided (AGGREGATE* agg, const void* first, size_t stride, size_t n)
+{
+    WORKER workers[AGGREGATE_MAX_THREADS];
+    pthread_t threads[AGGREGATE_MAX_THREADS];
+    size_t nWorkers = 1;
+    size_t w; // Worker index
+    size_t b; // Bucket index
+    int status = SUCCESS;
+
+    if ((agg->nBuckets > 0) && ((agg->histWidth < 1) || (agg->histogram == NULL)))
+    {
+        return FAILURE;
+    }
+
+    if (!(agg->scalarOnly))
+    {
+        long cpus = sysconf (_SC_NPROCESSORS_ONLN);
+
+        nWorkers = n / AGGREGATE_VALUES_PER_THREAD;
+        nWorkers = (cpus > 0 && nWorkers > (size_t) cpus) ? (size_t) cpus : nWorkers;
+        nWorkers = (nWorkers > AGGREGATE_MAX_THREADS) ? AGGREGATE_MAX_THREADS : nWorkers;
+        nWorkers = (nWorkers < 1) ? 1 : nWorkers;
+    }
+
+    KERNEL kernel = pick_kernel (agg);
+
+    for (w = 0; w < nWorkers; w ++)
+    {
+        workers[w].agg = agg;
+        workers[w].kernel = kernel;
+        workers[w].first = first;
+        workers[w].stride = stride;
+        workers[w].begin = n / nWorkers * w;
+        workers[w].end = (w == nWorkers - 1) ? n : n / nWorkers * (w + 1);
+        workers[w].partial.sum = 0;
+        workers[w].partial.min = INT64_MAX;
+        workers[w].partial.max = INT64_MIN;
+        workers[w].partial.countInRange = 0;
+        workers[w].partial.histogram = NULL;
+        workers[w].status = SUCCESS;
+
+        if (agg->nBuckets > 0)
+        {
+            workers[w].partial.histogram = calloc (agg->nBuckets, sizeof (size_t));
+            if (workers[w].partial.histogram == NULL)
+            {
+                status = FAILURE;
+            }
+        }
+    }
+
+    if (status == SUCCESS)
+    {
+        // Worker 0 runs on this thread; the others fall back to it if they cannot start
+        for (w = 1; w < nWorkers; w ++)
+        {
+            workers[w].status = (pthread_create (&threads[w], NULL, run_worker, &workers[w]) == 0);
+        }
+
+        run_worker (&workers[0]);
+
+        for (w = 1; w < nWorkers; w ++)
+        {
+            if (workers[w].status == SUCCESS)
+            {
+                pthread_join (threads[w], NULL);
+            }
+
+            else
+            {
+                run_worker (&workers[w]);
+            }
+        }
+    }
+
+    if (status == SUCCESS)
+    {
+        __int128 sum = 0;
+
+        agg->count = n;
+        agg->min = INT64_MAX;
+        agg->max = INT64_MIN;
+        agg->countInRange = 0;
+
+        if (agg->nBuckets > 0)
+        {
+            memset (agg->histogram, 0, agg->nBuckets * sizeof (size_t));
+        }
+
+        for (w = 0; w < nWorkers; w ++)
+        {
+            sum += workers[w].partial.sum;
+            agg->min = (workers[w].partial.min < agg->min) ? workers[w].partial.min : agg->min;
+            agg->max = (workers[w].partial.max > agg->max) ? workers[w].partial.max : agg->max;
+            agg->countInRange += workers[w].partial.countInRange;
+
+            for (b = 0; b < agg->nBuckets; b ++)
+            {
+                agg->histogram[b] += workers[w].partial.histogram[b];
+            }
+        }
+
+        agg->sum = (int64_t) (uint64_t) sum; // Modulo 2^64
+        agg->overflow = (sum > INT64_MAX) || (sum < INT64_MIN);
+
+        if (n == 0)
+        {
+            agg->min = 0;
+            agg->max = 0;
+        }
+    }
+
+    for (w = 0; w < nWorkers; w ++)
+    {
+        free (workers[w].partial.histogram);
+    }
+
+    return status;
+}
+
+//
+// It aggregates a contiguous column of n values. See aggregate_strided.
+//
+int aggregate_column (AGGREGATE* agg, const int64_t* values, size_t n)
+{
+    return aggregate_strided (agg, values, sizeof (int64_t), n);
+}
@@ -0,0 +1,42 @@
+#if !defined AGGREGATE_H
+#define AGGREGATE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define AGGREGATE_BLOCK 2048 // Values gathered at a time from a strided column
+#define AGGREGATE_VALUES_PER_THREAD (1 << 18) // Smaller columns run on one thread
+#define AGGREGATE_MAX_THREADS 16
+
+//
+// Aggregates over a column of int64 values: count, exact sum, min, max, the count of
+// values in a range, and an equal-width histogram. The inner loops use AVX2 or SSE4.2
+// when the CPU has them (checked at run time) and large columns are split across
+// threads. Every result is an integer computed exactly, so it does not depend on the
+// kernel or on the number of threads. Link with -pthread.
+//
+typedef struct AGGREGATE
+{
+	// Inputs, set by aggregate_init to compute no range count and no histogram
+	int64_t rangeLow; // countInRange counts the values in [rangeLow, rangeHigh]
+	int64_t rangeHigh;
+	int64_t histLow; // Bucket b counts the values in [histLow + b * histWidth, histLow + (b + 1) * histWidth)
+	int64_t histWidth;
+	size_t nBuckets; // 0 for no histogram
+	size_t* histogram; // nBuckets counters, owned by the caller
+	int scalarOnly; // Use the plain C loop on one thread, as a reference
+
+	// Outputs
+	size_t count;
+	int64_t sum; // Exact if overflow is 0, otherwise the sum modulo 2^64
+	int overflow; // The sum does not fit an int64_t
+	int64_t min; // 0 for an empty column
+	int64_t max;
+	size_t countInRange;
+} AGGREGATE;
+
+void aggregate_init (AGGREGATE* agg);
+int aggregate_column (AGGREGATE* agg, const int64_t* values, size_t n);
+int aggregate_strided (AGGREGATE* agg, const void* first, size_t stride, size_t n);
+
+#endif
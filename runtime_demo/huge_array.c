@@ -0,0 +1,108 @@
+#if !defined _GNU_SOURCE
+#define _GNU_SOURCE // mremap
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include "huge_array.h"
+
+/* Maps bytes of zeroed anonymous memory, advising huge pages if asked to. */
+static void* map_array (size_t bytes, int hugePages)
+{
+    void* array = mmap (NULL, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (array == MAP_FAILED)
+    {
+        return NULL;
+    }
+
+#if defined MADV_HUGEPAGE
+    if (hugePages)
+    {
+        // Only advice: the kernel may still use normal pages
+        madvise (array, bytes, MADV_HUGEPAGE);
+    }
+#else
+    (void) hugePages;
+#endif
+
+    return array;
+}
+
+//
+// It returns an array of the given size in bytes, or NULL if memory runs out.
+// hugePages asks for transparent huge pages if the array is mapped.
+//
+void* harray_alloc (size_t bytes, int hugePages)
+{
+    if (bytes < HARRAY_MMAP_THRESHOLD)
+    {
+        return malloc (bytes > 0 ? bytes : 1);
+    }
+
+    return map_array (bytes, hugePages);
+}
+
+//
+// It resizes an array from oldBytes to newBytes, keeping its contents, like realloc.
+// It returns NULL and leaves the old array untouched if memory runs out.
+//
+void* harray_realloc (void* array, size_t oldBytes, size_t newBytes, int hugePages)
+{
+    if ((oldBytes < HARRAY_MMAP_THRESHOLD) && (newBytes < HARRAY_MMAP_THRESHOLD))
+    {
+        return realloc (array, newBytes > 0 ? newBytes : 1);
+    }
+
+#if defined __linux__
+    if ((oldBytes >= HARRAY_MMAP_THRESHOLD) && (newBytes >= HARRAY_MMAP_THRESHOLD))
+    {
+        // The kernel moves the page tables, the contents are not copied
+        void* moved = mremap (array, oldBytes, newBytes, MREMAP_MAYMOVE);
+        if (moved == MAP_FAILED)
+        {
+            return NULL;
+        }
+
+#if defined MADV_HUGEPAGE
+        if (hugePages)
+        {
+            madvise (moved, newBytes, MADV_HUGEPAGE);
+        }
+#endif
+
+        return moved;
+    }
+#endif
+
+    // Crossing the threshold (or no mremap): allocate, copy and free
+    void* newArray = harray_alloc (newBytes, hugePages);
+    if (newArray == NULL)
+    {
+        return NULL;
+    }
+
+    memcpy (newArray, array, (oldBytes < newBytes) ? oldBytes : newBytes);
+    harray_free (array, oldBytes);
+
+    return newArray;
+}
+
+//
+// It frees an array returned by harray_alloc or harray_realloc of the given size.
+//
+void harray_free (void* array, size_t bytes)
+{
+    if (array == NULL)
+    {
+        return;
+    }
+
+    if (bytes < HARRAY_MMAP_THRESHOLD)
+    {
+        free (array);
+        return;
+    }
+
+    munmap (array, bytes);
+}
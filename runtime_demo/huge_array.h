@@ -0,0 +1,20 @@
+#if !defined HUGE_ARRAY_H
+#define HUGE_ARRAY_H
+
+#include <stddef.h>
+
+// Arrays of at least this many bytes are mapped directly with mmap instead of malloc.
+#define HARRAY_MMAP_THRESHOLD (32 * 1024 * 1024)
+
+//
+// Allocation of the large arrays behind the tables. Small arrays come from malloc.
+// Large arrays are anonymous mappings, which grow with mremap without copying, and
+// which can be backed by transparent huge pages (MADV_HUGEPAGE) to cut TLB misses on
+// random lookups. The caller must pass the same byte count to every call for one array,
+// since that decides how it was allocated.
+//
+void* harray_alloc (size_t bytes, int hugePages);
+void* harray_realloc (void* array, size_t oldBytes, size_t newBytes, int hugePages);
+void harray_free (void* array, size_t bytes);
+
+#endif
@@ -0,0 +1,386 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include "perfect_hash.h"
+
+#define SUCCESS 1
+#define FAILURE 0
+#define MAX_SEED_ATTEMPTS 32
+
+/* Final avalanche step, so that every input bit affects every output bit. */
+static uint64_t mix64 (uint64_t x)
+{
+    x ^= x >> 32;
+    x *= 0xd6e8feb86659fd93ULL;
+    x ^= x >> 32;
+    x *= 0xd6e8feb86659fd93ULL;
+    x ^= x >> 32;
+
+    return x;
+}
+
+/* Hashes a string 8 bytes at a time. Different seeds give independent hash functions. */
+static uint64_t hash_string (char* key, uint64_t seed)
+{
+    size_t len = strlen (key);
+    uint64_t h = seed ^ (len * 0x9e3779b97f4a7c15ULL);
+    uint64_t word;
+
+    while (len >= 8)
+    {
+        memcpy (&word, key, 8);
+        h = (h ^ mix64 (word)) * 0x100000001b3ULL;
+
+        key += 8;
+        len -= 8;
+    }
+
+    // Remaining 0..7 bytes
+    word = 0;
+    memcpy (&word, key, len);
+    h ^= word;
+
+    return mix64 (h);
+}
+
+/* Maps a 64 bit hash to [0, range) with a multiply instead of a division. */
+static int reduce (uint64_t h, int range)
+{
+    return (int) (((unsigned __int128) h * (uint64_t) range) >> 64);
+}
+
+static int bucket_of (PERFECT_HASH* phash, uint64_t h)
+{
+    return reduce (h, phash->nBuckets);
+}
+
+static int slot_of (PERFECT_HASH* phash, uint64_t h, uint32_t pilot)
+{
+    return reduce ((h ^ mix64 (pilot + 1)) * 0x9e3779b97f4a7c15ULL, phash->nSlots);
+}
+
+/* Computes the number of buckets and placement slots for nKeys keys. */
+static void set_sizes (PERFECT_HASH* phash, int nKeys)
+{
+    phash->nKeys = nKeys;
+    phash->nBuckets = nKeys / PHASH_KEYS_PER_BUCKET + 1;
+    phash->nSlots = (int) ((long long) nKeys * 100 / PHASH_LOAD_PERCENT) + 1;
+}
+
+/* Tries to place every bucket with the current seed. It returns SUCCESS if every bucket
+found a pilot, FAILURE if this seed does not work, and -1 if two keys are identical
+(no seed can ever separate them). */
+static int try_build (PERFECT_HASH* phash, char** keys, uint64_t* hashes, int* bucketStart, int* bucketKeys, int* bucketOrder, unsigned char* taken)
+{
+    int i, j, k; // Loop indices
+    int maxBucketSize = 0;
+    int nOrdered = 0; // Number of non-empty buckets in bucketOrder
+    int positions[64]; // Slots tried for the current bucket
+    uint32_t pilot;
+    uint64_t pilotLimit = 16 * (uint64_t) phash->nSlots + 1024;
+    uint32_t maxPilot = (pilotLimit < UINT32_MAX) ? (uint32_t) pilotLimit : UINT32_MAX;
+
+    for (i = 0; i < phash->nKeys; i ++)
+    {
+        hashes[i] = hash_string (keys[i], phash->seed);
+    }
+
+    // Counting sort of the keys by bucket
+    memset (bucketStart, 0, (phash->nBuckets + 1) * sizeof (int));
+
+    for (i = 0; i < phash->nKeys; i ++)
+    {
+        bucketStart[bucket_of (phash, hashes[i]) + 1] ++;
+    }
+
+    for (i = 0; i < phash->nBuckets; i ++)
+    {
+        if (bucketStart[i + 1] > maxBucketSize)
+        {
+            maxBucketSize = bucketStart[i + 1];
+        }
+
+        bucketStart[i + 1] += bucketStart[i];
+    }
+
+    if (maxBucketSize > 64) // Badly skewed seed, try another one
+    {
+        return FAILURE;
+    }
+
+    // bucketOrder is used as a temporary fill pointer here
+    memcpy (bucketOrder, bucketStart, phash->nBuckets * sizeof (int));
+
+    for (i = 0; i < phash->nKeys; i ++)
+    {
+        bucketKeys[bucketOrder[bucket_of (phash, hashes[i])] ++] = i;
+    }
+
+    // Keys of one bucket must have different hashes, otherwise no pilot can separate them
+    for (i = 0; i < phash->nBuckets; i ++)
+    {
+        for (j = bucketStart[i]; j < bucketStart[i + 1]; j ++)
+        {
+            for (k = j + 1; k < bucketStart[i + 1]; k ++)
+            {
+                if (hashes[bucketKeys[j]] == hashes[bucketKeys[k]])
+                {
+                    if (strcmp (keys[bucketKeys[j]], keys[bucketKeys[k]]) == 0)
+                    {
+                        return -1;
+                    }
+
+                    return FAILURE;
+                }
+            }
+        }
+    }
+
+    // Place the largest buckets first, while the table is still mostly empty
+    for (j = maxBucketSize; j > 0; j --)
+    {
+        for (i = 0; i < phash->nBuckets; i ++)
+        {
+            if (bucketStart[i + 1] - bucketStart[i] == j)
+            {
+                bucketOrder[nOrdered ++] = i;
+            }
+        }
+    }
+
+    memset (taken, 0, phash->nSlots);
+    memset (phash->pilots, 0, phash->nBuckets * sizeof (uint32_t));
+
+    for (i = 0; i < nOrdered; i ++)
+    {
+        int bucket = bucketOrder[i];
+        int size = bucketStart[bucket + 1] - bucketStart[bucket];
+
+        for (pilot = 0; pilot < maxPilot; pilot ++)
+        {
+            for (j = 0; j < size; j ++)
+            {
+                positions[j] = slot_of (phash, hashes[bucketKeys[bucketStart[bucket] + j]], pilot);
+
+                if (taken[positions[j]])
+                {
+                    break;
+                }
+
+                // Two keys of the same bucket must not collide with each other either
+                for (k = 0; k < j; k ++)
+                {
+                    if (positions[k] == positions[j])
+                    {
+                        break;
+                    }
+                }
+
+                if (k < j)
+                {
+                    break;
+                }
+            }
+
+            if (j == size) // Every key of the bucket found a free slot
+            {
+                break;
+            }
+        }
+
+        if (pilot == maxPilot)
+        {
+            return FAILURE;
+        }
+
+        for (j = 0; j < size; j ++)
+        {
+            taken[positions[j]] = 1;
+        }
+
+        phash->pilots[bucket] = pilot;
+    }
+
+    // Every key that was placed past nKeys moves to one of the holes below nKeys
+    j = 0;
+
+    for (i = phash->nKeys; i < phash->nSlots; i ++)
+    {
+        if (taken[i])
+        {
+            while (taken[j])
+            {
+                j ++;
+            }
+
+            taken[j] = 1;
+            phash->remap[i - phash->nKeys] = j;
+        }
+    }
+
+    return SUCCESS;
+}
+
+//
+// It builds a minimal perfect hash over the nKeys strings in keys. The keys must be
+// distinct. It returns NULL if two keys are equal or if memory runs out.
+// The keys are not copied, they are only needed during the build.
+//
+PERFECT_HASH* phash_build (char** keys, int nKeys)
+{
+    int attempt;
+    int result = FAILURE;
+
+    PERFECT_HASH* phash = malloc (sizeof (PERFECT_HASH));
+    if (phash == NULL)
+    {
+        return NULL;
+    }
+
+    set_sizes (phash, nKeys);
+    phash->seed = 0;
+    phash->pilots = calloc (phash->nBuckets, sizeof (uint32_t));
+    phash->remap = calloc (phash->nSlots - nKeys, sizeof (uint32_t));
+
+    uint64_t* hashes = malloc ((nKeys + 1) * sizeof (uint64_t));
+    int* bucketStart = malloc ((phash->nBuckets + 1) * sizeof (int));
+    int* bucketKeys = malloc ((nKeys + 1) * sizeof (int));
+    int* bucketOrder = malloc (phash->nBuckets * sizeof (int));
+    unsigned char* taken = malloc (phash->nSlots);
+
+    if ((phash->pilots != NULL) && (phash->remap != NULL) && (hashes != NULL) && (bucketStart != NULL) && (bucketKeys != NULL) && (bucketOrder != NULL) && (taken != NULL))
+    {
+        for (attempt = 0; attempt < MAX_SEED_ATTEMPTS; attempt ++)
+        {
+            phash->seed = mix64 (attempt + 0x5eed);
+
+            result = try_build (phash, keys, hashes, bucketStart, bucketKeys, bucketOrder, taken);
+            if (result != FAILURE) // Either built, or duplicate keys
+            {
+                break;
+            }
+        }
+    }
+
+    free (hashes);
+    free (bucketStart);
+    free (bucketKeys);
+    free (bucketOrder);
+    free (taken);
+
+    if (result != SUCCESS)
+    {
+        phash_free (phash);
+        return NULL;
+    }
+
+    return phash;
+}
+
+//
+// It returns the slot of key in [0, nKeys). Keys that were not part of the build also
+// map to some slot, so the caller has to compare the key stored there.
+// It returns -1 if the hash is empty.
+//
+int phash_index (PERFECT_HASH* phash, char* key)
+{
+    if (phash->nKeys == 0)
+    {
+        return -1;
+    }
+
+    uint64_t h = hash_string (key, phash->seed);
+    int slot = slot_of (phash, h, phash->pilots[bucket_of (phash, h)]);
+
+    if (slot >= phash->nKeys)
+    {
+        return phash->remap[slot - phash->nKeys];
+    }
+
+    return slot;
+}
+
+//
+// It frees the perfect hash.
+//
+void phash_free (PERFECT_HASH* phash)
+{
+    if (phash == NULL)
+    {
+        return;
+    }
+
+    free (phash->pilots);
+    free (phash->remap);
+    free (phash);
+}
+
+//
+// It writes the perfect hash to fout in binary form: nKeys, nBuckets, seed, the pilots
+// and the remapped slots. It returns 1 if successful, or 0 otherwise.
+//
+int phash_save (PERFECT_HASH* phash, FILE* fout)
+{
+    int32_t header[2] = { phash->nKeys, phash->nBuckets };
+
+    if ((fwrite (header, sizeof (int32_t), 2, fout) != 2) ||
+        (fwrite (&(phash->seed), sizeof (uint64_t), 1, fout) != 1) ||
+        (fwrite (phash->pilots, sizeof (uint32_t), phash->nBuckets, fout) != (size_t) phash->nBuckets) ||
+        (fwrite (phash->remap, sizeof (uint32_t), phash->nSlots - phash->nKeys, fout) != (size_t) (phash->nSlots - phash->nKeys)))
+    {
+        return FAILURE;
+    }
+
+    return SUCCESS;
+}
+
+//
+// It reads a perfect hash written by phash_save. It returns NULL if the data is
+// truncated or inconsistent.
+//
+PERFECT_HASH* phash_read (FILE* fin)
+{
+    int32_t header[2];
+
+    if (fread (header, sizeof (int32_t), 2, fin) != 2)
+    {
+        return NULL;
+    }
+
+    if ((header[0] < 0) || (header[1] != header[0] / PHASH_KEYS_PER_BUCKET + 1))
+    {
+        return NULL;
+    }
+
+    PERFECT_HASH* phash = malloc (sizeof (PERFECT_HASH));
+    if (phash == NULL)
+    {
+        return NULL;
+    }
+
+    set_sizes (phash, header[0]);
+    phash->pilots = malloc (phash->nBuckets * sizeof (uint32_t));
+    phash->remap = malloc ((phash->nSlots - phash->nKeys) * sizeof (uint32_t));
+
+    if ((phash->pilots == NULL) || (phash->remap == NULL) ||
+        (fread (&(phash->seed), sizeof (uint64_t), 1, fin) != 1) ||
+        (fread (phash->pilots, sizeof (uint32_t), phash->nBuckets, fin) != (size_t) phash->nBuckets) ||
+        (fread (phash->remap, sizeof (uint32_t), phash->nSlots - phash->nKeys, fin) != (size_t) (phash->nSlots - phash->nKeys)))
+    {
+        phash_free (phash);
+        return NULL;
+    }
+
+    // A remapped slot outside [0, nKeys) would index past the table
+    for (int i = 0; i < phash->nSlots - phash->nKeys; i ++)
+    {
+        if ((phash->nKeys > 0) && (phash->remap[i] >= (uint32_t) phash->nKeys))
+        {
+            phash_free (phash);
+            return NULL;
+        }
+    }
+
+    return phash;
+}
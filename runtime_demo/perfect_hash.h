@@ -0,0 +1,33 @@
+#if !defined PERFECT_HASH_H
+#define PERFECT_HASH_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+#define PHASH_KEYS_PER_BUCKET 4
+#define PHASH_LOAD_PERCENT 97
+
+//
+// A minimal perfect hash over a fixed set of n distinct strings. Every key of the set
+// maps to a different slot in [0, n). Built PTHash style: keys are split into buckets
+// and each bucket stores a "pilot" that displaces all of its keys into free slots of a
+// slightly larger space of nSlots slots. The few keys that land past nKeys are remapped
+// to the holes left below nKeys. Looking a key up costs one string hash and one array read.
+//
+typedef struct PERFECT_HASH
+{
+	int nKeys; // Number of keys, and of final slots
+	int nBuckets; // Number of buckets, about nKeys / PHASH_KEYS_PER_BUCKET
+	int nSlots; // Size of the placement space, about nKeys * 100 / PHASH_LOAD_PERCENT
+	uint64_t seed; // Seed of the string hash that worked for this key set
+	uint32_t* pilots; // One displacement per bucket
+	uint32_t* remap; // Final slot of the placement slots nKeys..nSlots-1
+} PERFECT_HASH;
+
+PERFECT_HASH* phash_build (char** keys, int nKeys);
+int phash_index (PERFECT_HASH* phash, char* key);
+void phash_free (PERFECT_HASH* phash);
+int phash_save (PERFECT_HASH* phash, FILE* fout);
+PERFECT_HASH* phash_read (FILE* fin);
+
+#endif
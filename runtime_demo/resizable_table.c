@@ -2,7 +2,14 @@
 #include <assert.h>
 #include <stdio.h>
 #include <string.h>
+#include <stdint.h>
+#include <limits.h>
+#include <time.h>
+#include <pthread.h>
 #include "resizable_table.h"
+#include "huge_array.h"
+#include "../common/hash_map.h"
+#include "../common/instrument.h"
 
 #define MAXLINE 512
 #define SUCCESS 1
@@ -11,8 +18,9 @@
 #define TERMINATING_NULL_BYTE '\0'
 #define READ_MODE "r"
 #define WRITE_MODE "w"
+#define MAX_JOIN_THREADS 64
 
-int rtable_lookup_index (RESIZABLE_TABLE* table, char* name);
+long rtable_lookup_index (RESIZABLE_TABLE* table, char* name);
 
 //
 // It returns a new RESIZABLE_TABLE. It allocates it dynamically,
@@ -30,8 +38,23 @@ RESIZABLE_TABLE* rtable_create()
 	// Initialise the members of RESIZABLE_TABLE
 	table->maxElements = INITIAL_SIZE_RESIZABLE_TABLE;
 	table->currentElements = 0;
+	table->intValues = 0;
+	table->hugePages = 0;
+	table->frozen = 0;
+	table->phash = NULL;
+	table->cache = NULL;
+	table->ttl = NULL;
+	table->clock = NULL;
+	table->clockContext = NULL;
+	table->vindex = NULL;
+	table->cursors = NULL;
+	table->statsOnly = 0;
+	table->nameBytes = 0;
+	table->valueBytes = 0;
+	table->stringOverhead = 0;
+	memset (table->keyLengths, 0, sizeof (table->keyLengths));
 	
-    table->array = malloc ((table->maxElements) * sizeof (RESIZABLE_TABLE_ENTRY));
+    table->array = harray_alloc ((table->maxElements) * sizeof (RESIZABLE_TABLE_ENTRY), table->hugePages);
 	if ((table->array) == NULL) 
     {
 		return NULL;
@@ -40,6 +63,30 @@ RESIZABLE_TABLE* rtable_create()
 	return table;
 }
 
+/* Prints the rtable_stats of the table in a few lines, for rtable_print_stats_only. */
+static void print_stats (RESIZABLE_TABLE* table)
+{
+	RTABLE_STATS stats;
+	int i; // Bucket index
+
+	rtable_stats (table, &stats);
+
+	printf("\n======== Table stats =======\n");
+	printf("currentElements=%zu maxElements=%zu load=%.2f\n", stats.entries, stats.capacity, stats.loadFactor);
+	printf("bytes: array=%zu (wasted %zu) names=%zu values=%zu overhead=%zu index=%zu\n", stats.arrayBytes, stats.wastedBytes, stats.nameBytes, stats.valueBytes, stats.overheadBytes, stats.indexBytes);
+	printf("key lengths (mean %.1f):", stats.meanKeyLength);
+
+	for (i = 0; i < RTABLE_KEY_LENGTH_BUCKETS; i ++)
+	{
+		if (stats.keyLengths[i] > 0)
+		{
+			printf(" <%d:%zu", 1 << i, stats.keyLengths[i]);
+		}
+	}
+
+	printf("\n======== End Table stats =======\n");
+}
+
 //
 // It prints the elements in the array assuming the value is a string in the form:
 //
@@ -51,14 +98,20 @@ RESIZABLE_TABLE* rtable_create()
 //
 void rtable_print_str (RESIZABLE_TABLE* table)
 {
-	int i = 0;
+	size_t i = 0;
+
+	if (table->statsOnly)
+	{
+		print_stats (table);
+		return;
+	}
 
 	printf("\n======== Table =======\n");
-	printf("currentElements=%d maxElements=%d\n", table->currentElements, table->maxElements);
+	printf("currentElements=%zu maxElements=%zu\n", table->currentElements, table->maxElements);
 
 	for (i = 0; i < (table->currentElements); i ++) 
     {
-		printf("%d: \"%s\" \"%s\"\n", i, table->array[i].name, (char*) (table->array[i].value));
+		printf("%zu: \"%s\" \"%s\"\n", i, table->array[i].name, (char*) (table->array[i].value));
 	}
     
 	printf("======== End Table =======\n");
@@ -76,50 +129,297 @@ void rtable_print_str (RESIZABLE_TABLE* table)
 //
 void rtable_print_int (RESIZABLE_TABLE* table)
 {
-	int i = 0;
+	size_t i = 0;
+
+	if (table->statsOnly)
+	{
+		print_stats (table);
+		return;
+	}
 
 	printf("\n======== Table =======\n");
-	printf("currentElements=%d maxElements=%d\n", table->currentElements, table->maxElements);
+	printf("currentElements=%zu maxElements=%zu\n", table->currentElements, table->maxElements);
 	
     for (i = 0; i < (table->currentElements); i ++) 
     {
-		printf("%d: \"%s\" %ld\n", i, table->array[i].name, (long) (table->array[i].value));
+		printf("%zu: \"%s\" %ld\n", i, table->array[i].name, (long) (table->array[i].value));
 	}
 	
     printf("======== End Table =======\n");
 	return;
 }
 
-/* Allocates a new array (NOT table!) with double the original size, copies over the original elements and frees the old array.
+/* Grows the array (NOT table!) to double the original size, keeping the original elements. Large arrays are mapped memory and grow with mremap, without copying.
+It returns 0 without touching the table if the new size would overflow size_t or memory runs out.
  */
-void reallocate (RESIZABLE_TABLE* table)
+int reallocate (RESIZABLE_TABLE* table)
 {
-    int i; // Loop index
+    size_t newMaxElements = (table->maxElements > 0) ? (table->maxElements) * 2 : INITIAL_SIZE_RESIZABLE_TABLE;
+    size_t oldBytes = (table->maxElements) * sizeof (RESIZABLE_TABLE_ENTRY);
+#if defined INSTRUMENT
+    uintptr_t oldAddress = (uintptr_t) table->array;
+#endif
+    INSTR_SCOPE (INSTR_RTABLE_REALLOCATE);
+    
+    if ((table->maxElements) > (SIZE_MAX / 2) / sizeof (RESIZABLE_TABLE_ENTRY)) // Size in bytes would overflow
+    {
+        return FAILURE;
+    }
     
-    // Allocate new array
-    RESIZABLE_TABLE_ENTRY* newArray = malloc (((table->maxElements) * 2) * sizeof (RESIZABLE_TABLE_ENTRY));
+    RESIZABLE_TABLE_ENTRY* newArray = harray_realloc (table->array, oldBytes, newMaxElements * sizeof (RESIZABLE_TABLE_ENTRY), table->hugePages);
     if (newArray == NULL) 
     {
-		return;
+		return FAILURE;
 	}
     
-    // Copy original elements into new array
-    for (i = 0; i < (table->currentElements); i ++)
-    {
-        newArray[i].name = table->array[i].name;
-        newArray[i].value = table->array[i].value;
-    }
-    
-	// Free original array
-    free (table->array);
+#if defined INSTRUMENT
+    // Only an array that moved was copied, and mremap moves the pages without copying them
+    INSTR_COUNT (INSTR_BYTES_COPIED, (((uintptr_t) newArray != oldAddress) && (oldBytes < HARRAY_MMAP_THRESHOLD)) ? oldBytes : 0);
+#endif
     
     // Redirect table->array to point to new array
     table->array = newArray;
     
     // Update maxElements.
-    (table->maxElements) *= 2;
+    table->maxElements = newMaxElements;
     
     // NOTE: Since neither the table structure nor the number of elements currently in the structure have changed, currentElements does not need to be updated.
+    return SUCCESS;
+}
+
+/* Returns the time the TTLs of the table are measured with, in milliseconds. */
+static uint64_t ttl_now (RESIZABLE_TABLE* table)
+{
+    struct timespec now;
+    
+    if (table->clock != NULL)
+    {
+        return table->clock (table->clockContext);
+    }
+    
+    clock_gettime (CLOCK_MONOTONIC, &now);
+    
+    return (uint64_t) now.tv_sec * 1000 + (uint64_t) now.tv_nsec / 1000000;
+}
+
+/* Tells the timers of the entries first..last-1 where their entries are, after the entries moved. */
+static void ttl_reindex (RESIZABLE_TABLE* table, size_t first, size_t last)
+{
+    size_t i; // Array index
+    
+    if ((table->ttl == NULL) || (table->ttl->timers == 0)) // No entry has a timer
+    {
+        return;
+    }
+    
+    for (i = first; i < last; i ++)
+    {
+        if (table->array[i].timer != NULL)
+        {
+            table->array[i].timer->index = i;
+        }
+    }
+}
+
+/* Adds the ith entry to the value index, if the table has one. It returns 1 if successful, or 0 if memory runs out. */
+static int index_entry (RESIZABLE_TABLE* table, size_t ith)
+{
+    if (table->vindex == NULL)
+    {
+        return SUCCESS;
+    }
+    
+    return vindex_insert (table->vindex, table->array[ith].name, (long) table->array[ith].value);
+}
+
+/* Drops the value index, once the values are no longer ints. */
+static void drop_index (RESIZABLE_TABLE* table)
+{
+    if (table->vindex != NULL)
+    {
+        vindex_free (table->vindex);
+        table->vindex = NULL;
+    }
+}
+
+/* Keeps the cursors of the table on their entries when the entry at ith is removed (delta -1) or a new entry is inserted at ith (delta 1). A cursor whose current entry is removed has no current entry until it moves on. */
+static void move_cursors (RESIZABLE_TABLE* table, size_t ith, int delta)
+{
+    RTABLE_CURSOR* cursor;
+    
+    for (cursor = table->cursors; cursor != NULL; cursor = cursor->nextCursor)
+    {
+        if ((delta < 0) && (cursor->current == ith))
+        {
+            cursor->current = RTABLE_CURSOR_NONE;
+        }
+        else if ((cursor->current != RTABLE_CURSOR_NONE) && (cursor->current >= ith))
+        {
+            cursor->current += delta;
+        }
+        
+        if ((cursor->next > ith) || ((delta > 0) && (cursor->next == ith)))
+        {
+            cursor->next += delta;
+        }
+    }
+}
+
+/* Estimated bytes that malloc adds to a block of size bytes: glibc puts a size_t header in
+front of it, rounds to 16 bytes and hands out at least 32. */
+static size_t malloc_overhead (size_t size)
+{
+    size_t chunk = (size + sizeof (size_t) + 15) & ~((size_t) 15);
+    
+    return ((chunk < 32) ? 32 : chunk) - size;
+}
+
+/* Adds (add is 1) or subtracts (add is 0) one string to the byte counters of rtable_stats. */
+static void count_string (RESIZABLE_TABLE* table, char* str, size_t* bytes, int add)
+{
+    size_t size = strlen (str) + 1;
+    
+    if (add)
+    {
+        *bytes += size;
+        table->stringOverhead += malloc_overhead (size);
+    }
+    else
+    {
+        *bytes -= size;
+        table->stringOverhead -= malloc_overhead (size);
+    }
+}
+
+/* Adds (add is 1) or subtracts (add is 0) the name and value of the ith entry to the counters of rtable_stats. */
+static void count_entry (RESIZABLE_TABLE* table, size_t ith, int add)
+{
+    size_t length = strlen (table->array[ith].name);
+    int bucket = 0;
+    
+    while ((length > 0) && (bucket < RTABLE_KEY_LENGTH_BUCKETS - 1))
+    {
+        length >>= 1;
+        bucket ++;
+    }
+    
+    table->keyLengths[bucket] += add ? 1 : -1;
+    count_string (table, table->array[ith].name, &(table->nameBytes), add);
+    
+    if ((!(table->intValues)) && (table->array[ith].value != NULL))
+    {
+        count_string (table, (char*) table->array[ith].value, &(table->valueBytes), add);
+    }
+}
+
+/* Ends the walk of every cursor of the table, when all of its entries go away at once. */
+static void end_cursors (RESIZABLE_TABLE* table)
+{
+    while (table->cursors != NULL)
+    {
+        rtable_cursor_end (table->cursors);
+    }
+}
+
+/* Frees the name, value and timer of the ith entry, without moving any entry. */
+static void free_entry (RESIZABLE_TABLE* table, size_t ith)
+{
+    count_entry (table, ith, 0);
+    
+    if (table->vindex != NULL) // The index orders by name too, so this goes before the name is freed
+    {
+        vindex_remove (table->vindex, table->array[ith].name, (long) table->array[ith].value);
+    }
+    
+    free (table->array[ith].name);
+    
+    if (!(table->intValues)) // Values of int tables are not pointers
+    {
+        free (table->array[ith].value);
+    }
+    
+    if (table->array[ith].timer != NULL)
+    {
+        twheel_cancel (table->ttl, table->array[ith].timer);
+        free (table->array[ith].timer);
+        table->array[ith].timer = NULL;
+    }
+}
+
+/* Shifts the entries after the ith entry, which must already be freed, one position upwards. The CLOCK bits of a cache table move with their entries. */
+static void remove_slot (RESIZABLE_TABLE* table, size_t ith)
+{
+    INSTR_COUNT (INSTR_SHIFTS, (table->currentElements) - ith - 1);
+    
+    memmove (table->array + ith, table->array + ith + 1, ((table->currentElements) - ith - 1) * sizeof (RESIZABLE_TABLE_ENTRY));
+    
+    if (table->cache != NULL)
+    {
+        memmove (table->cache->referenced + ith, table->cache->referenced + ith + 1, (table->currentElements) - ith - 1);
+        
+        if (table->cache->hand > ith)
+        {
+            table->cache->hand --;
+        }
+    }
+    
+    (table->currentElements) --;
+    
+    ttl_reindex (table, ith, table->currentElements);
+    move_cursors (table, ith, -1);
+}
+
+/* Evicts one entry of a cache table with the CLOCK algorithm. New entries start unreferenced, so a scan of names used only once does not flush the entries that are looked up again: the hand skips (and clears) the entries that were looked up since it last passed them and stops at the first one that was not. Every bit is cleared at most once per set, so this is O(1) amortised. The eviction callback sees the entry, then its name and value are freed. It returns the index of the evicted entry, whose slot is free but still counted in currentElements. */
+static size_t cache_evict (RESIZABLE_TABLE* table)
+{
+    RTABLE_CACHE* cache = table->cache;
+    
+    while (1)
+    {
+        if (cache->hand >= table->currentElements) // Wrap around
+        {
+            cache->hand = 0;
+        }
+        
+        if (!(cache->referenced[cache->hand]))
+        {
+            break;
+        }
+        
+        cache->referenced[cache->hand] = 0;
+        cache->hand ++;
+    }
+    
+    size_t victim = (cache->hand) ++;
+    
+    if (cache->evict != NULL)
+    {
+        cache->evict (table->array[victim].name, table->array[victim].value, cache->evictContext);
+    }
+    
+    free_entry (table, victim);
+    cache->stats.evictions ++;
+    
+    return victim;
+}
+
+/* Makes room for one more entry in a full cache table by evicting one entry. */
+static void cache_make_room (RESIZABLE_TABLE* table)
+{
+    if ((table->cache != NULL) && (table->currentElements >= table->cache->capacity))
+    {
+        remove_slot (table, cache_evict (table));
+    }
+}
+
+/* Forgets which entries were used, after the entries of a cache table have been reordered. */
+static void cache_reset (RESIZABLE_TABLE* table)
+{
+    if (table->cache != NULL)
+    {
+        memset (table->cache->referenced, 0, table->currentElements);
+        table->cache->hand = 0;
+    }
 }
 
 //
@@ -131,15 +431,78 @@ void reallocate (RESIZABLE_TABLE* table)
 //
 int rtable_add (RESIZABLE_TABLE* table, char* name, void* value) 
 {
+    INSTR_SCOPE (INSTR_RTABLE_ADD);
+    
+    if (table->frozen) // Frozen tables are read-only
+    {
+        return !FAILURE;
+    }
+    
 	// Find if it is already there and substitute value
     
-    int nameIndex = rtable_lookup_index (table, name);
+    long nameIndex = rtable_lookup_index (table, name);
     
     if (nameIndex != -1) // Name and value already exist
     {
+        if (table->vindex != NULL)
+        {
+            vindex_update (table->vindex, table->array[nameIndex].name, (long) table->array[nameIndex].value, (long) value);
+        }
+        
+        if ((!(table->intValues)) && (table->array[nameIndex].value != NULL))
+        {
+            count_string (table, (char*) table->array[nameIndex].value, &(table->valueBytes), 0);
+        }
+        
         // Assuming preexisting value does not need to be freed
         table->array[nameIndex].value = value;
         
+        if ((!(table->intValues)) && (value != NULL))
+        {
+            count_string (table, (char*) value, &(table->valueBytes), 1);
+        }
+        
+        if (table->cache != NULL)
+        {
+            table->cache->referenced[nameIndex] = 1;
+        }
+        
+        return !SUCCESS;
+    }
+    
+    if ((table->cache != NULL) && (table->currentElements >= table->cache->capacity))
+    {
+        // Full cache: the new entry takes the slot of the evicted one, so nothing shifts.
+        size_t victim = cache_evict (table);
+        
+        // For the cursors this is a removal followed by an insertion at the same index
+        move_cursors (table, victim, -1);
+        move_cursors (table, victim, 1);
+        
+        table->array[victim].name = strdup (name);
+        
+        if (table->array[victim].name == NULL)
+        {
+            remove_slot (table, victim);
+            
+            return !FAILURE;
+        }
+        
+        table->array[victim].value = value;
+        table->array[victim].timer = NULL;
+        table->cache->referenced[victim] = 0;
+        
+        if (index_entry (table, victim) == FAILURE)
+        {
+            // Leave the slot empty rather than unindexed
+            free (table->array[victim].name);
+            remove_slot (table, victim);
+            
+            return !FAILURE;
+        }
+        
+        count_entry (table, victim, 1);
+        
         return !SUCCESS;
     }
     
@@ -149,10 +512,20 @@ int rtable_add (RESIZABLE_TABLE* table, char* name, void* value)
 
 //
 // Add name and value into table where value is a string (char *)
-// Implement on top of rtable_add.
+// Implement on top of rtable_add. It fails on a table with a value index.
 //
 int rtable_add_str (RESIZABLE_TABLE* table, char* name, char* str_value)
 {
+    if (table->frozen) // Do not duplicate a value that cannot be stored
+    {
+        return !FAILURE;
+    }
+    
+    if (table->vindex != NULL) // The value index orders ints, not string pointers
+    {
+        return !FAILURE;
+    }
+    
 	return rtable_add (table, name, (void*) strdup(str_value));
 }
 
@@ -162,6 +535,22 @@ int rtable_add_str (RESIZABLE_TABLE* table, char* name, char* str_value)
 //
 int rtable_add_int (RESIZABLE_TABLE* table, char* name, long int_value)
 {
+    // From now on the values are not pointers, so they must not be freed.
+    if (!(table->intValues))
+    {
+        // Values already stored stop counting as strings. This walks the table only when
+        // a string table turns into an int table.
+        for (size_t i = 0; i < table->currentElements; i ++)
+        {
+            if (table->array[i].value != NULL)
+            {
+                count_string (table, (char*) table->array[i].value, &(table->valueBytes), 0);
+            }
+        }
+        
+        table->intValues = 1;
+    }
+    
 	return rtable_add (table, name, (void*) int_value );
 }
 
@@ -171,34 +560,68 @@ int rtable_add_int (RESIZABLE_TABLE* table, char* name, long int_value)
 //
 void* rtable_lookup (RESIZABLE_TABLE* table, char* name) 
 {
-    int i; // Loop index
-   
-    for (i = 0; i < (table->currentElements); i ++)
+    INSTR_SCOPE (INSTR_RTABLE_LOOKUP);
+    long nameIndex = rtable_lookup_index (table, name);
+    
+    if (nameIndex == -1) // Name does not exist in the table.
     {
-        if ((strcmp (table->array[i].name, name)) == 0)
+        if (table->cache != NULL)
         {
-            return (void*) table->array[i].value;
+            table->cache->stats.misses ++;
         }
+        
+        return NULL;
     }
-
-    // If reached this point, name does not exist in the table.
-    return NULL;
+    
+    if (table->cache != NULL)
+    {
+        table->cache->stats.hits ++;
+        table->cache->referenced[nameIndex] = 1;
+    }
+    
+    return (void*) table->array[nameIndex].value;
 }
 
 /* Returns the index that corresponds to the name or -1 if the
-name does not exist in the table. */
-int rtable_lookup_index (RESIZABLE_TABLE* table, char* name) 
+name does not exist in the table. A frozen table needs one hash and one strcmp,
+otherwise the table is scanned. An expired entry found on the way is removed, as if it did not exist. */
+long rtable_lookup_index (RESIZABLE_TABLE* table, char* name) 
 {
-    int i; // Loop index
+    size_t i; // Loop index
+    
+    if (table->frozen)
+    {
+        int slot = phash_index (table->phash, name);
+        
+        INSTR_COUNT (INSTR_COMPARES, 1);
+        
+        if ((slot != -1) && (strcmp (table->array[slot].name, name) == 0))
+        {
+            return slot;
+        }
+        
+        return -1;
+    }
    
-    for (i = 0; i <= (table->currentElements); i ++)
+    for (i = 0; i < (table->currentElements); i ++)
     {
         if ((strcmp (table->array[i].name, name)) == 0)
         {
+            INSTR_COUNT (INSTR_COMPARES, i + 1);
+            
+            // An entry past its TTL is removed when it is found
+            if ((table->array[i].timer != NULL) && (table->array[i].timer->expires <= ttl_now (table)))
+            {
+                rtable_remove_ith (table, i);
+                return -1;
+            }
+            
             return i;
         }
     }
 
+    INSTR_COUNT (INSTR_COMPARES, table->currentElements);
+    
     // If reached this point, name does not exist in the table.
     return -1;
 }
@@ -209,7 +632,7 @@ int rtable_lookup_index (RESIZABLE_TABLE* table, char* name)
 //
 int rtable_remove (RESIZABLE_TABLE* table, char* name) 
 {
-	int nameIndex = rtable_lookup_index (table, name);
+	long nameIndex = rtable_lookup_index (table, name);
     
     if (nameIndex != -1) // Name and value already exist
     {
@@ -229,9 +652,9 @@ int rtable_remove (RESIZABLE_TABLE* table, char* name)
 // It returns in *name and *value the name and value that correspond to
 // the ith entry. It will return 1 if successful, or 0 otherwise.
 //
-int rtable_get_ith (RESIZABLE_TABLE* table, int ith, char** name, void** value)
+int rtable_get_ith (RESIZABLE_TABLE* table, size_t ith, char** name, void** value)
 {
-    if (ith >= (table->maxElements)) // Index is out of bounds
+    if (ith >= (table->currentElements)) // Index does not refer to a valid entry
     {
         return FAILURE;
     }
@@ -246,28 +669,25 @@ int rtable_get_ith (RESIZABLE_TABLE* table, int ith, char** name, void** value)
 // It removes the ith entry from the table. The entries after the entry removed are
 // moved upwards to use the empty space. Also the name/value strings are freed.
 //
-int rtable_remove_ith (RESIZABLE_TABLE* table, int ith)
+int rtable_remove_ith (RESIZABLE_TABLE* table, size_t ith)
 {
-    int i; // Loop index
+    INSTR_SCOPE (INSTR_RTABLE_REMOVE_ITH);
     
-    if (ith >= (table->currentElements)) // Index does not refer to a valid entry
+    if (table->frozen) // Frozen tables are read-only
     {
         return FAILURE;
     }
-
-    // Free preexisting name and value
-    free (table->array[ith].name);
-    free (table->array[ith].value);
     
-    // Shift subsequent entries upwards.
-    for (i = ith; i <= ((table->currentElements) - 1); i ++)
+    if (ith >= (table->currentElements)) // Index does not refer to a valid entry
     {
-        table->array[i].name = table->array[i+1].name;
-        table->array[i].value = table->array[i+1].value;
+        return FAILURE;
     }
+
+    // Free preexisting name and value
+    free_entry (table, ith);
     
-    // Update currentElements -- this way, caller won't attempt to access duplicate last entry.
-    (table->currentElements) --;
+    // Shift subsequent entries upwards. This also updates currentElements -- this way, caller won't attempt to access duplicate last entry.
+    remove_slot (table, ith);
     
 	return SUCCESS;
 }
@@ -275,7 +695,7 @@ int rtable_remove_ith (RESIZABLE_TABLE* table, int ith)
 //
 // It returns the number of elements in the table.
 //
-int rtable_number_elements (RESIZABLE_TABLE* table)
+size_t rtable_number_elements (RESIZABLE_TABLE* table)
 {
 	return table->currentElements;
 }
@@ -283,7 +703,7 @@ int rtable_number_elements (RESIZABLE_TABLE* table)
 //
 // It returns the maximum number of elements in the table
 //
-int rtable_max_elements (RESIZABLE_TABLE* table)
+size_t rtable_max_elements (RESIZABLE_TABLE* table)
 {
 	return table->maxElements;
 }
@@ -303,7 +723,7 @@ int rtable_max_elements (RESIZABLE_TABLE* table)
 //
 int rtable_save_str (RESIZABLE_TABLE* table, char* file_name)
 {
-    int i; // Loop index
+    size_t i; // Loop index
     
     FILE* fout = fopen (file_name, WRITE_MODE);
     if (fout == NULL) // fopen failed
@@ -322,8 +742,23 @@ int rtable_save_str (RESIZABLE_TABLE* table, char* file_name)
 	return SUCCESS;
 }
 
+/* Frees the names of all entries, and the values unless they are ints, and empties the table. */
+static void clear_entries (RESIZABLE_TABLE* table)
+{
+    size_t i; // Array index
+    
+    for (i = 0; i < table->currentElements; i ++)
+    {
+        free_entry (table, i);
+    }
+    
+    table->currentElements = 0;
+    cache_reset (table);
+    end_cursors (table);
+}
+
 /* Removes newline character from the end of input strings. */
-void sanitise (char* str)
+static void sanitise (char* str)
 {
     int len = strlen (str);
     
@@ -339,32 +774,42 @@ void sanitise (char* str)
 //
 int rtable_read_str (RESIZABLE_TABLE* table, char* file_name)
 {
-    int i; // Array index
+    size_t i; // Array index
     char line[MAXLINE + 1]; // Temporary buffer to store name/value read in from file
     
-    FILE* fin = fopen (file_name, READ_MODE);
-    if (fin == NULL) // fopen failed
+    if (table->frozen) // Frozen tables are read-only
     {
         return FAILURE;
     }
     
-    if ((table->currentElements) > 0) // Table already has elements
+    FILE* fin = fopen (file_name, READ_MODE);
+    if (fin == NULL) // fopen failed
     {
-        for (i = 0; i < (table->currentElements); i ++)
-        {
-            rtable_remove_ith (table, i);
-        }
+        return FAILURE;
     }
     
-    // Reset array index
-    i = 0;
+    // Clear the existing entries. String values cannot be indexed.
+    drop_index (table);
+    clear_entries (table);
+    table->intValues = 0;
     
     while (fgets(line, MAXLINE + 1, fin) != NULL) // Read in name
     {
+        // A cache table stays within its capacity
+        cache_make_room (table);
+        
+        i = table->currentElements;
+        
+        if (table->cache != NULL)
+        {
+            table->cache->referenced[i] = 0;
+        }
+        
         // Remove newline character at the end of input string
         sanitise (line);
     
         table->array[i].name = strdup (line);
+        table->array[i].timer = NULL;
         
         /* fgets preferred over fscanf since fscanf stops at whitespace unless expressly anticipated in the format string, unlike fgets, which will be an issue when reading in values with possible spaces. */
         
@@ -387,6 +832,8 @@ int rtable_read_str (RESIZABLE_TABLE* table, char* file_name)
             return FAILURE;
         }
         
+        count_entry (table, i, 1);
+        
         /* At this point, name, value and empty line separator were successfully read in. Only at this point do we update currentElements. Thus, even if stored garbage name and/or value, currentElements won't update to reflect it and caller won't attempt to access it. */
         (table->currentElements) ++;
         
@@ -395,10 +842,12 @@ int rtable_read_str (RESIZABLE_TABLE* table, char* file_name)
         if ((table->currentElements) == (table->maxElements)) // Run out of space
         {
             // Allocate more memory
-            reallocate (table);
+            if (reallocate (table) == FAILURE)
+            {
+                fclose (fin);
+                return FAILURE;
+            }
         }
-        
-        i ++;
     }
     
     fclose (fin);
@@ -420,7 +869,7 @@ int rtable_read_str (RESIZABLE_TABLE* table, char* file_name)
 //
 int rtable_save_int (RESIZABLE_TABLE* table, char* file_name) 
 {
-    int i; // Loop index
+    size_t i; // Loop index
     
     FILE* fout = fopen (file_name, WRITE_MODE);
     if (fout == NULL) // fopen failed
@@ -445,34 +894,42 @@ int rtable_save_int (RESIZABLE_TABLE* table, char* file_name)
 //
 int rtable_read_int (RESIZABLE_TABLE* table, char* file_name) 
 {
-	int i; // Array index
+	size_t i; // Array index
     char line[MAXLINE + 1]; // Temporary buffer to store name read in from file
     long value; // Temporarily stores value read in from file
     
-    FILE* fin = fopen (file_name, READ_MODE);
-    if (fin == NULL) // fopen failed
+    if (table->frozen) // Frozen tables are read-only
     {
         return FAILURE;
     }
     
-    if ((table->currentElements) > 0) // Table already has elements
+    FILE* fin = fopen (file_name, READ_MODE);
+    if (fin == NULL) // fopen failed
     {
-        for (i = 0; i < (table->currentElements); i ++)
-        {
-            // Assuming preexisting values are strings.
-            rtable_remove_ith (table, i);
-        }
+        return FAILURE;
     }
     
-    // Reset array index
-    i = 0;
+    // Clear the existing entries
+    clear_entries (table);
+    table->intValues = 1;
     
     while (fgets(line, MAXLINE + 1, fin) != NULL) // Read in name
     {
+        // A cache table stays within its capacity
+        cache_make_room (table);
+        
+        i = table->currentElements;
+        
+        if (table->cache != NULL)
+        {
+            table->cache->referenced[i] = 0;
+        }
+        
         // Remove newline character at the end of input string
         sanitise (line);
     
         table->array[i].name = strdup (line);
+        table->array[i].timer = NULL;
         
         /* fgets preferred over fscanf since fscanf stops at whitespace unless expressly anticipated in the format string, unlike fgets, which will be an issue when reading in values with possible spaces. */
         
@@ -485,6 +942,15 @@ int rtable_read_int (RESIZABLE_TABLE* table, char* file_name)
         
         table->array[i].value = (void*) value;
         
+        if (index_entry (table, i) == FAILURE)
+        {
+            free (table->array[i].name);
+            fclose (fin);
+            return FAILURE;
+        }
+        
+        count_entry (table, i, 1);
+        
         /* At this point, name, value and empty line separator were successfully read in. Only at this point do we update currentElements. Thus, even if stored garbage name and/or value, currentElements won't update to reflect it and caller won't attempt to access it. */
         (table->currentElements) ++;
         
@@ -493,29 +959,31 @@ int rtable_read_int (RESIZABLE_TABLE* table, char* file_name)
         if ((table->currentElements) == (table->maxElements)) // Run out of space
         {
             // Allocate more memory
-            reallocate (table);
+            if (reallocate (table) == FAILURE)
+            {
+                fclose (fin);
+                return FAILURE;
+            }
         }
-        
-        i ++;
     }
     
     fclose (fin);
 	return SUCCESS;
 }
 
-// Causes qsort to sort names in ascending order
-int nameSortAsc (const void* namePtr1, const void* namePtr2)
+// Causes qsort to sort entries by name in ascending order
+static int nameSortAsc (const void* entryPtr1, const void* entryPtr2)
 {
-    char* name1 = *((char**) namePtr1);
-    char* name2 = *((char**) namePtr2);
+    char* name1 = ((RESIZABLE_TABLE_ENTRY*) entryPtr1)->name;
+    char* name2 = ((RESIZABLE_TABLE_ENTRY*) entryPtr2)->name;
     
     return strcmp (name1, name2);
 }
 
-// Causes qsort to sort names in descending order
-int nameSortDesc (const void* namePtr1, const void* namePtr2)
+// Causes qsort to sort entries by name in descending order
+static int nameSortDesc (const void* entryPtr1, const void* entryPtr2)
 {
-    return nameSortAsc (namePtr2, namePtr1);
+    return nameSortAsc (entryPtr2, entryPtr1);
 }
 
 //
@@ -529,60 +997,40 @@ void rtable_sort (RESIZABLE_TABLE* table, int ascending)
         return;
     }
     
-    int i; // Array index
-    
-    // Create an array consisting of only the names stored in the array and an array consisting of only the values stored in the array, in their original order. 
-    
-    char* names[table->currentElements];
-    void* values[table->currentElements];
-    
-    for (i = 0; i < table->currentElements; i ++)
+    if (table->frozen) // The order of a frozen table is fixed by its perfect hash
     {
-        names[i] = table->array[i].name; // Copy only the address
-        values[i] = table->array[i].value; // Copy only the address, if value is a string
+        return;
     }
     
+    /* The entries are sorted in place, so each value moves together with its name. No copy of the names is needed, which would not fit on the stack for large tables. */
     if (ascending == 1)
     {
-        qsort (names, table->currentElements, sizeof (char*), nameSortAsc);
+        qsort (table->array, table->currentElements, sizeof (RESIZABLE_TABLE_ENTRY), nameSortAsc);
     }
     
     else
     {
-        qsort (names, table->currentElements, sizeof (char*), nameSortDesc);
-    }
-    
-    // Array 'names' is now sorted.
-    
-    // First transfer corresponding values from 'values' to 'table->array'
-    for (i = 0; i < table->currentElements; i ++)
-    {
-        
-        table->array[i].value = values[rtable_lookup_index (table, names[i])]; // Copy only the address, if value is a string
-        
-        // Cannot transfer names till all values are transferred, to avoid affecting the results of rtable_lookup_index.
+        qsort (table->array, table->currentElements, sizeof (RESIZABLE_TABLE_ENTRY), nameSortDesc);
     }
     
-    // Transfer sorted names from 'names' to 'table->array'
-    for (i = 0; i < table->currentElements; i ++)
-    {   
-        table->array[i].name = names[i]; // Copy only the address
-    }
+    cache_reset (table);
+    ttl_reindex (table, 0, table->currentElements);
 }
 
-// Causes qsort to sort integer values in ascending order
-int longValSortAsc (const void* valPtr1, const void* valPtr2)
+// Causes qsort to sort entries by integer value in ascending order
+static int longValSortAsc (const void* entryPtr1, const void* entryPtr2)
 {
-    long val1 = *((long*) valPtr1);
-    long val2 = *((long*) valPtr2);
+    long val1 = (long) (((RESIZABLE_TABLE_ENTRY*) entryPtr1)->value);
+    long val2 = (long) (((RESIZABLE_TABLE_ENTRY*) entryPtr2)->value);
     
-    return (val1 - val2);
+    // Do not return val1 - val2, it overflows for values far apart
+    return (val1 > val2) - (val1 < val2);
 }
 
-// Causes qsort to sort integer values in descending order
-int longValSortDesc (const void* valPtr1, const void* valPtr2)
+// Causes qsort to sort entries by integer value in descending order
+static int longValSortDesc (const void* entryPtr1, const void* entryPtr2)
 {
-    return longValSortAsc (valPtr2, valPtr1);
+    return longValSortAsc (entryPtr2, entryPtr1);
 }
 
 //
@@ -597,56 +1045,24 @@ void rtable_sort_by_intval (RESIZABLE_TABLE* table, int ascending)
         return;
     }
     
-    int i, j; // Array indices
-    
-    // Create an array consisting of only the names stored in the array and an array consisting of only the values stored in the array, in their original order. 
-    
-    char* names[table->currentElements];
-    void* values[table->currentElements];
-    
-    for (i = 0; i < table->currentElements; i ++)
+    if (table->frozen) // The order of a frozen table is fixed by its perfect hash
     {
-        names[i] = table->array[i].name; // Copy only the address
-        values[i] = table->array[i].value; // Copy only the address, if value is a string
+        return;
     }
     
+    // Sorting whole entries keeps every name with its value, even when values repeat.
     if (ascending == 1)
     {
-        qsort (values, table->currentElements, sizeof (long), longValSortAsc);
+        qsort (table->array, table->currentElements, sizeof (RESIZABLE_TABLE_ENTRY), longValSortAsc);
     }
     
     else
     {
-        qsort (values, table->currentElements, sizeof (long), longValSortDesc);
-    }
-    
-    // Array 'values' is now sorted.
-    
-    // First transfer corresponding names
-    for (i = 0; i < table->currentElements; i ++)
-    {
-        for (j = 0; j < table->currentElements; j ++)
-        {
-            if (values[i] == table->array[j].value)
-            {
-                table->array[i].name = names[j];
-                
-                /* In case multiple names have the same value (if value is not a string), need to change value so that it will not be matched again. To reduce chances of accidentally matching something else, replace it with something that will probably NOT match any of the other values -- here, I replace value with address of the corresponding name. */
-                table->array[j].value = table->array[j].name;
-                
-                // Do NOT keep looking after you have found a match
-                break;
-            }
-        }
-        
-        // Cannot transfer values till all names are transferred, to avoid affecting the results of value lookup.
+        qsort (table->array, table->currentElements, sizeof (RESIZABLE_TABLE_ENTRY), longValSortDesc);
     }
     
-    // Transfer sorted values from 'values' into 'table->array'
-    for (i = 0; i < table->currentElements; i ++)
-    {   
-        table->array[i].value = values[i]; // Copy only the address
-    }
+    cache_reset (table);
+    ttl_reindex (table, 0, table->currentElements);
 }
 
 //
@@ -684,30 +1100,61 @@ int rtable_remove_last (RESIZABLE_TABLE* table)
 //
 int rtable_insert_first (RESIZABLE_TABLE* table, char* name, void* value) 
 {
-    int i; // Loop index
+    if (table->frozen) // Frozen tables are read-only
+    {
+        return FAILURE;
+    }
+    
+    // A cache table stays within its capacity
+    cache_make_room (table);
 
     // Make sure that there is enough space
     
     if ((table->currentElements) == (table->maxElements)) // Run out of space
     {
         // Allocate more memory
-        reallocate (table);
+        if (reallocate (table) == FAILURE)
+        {
+            return FAILURE;
+        }
     }
     
     // Shift all entries, after the first, downwards.
-    for (i = (table->currentElements); i >= 0 ; i --)
+    INSTR_COUNT (INSTR_SHIFTS, table->currentElements);
+    memmove (table->array + 1, table->array, (table->currentElements) * sizeof (RESIZABLE_TABLE_ENTRY));
+    
+    if (table->cache != NULL)
     {
-        table->array[i].name = table->array[i-1].name;
-        table->array[i].value = table->array[i-1].value;
+        memmove (table->cache->referenced + 1, table->cache->referenced, table->currentElements);
+        table->cache->referenced[0] = 0;
     }
     
     // We need to use strdup to create a copy of the name but not value.
-	table->array[0].name = name;
+	table->array[0].name = strdup (name);
     table->array[0].value = value;
+    table->array[0].timer = NULL;
+    
+    if (index_entry (table, 0) == FAILURE)
+    {
+        free (table->array[0].name);
+        memmove (table->array, table->array + 1, (table->currentElements) * sizeof (RESIZABLE_TABLE_ENTRY));
+        
+        if (table->cache != NULL)
+        {
+            memmove (table->cache->referenced, table->cache->referenced + 1, table->currentElements);
+        }
+        
+        return FAILURE;
+    }
+    
+    count_entry (table, 0, 1);
     
     // Update currentElements
     (table->currentElements) ++;
     
+    ttl_reindex (table, 1, table->currentElements);
+    move_cursors (table, 0, 1);
+    
     return SUCCESS;
 }
 
@@ -718,22 +1165,1664 @@ int rtable_insert_first (RESIZABLE_TABLE* table, char* name, void* value)
 
 int rtable_insert_last (RESIZABLE_TABLE* table, char* name, void* value)
 {
+    if (table->frozen) // Frozen tables are read-only
+    {
+        return FAILURE;
+    }
+    
+    // A cache table stays within its capacity
+    cache_make_room (table);
+    
     // Make sure that there is enough space
     
     if ((table->currentElements) == (table->maxElements)) // Run out of space
     {
         // Allocate more memory
-        reallocate (table);
+        if (reallocate (table) == FAILURE)
+        {
+            return FAILURE;
+        }
+    }
+    
+    if (table->cache != NULL)
+    {
+        table->cache->referenced[table->currentElements] = 0;
     }
 
     /* Add name and value to a new entry. We need to use strdup to create a copy 
     of the name but not value. Assuming preexisting name and value do not need to be freed. */
-	//table->array[table->currentElements].name = strdup (name);
-	table->array[table->currentElements].name = name;
+	table->array[table->currentElements].name = strdup (name);
     table->array[table->currentElements].value = value;
+    table->array[table->currentElements].timer = NULL;
+    
+    if (index_entry (table, table->currentElements) == FAILURE)
+    {
+        free (table->array[table->currentElements].name);
+        return FAILURE;
+    }
+    
+    count_entry (table, table->currentElements, 1);
     
     // Update currentElements
     (table->currentElements) ++;
     
 	return SUCCESS;
-}
\ No newline at end of file
+}
+
+//
+// It turns the table into a read-only table. A minimal perfect hash is built over the
+// names and the entries are reordered so that the entry of every name sits in the slot
+// the hash gives for it. After this, rtable_lookup costs one hash and one strcmp.
+// Every function that modifies the table fails on a frozen table.
+// It will return 1 if successful, or 0 if the table has duplicate names or memory runs out.
+//
+int rtable_freeze (RESIZABLE_TABLE* table)
+{
+    size_t i; // Array index
+    
+    if (table->frozen) // Nothing to do
+    {
+        return SUCCESS;
+    }
+    
+    if (table->currentElements > INT_MAX) // Too large for the perfect hash
+    {
+        return FAILURE;
+    }
+    
+    if ((table->ttl != NULL) && (table->ttl->timers > 0)) // Entries of a frozen table cannot expire
+    {
+        return FAILURE;
+    }
+    
+    char** names = malloc ((table->currentElements + 1) * sizeof (char*));
+    if (names == NULL)
+    {
+        return FAILURE;
+    }
+    
+    for (i = 0; i < table->currentElements; i ++)
+    {
+        names[i] = table->array[i].name; // Copy only the address
+    }
+    
+    PERFECT_HASH* phash = phash_build (names, (int) table->currentElements);
+    free (names);
+    
+    if (phash == NULL)
+    {
+        return FAILURE;
+    }
+    
+    // A frozen table never grows, so the new array holds exactly currentElements entries.
+    RESIZABLE_TABLE_ENTRY* frozenArray = harray_alloc ((table->currentElements) * sizeof (RESIZABLE_TABLE_ENTRY), table->hugePages);
+    if (frozenArray == NULL)
+    {
+        phash_free (phash);
+        return FAILURE;
+    }
+    
+    for (i = 0; i < table->currentElements; i ++)
+    {
+        frozenArray[phash_index (phash, table->array[i].name)] = table->array[i];
+    }
+    
+    harray_free (table->array, (table->maxElements) * sizeof (RESIZABLE_TABLE_ENTRY));
+    
+    table->array = frozenArray;
+    table->maxElements = table->currentElements;
+    table->phash = phash;
+    table->frozen = 1;
+    cache_reset (table);
+    
+    return SUCCESS;
+}
+
+//
+// It returns 1 if the table was frozen with rtable_freeze, or 0 otherwise.
+//
+int rtable_is_frozen (RESIZABLE_TABLE* table)
+{
+    return table->frozen;
+}
+
+#define FROZEN_MAGIC "RTFZ"
+#define FROZEN_STR_VALUES 0
+#define FROZEN_INT_VALUES 1
+
+/* Writes a string as its length followed by its bytes. */
+static int save_string (FILE* fout, char* str)
+{
+    int32_t len = strlen (str);
+    
+    if ((fwrite (&len, sizeof (int32_t), 1, fout) != 1) || (fwrite (str, 1, len, fout) != (size_t) len))
+    {
+        return FAILURE;
+    }
+    
+    return SUCCESS;
+}
+
+/* Reads a string written by save_string. It returns NULL on a truncated file. */
+static char* read_string (FILE* fin)
+{
+    int32_t len;
+    
+    if ((fread (&len, sizeof (int32_t), 1, fin) != 1) || (len < 0))
+    {
+        return NULL;
+    }
+    
+    char* str = malloc (len + 1);
+    if (str == NULL)
+    {
+        return NULL;
+    }
+    
+    if (fread (str, 1, len, fin) != (size_t) len)
+    {
+        free (str);
+        return NULL;
+    }
+    
+    str[len] = TERMINATING_NULL_BYTE;
+    
+    return str;
+}
+
+/* Saves a frozen table in binary form: a magic string, the value type, the perfect hash
+and then the entries in slot order. Loading it back does not need to rebuild the hash. */
+static int save_frozen (RESIZABLE_TABLE* table, char* file_name, int32_t valueType)
+{
+    size_t i; // Array index
+    int result = SUCCESS;
+    
+    if (!(table->frozen))
+    {
+        return FAILURE;
+    }
+    
+    FILE* fout = fopen (file_name, "wb");
+    if (fout == NULL) // fopen failed
+    {
+        return FAILURE;
+    }
+    
+    if ((fwrite (FROZEN_MAGIC, 1, 4, fout) != 4) || (fwrite (&valueType, sizeof (int32_t), 1, fout) != 1) || (phash_save (table->phash, fout) == FAILURE))
+    {
+        result = FAILURE;
+    }
+    
+    for (i = 0; (i < table->currentElements) && (result == SUCCESS); i ++)
+    {
+        result = save_string (fout, table->array[i].name);
+        
+        if ((result == SUCCESS) && (valueType == FROZEN_STR_VALUES))
+        {
+            result = save_string (fout, (char*) (table->array[i].value));
+        }
+        
+        else if (result == SUCCESS)
+        {
+            int64_t value = (long) (table->array[i].value);
+            
+            if (fwrite (&value, sizeof (int64_t), 1, fout) != 1)
+            {
+                result = FAILURE;
+            }
+        }
+    }
+    
+    if (fclose (fout) != 0)
+    {
+        result = FAILURE;
+    }
+    
+	return result;
+}
+
+/* Reads a table written by save_frozen. The table comes back frozen, without rebuilding
+the perfect hash. Existing entries are cleared first; their values are freed only if
+the file holds string values, as in rtable_read_str. */
+static int read_frozen (RESIZABLE_TABLE* table, char* file_name, int32_t valueType)
+{
+    size_t i; // Array index
+    char magic[4];
+    int32_t fileValueType;
+    
+    if (table->frozen) // Frozen tables are read-only
+    {
+        return FAILURE;
+    }
+    
+    if (table->cache != NULL) // The whole file would not fit a bounded cache
+    {
+        return FAILURE;
+    }
+    
+    FILE* fin = fopen (file_name, "rb");
+    if (fin == NULL) // fopen failed
+    {
+        return FAILURE;
+    }
+    
+    if ((fread (magic, 1, 4, fin) != 4) || (memcmp (magic, FROZEN_MAGIC, 4) != 0) ||
+        (fread (&fileValueType, sizeof (int32_t), 1, fin) != 1) || (fileValueType != valueType))
+    {
+        fclose (fin);
+        return FAILURE;
+    }
+    
+    PERFECT_HASH* phash = phash_read (fin);
+    if (phash == NULL)
+    {
+        fclose (fin);
+        return FAILURE;
+    }
+    
+    RESIZABLE_TABLE_ENTRY* frozenArray = harray_alloc (phash->nKeys * sizeof (RESIZABLE_TABLE_ENTRY), table->hugePages);
+    if (frozenArray == NULL)
+    {
+        phash_free (phash);
+        fclose (fin);
+        return FAILURE;
+    }
+    
+    if (valueType == FROZEN_STR_VALUES) // String values cannot be indexed
+    {
+        drop_index (table);
+    }
+    
+    clear_entries (table);
+    harray_free (table->array, (table->maxElements) * sizeof (RESIZABLE_TABLE_ENTRY));
+    
+    table->intValues = (valueType == FROZEN_INT_VALUES);    
+    table->array = frozenArray;
+    table->maxElements = phash->nKeys;
+    
+    for (i = 0; i < table->maxElements; i ++)
+    {
+        char* name = read_string (fin);
+        void* value = NULL;
+        int64_t intValue;
+        int valueRead = FAILURE;
+        
+        if ((name != NULL) && (valueType == FROZEN_STR_VALUES))
+        {
+            value = (void*) read_string (fin);
+            valueRead = (value != NULL);
+        }
+        
+        else if ((name != NULL) && (fread (&intValue, sizeof (int64_t), 1, fin) == 1))
+        {
+            value = (void*) (long) intValue;
+            valueRead = SUCCESS;
+        }
+        
+        table->array[i].name = name;
+        table->array[i].value = value;
+        table->array[i].timer = NULL;
+        
+        // Every name must sit in its own slot, or the file does not match its hash
+        if ((valueRead == FAILURE) || ((size_t) phash_index (phash, name) != i) || (index_entry (table, i) == FAILURE))
+        {
+            free (name);
+            
+            if (valueType == FROZEN_STR_VALUES)
+            {
+                free (value);
+            }
+            
+            // Keep what was read as an ordinary (not frozen) table
+            phash_free (phash);
+            fclose (fin);
+            return FAILURE;
+        }
+        
+        count_entry (table, i, 1);
+        (table->currentElements) ++;
+    }
+    
+    fclose (fin);
+    
+    table->phash = phash;
+    table->frozen = 1;
+    
+	return SUCCESS;
+}
+
+//
+// It saves a frozen table with values as char * in binary form, together with its perfect
+// hash. It will return 1 if successful, or 0 if the table is not frozen or writing failed.
+//
+int rtable_save_frozen_str (RESIZABLE_TABLE* table, char* file_name)
+{
+    return save_frozen (table, file_name, FROZEN_STR_VALUES);
+}
+
+//
+// It reads a table saved with rtable_save_frozen_str. The table is frozen when this
+// returns 1. If the table already has entries, it will clear the entries.
+//
+int rtable_read_frozen_str (RESIZABLE_TABLE* table, char* file_name)
+{
+    return read_frozen (table, file_name, FROZEN_STR_VALUES);
+}
+
+//
+// It saves a frozen table with values as int in binary form, together with its perfect
+// hash. It will return 1 if successful, or 0 if the table is not frozen or writing failed.
+//
+int rtable_save_frozen_int (RESIZABLE_TABLE* table, char* file_name)
+{
+    return save_frozen (table, file_name, FROZEN_INT_VALUES);
+}
+
+//
+// It reads a table saved with rtable_save_frozen_int. The table is frozen when this
+// returns 1. If the table already has entries, it will clear the entries.
+//
+int rtable_read_frozen_int (RESIZABLE_TABLE* table, char* file_name)
+{
+    return read_frozen (table, file_name, FROZEN_INT_VALUES);
+}
+
+//
+// It asks for transparent huge pages for the arrays of this table that are large enough
+// to be mapped (see huge_array.h). It takes effect from the next time the array grows.
+// Huge pages cut TLB misses when lookups jump around a very large table.
+//
+void rtable_use_huge_pages (RESIZABLE_TABLE* table, int hugePages)
+{
+    table->hugePages = hugePages;
+}
+
+/* Frees the cache of the table, if it has one, and turns cache mode off. */
+static void free_cache (RESIZABLE_TABLE* table)
+{
+    if (table->cache != NULL)
+    {
+        free ((table->cache)->referenced);
+        free (table->cache);
+        table->cache = NULL;
+    }
+}
+
+//
+// It turns the table into a cache of at most capacity entries. When the table is full,
+// rtable_add, rtable_insert_first, rtable_insert_last and rtable_read_* evict one entry
+// chosen by the CLOCK algorithm: every rtable_lookup hit marks its entry as used and
+// eviction skips used entries once. rtable_add puts the new entry in the slot of the
+// evicted one, so it takes O(1); the order of the entries is not kept.
+// If evict is not NULL it is called with every evicted entry and context.
+// If the table already has more entries, the extra ones are evicted now.
+// A capacity of 0 turns cache mode off. It will return 1 if successful, or 0 otherwise.
+//
+int rtable_set_cache (RESIZABLE_TABLE* table, size_t capacity, RTABLE_EVICT_FUNC evict, void* context)
+{
+    RTABLE_CACHE* cache = table->cache;
+    
+    if (table->frozen) // A frozen table cannot evict
+    {
+        return FAILURE;
+    }
+    
+    if (capacity == 0) // Back to an unbounded table
+    {
+        free_cache (table);
+        
+        return SUCCESS;
+    }
+    
+    if (cache == NULL)
+    {
+        cache = calloc (1, sizeof (RTABLE_CACHE));
+        if (cache == NULL)
+        {
+            return FAILURE;
+        }
+    }
+    
+    // One bit for every entry there is now, and for every entry there may be later
+    size_t referencedLength = (capacity > table->currentElements) ? capacity : table->currentElements;
+    unsigned char* referenced = calloc (referencedLength, 1);
+    if (referenced == NULL)
+    {
+        if (table->cache == NULL)
+        {
+            free (cache);
+        }
+        
+        return FAILURE;
+    }
+    
+    if (cache->referenced != NULL) // Keep what is known about the current entries
+    {
+        memcpy (referenced, cache->referenced, table->currentElements);
+        free (cache->referenced);
+    }
+    
+    cache->capacity = capacity;
+    cache->referenced = referenced;
+    cache->referencedLength = referencedLength;
+    cache->evict = evict;
+    cache->evictContext = context;
+    table->cache = cache;
+    
+    while (table->currentElements > capacity)
+    {
+        remove_slot (table, cache_evict (table));
+    }
+    
+    return SUCCESS;
+}
+
+//
+// It stores in *stats the hit, miss and eviction counters of a cache table.
+// They are all 0 if the table is not a cache.
+//
+void rtable_cache_stats (RESIZABLE_TABLE* table, RTABLE_CACHE_STATS* stats)
+{
+    if (table->cache == NULL)
+    {
+        memset (stats, 0, sizeof (RTABLE_CACHE_STATS));
+        return;
+    }
+    
+    *stats = table->cache->stats;
+}
+
+//
+// It sets the time to live of the entry with that name to ttl milliseconds from now,
+// replacing any previous TTL. A ttl of 0 makes the entry permanent again. An expired
+// entry is removed by the first lookup that finds it, or by rtable_expire.
+// It will return 1 if successful, or 0 if the name does not exist or the table is frozen.
+//
+int rtable_set_ttl (RESIZABLE_TABLE* table, char* name, uint64_t ttl)
+{
+    if (table->frozen) // Frozen tables are read-only
+    {
+        return FAILURE;
+    }
+    
+    long nameIndex = rtable_lookup_index (table, name);
+    
+    if (nameIndex == -1) // Name does not exist in the table
+    {
+        return FAILURE;
+    }
+    
+    RESIZABLE_TABLE_ENTRY* entry = &(table->array[nameIndex]);
+    uint64_t now = ttl_now (table);
+    
+    if (table->ttl == NULL) // First TTL of the table
+    {
+        table->ttl = malloc (sizeof (TIMER_WHEEL));
+        if (table->ttl == NULL)
+        {
+            return FAILURE;
+        }
+        
+        twheel_init (table->ttl, now);
+    }
+    
+    if (entry->timer != NULL) // Replace the previous TTL
+    {
+        twheel_cancel (table->ttl, entry->timer);
+        
+        if (ttl == 0)
+        {
+            free (entry->timer);
+            entry->timer = NULL;
+            
+            return SUCCESS;
+        }
+    }
+    
+    else if (ttl == 0) // Already permanent
+    {
+        return SUCCESS;
+    }
+    
+    else
+    {
+        entry->timer = malloc (sizeof (TIMER_WHEEL_TIMER));
+        if (entry->timer == NULL)
+        {
+            return FAILURE;
+        }
+    }
+    
+    entry->timer->expires = now + ttl;
+    entry->timer->index = (size_t) nameIndex;
+    
+    // The wheel files the timer relative to the time it was last advanced to
+    twheel_advance (table->ttl, now);
+    twheel_add (table->ttl, entry->timer);
+    
+    return SUCCESS;
+}
+
+//
+// It removes at most maxEntries entries whose TTL has passed, and returns how many it
+// removed. The timer wheel only visits the timers that are due, so calling this often with
+// a small maxEntries keeps every sweep short no matter how large the table is.
+//
+size_t rtable_expire (RESIZABLE_TABLE* table, size_t maxEntries)
+{
+    size_t removed = 0;
+    TIMER_WHEEL_TIMER* timer;
+    
+    if ((table->ttl == NULL) || (table->frozen)) // No entry has ever had a TTL
+    {
+        return 0;
+    }
+    
+    twheel_advance (table->ttl, ttl_now (table));
+    
+    while ((removed < maxEntries) && ((timer = twheel_first_expired (table->ttl)) != NULL))
+    {
+        // This also cancels and frees the timer
+        rtable_remove_ith (table, timer->index);
+        removed ++;
+    }
+    
+    return removed;
+}
+
+//
+// It makes the TTLs of the table use clock, called with context, instead of the monotonic
+// clock. A NULL clock goes back to the monotonic clock. Set it before the first TTL.
+//
+void rtable_set_clock (RESIZABLE_TABLE* table, RTABLE_CLOCK_FUNC clock, void* context)
+{
+    table->clock = clock;
+    table->clockContext = context;
+}
+
+//
+// It builds a secondary index over the values of an int table, which is kept up to date
+// by every function that adds, changes or removes entries. It powers rtable_topk,
+// rtable_value_range and rtable_rank, which never reorder the table. An empty table becomes
+// an int table, and rtable_add_str fails while the index exists. Reading a string table
+// with rtable_read_str drops the index.
+// It will return 1 if successful, or 0 if the values are not ints or memory runs out.
+//
+int rtable_index_values (RESIZABLE_TABLE* table)
+{
+    size_t i; // Array index
+    
+    if (table->vindex != NULL) // Already indexed
+    {
+        return SUCCESS;
+    }
+    
+    if ((!(table->intValues)) && (table->currentElements > 0)) // String values have no order
+    {
+        return FAILURE;
+    }
+    
+    table->vindex = vindex_create ();
+    if (table->vindex == NULL)
+    {
+        return FAILURE;
+    }
+    
+    table->intValues = 1; // An empty table is an int table from now on
+    
+    for (i = 0; i < table->currentElements; i ++)
+    {
+        if (index_entry (table, i) == FAILURE)
+        {
+            drop_index (table);
+            return FAILURE;
+        }
+    }
+    
+    return SUCCESS;
+}
+
+//
+// It stores in names and values the k entries with the largest values, from the largest
+// down, and returns how many it stored. It takes O(log n + k) and needs rtable_index_values.
+// It returns 0 if the table has no value index.
+//
+size_t rtable_topk (RESIZABLE_TABLE* table, size_t k, char** names, long* values)
+{
+    if (table->vindex == NULL)
+    {
+        return 0;
+    }
+    
+    return vindex_largest (table->vindex, k, names, values);
+}
+
+//
+// It stores in names and values, by ascending value, the entries with low <= value <= high,
+// at most maxResults of them, and returns how many it stored. It needs rtable_index_values.
+// It returns 0 if the table has no value index.
+//
+size_t rtable_value_range (RESIZABLE_TABLE* table, long low, long high, char** names, long* values, size_t maxResults)
+{
+    if (table->vindex == NULL)
+    {
+        return 0;
+    }
+    
+    return vindex_range (table->vindex, low, high, names, values, maxResults);
+}
+
+//
+// It returns how many entries have a smaller value than the entry with that name, so the
+// smallest value has rank 0. It needs rtable_index_values. It returns -1 if the name does
+// not exist or the table has no value index.
+//
+long rtable_rank (RESIZABLE_TABLE* table, char* name)
+{
+    if (table->vindex == NULL)
+    {
+        return -1;
+    }
+    
+    long nameIndex = rtable_lookup_index (table, name);
+    
+    if (nameIndex == -1) // Name does not exist in the table
+    {
+        return -1;
+    }
+    
+    return (long) vindex_count_less (table->vindex, (long) table->array[nameIndex].value);
+}
+
+//
+// It finds the k entries of an int table with the largest values, in one pass and O(k)
+// memory, without sorting or indexing the table. mode is one of the TOPK_* modes of
+// top_k.h; in a table every name is unique, so the heavy hitter modes only differ in
+// ignoring negative values. The results go to items, which must have room for k items,
+// from the largest value down, and their names must be freed by the caller.
+// It returns the number of items, or -1 if the values are not ints, if k is 0 or if
+// memory runs out.
+//
+long rtable_stream_topk (RESIZABLE_TABLE* table, size_t k, int mode, TOPK_ITEM* items)
+{
+    size_t i; // Array index
+    
+    if ((!(table->intValues)) && (table->currentElements > 0)) // Values are pointers
+    {
+        return -1;
+    }
+    
+    TOPK* topk = topk_create (k, mode);
+    if (topk == NULL)
+    {
+        return -1;
+    }
+    
+    for (i = 0; i < table->currentElements; i ++)
+    {
+        if (topk_add (topk, table->array[i].name, (long) table->array[i].value) == FAILURE)
+        {
+            topk_free (topk);
+            return -1;
+        }
+    }
+    
+    long n = (long) topk_finish (topk, items);
+    topk_free (topk);
+    
+    return n;
+}
+
+//
+// Like rtable_stream_topk, over the records of a file saved by rtable_save_int, which are
+// streamed one by one instead of being read into a table. The same name may appear in many
+// records; the heavy hitter modes add up its values.
+// It returns the number of items, or -1 if the file cannot be read or memory runs out.
+//
+long rtable_stream_topk_file (char* file_name, size_t k, int mode, TOPK_ITEM* items)
+{
+    char line[MAXLINE + 1]; // Temporary buffer to store name read in from file
+    long value; // Temporarily stores value read in from file
+    
+    TOPK* topk = topk_create (k, mode);
+    if (topk == NULL)
+    {
+        return -1;
+    }
+    
+    FILE* fin = fopen (file_name, READ_MODE);
+    if (fin == NULL) // fopen failed
+    {
+        topk_free (topk);
+        return -1;
+    }
+    
+    while (fgets(line, MAXLINE + 1, fin) != NULL) // Read in name
+    {
+        // Remove newline character at the end of input string
+        sanitise (line);
+        
+        if ((fscanf(fin, "%ld\n", &value) != 1) || (topk_add (topk, line, value) == FAILURE))
+        {
+            fclose (fin);
+            topk_free (topk);
+            return -1;
+        }
+    }
+    
+    fclose (fin);
+    
+    long n = (long) topk_finish (topk, items);
+    topk_free (topk);
+    
+    return n;
+}
+
+//
+// It computes the aggregates requested in agg (see aggregate.h) over the values of an int
+// table, without rtable_get_ith or casts. The values are 8 bytes apart from the names, so
+// they are gathered into a small contiguous buffer a block at a time for the vector kernels.
+// It will return 1 if successful, or 0 if the values are not ints or the inputs are invalid.
+//
+int rtable_aggregate_int (RESIZABLE_TABLE* table, AGGREGATE* agg)
+{
+    if ((!(table->intValues)) && (table->currentElements > 0)) // Values are pointers
+    {
+        return FAILURE;
+    }
+    
+    // A long stored in a void* has the bits of an int64_t on the 64 bit targets the table runs on
+    return aggregate_strided (agg, &(table->array[0].value), sizeof (RESIZABLE_TABLE_ENTRY), table->currentElements);
+}
+
+/* Maps every name of the table to its index + 1, so that no entry maps to NULL. If the table
+has the same name more than once the map keeps the first entry, and next (if not NULL) chains
+each entry to the index + 1 of the following one with its name, or 0. */
+static HASH_MAP* map_names (RESIZABLE_TABLE* table, size_t* next)
+{
+    size_t i; // Array index
+    
+    HASH_MAP* map = hmap_create (table->currentElements);
+    if (map == NULL)
+    {
+        return NULL;
+    }
+    
+    for (i = table->currentElements; i -- > 0; ) // Backwards, so that the first entry ends up in the map
+    {
+        char* name = table->array[i].name;
+        uint64_t hash = hmap_hash (name);
+        void* later = NULL;
+        
+        if (next != NULL)
+        {
+            next[i] = hmap_get_hashed (map, name, hash, &later) ? (size_t) later : 0;
+        }
+        
+        if (hmap_put_hashed (map, name, hash, (void*) (i + 1)) == FAILURE)
+        {
+            hmap_free (map);
+            return NULL;
+        }
+    }
+    
+    return map;
+}
+
+/* Replaces the value of the ith entry. A string table stores a copy and frees the old string. */
+static int replace_value (RESIZABLE_TABLE* table, size_t ith, void* value)
+{
+    RESIZABLE_TABLE_ENTRY* entry = &(table->array[ith]);
+    
+    if (table->intValues)
+    {
+        if (table->vindex != NULL)
+        {
+            vindex_update (table->vindex, entry->name, (long) entry->value, (long) value);
+        }
+        
+        entry->value = value;
+        return SUCCESS;
+    }
+    
+    if (value == entry->value) // Kept as it is
+    {
+        return SUCCESS;
+    }
+    
+    char* copy = strdup ((char*) value);
+    if (copy == NULL)
+    {
+        return FAILURE;
+    }
+    
+    if (entry->value != NULL)
+    {
+        count_string (table, (char*) entry->value, &(table->valueBytes), 0);
+    }
+    
+    count_string (table, copy, &(table->valueBytes), 1);
+    free (entry->value);
+    entry->value = copy;
+    
+    return SUCCESS;
+}
+
+//
+// It merges src into dest in O(N + M), with one temporary hash table over the names of
+// dest. Names only in src are added at the end of dest. For a name in both tables, dest
+// keeps the value returned by resolve, or the value of src if resolve is NULL (last writer
+// wins). String values are copied, so src is left as it is.
+// It will return 1 if successful, or 0 if the value types differ, dest is frozen or a cache,
+// or memory runs out (dest then holds part of the merge).
+//
+int rtable_merge (RESIZABLE_TABLE* dest, RESIZABLE_TABLE* src, RTABLE_MERGE_FUNC resolve, void* context)
+{
+    size_t j; // Index in src
+    void* found;
+    
+    if ((dest->frozen) || (dest->cache != NULL)) // Evictions would move the entries the map points to
+    {
+        return FAILURE;
+    }
+    
+    if (dest->currentElements == 0) // An empty table takes the value type of src
+    {
+        dest->intValues = src->intValues;
+    }
+    
+    else if ((src->currentElements > 0) && (dest->intValues != src->intValues))
+    {
+        return FAILURE;
+    }
+    
+    HASH_MAP* map = map_names (dest, NULL);
+    if (map == NULL)
+    {
+        return FAILURE;
+    }
+    
+    for (j = 0; j < src->currentElements; j ++)
+    {
+        char* name = src->array[j].name;
+        void* value = src->array[j].value;
+        uint64_t hash = hmap_hash (name);
+        int status;
+        
+        if (hmap_get_hashed (map, name, hash, &found))
+        {
+            size_t i = (size_t) found - 1;
+            
+            if (resolve != NULL)
+            {
+                value = resolve (name, dest->array[i].value, value, context);
+            }
+            
+            status = replace_value (dest, i, value);
+        }
+        
+        else
+        {
+            if (!(dest->intValues))
+            {
+                value = strdup ((char*) value);
+            }
+            
+            status = (value != NULL) || (dest->intValues);
+            status = status && rtable_insert_last (dest, name, value);
+            
+            // Later entries of src with this name merge into the new entry
+            status = status && hmap_put_hashed (map, dest->array[dest->currentElements - 1].name, hash, (void*) dest->currentElements);
+        }
+        
+        if (status == FAILURE)
+        {
+            hmap_free (map);
+            return FAILURE;
+        }
+    }
+    
+    hmap_free (map);
+    return SUCCESS;
+}
+
+//
+// It reports through report every name added, removed or changed from oldTable to newTable,
+// in O(N + M), with one temporary hash table over the names of oldTable. Changes and
+// additions come in the order of newTable, then removals in the order of oldTable. Int
+// values are compared as numbers, string values with strcmp.
+// It will return 1 if successful, or 0 if memory runs out.
+//
+int rtable_diff (RESIZABLE_TABLE* oldTable, RESIZABLE_TABLE* newTable, RTABLE_DIFF_FUNC report, void* context)
+{
+    size_t i; // Index in oldTable
+    size_t j; // Index in newTable
+    void* found;
+    int intValues = (oldTable->intValues) || (newTable->intValues);
+    
+    HASH_MAP* map = map_names (oldTable, NULL);
+    if (map == NULL)
+    {
+        return FAILURE;
+    }
+    
+    char* seen = calloc (oldTable->currentElements + 1, 1);
+    if (seen == NULL)
+    {
+        hmap_free (map);
+        return FAILURE;
+    }
+    
+    for (j = 0; j < newTable->currentElements; j ++)
+    {
+        RESIZABLE_TABLE_ENTRY* entry = &(newTable->array[j]);
+        
+        if (!hmap_get (map, entry->name, &found))
+        {
+            report (RTABLE_DIFF_ADDED, entry->name, NULL, entry->value, context);
+            continue;
+        }
+        
+        i = (size_t) found - 1;
+        seen[i] = 1;
+        
+        void* oldValue = oldTable->array[i].value;
+        int same = intValues ? (oldValue == entry->value) : (strcmp ((char*) oldValue, (char*) entry->value) == 0);
+        
+        if (!same)
+        {
+            report (RTABLE_DIFF_CHANGED, entry->name, oldValue, entry->value, context);
+        }
+    }
+    
+    for (i = 0; i < oldTable->currentElements; i ++)
+    {
+        // Entries that share a name with an earlier one are covered by it
+        if ((!seen[i]) && hmap_get (map, oldTable->array[i].name, &found) && ((size_t) found - 1 == i))
+        {
+            report (RTABLE_DIFF_REMOVED, oldTable->array[i].name, oldTable->array[i].value, NULL, context);
+        }
+    }
+    
+    free (seen);
+    hmap_free (map);
+    return SUCCESS;
+}
+
+/* One partition of a parallel hash join. The names are split by their hash, so the
+partitions are independent and each builds its own small hash table. */
+typedef struct JOIN_PARTITION
+{
+    RESIZABLE_TABLE* left;
+    RESIZABLE_TABLE* right;
+    RTABLE_JOIN_FUNC emit;
+    void* context;
+    uint64_t* leftHashes;
+    uint64_t* rightHashes;
+    size_t* next; // Chains of left entries with the same name, shared by all partitions
+    int partition;
+    int nPartitions;
+    int status;
+} JOIN_PARTITION;
+
+static int partition_of (uint64_t hash, int nPartitions)
+{
+    // High bits: the hash table inside the partition uses the low ones
+    return (int) (((hash >> 32) * (uint64_t) nPartitions) >> 32);
+}
+
+static void* join_partition (void* partitionPtr)
+{
+    JOIN_PARTITION* part = partitionPtr;
+    size_t i; // Index in left
+    size_t j; // Index in right
+    size_t k;
+    size_t nLeft = 0;
+    void* found;
+    
+    for (i = 0; i < part->left->currentElements; i ++)
+    {
+        nLeft += (partition_of (part->leftHashes[i], part->nPartitions) == part->partition);
+    }
+    
+    HASH_MAP* map = hmap_create (nLeft);
+    if (map == NULL)
+    {
+        part->status = FAILURE;
+        return NULL;
+    }
+    
+    // Build over left, backwards so that each chain runs in table order
+    for (i = part->left->currentElements; i -- > 0; )
+    {
+        char* name = part->left->array[i].name;
+        
+        if (partition_of (part->leftHashes[i], part->nPartitions) != part->partition)
+        {
+            continue;
+        }
+        
+        part->next[i] = hmap_get_hashed (map, name, part->leftHashes[i], &found) ? (size_t) found : 0;
+        
+        if (hmap_put_hashed (map, name, part->leftHashes[i], (void*) (i + 1)) == FAILURE)
+        {
+            hmap_free (map);
+            part->status = FAILURE;
+            return NULL;
+        }
+    }
+    
+    // Probe with right
+    for (j = 0; j < part->right->currentElements; j ++)
+    {
+        RESIZABLE_TABLE_ENTRY* entry = &(part->right->array[j]);
+        
+        if ((partition_of (part->rightHashes[j], part->nPartitions) != part->partition) ||
+            (!hmap_get_hashed (map, entry->name, part->rightHashes[j], &found)))
+        {
+            continue;
+        }
+        
+        for (k = (size_t) found; k != 0; k = part->next[k - 1])
+        {
+            part->emit (entry->name, part->left->array[k - 1].value, entry->value, part->context);
+        }
+    }
+    
+    hmap_free (map);
+    part->status = SUCCESS;
+    return NULL;
+}
+
+//
+// It calls emit with every pair of entries, one from left and one from right, that have
+// the same name, in O(N + M) with one temporary hash table over left. The pairs come in
+// the order of right. It will return 1 if successful, or 0 if memory runs out.
+//
+int rtable_join (RESIZABLE_TABLE* left, RESIZABLE_TABLE* right, RTABLE_JOIN_FUNC emit, void* context)
+{
+    return rtable_join_parallel (left, right, emit, context, 1);
+}
+
+//
+// Like rtable_join, with the names split by hash into nThreads partitions that are joined
+// by nThreads threads at once. emit is then called from several threads at the same time,
+// and the order of the pairs is only kept within a partition.
+//
+int rtable_join_parallel (RESIZABLE_TABLE* left, RESIZABLE_TABLE* right, RTABLE_JOIN_FUNC emit, void* context, int nThreads)
+{
+    JOIN_PARTITION parts[MAX_JOIN_THREADS];
+    pthread_t threads[MAX_JOIN_THREADS];
+    int started[MAX_JOIN_THREADS];
+    size_t i; // Array index
+    int p; // Partition index
+    int status = SUCCESS;
+    
+    nThreads = (nThreads < 1) ? 1 : (nThreads > MAX_JOIN_THREADS) ? MAX_JOIN_THREADS : nThreads;
+    
+    uint64_t* leftHashes = malloc ((left->currentElements + 1) * sizeof (uint64_t));
+    uint64_t* rightHashes = malloc ((right->currentElements + 1) * sizeof (uint64_t));
+    size_t* next = malloc ((left->currentElements + 1) * sizeof (size_t));
+    
+    if ((leftHashes == NULL) || (rightHashes == NULL) || (next == NULL))
+    {
+        free (leftHashes);
+        free (rightHashes);
+        free (next);
+        return FAILURE;
+    }
+    
+    // Every name is hashed once, whatever the number of partitions
+    for (i = 0; i < left->currentElements; i ++)
+    {
+        leftHashes[i] = hmap_hash (left->array[i].name);
+    }
+    
+    for (i = 0; i < right->currentElements; i ++)
+    {
+        rightHashes[i] = hmap_hash (right->array[i].name);
+    }
+    
+    for (p = 0; p < nThreads; p ++)
+    {
+        parts[p].left = left;
+        parts[p].right = right;
+        parts[p].emit = emit;
+        parts[p].context = context;
+        parts[p].leftHashes = leftHashes;
+        parts[p].rightHashes = rightHashes;
+        parts[p].next = next;
+        parts[p].partition = p;
+        parts[p].nPartitions = nThreads;
+        parts[p].status = FAILURE;
+        
+        // The last partition runs on this thread, as does any whose thread cannot start
+        started[p] = (p < nThreads - 1) && (pthread_create (&threads[p], NULL, join_partition, &parts[p]) == 0);
+    }
+    
+    for (p = 0; p < nThreads; p ++)
+    {
+        if (started[p])
+        {
+            pthread_join (threads[p], NULL);
+        }
+        
+        else
+        {
+            join_partition (&parts[p]);
+        }
+        
+        status = status && parts[p].status;
+    }
+    
+    free (leftHashes);
+    free (rightHashes);
+    free (next);
+    
+    return status;
+}
+
+/* Orders entries by name, then by their position in the input of rtable_bulk_load, which
+is kept in the (still unused) timer field while they are sorted. */
+static int nameThenPositionAsc (const void* entryPtr1, const void* entryPtr2)
+{
+    const RESIZABLE_TABLE_ENTRY* entry1 = entryPtr1;
+    const RESIZABLE_TABLE_ENTRY* entry2 = entryPtr2;
+    
+    int order = strcmp (entry1->name, entry2->name);
+    if (order != 0)
+    {
+        return order;
+    }
+    
+    return ((uintptr_t) entry1->timer > (uintptr_t) entry2->timer) - ((uintptr_t) entry1->timer < (uintptr_t) entry2->timer);
+}
+
+/* Orders pointers to entries like the value index: by value, then name, then address of the name. */
+static int valueIndexOrder (const void* entryPtr1, const void* entryPtr2)
+{
+    const RESIZABLE_TABLE_ENTRY* entry1 = *((RESIZABLE_TABLE_ENTRY**) entryPtr1);
+    const RESIZABLE_TABLE_ENTRY* entry2 = *((RESIZABLE_TABLE_ENTRY**) entryPtr2);
+    long val1 = (long) entry1->value;
+    long val2 = (long) entry2->value;
+    
+    if (val1 != val2)
+    {
+        return (val1 > val2) - (val1 < val2);
+    }
+    
+    int order = strcmp (entry1->name, entry2->name);
+    if (order != 0)
+    {
+        return order;
+    }
+    
+    return (entry1->name > entry2->name) - (entry1->name < entry2->name);
+}
+
+/* Builds the value index of a bulk loaded table: one sort of pointers, then a linear build. */
+static int bulk_index (RESIZABLE_TABLE* table)
+{
+    size_t i; // Array index
+    size_t n = table->currentElements;
+    int status = FAILURE;
+    
+    RESIZABLE_TABLE_ENTRY** order = malloc ((n + 1) * sizeof (RESIZABLE_TABLE_ENTRY*));
+    char** names = malloc ((n + 1) * sizeof (char*));
+    long* values = malloc ((n + 1) * sizeof (long));
+    table->vindex = vindex_create ();
+    
+    if ((order != NULL) && (names != NULL) && (values != NULL) && (table->vindex != NULL))
+    {
+        for (i = 0; i < n; i ++)
+        {
+            order[i] = &(table->array[i]);
+        }
+        
+        qsort (order, n, sizeof (RESIZABLE_TABLE_ENTRY*), valueIndexOrder);
+        
+        for (i = 0; i < n; i ++)
+        {
+            names[i] = order[i]->name;
+            values[i] = (long) order[i]->value;
+        }
+        
+        status = vindex_build (table->vindex, names, values, n);
+    }
+    
+    if (status == FAILURE)
+    {
+        drop_index (table);
+    }
+    
+    free (order);
+    free (names);
+    free (values);
+    
+    return status;
+}
+
+//
+// It returns a new table with the n entries, or NULL if memory runs out. The array is
+// sized once, for n entries. By default repeated names are removed in one sort and one
+// linear pass, keeping the value of the last one as repeated rtable_add calls would, and
+// the table ends up sorted by name. RTABLE_BULK_SORTED skips the sort and
+// RTABLE_BULK_UNIQUE skips both, keeping the input order. With RTABLE_BULK_TAKE the names
+// and values are not copied, so loading is a copy of the entries array; they belong to the
+// table from then on and are freed if it fails. See resizable_table.h for the other flags.
+//
+RESIZABLE_TABLE* rtable_bulk_load (RESIZABLE_TABLE_ENTRY* entries, size_t n, int flags)
+{
+    size_t i; // Index in the input
+    size_t m = n; // Entries kept
+    int take = ((flags & RTABLE_BULK_TAKE) != 0);
+    int dedup = ((flags & RTABLE_BULK_UNIQUE) == 0);
+    
+    RESIZABLE_TABLE* table = rtable_create ();
+    if (table == NULL)
+    {
+        return NULL;
+    }
+    
+    table->intValues = ((flags & RTABLE_BULK_INT) != 0);
+    table->hugePages = ((flags & RTABLE_BULK_HUGE_PAGES) != 0);
+    
+    if ((n > table->maxElements) && (n <= SIZE_MAX / sizeof (RESIZABLE_TABLE_ENTRY)))
+    {
+        // The only allocation of the array
+        RESIZABLE_TABLE_ENTRY* array = harray_alloc (n * sizeof (RESIZABLE_TABLE_ENTRY), table->hugePages);
+        
+        if (array != NULL)
+        {
+            harray_free (table->array, (table->maxElements) * sizeof (RESIZABLE_TABLE_ENTRY));
+            table->array = array;
+            table->maxElements = n;
+        }
+    }
+    
+    if (n > table->maxElements) // Too large, or memory ran out
+    {
+        for (i = 0; take && (i < n); i ++) // Freed like the entries of the table would be
+        {
+            free (entries[i].name);
+            
+            if (!(table->intValues))
+            {
+                free (entries[i].value);
+            }
+        }
+        
+        rtable_destroy (table);
+        return NULL;
+    }
+    
+    for (i = 0; i < n; i ++)
+    {
+        table->array[i].name = entries[i].name;
+        table->array[i].value = entries[i].value;
+        table->array[i].timer = (TIMER_WHEEL_TIMER*) (uintptr_t) i; // Input position, until deduplicated
+    }
+    
+    if (dedup)
+    {
+        if ((flags & RTABLE_BULK_SORTED) == 0)
+        {
+            qsort (table->array, n, sizeof (RESIZABLE_TABLE_ENTRY), nameThenPositionAsc);
+        }
+        
+        // Keep the last entry of every run of equal names
+        m = 0;
+        
+        for (i = 0; i < n; i ++)
+        {
+            if ((i + 1 < n) && (strcmp (table->array[i].name, table->array[i + 1].name) == 0))
+            {
+                if (take) // Owned by the table, and not kept
+                {
+                    free (table->array[i].name);
+                    
+                    if (!(table->intValues))
+                    {
+                        free (table->array[i].value);
+                    }
+                }
+                
+                continue;
+            }
+            
+            table->array[m ++] = table->array[i];
+        }
+    }
+    
+    for (i = 0; i < m; i ++)
+    {
+        table->array[i].timer = NULL;
+        count_entry (table, i, 1); // A copy has the same length
+    }
+    
+    if (!take) // Copy only the entries that are kept
+    {
+        for (i = 0; i < m; i ++)
+        {
+            table->array[i].name = strdup (table->array[i].name);
+            
+            if (!(table->intValues))
+            {
+                table->array[i].value = strdup ((char*) table->array[i].value);
+            }
+            
+            if ((table->array[i].name == NULL) || ((!(table->intValues)) && (table->array[i].value == NULL)))
+            {
+                free (table->array[i].name);
+                
+                if (!(table->intValues))
+                {
+                    free (table->array[i].value);
+                }
+                
+                table->currentElements = i; // Only the copies are freed
+                rtable_destroy (table);
+                return NULL;
+            }
+        }
+    }
+    
+    table->currentElements = m;
+    
+    if (((flags & RTABLE_BULK_INDEX) != 0) && (table->intValues) && (bulk_index (table) == FAILURE))
+    {
+        rtable_destroy (table);
+        return NULL;
+    }
+    
+    return table;
+}
+
+//
+// It starts a walk over the entries of the table in cursor, which the caller provides.
+// Every rtable_cursor_next call returns the next entry in O(1). The walk stays on its
+// entries while the table changes: entries removed before they are reached are not
+// returned, entries inserted before the position reached are not returned either and
+// entries added at the end are. A sort or a freeze during the walk reorders the entries
+// that are not reached yet. A cursor that is not walked to the end has to be ended with
+// rtable_cursor_end.
+//
+void rtable_cursor_begin (RESIZABLE_TABLE* table, RTABLE_CURSOR* cursor)
+{
+    cursor->table = table;
+    cursor->next = 0;
+    cursor->current = RTABLE_CURSOR_NONE;
+    cursor->nextCursor = table->cursors;
+    table->cursors = cursor;
+}
+
+//
+// It returns in *name and *value the next entry of the walk. It will return 1 if
+// successful, or 0 at the end of the table, which also ends the walk.
+//
+int rtable_cursor_next (RTABLE_CURSOR* cursor, char** name, void** value)
+{
+    RESIZABLE_TABLE* table = cursor->table;
+    
+    if (table == NULL) // The walk is over
+    {
+        return FAILURE;
+    }
+    
+    if (cursor->next >= table->currentElements)
+    {
+        rtable_cursor_end (cursor);
+        return FAILURE;
+    }
+    
+    cursor->current = cursor->next ++;
+    *name = table->array[cursor->current].name;
+    *value = table->array[cursor->current].value;
+    
+    return SUCCESS;
+}
+
+//
+// It returns in *name and *value the entry rtable_cursor_next returned last. It will return
+// 1 if successful, or 0 if that entry has been removed or the walk is over.
+//
+int rtable_cursor_get (RTABLE_CURSOR* cursor, char** name, void** value)
+{
+    if ((cursor->table == NULL) || (cursor->current == RTABLE_CURSOR_NONE))
+    {
+        return FAILURE;
+    }
+    
+    *name = cursor->table->array[cursor->current].name;
+    *value = cursor->table->array[cursor->current].value;
+    
+    return SUCCESS;
+}
+
+//
+// It removes the entry rtable_cursor_next returned last, like rtable_remove_ith. The next
+// rtable_cursor_next call returns the entry that followed it. It will return 1 if
+// successful, or 0 if there is no such entry or the table is frozen.
+//
+int rtable_cursor_erase (RTABLE_CURSOR* cursor)
+{
+    if ((cursor->table == NULL) || (cursor->current == RTABLE_CURSOR_NONE))
+    {
+        return FAILURE;
+    }
+    
+    return rtable_remove_ith (cursor->table, cursor->current);
+}
+
+//
+// It ends the walk of cursor before it reaches the end of the table. It does nothing if
+// the walk is already over.
+//
+void rtable_cursor_end (RTABLE_CURSOR* cursor)
+{
+    RTABLE_CURSOR** link;
+    
+    if (cursor->table == NULL)
+    {
+        return;
+    }
+    
+    for (link = &(cursor->table->cursors); *link != NULL; link = &((*link)->nextCursor))
+    {
+        if (*link == cursor)
+        {
+            *link = cursor->nextCursor;
+            break;
+        }
+    }
+    
+    cursor->table = NULL;
+    cursor->current = RTABLE_CURSOR_NONE;
+}
+
+//
+// It fills stats with the memory used by the table. It costs O(1): the string bytes and
+// the distribution of the name lengths are counters that every change of the table keeps
+// up to date, so nothing is walked.
+//
+void rtable_stats (RESIZABLE_TABLE* table, RTABLE_STATS* stats)
+{
+    stats->entries = table->currentElements;
+    stats->capacity = table->maxElements;
+    stats->loadFactor = (table->maxElements > 0) ? (double) table->currentElements / table->maxElements : 0;
+    stats->arrayBytes = (table->maxElements) * sizeof (RESIZABLE_TABLE_ENTRY);
+    stats->wastedBytes = (table->maxElements - table->currentElements) * sizeof (RESIZABLE_TABLE_ENTRY);
+    stats->nameBytes = table->nameBytes;
+    stats->valueBytes = table->valueBytes;
+    stats->overheadBytes = table->stringOverhead;
+    stats->indexBytes = 0;
+    
+    if (table->cache != NULL)
+    {
+        stats->indexBytes += sizeof (RTABLE_CACHE) + table->cache->referencedLength;
+    }
+    
+    if (table->ttl != NULL)
+    {
+        stats->indexBytes += sizeof (TIMER_WHEEL) + table->ttl->timers * sizeof (TIMER_WHEEL_TIMER);
+    }
+    
+    if (table->vindex != NULL)
+    {
+        stats->indexBytes += sizeof (VALUE_INDEX) + vindex_count (table->vindex) * sizeof (VALUE_INDEX_NODE);
+    }
+    
+    if (table->phash != NULL)
+    {
+        stats->indexBytes += sizeof (PERFECT_HASH) + ((size_t) table->phash->nBuckets + table->phash->nSlots - table->phash->nKeys) * sizeof (uint32_t);
+    }
+    
+    // The null bytes are not part of the length
+    stats->meanKeyLength = (table->currentElements > 0) ? (double) (table->nameBytes - table->currentElements) / table->currentElements : 0;
+    memcpy (stats->keyLengths, table->keyLengths, sizeof (stats->keyLengths));
+}
+
+//
+// It makes rtable_print_str and rtable_print_int print only the rtable_stats of the
+// table (statsOnly is 1) instead of every entry, or print the entries again (statsOnly is 0).
+//
+void rtable_print_stats_only (RESIZABLE_TABLE* table, int statsOnly)
+{
+    table->statsOnly = statsOnly;
+}
+
+//
+// It frees the table: every name and string value, the timers, the cache, the value index
+// and the perfect hash. Cursors still open on it are ended.
+//
+void rtable_destroy (RESIZABLE_TABLE* table)
+{
+    drop_index (table);
+    clear_entries (table);
+    free_cache (table); // Not through rtable_set_cache, which fails on a frozen table
+    phash_free (table->phash);
+    free (table->ttl);
+    harray_free (table->array, (table->maxElements) * sizeof (RESIZABLE_TABLE_ENTRY));
+    free (table);
+}
+
+/* The rtable_kv_ops functions. The tables they create hold string values. */
+static void* kv_table_create ()
+{
+    return rtable_create ();
+}
+
+static void kv_table_destroy (void* store)
+{
+    rtable_destroy ((RESIZABLE_TABLE*) store);
+}
+
+/* Unlike rtable_add_str, it frees the value it replaces, and returns 1 if successful. */
+static int kv_table_add (void* store, char* name, char* value)
+{
+    RESIZABLE_TABLE* table = store;
+    
+    if (table->frozen) // Frozen tables are read-only
+    {
+        return FAILURE;
+    }
+    
+    long nameIndex = rtable_lookup_index (table, name);
+    
+    if (nameIndex != -1)
+    {
+        return replace_value (table, nameIndex, value);
+    }
+    
+    char* copy = strdup (value);
+    if (copy == NULL)
+    {
+        return FAILURE;
+    }
+    
+    // A cache table goes through rtable_add, which may evict. It returns 0 if successful.
+    if ((table->cache != NULL) ? (rtable_add (table, name, copy) != 0) : (rtable_insert_last (table, name, copy) == FAILURE))
+    {
+        free (copy);
+        return FAILURE;
+    }
+    
+    return SUCCESS;
+}
+
+static char* kv_table_lookup (void* store, char* name)
+{
+    return (char*) rtable_lookup ((RESIZABLE_TABLE*) store, name);
+}
+
+static int kv_table_remove (void* store, char* name)
+{
+    return rtable_remove ((RESIZABLE_TABLE*) store, name);
+}
+
+static size_t kv_table_count (void* store)
+{
+    return rtable_number_elements ((RESIZABLE_TABLE*) store);
+}
+
+static int kv_table_get_ith (void* store, size_t ith, char** name, char** value)
+{
+    return rtable_get_ith ((RESIZABLE_TABLE*) store, ith, name, (void**) value);
+}
+
+static int kv_table_insert_first (void* store, char* name, char* value)
+{
+    char* copy = strdup (value);
+    
+    if ((copy == NULL) || (rtable_insert_first ((RESIZABLE_TABLE*) store, name, copy) == FAILURE))
+    {
+        free (copy);
+        return FAILURE;
+    }
+    
+    return SUCCESS;
+}
+
+static int kv_table_insert_last (void* store, char* name, char* value)
+{
+    char* copy = strdup (value);
+    
+    if ((copy == NULL) || (rtable_insert_last ((RESIZABLE_TABLE*) store, name, copy) == FAILURE))
+    {
+        free (copy);
+        return FAILURE;
+    }
+    
+    return SUCCESS;
+}
+
+static void kv_table_sort (void* store, int ascending)
+{
+    rtable_sort ((RESIZABLE_TABLE*) store, ascending);
+}
+
+static void kv_table_clear (void* store)
+{
+    RESIZABLE_TABLE* table = store;
+    
+    if (!(table->frozen)) // Frozen tables are read-only
+    {
+        clear_entries (table);
+    }
+}
+
+static int kv_table_save (void* store, char* file_name)
+{
+    return rtable_save_str ((RESIZABLE_TABLE*) store, file_name);
+}
+
+static int kv_table_read (void* store, char* file_name)
+{
+    return rtable_read_str ((RESIZABLE_TABLE*) store, file_name);
+}
+
+const KV_STORE_OPS rtable_kv_ops =
+{
+    "rtable", kv_table_create, kv_table_destroy, kv_table_add, kv_table_lookup, kv_table_remove, kv_table_count, kv_table_get_ith,
+    kv_table_insert_first, kv_table_insert_last, kv_table_sort, kv_table_clear, kv_table_save, kv_table_read
+};
@@ -1,19 +1,126 @@
 #if !defined RESIZABLE_ARRAY_H
 #define RESIZABLE_ARRAY_H
 
+#include <stddef.h>
+#include <stdint.h>
+#include "perfect_hash.h"
+#include "timer_wheel.h"
+#include "value_index.h"
+#include "top_k.h"
+#include "aggregate.h"
+#include "../common/kv_store.h"
+
+// For tables with one value type, typed_table.h has RTABLE_INT and RTABLE_STR, which
+// store their values without casts.
+
 #define INITIAL_SIZE_RESIZABLE_TABLE 10
 
+// Flags of rtable_bulk_load
+#define RTABLE_BULK_UNIQUE 1 // The caller vouches that no name repeats: no duplicate checks at all
+#define RTABLE_BULK_SORTED 2 // The entries are sorted by name, so repeated names are adjacent
+#define RTABLE_BULK_INT 4 // The values are longs, not strings
+#define RTABLE_BULK_TAKE 8 // The table takes the names and values instead of copying them
+#define RTABLE_BULK_INDEX 16 // Also build the value index of an int table, see rtable_index_values
+#define RTABLE_BULK_HUGE_PAGES 32 // See rtable_use_huge_pages
+
 typedef struct RESIZABLE_TABLE_ENTRY 
 {
 	char* name;
 	void* value;
+	TIMER_WHEEL_TIMER* timer; // Expiry set by rtable_set_ttl, or NULL
 } RESIZABLE_TABLE_ENTRY;
 
+// Returns the value that a name in both tables keeps after rtable_merge. A string table
+// stores a copy of the string returned, which stays owned by the caller.
+typedef void* (*RTABLE_MERGE_FUNC) (char* name, void* destValue, void* srcValue, void* context);
+
+// Kinds of changes reported by rtable_diff
+#define RTABLE_DIFF_ADDED 1 // Only in the new table. oldValue is NULL.
+#define RTABLE_DIFF_REMOVED 2 // Only in the old table. newValue is NULL.
+#define RTABLE_DIFF_CHANGED 3 // In both, with different values
+
+typedef void (*RTABLE_DIFF_FUNC) (int change, char* name, void* oldValue, void* newValue, void* context);
+
+// Called by rtable_join with every pair of entries that have the same name.
+typedef void (*RTABLE_JOIN_FUNC) (char* name, void* leftValue, void* rightValue, void* context);
+
+// Returns the current time in milliseconds, for the TTLs of a table.
+typedef uint64_t (*RTABLE_CLOCK_FUNC) (void* context);
+
+// Called with the name and value of an entry that a cache table evicts. The table frees
+// the name (and the value, unless it is an int) right after the call.
+typedef void (*RTABLE_EVICT_FUNC) (char* name, void* value, void* context);
+
+typedef struct RTABLE_CACHE_STATS
+{
+	size_t hits; // rtable_lookup calls that found the name
+	size_t misses; // rtable_lookup calls that did not
+	size_t evictions; // Entries evicted to stay within the capacity
+} RTABLE_CACHE_STATS;
+
+// State of a table in cache mode, see rtable_set_cache.
+typedef struct RTABLE_CACHE
+{
+	size_t capacity; // Maximum number of entries
+	unsigned char* referenced; // CLOCK bit of every entry, parallel to the table's array
+	size_t referencedLength; // Bytes allocated for referenced, at least capacity
+	size_t hand; // Next entry the CLOCK hand looks at
+	RTABLE_EVICT_FUNC evict; // Optional eviction callback
+	void* evictContext; // Passed to evict
+	RTABLE_CACHE_STATS stats;
+} RTABLE_CACHE;
+
+#define RTABLE_KEY_LENGTH_BUCKETS 8
+
+// Memory used by a table, see rtable_stats
+typedef struct RTABLE_STATS
+{
+	size_t entries; // currentElements
+	size_t capacity; // maxElements
+	double loadFactor; // entries / capacity
+	size_t arrayBytes; // Entry array
+	size_t wastedBytes; // Part of arrayBytes in the slots past the entries
+	size_t nameBytes; // Name strings, with their null bytes
+	size_t valueBytes; // Value strings, with their null bytes. 0 in an int table.
+	size_t overheadBytes; // Estimated malloc headers and rounding of the strings
+	size_t indexBytes; // Cache bits, TTL timers, value index and perfect hash
+	double meanKeyLength; // Mean length of the names
+	size_t keyLengths[RTABLE_KEY_LENGTH_BUCKETS]; // keyLengths[0] counts the empty names and keyLengths[i] the names
+	// of 2^(i-1) to 2^i - 1 bytes. The last bucket also counts every longer name.
+} RTABLE_STATS;
+
+#define RTABLE_CURSOR_NONE SIZE_MAX // RTABLE_CURSOR.current when there is no current entry
+
+// Walks the entries of a table in order, see rtable_cursor_begin. The table keeps every
+// cursor on its entries while entries are removed or inserted during the walk.
+typedef struct RTABLE_CURSOR
+{
+	struct RESIZABLE_TABLE* table; // NULL once the walk is over
+	size_t next; // Index of the entry the next rtable_cursor_next returns
+	size_t current; // Index of the entry it returned last, or RTABLE_CURSOR_NONE
+	struct RTABLE_CURSOR* nextCursor; // Next cursor of the same table
+} RTABLE_CURSOR;
+
 typedef struct RESIZABLE_TABLE 
 {
-	int maxElements;
-	int currentElements;
-	RESIZABLE_TABLE_ENTRY* array;
+	size_t maxElements;
+	size_t currentElements;
+	RESIZABLE_TABLE_ENTRY* array; // Mapped memory once it is large, see huge_array.h
+	int intValues; // Set by rtable_add_int and rtable_read_int. The values are longs, not owned strings.
+	int hugePages; // Set by rtable_use_huge_pages. Large arrays ask for transparent huge pages.
+	int frozen; // Set by rtable_freeze. A frozen table is read-only.
+	PERFECT_HASH* phash; // Maps every name of a frozen table to its index in array
+	RTABLE_CACHE* cache; // NULL unless the table is a bounded cache
+	TIMER_WHEEL* ttl; // Expiry of the entries with a TTL, in milliseconds. NULL until the first TTL.
+	RTABLE_CLOCK_FUNC clock; // Set by rtable_set_clock. NULL is the monotonic clock.
+	void* clockContext;
+	VALUE_INDEX* vindex; // Set by rtable_index_values. Orders the int values, or NULL.
+	RTABLE_CURSOR* cursors; // Cursors walking the table, or NULL
+	int statsOnly; // Set by rtable_print_stats_only. The print functions show rtable_stats instead of the entries.
+	size_t nameBytes; // Counters behind rtable_stats, kept up to date by every change
+	size_t valueBytes;
+	size_t stringOverhead;
+	size_t keyLengths[RTABLE_KEY_LENGTH_BUCKETS];
 } RESIZABLE_TABLE;
 
 RESIZABLE_TABLE* rtable_create ();
@@ -22,10 +129,10 @@ int rtable_add_str (RESIZABLE_TABLE* table, char* name, char* str_value);
 int rtable_add_int (RESIZABLE_TABLE* table, char* name, long int_value);
 void* rtable_lookup (RESIZABLE_TABLE* table, char* name);
 int rtable_remove (RESIZABLE_TABLE* table, char* name);
-int rtable_get_ith (RESIZABLE_TABLE* table, int ith, char** name, void** value);
-int rtable_remove_ith (RESIZABLE_TABLE* table, int ith);
-int rtable_number_elements (RESIZABLE_TABLE* table);
-int rtable_max_elements (RESIZABLE_TABLE* table);
+int rtable_get_ith (RESIZABLE_TABLE* table, size_t ith, char** name, void** value);
+int rtable_remove_ith (RESIZABLE_TABLE* table, size_t ith);
+size_t rtable_number_elements (RESIZABLE_TABLE* table);
+size_t rtable_max_elements (RESIZABLE_TABLE* table);
 void rtable_sort (RESIZABLE_TABLE* table, int ascending);
 void rtable_sort_by_intval (RESIZABLE_TABLE* table, int ascending);
 int rtable_remove_first (RESIZABLE_TABLE* table );
@@ -38,6 +145,41 @@ int rtable_save_str (RESIZABLE_TABLE* table, char* file_name);
 int rtable_read_str (RESIZABLE_TABLE* table, char* file_name);
 int rtable_save_int (RESIZABLE_TABLE* table, char* file_name);
 int rtable_read_int (RESIZABLE_TABLE* table, char* file_name);
+int rtable_freeze (RESIZABLE_TABLE* table);
+int rtable_is_frozen (RESIZABLE_TABLE* table);
+int rtable_save_frozen_str (RESIZABLE_TABLE* table, char* file_name);
+int rtable_read_frozen_str (RESIZABLE_TABLE* table, char* file_name);
+int rtable_save_frozen_int (RESIZABLE_TABLE* table, char* file_name);
+int rtable_read_frozen_int (RESIZABLE_TABLE* table, char* file_name);
+void rtable_use_huge_pages (RESIZABLE_TABLE* table, int hugePages);
+int rtable_set_cache (RESIZABLE_TABLE* table, size_t capacity, RTABLE_EVICT_FUNC evict, void* context);
+void rtable_cache_stats (RESIZABLE_TABLE* table, RTABLE_CACHE_STATS* stats);
+int rtable_set_ttl (RESIZABLE_TABLE* table, char* name, uint64_t ttl);
+size_t rtable_expire (RESIZABLE_TABLE* table, size_t maxEntries);
+void rtable_set_clock (RESIZABLE_TABLE* table, RTABLE_CLOCK_FUNC clock, void* context);
+int rtable_index_values (RESIZABLE_TABLE* table);
+size_t rtable_topk (RESIZABLE_TABLE* table, size_t k, char** names, long* values);
+size_t rtable_value_range (RESIZABLE_TABLE* table, long low, long high, char** names, long* values, size_t maxResults);
+long rtable_rank (RESIZABLE_TABLE* table, char* name);
+long rtable_stream_topk (RESIZABLE_TABLE* table, size_t k, int mode, TOPK_ITEM* items);
+long rtable_stream_topk_file (char* file_name, size_t k, int mode, TOPK_ITEM* items);
+int rtable_aggregate_int (RESIZABLE_TABLE* table, AGGREGATE* agg);
+int rtable_merge (RESIZABLE_TABLE* dest, RESIZABLE_TABLE* src, RTABLE_MERGE_FUNC resolve, void* context);
+int rtable_diff (RESIZABLE_TABLE* oldTable, RESIZABLE_TABLE* newTable, RTABLE_DIFF_FUNC report, void* context);
+int rtable_join (RESIZABLE_TABLE* left, RESIZABLE_TABLE* right, RTABLE_JOIN_FUNC emit, void* context);
+int rtable_join_parallel (RESIZABLE_TABLE* left, RESIZABLE_TABLE* right, RTABLE_JOIN_FUNC emit, void* context, int nThreads);
+RESIZABLE_TABLE* rtable_bulk_load (RESIZABLE_TABLE_ENTRY* entries, size_t n, int flags);
+void rtable_cursor_begin (RESIZABLE_TABLE* table, RTABLE_CURSOR* cursor);
+int rtable_cursor_next (RTABLE_CURSOR* cursor, char** name, void** value);
+int rtable_cursor_get (RTABLE_CURSOR* cursor, char** name, void** value);
+int rtable_cursor_erase (RTABLE_CURSOR* cursor);
+void rtable_cursor_end (RTABLE_CURSOR* cursor);
+void rtable_stats (RESIZABLE_TABLE* table, RTABLE_STATS* stats);
+void rtable_print_stats_only (RESIZABLE_TABLE* table, int statsOnly);
+void rtable_destroy (RESIZABLE_TABLE* table);
+
+// The table as a KV_STORE backend, called "rtable". Its stores hold string values.
+extern const KV_STORE_OPS rtable_kv_ops;
 
 #endif
 
@@ -0,0 +1,78 @@
+#include <stdlib.h>
+#include <string.h>
+#include "string_arena.h"
+
+//
+// It initialises an empty arena. No memory is allocated until the first string.
+//
+void arena_init (STRING_ARENA* arena)
+{
+    arena->chunks = NULL;
+    arena->liveBytes = 0;
+    arena->deadBytes = 0;
+}
+
+//
+// It copies str into the arena and returns the copy, or NULL if memory runs out.
+// The copy stays valid until arena_free.
+//
+char* arena_strdup (STRING_ARENA* arena, const char* str)
+{
+    size_t len = strlen (str) + 1;
+    STRING_ARENA_CHUNK* chunk = arena->chunks;
+
+    if ((chunk == NULL) || (chunk->size - chunk->used < len)) // Current chunk is full
+    {
+        size_t size = (len > STRING_ARENA_CHUNK_SIZE) ? len : STRING_ARENA_CHUNK_SIZE;
+
+        chunk = malloc (sizeof (STRING_ARENA_CHUNK) + size);
+        if (chunk == NULL)
+        {
+            return NULL;
+        }
+
+        chunk->size = size;
+        chunk->used = 0;
+        chunk->next = arena->chunks;
+        arena->chunks = chunk;
+    }
+
+    char* copy = chunk->data + chunk->used;
+    memcpy (copy, str, len);
+
+    chunk->used += len;
+    arena->liveBytes += len;
+
+    return copy;
+}
+
+//
+// It records that str, which was returned by arena_strdup, is no longer used.
+// The memory itself is only given back by arena_free.
+//
+void arena_release (STRING_ARENA* arena, const char* str)
+{
+    size_t len = strlen (str) + 1;
+
+    arena->liveBytes -= len;
+    arena->deadBytes += len;
+}
+
+//
+// It frees every chunk of the arena and leaves it empty.
+//
+void arena_free (STRING_ARENA* arena)
+{
+    STRING_ARENA_CHUNK* chunk = arena->chunks;
+
+    while (chunk != NULL)
+    {
+        STRING_ARENA_CHUNK* next = chunk->next;
+
+        free (chunk);
+
+        chunk = next;
+    }
+
+    arena_init (arena);
+}
@@ -0,0 +1,34 @@
+#if !defined STRING_ARENA_H
+#define STRING_ARENA_H
+
+#include <stddef.h>
+
+#define STRING_ARENA_CHUNK_SIZE 65536
+
+typedef struct STRING_ARENA_CHUNK
+{
+	struct STRING_ARENA_CHUNK* next; // Previously filled chunk
+	size_t size; // Bytes available in data
+	size_t used; // Bytes handed out from data
+	char data[]; // The strings themselves
+} STRING_ARENA_CHUNK;
+
+//
+// Strings are copied one after the other into large chunks, so a table of short strings
+// does not pay one malloc (and its header) per string, and nearby strings share cache lines.
+// Single strings are never freed; arena_release only counts the bytes as dead so the owner
+// can decide when to copy the live strings into a fresh arena.
+//
+typedef struct STRING_ARENA
+{
+	STRING_ARENA_CHUNK* chunks; // Chunk currently being filled, followed by older chunks
+	size_t liveBytes; // Bytes of strings still in use
+	size_t deadBytes; // Bytes of strings given back with arena_release
+} STRING_ARENA;
+
+void arena_init (STRING_ARENA* arena);
+char* arena_strdup (STRING_ARENA* arena, const char* str);
+void arena_release (STRING_ARENA* arena, const char* str);
+void arena_free (STRING_ARENA* arena);
+
+#endif
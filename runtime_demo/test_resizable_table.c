@@ -2,7 +2,10 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <inttypes.h>
 #include "resizable_table.h"
+#include "typed_table.h"
+#include "../common/instrument.h"
 
 void test1() {
 	RESIZABLE_TABLE *rt;
@@ -213,7 +216,7 @@ void test7() {
 	}
 	rtable_print_str(rt);
 
-	printf("number in table: %d, max: %d\n",
+	printf("number in table: %zu, max: %zu\n",
 	       rtable_number_elements(rt), rtable_max_elements(rt));
 }
 
@@ -529,15 +532,644 @@ void test16() {
 	rtable_print_int(rt);
 }
 
+void test17() {
+	char name[20];
+	char address[20];
+	int i = 0;
+	int result;
+	RESIZABLE_TABLE *rt;
+	RESIZABLE_TABLE *rt2;
+
+	rt = rtable_create();
+
+	for (i=0; i < 100; i++) {
+		sprintf(name,"name%d", i);
+		sprintf(address, "address%d", i);
+		rtable_add_str(rt, name, address);
+	}
+
+	printf("Freeze table\n");
+	result = rtable_freeze(rt);
+	printf("result1=%d frozen=%d\n", result, rtable_is_frozen(rt));
+
+	for (i=0; i < 100; i++) {
+		sprintf(name,"name%d", i);
+		sprintf(address, "address%d", i);
+		assert(strcmp(rtable_lookup(rt, name), address)==0);
+	}
+	assert(rtable_lookup(rt, "name100")==NULL);
+
+	printf("Add to frozen table\n");
+	result = rtable_add_str(rt, "name100", "address100");
+	printf("result2=%d elements=%zu\n", result, rtable_number_elements(rt));
+
+	printf("Saving frozen table frozen.rtf\n");
+	result = rtable_save_frozen_str(rt, "frozen.rtf");
+	printf("result3=%d\n", result);
+
+	rt2 = rtable_create();
+	result = rtable_read_frozen_str(rt2, "frozen.rtf");
+	printf("result4=%d frozen=%d elements=%zu\n", result, rtable_is_frozen(rt2), rtable_number_elements(rt2));
+
+	printf("name42's address is: %s\n", (char *) rtable_lookup(rt2, "name42"));
+	remove("frozen.rtf");
+}
+
+void test18() {
+	char name[20];
+	char address[20];
+	int i = 0;
+	int result;
+	int64_t grade;
+	char * value;
+	RTABLE_INT *grades;
+	RTABLE_STR *addresses;
+
+	grades = rtable_int_create();
+	addresses = rtable_str_create();
+
+	for (i=0; i < 30; i++) {
+		sprintf(name,"name%d", i);
+		sprintf(address, "address%d", i);
+		rtable_int_add(grades, name, 100 - i);
+		rtable_str_add(addresses, name, address);
+	}
+
+	printf("Add name5 again\n");
+	result = rtable_int_add(grades, "name5", 7);
+	printf("result1=%d\n", result);
+	rtable_int_lookup(grades, "name5", &grade);
+	assert(grade == 7);
+
+	result = rtable_str_lookup(addresses, "name17", &value);
+	printf("result2=%d name17's address is: %s\n", result, value);
+
+	printf("remove name3\n");
+	result = rtable_int_remove(grades, "name3");
+	printf("result3=%d\n", result);
+
+	printf("\nSort int table by value ascending\n");
+	rtable_int_sort_by_value(grades, 1);
+	rtable_int_print(grades);
+
+	printf("\nSort str table descending\n");
+	rtable_str_sort(addresses, 0);
+	rtable_str_print(addresses);
+
+	printf("Saving table typed_grades.rt\n");
+	result = rtable_int_save(grades, "typed_grades.rt");
+	printf("result4=%d\n", result);
+
+	rtable_int_destroy(grades);
+	grades = rtable_int_create();
+	result = rtable_int_read(grades, "typed_grades.rt");
+	printf("result5=%d elements=%zu\n", result, rtable_int_number_elements(grades));
+	remove("typed_grades.rt");
+
+	rtable_int_destroy(grades);
+	rtable_str_destroy(addresses);
+
+	printf("Save and read back a str table\n");
+	addresses = rtable_str_create();
+	rtable_str_add(addresses, "George", "23 Oak St");
+	rtable_str_add(addresses, "Peter", "27 Oak St");
+	result = rtable_str_save(addresses, "typed_addresses.rt");
+	rtable_str_destroy(addresses);
+	addresses = rtable_str_create();
+	result = result && rtable_str_read(addresses, "typed_addresses.rt");
+	printf("result6=%d elements=%zu\n", result, rtable_str_number_elements(addresses));
+	assert(rtable_str_lookup(addresses, "George", &value) && strcmp(value, "23 Oak St") == 0);
+	assert(rtable_str_lookup(addresses, "Peter", &value) && strcmp(value, "27 Oak St") == 0);
+	rtable_str_print(addresses);
+	rtable_str_destroy(addresses);
+	remove("typed_addresses.rt");
+}
+
+void count_eviction(char * name, void * value, void * context) {
+	(void) value;
+	printf("evicted %s\n", name);
+	(*(int *) context) ++;
+}
+
+void test19() {
+	char name[20];
+	char address[20];
+	int i = 0;
+	int result;
+	int evicted = 0;
+	RTABLE_CACHE_STATS stats;
+	RESIZABLE_TABLE *rt;
+
+	rt = rtable_create();
+	result = rtable_set_cache(rt, 4, count_eviction, &evicted);
+	printf("result1=%d\n", result);
+
+	for (i=0; i < 4; i++) {
+		sprintf(name,"name%d", i);
+		sprintf(address, "address%d", i);
+		rtable_add_str(rt, name, address);
+	}
+
+	printf("Use name0 and name2, then add name4 and name5\n");
+	rtable_lookup(rt, "name0");
+	rtable_lookup(rt, "name2");
+	rtable_add_str(rt, "name4", "address4");
+	rtable_add_str(rt, "name5", "address5");
+	rtable_print_str(rt);
+
+	assert(rtable_number_elements(rt) == 4);
+	assert(rtable_lookup(rt, "name0") != NULL);
+	assert(rtable_lookup(rt, "name9") == NULL);
+
+	printf("Shrink cache to 2\n");
+	result = rtable_set_cache(rt, 2, count_eviction, &evicted);
+	printf("result2=%d elements=%zu evicted=%d\n", result, rtable_number_elements(rt), evicted);
+
+	rtable_cache_stats(rt, &stats);
+	printf("hits=%zu misses=%zu evictions=%zu\n", stats.hits, stats.misses, stats.evictions);
+	assert(stats.evictions == (size_t) evicted);
+
+	// A frozen cache table cannot change its cache, but still frees it
+	assert(rtable_freeze(rt));
+	assert(!rtable_set_cache(rt, 0, NULL, NULL));
+	rtable_destroy(rt);
+}
+
+uint64_t test_clock(void * context) {
+	return *(uint64_t *) context;
+}
+
+void test20() {
+	char name[20];
+	char address[20];
+	int i = 0;
+	int result;
+	size_t removed;
+	uint64_t now = 1000;
+	RESIZABLE_TABLE *rt;
+
+	rt = rtable_create();
+	rtable_set_clock(rt, test_clock, &now);
+
+	for (i=0; i < 20; i++) {
+		sprintf(name,"name%d", i);
+		sprintf(address, "address%d", i);
+		rtable_add_str(rt, name, address);
+		rtable_set_ttl(rt, name, (i % 2 == 0) ? 100 : 100000);
+	}
+
+	result = rtable_set_ttl(rt, "name99", 10);
+	printf("result1=%d\n", result);
+
+	printf("Make name4 permanent, then 150ms pass\n");
+	rtable_set_ttl(rt, "name4", 0);
+	now += 150;
+
+	printf("name2 after expiry: %s\n", (char *) rtable_lookup(rt, "name2"));
+	printf("name3 before expiry: %s\n", (char *) rtable_lookup(rt, "name3"));
+	printf("name4 made permanent: %s\n", (char *) rtable_lookup(rt, "name4"));
+
+	removed = rtable_expire(rt, 3);
+	printf("removed=%zu elements=%zu\n", removed, rtable_number_elements(rt));
+	removed = rtable_expire(rt, 100);
+	printf("removed=%zu elements=%zu\n", removed, rtable_number_elements(rt));
+
+	rtable_sort(rt, 1);
+	printf("Two hours pass\n");
+	now += 2 * 60 * 60 * 1000;
+	removed = rtable_expire(rt, 100);
+	printf("removed=%zu elements=%zu\n", removed, rtable_number_elements(rt));
+	rtable_print_str(rt);
+}
+
+void test21() {
+	char name[20];
+	char * names[5];
+	long values[5];
+	int i = 0;
+	int result;
+	size_t n;
+	RESIZABLE_TABLE *rt;
+
+	rt = rtable_create();
+	for (i=0; i < 30; i++) {
+		sprintf(name,"name%d", i);
+		rtable_add_int(rt, name, (i * 7) % 30);
+	}
+
+	result = rtable_index_values(rt);
+	printf("result1=%d\n", result);
+
+	printf("Change name3 to 100, remove name0, add name30\n");
+	rtable_add_int(rt, "name3", 100);
+	rtable_remove(rt, "name0");
+	rtable_add_int(rt, "name30", 50);
+
+	n = rtable_topk(rt, 3, names, values);
+	printf("top %zu:", n);
+	for (i=0; i < (int) n; i++) {
+		printf(" %s=%ld", names[i], values[i]);
+	}
+	printf("\n");
+
+	n = rtable_value_range(rt, 10, 14, names, values, 5);
+	printf("range [10, 14] %zu:", n);
+	for (i=0; i < (int) n; i++) {
+		printf(" %s=%ld", names[i], values[i]);
+	}
+	printf("\n");
+
+	printf("rank of name30=%ld rank of name99=%ld\n", rtable_rank(rt, "name30"), rtable_rank(rt, "name99"));
+
+	// The primary array keeps its order
+	rtable_get_ith(rt, 0, names, (void **) values);
+	assert(strcmp(names[0], "name1") == 0);
+	assert(rtable_rank(rt, "name3") == (long) rtable_number_elements(rt) - 1);
+
+	// An empty table indexed first takes ints only
+	rt = rtable_create();
+	assert(rtable_index_values(rt));
+	assert(rtable_add_str(rt, "name0", "not a number") != 0);
+	assert(rtable_number_elements(rt) == 0 && rtable_topk(rt, 3, names, values) == 0);
+}
+
+void test22() {
+	char name[20];
+	TOPK_ITEM items[10];
+	int i = 0;
+	long n;
+	RESIZABLE_TABLE *rt;
+	FILE * fout;
+
+	rt = rtable_create();
+	for (i=0; i < 100; i++) {
+		sprintf(name,"name%d", i);
+		rtable_add_int(rt, name, (i * 37) % 100);
+	}
+
+	n = rtable_stream_topk(rt, 3, TOPK_EXACT, items);
+	printf("table top %ld:", n);
+	for (i=0; i < n; i++) {
+		printf(" %s=%ld", items[i].name, items[i].value);
+		free(items[i].name);
+	}
+	printf("\n");
+
+	printf("Saving stream.rt with repeated names\n");
+	fout = fopen("stream.rt", "w");
+	for (i=0; i < 1000; i++) {
+		fprintf(fout, "name%d\n%d\n\n", (i % 2 == 0) ? i % 3 : 10 + i % 97, 1);
+	}
+	fclose(fout);
+
+	n = rtable_stream_topk_file("stream.rt", 10, TOPK_SPACE_SAVING, items);
+	printf("space saving %ld:", n);
+	for (i=0; i < 3; i++) {
+		printf(" %s=%ld(+-%ld)", items[i].name, items[i].value, items[i].error);
+		assert(items[i].value - items[i].error <= 167);
+	}
+	printf("\n");
+	for (i=0; i < n; i++) {
+		free(items[i].name);
+	}
+
+	n = rtable_stream_topk_file("stream.rt", 3, TOPK_COUNT_MIN, items);
+	printf("count-min %ld:", n);
+	for (i=0; i < n; i++) {
+		printf(" %s=%ld", items[i].name, items[i].value);
+		assert(items[i].value >= 166);
+		free(items[i].name);
+	}
+	printf("\n");
+	remove("stream.rt");
+
+	// String values cannot be ranked
+	rt = rtable_create();
+	rtable_add_str(rt, "George", "23 Oak St");
+	rtable_add_str(rt, "Peter", "27 Oak St");
+	assert(rtable_stream_topk(rt, 3, TOPK_EXACT, items) == -1);
+	rtable_destroy(rt);
+}
+
+void test23() {
+	char name[20];
+	size_t histogram[4];
+	size_t scalarHistogram[4];
+	int i = 0;
+	int result;
+	AGGREGATE agg;
+	AGGREGATE scalar;
+	RESIZABLE_TABLE *rt;
+	RTABLE_INT *grades;
+
+	rt = rtable_create();
+	grades = rtable_int_create();
+	for (i=0; i < 1000; i++) {
+		sprintf(name,"name%d", i);
+		rtable_add_int(rt, name, (i * 7919) % 1000 - 200);
+		rtable_int_add(grades, name, (i * 7919) % 1000 - 200);
+	}
+
+	aggregate_init(&agg);
+	agg.rangeLow = 0;
+	agg.rangeHigh = 99;
+	agg.histLow = -200;
+	agg.histWidth = 250;
+	agg.nBuckets = 4;
+	agg.histogram = histogram;
+	scalar = agg;
+	scalar.scalarOnly = 1;
+	scalar.histogram = scalarHistogram;
+
+	result = rtable_aggregate_int(rt, &agg);
+	printf("result1=%d count=%zu sum=%" PRId64 " min=%" PRId64 " max=%" PRId64 " inRange=%zu overflow=%d\n", result,
+		agg.count, agg.sum, agg.min, agg.max, agg.countInRange, agg.overflow);
+	printf("histogram: %zu %zu %zu %zu\n", histogram[0], histogram[1], histogram[2], histogram[3]);
+
+	rtable_int_aggregate(grades, &scalar);
+	assert(scalar.sum == agg.sum && scalar.min == agg.min && scalar.max == agg.max);
+	assert(scalar.countInRange == agg.countInRange && memcmp(histogram, scalarHistogram, sizeof(histogram)) == 0);
+
+	printf("Add two values near INT64_MAX\n");
+	rtable_add_int(rt, "big1", INT64_MAX - 1);
+	rtable_add_int(rt, "big2", INT64_MAX - 1);
+	rtable_aggregate_int(rt, &agg);
+	printf("sum=%" PRId64 " overflow=%d\n", agg.sum, agg.overflow);
+	rtable_add_int(rt, "small", INT64_MIN);
+	rtable_aggregate_int(rt, &agg);
+	printf("sum=%" PRId64 " overflow=%d\n", agg.sum, agg.overflow);
+
+	rtable_int_destroy(grades);
+}
+
+void count_change(int change, char * name, void * oldValue, void * newValue, void * context) {
+	((int *) context)[change] ++;
+	if (change == RTABLE_DIFF_CHANGED) {
+		printf("changed %s: %ld -> %ld\n", name, (long) oldValue, (long) newValue);
+	}
+}
+
+void count_pair(char * name, void * leftValue, void * rightValue, void * context) {
+	(void) name;
+	__atomic_add_fetch((long *) context, (long) leftValue + (long) rightValue, __ATOMIC_RELAXED);
+}
+
+void * add_values(char * name, void * destValue, void * srcValue, void * context) {
+	(void) name;
+	(void) context;
+	return (void *) ((long) destValue + (long) srcValue);
+}
+
+void test24() {
+	char name[20];
+	int i = 0;
+	int result;
+	long sum = 0;
+	long parallelSum = 0;
+	int changes[4] = {0, 0, 0, 0};
+	RESIZABLE_TABLE *rt1;
+	RESIZABLE_TABLE *rt2;
+
+	rt1 = rtable_create();
+	rt2 = rtable_create();
+	for (i=0; i < 1000; i++) {
+		sprintf(name,"name%d", i);
+		rtable_add_int(rt1, name, i);
+		sprintf(name,"name%d", i + 995);
+		rtable_add_int(rt2, name, (i == 2) ? 7 : i + 995);
+	}
+
+	printf("Diff\n");
+	result = rtable_diff(rt1, rt2, count_change, changes);
+	printf("result1=%d added=%d removed=%d changed=%d\n", result, changes[RTABLE_DIFF_ADDED], changes[RTABLE_DIFF_REMOVED], changes[RTABLE_DIFF_CHANGED]);
+
+	result = rtable_join(rt1, rt2, count_pair, &sum);
+	rtable_join_parallel(rt1, rt2, count_pair, &parallelSum, 4);
+	printf("result2=%d join sum=%ld\n", result, sum);
+	assert(sum == parallelSum);
+
+	printf("Merge adding values\n");
+	result = rtable_merge(rt1, rt2, add_values, NULL);
+	printf("result3=%d elements=%zu name996=%ld name1994=%ld\n", result, rtable_number_elements(rt1),
+		(long) rtable_lookup(rt1, "name996"), (long) rtable_lookup(rt1, "name1994"));
+}
+
+void test25() {
+	char name[20];
+	int i = 0;
+	char * names[3];
+	long values[3];
+	RESIZABLE_TABLE_ENTRY entries[100];
+	RESIZABLE_TABLE *rt;
+
+	for (i=0; i < 100; i++) {
+		sprintf(name,"name%d", i % 40);
+		entries[i].name = strdup(name);
+		entries[i].value = (void *) (long) i;
+		entries[i].timer = NULL;
+	}
+
+	printf("Bulk load 100 entries with 40 names\n");
+	rt = rtable_bulk_load(entries, 100, RTABLE_BULK_INT | RTABLE_BULK_INDEX);
+	printf("elements=%zu max=%zu name5=%ld\n", rtable_number_elements(rt), rtable_max_elements(rt), (long) rtable_lookup(rt, "name5"));
+	rtable_topk(rt, 3, names, values);
+	printf("top 3: %s=%ld %s=%ld %s=%ld\n", names[0], values[0], names[1], values[1], names[2], values[2]);
+	assert(rtable_rank(rt, "name20") == 0 && rtable_rank(rt, "name0") == 20);
+
+	printf("Bulk load taking the first 40 entries, which are unique\n");
+	rt = rtable_bulk_load(entries, 40, RTABLE_BULK_INT | RTABLE_BULK_UNIQUE | RTABLE_BULK_TAKE);
+	rtable_get_ith(rt, 39, names, (void **) values);
+	printf("elements=%zu last=%s\n", rtable_number_elements(rt), names[0]);
+	assert(names[0] == entries[39].name);
+}
+
+void test26() {
+	char name[20];
+	int i = 0;
+	int visited = 0;
+	long sum = 0;
+	char * entryName;
+	void * value;
+	RTABLE_CURSOR cursor;
+	RTABLE_CURSOR other;
+	RESIZABLE_TABLE *rt;
+
+	rt = rtable_create();
+	for (i=0; i < 10; i++) {
+		sprintf(name,"name%d", i);
+		rtable_add_int(rt, name, i);
+	}
+
+	printf("Walk erasing the odd values, and removing name8 when name4 is reached\n");
+	rtable_cursor_begin(rt, &cursor);
+	rtable_cursor_begin(rt, &other);
+	rtable_cursor_next(&other, &entryName, &value);
+	while (rtable_cursor_next(&cursor, &entryName, &value)) {
+		visited++;
+		if ((long) value % 2 == 1) {
+			rtable_cursor_erase(&cursor);
+			assert(rtable_cursor_get(&cursor, &entryName, &value) == 0);
+		}
+		else if ((long) value == 4) {
+			rtable_remove(rt, "name8");
+			rtable_insert_first(rt, "name10", (void *) 10L);
+			rtable_insert_last(rt, "name11", (void *) 11L);
+		}
+	}
+	printf("visited=%d elements=%zu\n", visited, rtable_number_elements(rt));
+	rtable_print_int(rt);
+
+	// The other cursor is still on name0, which moved to index 1
+	assert(rtable_cursor_get(&other, &entryName, &value) == 1 && strcmp(entryName, "name0") == 0);
+	rtable_cursor_next(&other, &entryName, &value);
+	printf("other cursor continues at %s\n", entryName);
+	rtable_cursor_end(&other);
+	assert(rt->cursors == NULL);
+
+	rtable_cursor_begin(rt, &cursor);
+	while (rtable_cursor_next(&cursor, &entryName, &value)) {
+		sum += (long) value;
+	}
+	printf("sum=%ld\n", sum);
+	assert(rtable_get_ith(rt, rtable_number_elements(rt), &entryName, &value) == 0);
+}
+
+void test27() {
+	char name[40];
+	int i = 0;
+	RTABLE_STATS stats;
+	RESIZABLE_TABLE *rt;
+
+	rt = rtable_create();
+	for (i=0; i < 12; i++) {
+		sprintf(name,"name%d", i);
+		rtable_add_str(rt, name, "value");
+	}
+	rtable_add_str(rt, "a much longer name for the stats", "value");
+	rtable_remove(rt, "name3");
+	rtable_add_str(rt, "name4", "longer value");
+
+	rtable_stats(rt, &stats);
+	printf("entries=%zu capacity=%zu load=%.2f wasted=%zu\n", stats.entries, stats.capacity, stats.loadFactor, stats.wastedBytes);
+	printf("names=%zu values=%zu overhead=%zu\n", stats.nameBytes, stats.valueBytes, stats.overheadBytes);
+	assert(stats.nameBytes == 9 * 6 + 2 * 7 + 33);
+	assert(stats.keyLengths[3] == 11 && stats.keyLengths[6] == 1);
+
+	printf("Print the stats only\n");
+	rtable_print_stats_only(rt, 1);
+	rtable_print_str(rt);
+
+	while (rtable_number_elements(rt) > 0) {
+		rtable_remove_first(rt);
+	}
+	rtable_stats(rt, &stats);
+	assert(stats.nameBytes == 0 && stats.valueBytes == 0 && stats.overheadBytes == 0);
+
+	// Shrinking into a cache keeps a CLOCK bit for every entry the table had
+	for (i=0; i < 12; i++) {
+		sprintf(name,"name%d", i);
+		rtable_add_str(rt, name, "value");
+	}
+	assert(rtable_set_cache(rt, 4, NULL, NULL));
+	rtable_stats(rt, &stats);
+	assert(stats.entries == 4 && stats.indexBytes == sizeof(RTABLE_CACHE) + 12);
+}
+
+void test28() {
+#if defined INSTRUMENT
+	char name[20];
+	int i = 0;
+	INSTR_OP_STATS totals[INSTR_OPERATIONS];
+	RESIZABLE_TABLE *rt;
+
+	instr_reset();
+	rt = rtable_create();
+	for (i=0; i < 100; i++) {
+		sprintf(name,"name%d", i);
+		rtable_add_int(rt, name, i);
+	}
+	for (i=0; i < 100; i++) {
+		sprintf(name,"name%d", i);
+		rtable_lookup(rt, name);
+	}
+	rtable_lookup(rt, "missing");
+	rtable_remove_ith(rt, 0);
+
+	instr_snapshot(totals);
+	printf("lookups=%llu compares=%llu\n", (unsigned long long) totals[INSTR_RTABLE_LOOKUP].calls,
+		(unsigned long long) totals[INSTR_RTABLE_LOOKUP].compares);
+	assert(totals[INSTR_RTABLE_LOOKUP].compares == 100 * 101 / 2 + 100);
+	assert(totals[INSTR_RTABLE_ADD].compares == 100 * 99 / 2);
+	assert(totals[INSTR_RTABLE_REMOVE_ITH].shifts == 99);
+	assert(totals[INSTR_RTABLE_REALLOCATE].calls == 4);
+	instr_dump_text(stdout);
+	instr_dump_json(stdout);
+#else
+	printf("Instrumentation is compiled out, build with -DINSTRUMENT\n");
+#endif
+}
+
+void test29() {
+	const KV_STORE_OPS *backends[] = { &rtable_kv_ops, &kv_hash_ops, &kv_sorted_ops, NULL };
+	char name[40];
+	char *n, *v;
+	size_t i = 0;
+	int b = 0;
+	KV_STORE *kv;
+
+	assert(kv_find_backend(backends, "hash") == &kv_hash_ops);
+	assert(kv_find_backend(backends, "btree") == NULL);
+	for (b=0; backends[b] != NULL; b++) {
+		kv = kv_create(backends[b]);
+		for (i=0; i < 6; i++) {
+			sprintf(name,"name%zu", (i * 7) % 6);
+			kv_add(kv, name, "value");
+		}
+		kv_add(kv, "name2", "new value");
+		kv_remove(kv, "name3");
+		assert(kv_remove(kv, "name3") == 0);
+		assert(kv_count(kv) == 5);
+		assert(strcmp(kv_lookup(kv, "name2"), "new value") == 0);
+		assert(kv_lookup(kv, "name3") == NULL);
+		kv_sort(kv, 0);
+		printf("%s:", backends[b]->name);
+		for (i=0; kv_get_ith(kv, i, &n, &v); i++) {
+			printf(" %s=%s", n, v);
+		}
+		printf("\n");
+		assert(kv_save(kv, "kv.rt"));
+		kv_clear(kv);
+		assert(kv_count(kv) == 0);
+		assert(kv_read(kv, "kv.rt"));
+		assert(kv_count(kv) == 5 && strcmp(kv_lookup(kv, "name4"), "value") == 0);
+		printf("insert_first %s\n", kv_insert_first(kv, "first", "1") ? "supported" : "not supported");
+		kv_destroy(kv);
+	}
+	remove("kv.rt");
+}
+
 int main(int argc, char ** argv) {
 
     test11();
     test12();
+    test17();
+    test18();
+    test19();
+    test20();
+    test21();
+    test22();
+    test23();
+    test24();
+    test25();
+    test26();
+    test27();
+    test28();
+    test29();
 
 /* 	char * test;
 	
 	if (argc <2) {
-		printf("Usage: test_resizable_table test1|test2|...test16\n");
+		printf("Usage: test_resizable_table test1|test2|...test29\n");
 		exit(1);
 	}
 
@@ -597,6 +1229,45 @@ int main(int argc, char ** argv) {
 	else if (strcmp(test, "test16")==0) {
 		test16();
 	}
+	else if (strcmp(test, "test17")==0) {
+		test17();
+	}
+	else if (strcmp(test, "test18")==0) {
+		test18();
+	}
+	else if (strcmp(test, "test19")==0) {
+		test19();
+	}
+	else if (strcmp(test, "test20")==0) {
+		test20();
+	}
+	else if (strcmp(test, "test21")==0) {
+		test21();
+	}
+	else if (strcmp(test, "test22")==0) {
+		test22();
+	}
+	else if (strcmp(test, "test23")==0) {
+		test23();
+	}
+	else if (strcmp(test, "test24")==0) {
+		test24();
+	}
+	else if (strcmp(test, "test25")==0) {
+		test25();
+	}
+	else if (strcmp(test, "test26")==0) {
+		test26();
+	}
+	else if (strcmp(test, "test27")==0) {
+		test27();
+	}
+	else if (strcmp(test, "test28")==0) {
+		test28();
+	}
+	else if (strcmp(test, "test29")==0) {
+		test29();
+	}
 	else {
 		printf("Test not found!!n");
 		exit(1);
@@ -0,0 +1,210 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "timer_wheel.h"
+
+/* Ticks covered by one slot of a level. */
+#define SLOT_TICKS(level) (1ULL << (TWHEEL_BITS * (level)))
+
+/* Returns the list a timer is on. */
+static TIMER_WHEEL_TIMER** list_of (TIMER_WHEEL* wheel, TIMER_WHEEL_TIMER* timer)
+{
+    if (timer->level == TWHEEL_EXPIRED)
+    {
+        return &(wheel->expired);
+    }
+
+    return &(wheel->slots[timer->level][timer->slot]);
+}
+
+static void push (TIMER_WHEEL_TIMER** list, TIMER_WHEEL_TIMER* timer)
+{
+    timer->prev = NULL;
+    timer->next = *list;
+
+    if (*list != NULL)
+    {
+        (*list)->prev = timer;
+    }
+
+    *list = timer;
+}
+
+/* Files a timer in the slot for how far ahead of the wheel it is due, or on the expired list. */
+static void place (TIMER_WHEEL* wheel, TIMER_WHEEL_TIMER* timer)
+{
+    uint64_t expires = timer->expires;
+    int level = 0;
+
+    if (expires <= wheel->now) // Already due
+    {
+        timer->level = TWHEEL_EXPIRED;
+        push (&(wheel->expired), timer);
+        return;
+    }
+
+    if (expires - wheel->now >= SLOT_TICKS (TWHEEL_LEVELS))
+    {
+        // Beyond the top level: park it in the last slot it reaches, it is filed again when that slot cascades
+        expires = wheel->now + SLOT_TICKS (TWHEEL_LEVELS) - 1;
+    }
+
+    while ((level < TWHEEL_LEVELS - 1) && (expires - wheel->now >= SLOT_TICKS (level + 1)))
+    {
+        level ++;
+    }
+
+    timer->level = level;
+    timer->slot = (int) ((expires >> (TWHEEL_BITS * level)) & (TWHEEL_SLOTS - 1));
+    push (&(wheel->slots[level][timer->slot]), timer);
+    wheel->occupied[level] |= 1ULL << timer->slot;
+}
+
+/* Returns the tick at which the next non-empty slot comes up, or UINT64_MAX if every slot is empty.
+A slot after the current position of its level comes up in this rotation of the level, any other in the next one. */
+static uint64_t next_event (TIMER_WHEEL* wheel)
+{
+    uint64_t next = UINT64_MAX;
+    int level;
+
+    for (level = 0; level < TWHEEL_LEVELS; level ++)
+    {
+        uint64_t occupied = wheel->occupied[level];
+        int shift = TWHEEL_BITS * level;
+
+        if (occupied == 0)
+        {
+            continue;
+        }
+
+        int position = (int) ((wheel->now >> shift) & (TWHEEL_SLOTS - 1));
+        uint64_t rotation = (wheel->now >> (shift + TWHEEL_BITS)) << (shift + TWHEEL_BITS);
+        uint64_t later = (position == TWHEEL_SLOTS - 1) ? 0 : occupied & (~0ULL << (position + 1));
+        uint64_t tick;
+
+        if (later != 0)
+        {
+            tick = rotation + ((uint64_t) __builtin_ctzll (later) << shift);
+        }
+
+        else
+        {
+            tick = rotation + SLOT_TICKS (level + 1) + ((uint64_t) __builtin_ctzll (occupied) << shift);
+        }
+
+        if (tick < next)
+        {
+            next = tick;
+        }
+    }
+
+    return next;
+}
+
+/* Files again every timer of a slot that has come up. They all go to lower levels or expire. */
+static void cascade (TIMER_WHEEL* wheel, int level, int slot)
+{
+    TIMER_WHEEL_TIMER* timer = wheel->slots[level][slot];
+
+    wheel->slots[level][slot] = NULL;
+    wheel->occupied[level] &= ~(1ULL << slot);
+
+    while (timer != NULL)
+    {
+        TIMER_WHEEL_TIMER* next = timer->next;
+
+        place (wheel, timer);
+        timer = next;
+    }
+}
+
+//
+// It initialises an empty wheel at tick now.
+//
+void twheel_init (TIMER_WHEEL* wheel, uint64_t now)
+{
+    memset (wheel, 0, sizeof (TIMER_WHEEL));
+    wheel->now = now;
+}
+
+//
+// It adds a timer, which is due at timer->expires. A timer that is already due goes
+// straight to the expired list. O(1).
+//
+void twheel_add (TIMER_WHEEL* wheel, TIMER_WHEEL_TIMER* timer)
+{
+    place (wheel, timer);
+    (wheel->timers) ++;
+}
+
+//
+// It removes a timer from the wheel or from the expired list. O(1).
+//
+void twheel_cancel (TIMER_WHEEL* wheel, TIMER_WHEEL_TIMER* timer)
+{
+    TIMER_WHEEL_TIMER** list = list_of (wheel, timer);
+
+    if (timer->prev != NULL)
+    {
+        timer->prev->next = timer->next;
+    }
+
+    else
+    {
+        *list = timer->next;
+    }
+
+    if (timer->next != NULL)
+    {
+        timer->next->prev = timer->prev;
+    }
+
+    if ((*list == NULL) && (timer->level != TWHEEL_EXPIRED))
+    {
+        wheel->occupied[timer->level] &= ~(1ULL << timer->slot);
+    }
+
+    (wheel->timers) --;
+}
+
+//
+// It advances the wheel to tick now and moves every timer due by then to the expired
+// list. Only the slots that hold timers are visited.
+//
+void twheel_advance (TIMER_WHEEL* wheel, uint64_t now)
+{
+    while (wheel->now < now)
+    {
+        uint64_t tick = next_event (wheel);
+        int level;
+
+        if (tick > now) // Nothing comes up before now
+        {
+            wheel->now = now;
+            break;
+        }
+
+        wheel->now = tick;
+
+        // Higher levels first, their timers may land in the lower slots that come up now
+        for (level = TWHEEL_LEVELS - 1; level > 0; level --)
+        {
+            if ((tick & (SLOT_TICKS (level) - 1)) == 0)
+            {
+                cascade (wheel, level, (int) ((tick >> (TWHEEL_BITS * level)) & (TWHEEL_SLOTS - 1)));
+            }
+        }
+
+        // Every timer in the level 0 slot is due exactly now
+        cascade (wheel, 0, (int) (tick & (TWHEEL_SLOTS - 1)));
+    }
+}
+
+//
+// It returns a timer on the expired list, or NULL if no timer is due. The timer stays
+// on the list until it is cancelled.
+//
+TIMER_WHEEL_TIMER* twheel_first_expired (TIMER_WHEEL* wheel)
+{
+    return wheel->expired;
+}
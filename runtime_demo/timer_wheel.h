@@ -0,0 +1,44 @@
+#if !defined TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define TWHEEL_BITS 6
+#define TWHEEL_SLOTS (1 << TWHEEL_BITS) // One 64 bit occupancy word per level
+#define TWHEEL_LEVELS 4 // Ticks up to 64^4 ahead are placed exactly
+#define TWHEEL_EXPIRED -1 // Level of a timer on the expired list
+
+typedef struct TIMER_WHEEL_TIMER
+{
+	uint64_t expires; // Tick at which the timer is due
+	size_t index; // What the timer belongs to, for the owner to use
+	int level; // Level of its slot, or TWHEEL_EXPIRED
+	int slot;
+	struct TIMER_WHEEL_TIMER* next;
+	struct TIMER_WHEEL_TIMER* prev;
+} TIMER_WHEEL_TIMER;
+
+//
+// A hierarchical timer wheel. Level L has 64 slots of 64^L ticks each, so a timer is
+// filed in O(1) by how far ahead it is due, and it drops one level every time its slot
+// comes up ("cascades") until it lands on the expired list. An occupancy bitmap per
+// level lets the wheel jump straight to the next slot that holds timers, so advancing
+// costs O(levels) per slot visited plus O(1) per timer moved, never O(ticks elapsed).
+//
+typedef struct TIMER_WHEEL
+{
+	TIMER_WHEEL_TIMER* slots[TWHEEL_LEVELS][TWHEEL_SLOTS];
+	uint64_t occupied[TWHEEL_LEVELS]; // Bit s is set if slot s of the level has timers
+	TIMER_WHEEL_TIMER* expired; // Timers that are due, until their owner cancels them
+	uint64_t now; // Tick the wheel has been advanced to
+	size_t timers; // Timers on the wheel and on the expired list
+} TIMER_WHEEL;
+
+void twheel_init (TIMER_WHEEL* wheel, uint64_t now);
+void twheel_add (TIMER_WHEEL* wheel, TIMER_WHEEL_TIMER* timer);
+void twheel_cancel (TIMER_WHEEL* wheel, TIMER_WHEEL_TIMER* timer);
+void twheel_advance (TIMER_WHEEL* wheel, uint64_t now);
+TIMER_WHEEL_TIMER* twheel_first_expired (TIMER_WHEEL* wheel);
+
+#endif
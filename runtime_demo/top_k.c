@@ -0,0 +1,391 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <limits.h>
+#include "top_k.h"
+
+#define SUCCESS 1
+#define FAILURE 0
+
+/* FNV-1a with a final mix, so that the low bits are usable for a power of two table. */
+static uint64_t hash_name (char* name)
+{
+    uint64_t h = 0xcbf29ce484222325ULL;
+
+    while (*name != '\0')
+    {
+        h = (h ^ (unsigned char) *name) * 0x100000001b3ULL;
+        name ++;
+    }
+
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+
+    return h;
+}
+
+static size_t power_of_two_above (size_t n)
+{
+    size_t p = 1;
+
+    while (p < n)
+    {
+        p <<= 1;
+    }
+
+    return p;
+}
+
+/* Returns the index slot of the name, or the free slot where it would go. */
+static size_t find_slot (TOPK* topk, char* name)
+{
+    size_t slot = hash_name (name) & (topk->nSlots - 1);
+
+    while ((topk->index[slot] != 0) && (strcmp (topk->heap[topk->index[slot] - 1].name, name) != 0))
+    {
+        slot = (slot + 1) & (topk->nSlots - 1);
+    }
+
+    return slot;
+}
+
+/* Frees an index slot, shifting back the names after it so that no probe sequence breaks. */
+static void free_slot (TOPK* topk, size_t slot)
+{
+    size_t mask = topk->nSlots - 1;
+    size_t next = (slot + 1) & mask;
+
+    topk->index[slot] = 0;
+
+    while (topk->index[next] != 0)
+    {
+        TOPK_ENTRY* entry = &(topk->heap[topk->index[next] - 1]);
+        size_t home = hash_name (entry->name) & mask;
+
+        // Move it back if its home is not between the hole and its slot
+        if (((next - home) & mask) >= ((next - slot) & mask))
+        {
+            topk->index[slot] = topk->index[next];
+            topk->index[next] = 0;
+            entry->slot = slot;
+            slot = next;
+        }
+
+        next = (next + 1) & mask;
+    }
+}
+
+static void swap_entries (TOPK* topk, size_t i, size_t j)
+{
+    TOPK_ENTRY entry = topk->heap[i];
+
+    topk->heap[i] = topk->heap[j];
+    topk->heap[j] = entry;
+
+    if (topk->index != NULL)
+    {
+        topk->index[topk->heap[i].slot] = i + 1;
+        topk->index[topk->heap[j].slot] = j + 1;
+    }
+}
+
+static void sift_up (TOPK* topk, size_t i)
+{
+    while ((i > 0) && (topk->heap[i].value < topk->heap[(i - 1) / 2].value))
+    {
+        swap_entries (topk, i, (i - 1) / 2);
+        i = (i - 1) / 2;
+    }
+}
+
+static void sift_down (TOPK* topk, size_t i)
+{
+    while (1)
+    {
+        size_t smallest = i;
+        size_t left = 2 * i + 1;
+        size_t right = left + 1;
+
+        if ((left < topk->n) && (topk->heap[left].value < topk->heap[smallest].value))
+        {
+            smallest = left;
+        }
+
+        if ((right < topk->n) && (topk->heap[right].value < topk->heap[smallest].value))
+        {
+            smallest = right;
+        }
+
+        if (smallest == i)
+        {
+            return;
+        }
+
+        swap_entries (topk, i, smallest);
+        i = smallest;
+    }
+}
+
+/* Adds a new entry to a heap that is not full. */
+static int push (TOPK* topk, char* name, long value, long error)
+{
+    char* copy = strdup (name);
+    if (copy == NULL)
+    {
+        return FAILURE;
+    }
+
+    TOPK_ENTRY* entry = &(topk->heap[topk->n]);
+    entry->name = copy;
+    entry->value = value;
+    entry->error = error;
+
+    if (topk->index != NULL)
+    {
+        entry->slot = find_slot (topk, copy);
+        topk->index[entry->slot] = topk->n + 1;
+    }
+
+    (topk->n) ++;
+    sift_up (topk, topk->n - 1);
+
+    return SUCCESS;
+}
+
+/* Gives the smallest entry to another name. */
+static int replace_smallest (TOPK* topk, char* name, long value, long error)
+{
+    char* copy = strdup (name);
+    if (copy == NULL)
+    {
+        return FAILURE;
+    }
+
+    TOPK_ENTRY* entry = &(topk->heap[0]);
+
+    if (topk->index != NULL)
+    {
+        free_slot (topk, entry->slot);
+    }
+
+    free (entry->name);
+    entry->name = copy;
+    entry->value = value;
+    entry->error = error;
+
+    if (topk->index != NULL)
+    {
+        entry->slot = find_slot (topk, copy);
+        topk->index[entry->slot] = 1;
+    }
+
+    sift_down (topk, 0);
+
+    return SUCCESS;
+}
+
+/* Adds weight to the sketch counters of the name and returns its new estimate, the smallest of them. */
+static long sketch_add (TOPK* topk, char* name, long weight)
+{
+    uint64_t h = hash_name (name);
+    uint64_t step = (h >> 32) | 1; // Rows probe with h + row * step
+    uint64_t estimate = UINT64_MAX;
+    int row;
+
+    for (row = 0; row < TOPK_CM_DEPTH; row ++)
+    {
+        uint64_t* counter = &(topk->sketch[row * topk->cmWidth + ((h + row * step) & (topk->cmWidth - 1))]);
+
+        *counter += (uint64_t) weight;
+
+        if (*counter < estimate)
+        {
+            estimate = *counter;
+        }
+    }
+
+    return (estimate > (uint64_t) LONG_MAX) ? LONG_MAX : (long) estimate;
+}
+
+static int compare_items (const void* itemPtr1, const void* itemPtr2)
+{
+    const TOPK_ITEM* item1 = itemPtr1;
+    const TOPK_ITEM* item2 = itemPtr2;
+
+    if (item1->value != item2->value) // Largest first
+    {
+        return (item1->value < item2->value) - (item1->value > item2->value);
+    }
+
+    return strcmp (item1->name, item2->name);
+}
+
+//
+// It returns a new top-K operator in one of the TOPK_* modes, or NULL if k is 0, the
+// mode is unknown or memory runs out.
+//
+TOPK* topk_create (size_t k, int mode)
+{
+    if ((k == 0) || (mode < TOPK_EXACT) || (mode > TOPK_COUNT_MIN))
+    {
+        return NULL;
+    }
+
+    TOPK* topk = calloc (1, sizeof (TOPK));
+    if (topk == NULL)
+    {
+        return NULL;
+    }
+
+    topk->mode = mode;
+    topk->k = k;
+    topk->heap = malloc (k * sizeof (TOPK_ENTRY));
+
+    if (mode != TOPK_EXACT) // Records of one name add up
+    {
+        topk->nSlots = power_of_two_above (2 * k);
+        topk->index = calloc (topk->nSlots, sizeof (size_t));
+    }
+
+    if (mode == TOPK_COUNT_MIN)
+    {
+        topk->cmWidth = power_of_two_above (TOPK_CM_WIDTH_PER_K * k);
+        topk->sketch = calloc (TOPK_CM_DEPTH * topk->cmWidth, sizeof (uint64_t));
+    }
+
+    if ((topk->heap == NULL) || ((mode != TOPK_EXACT) && (topk->index == NULL)) ||
+        ((mode == TOPK_COUNT_MIN) && (topk->sketch == NULL)))
+    {
+        topk_free (topk);
+        return NULL;
+    }
+
+    return topk;
+}
+
+//
+// It feeds one record to the operator. The name is copied only if it is kept.
+// It will return 1 if successful, or 0 if memory runs out.
+//
+int topk_add (TOPK* topk, char* name, long value)
+{
+    if (topk->mode == TOPK_EXACT)
+    {
+        if (topk->n < topk->k)
+        {
+            return push (topk, name, value, 0);
+        }
+
+        if (value > topk->heap[0].value) // Makes the cut
+        {
+            return replace_smallest (topk, name, value, 0);
+        }
+
+        return SUCCESS;
+    }
+
+    if (value < 0)
+    {
+        value = 0;
+    }
+
+    size_t slot = find_slot (topk, name);
+    long sum = (topk->mode == TOPK_COUNT_MIN) ? sketch_add (topk, name, value) : 0;
+
+    if (topk->index[slot] != 0) // Already kept: its value only grows
+    {
+        TOPK_ENTRY* entry = &(topk->heap[topk->index[slot] - 1]);
+
+        if (topk->mode == TOPK_COUNT_MIN)
+        {
+            entry->value = sum;
+        }
+
+        else
+        {
+            entry->value = (value > LONG_MAX - entry->value) ? LONG_MAX : entry->value + value;
+        }
+
+        sift_down (topk, topk->index[slot] - 1);
+
+        return SUCCESS;
+    }
+
+    if (topk->mode == TOPK_COUNT_MIN)
+    {
+        if (topk->n < topk->k)
+        {
+            return push (topk, name, sum, 0);
+        }
+
+        if (sum > topk->heap[0].value)
+        {
+            return replace_smallest (topk, name, sum, 0);
+        }
+
+        return SUCCESS;
+    }
+
+    // Space-Saving: a new name takes over the smallest count, which bounds its error
+    if (topk->n < topk->k)
+    {
+        return push (topk, name, value, 0);
+    }
+
+    long smallest = topk->heap[0].value;
+
+    return replace_smallest (topk, name, (value > LONG_MAX - smallest) ? LONG_MAX : smallest + value, smallest);
+}
+
+//
+// It stores the result in items, which must have room for k items, from the largest
+// value down, and returns how many it stored. The names now belong to the caller.
+// The operator is empty afterwards and can be fed again.
+//
+size_t topk_finish (TOPK* topk, TOPK_ITEM* items)
+{
+    size_t i; // Heap index
+    size_t n = topk->n;
+
+    for (i = 0; i < n; i ++)
+    {
+        items[i].name = topk->heap[i].name;
+        items[i].value = topk->heap[i].value;
+        items[i].error = topk->heap[i].error;
+    }
+
+    qsort (items, n, sizeof (TOPK_ITEM), compare_items);
+
+    topk->n = 0;
+
+    if (topk->index != NULL)
+    {
+        memset (topk->index, 0, topk->nSlots * sizeof (size_t));
+    }
+
+    if (topk->sketch != NULL)
+    {
+        memset (topk->sketch, 0, TOPK_CM_DEPTH * topk->cmWidth * sizeof (uint64_t));
+    }
+
+    return n;
+}
+
+//
+// It frees the operator and the names it still holds.
+//
+void topk_free (TOPK* topk)
+{
+    size_t i; // Heap index
+
+    for (i = 0; i < topk->n; i ++)
+    {
+        free (topk->heap[i].name);
+    }
+
+    free (topk->heap);
+    free (topk->index);
+    free (topk->sketch);
+    free (topk);
+}
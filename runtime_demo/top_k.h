@@ -0,0 +1,56 @@
+#if !defined TOP_K_H
+#define TOP_K_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define TOPK_EXACT 0 // The k records with the largest values
+#define TOPK_SPACE_SAVING 1 // Approximate heavy hitters: the k names with the largest summed values
+#define TOPK_COUNT_MIN 2 // Same, with the sums estimated by a Count-Min sketch
+
+#define TOPK_CM_DEPTH 4 // Rows of the Count-Min sketch
+#define TOPK_CM_WIDTH_PER_K 16 // Columns of the sketch per item kept
+
+// One result of a top-K stream. The name is a copy that the caller frees.
+typedef struct TOPK_ITEM
+{
+	char* name;
+	long value; // Value of the record, or (estimated) sum of the values of the name
+	long error; // Space-Saving only: the value may be overestimated by up to this much
+} TOPK_ITEM;
+
+typedef struct TOPK_ENTRY
+{
+	char* name;
+	long value;
+	long error;
+	size_t slot; // Slot of the name in the name index
+} TOPK_ENTRY;
+
+//
+// A top-K operator over a stream of name/value records, in O(k) memory whatever the
+// length of the stream. The k entries are a min-heap on value, so a record that does not
+// make the cut costs O(1) and one that does costs O(log k).
+// In the heavy hitter modes the records of one name add up. A small open-addressing index
+// finds the entry of a name. Space-Saving gives a name that is not kept the slot of the
+// smallest entry, which is exact about what it may have overcounted. Count-Min keeps the
+// k names with the largest sketch estimates. Negative values count as 0 in these modes.
+//
+typedef struct TOPK
+{
+	int mode;
+	size_t k;
+	size_t n; // Entries in the heap
+	TOPK_ENTRY* heap;
+	size_t* index; // Heap position + 1 of every name, 0 for a free slot
+	size_t nSlots; // Power of two, at least twice k
+	uint64_t* sketch; // TOPK_CM_DEPTH rows of cmWidth counters
+	size_t cmWidth;
+} TOPK;
+
+TOPK* topk_create (size_t k, int mode);
+int topk_add (TOPK* topk, char* name, long value);
+size_t topk_finish (TOPK* topk, TOPK_ITEM* items);
+void topk_free (TOPK* topk);
+
+#endif
@@ -0,0 +1,71 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include "resizable_table.h"
+#include "huge_array.h"
+#include "typed_table.h"
+
+#define MAXLINE 512
+#define SUCCESS 1
+#define FAILURE 0
+#define TERMINATING_NULL_BYTE '\0'
+#define READ_MODE "r"
+#define WRITE_MODE "w"
+
+/* Parses an int64_t written by PRId64, followed only by whitespace. */
+static int parse_int64 (char* line, int64_t* value)
+{
+    char* end;
+
+    *value = strtoll (line, &end, 10);
+
+    return (end != line) && (end[strspn (end, " \t\n")] == TERMINATING_NULL_BYTE);
+}
+
+/* Strips the newline of a value read with fgets. The table copies it when storing it. */
+static int parse_str (char* line, char** value)
+{
+    line[strcspn (line, "\n")] = TERMINATING_NULL_BYTE;
+    *value = line;
+
+    return SUCCESS;
+}
+
+// RTABLE_INT: values are plain int64_t, nothing to copy or free
+#define TT_TABLE RTABLE_INT
+#define TT_PREFIX rtable_int_
+#define TT_VALUE int64_t
+#define TT_VALUE_STORE(table, value) (value)
+#define TT_VALUE_STORED(value) 1
+#define TT_VALUE_RELEASE(table, value)
+#define TT_VALUE_COMPARE(a, b) (((a) > (b)) - ((a) < (b)))
+#define TT_VALUE_PRINT(fout, value) fprintf ((fout), "%" PRId64, (value))
+#define TT_VALUE_SHOW(value) printf ("%" PRId64, (value))
+#define TT_VALUE_PARSE(table, line, valuePtr) parse_int64 ((line), (valuePtr))
+#define TT_VALUES_IN_ARENA 0
+#include "typed_table_impl.h"
+
+// RTABLE_STR: values are copied into the arena, like the names
+#define TT_TABLE RTABLE_STR
+#define TT_PREFIX rtable_str_
+#define TT_VALUE char*
+#define TT_VALUE_STORE(table, value) arena_strdup (&((table)->arena), (value))
+#define TT_VALUE_STORED(value) ((value) != NULL)
+#define TT_VALUE_RELEASE(table, value) arena_release (&((table)->arena), (value))
+#define TT_VALUE_COMPARE(a, b) strcmp ((a), (b))
+#define TT_VALUE_PRINT(fout, value) fprintf ((fout), "%s", (value))
+#define TT_VALUE_SHOW(value) printf ("\"%s\"", (value))
+#define TT_VALUE_PARSE(table, line, valuePtr) parse_str ((line), (valuePtr))
+#define TT_VALUES_IN_ARENA 1
+#include "typed_table_impl.h"
+
+//
+// It computes the aggregates requested in agg over the values of the table, which are
+// already one contiguous int64_t column. It will return 1 if successful, or 0 otherwise.
+//
+int rtable_int_aggregate (RTABLE_INT* table, AGGREGATE* agg)
+{
+    return aggregate_column (agg, table->values, table->currentElements);
+}
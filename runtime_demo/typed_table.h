@@ -0,0 +1,38 @@
+#if !defined TYPED_TABLE_H
+#define TYPED_TABLE_H
+
+#include <stdint.h>
+#include "string_arena.h"
+#include "aggregate.h"
+
+//
+// Resizable tables with a fixed value type. They are generated from one template,
+// typed_table_decl.h and typed_table_impl.h, that is included once per value type.
+// Names and values are kept in two parallel arrays, so scanning the values of an
+// RTABLE_INT reads one contiguous int64_t array with no casts and no pointers.
+// Names (and the values of an RTABLE_STR) are copied into an arena owned by the table.
+//
+// Unlike rtable_add, the functions of the typed tables return 1 if successful
+// and 0 otherwise.
+//
+
+#define TT_CONCAT2(a, b) a##b
+#define TT_CONCAT(a, b) TT_CONCAT2(a, b)
+#define TT_FN(name) TT_CONCAT(TT_PREFIX, name)
+
+// RTABLE_INT: int64_t values stored inline in the values array
+#define TT_TABLE RTABLE_INT
+#define TT_PREFIX rtable_int_
+#define TT_VALUE int64_t
+#include "typed_table_decl.h"
+
+// Aggregates run directly over the values array, see aggregate.h
+int rtable_int_aggregate (RTABLE_INT* table, AGGREGATE* agg);
+
+// RTABLE_STR: string values copied into the table's arena
+#define TT_TABLE RTABLE_STR
+#define TT_PREFIX rtable_str_
+#define TT_VALUE char*
+#include "typed_table_decl.h"
+
+#endif
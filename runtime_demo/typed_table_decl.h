@@ -0,0 +1,42 @@
+//
+// Declarations of one typed table. Not a normal header: it is included by typed_table.h
+// once per value type, with these macros defined:
+//
+// TT_TABLE     name of the table type, e.g. RTABLE_INT
+// TT_PREFIX    prefix of its functions, e.g. rtable_int_
+// TT_VALUE     type of the values, e.g. int64_t
+//
+
+typedef struct TT_TABLE
+{
+	size_t maxElements; // Capacity of names and values
+	size_t currentElements; // Number of entries in use
+	char** names; // Names of the entries, stored in arena
+	TT_VALUE* values; // Values of the entries, values[i] belongs to names[i]
+	STRING_ARENA arena; // Owns the names, and the values if they are strings
+	int hugePages; // Large arrays ask for transparent huge pages, see huge_array.h
+} TT_TABLE;
+
+TT_TABLE* TT_FN(create) ();
+void TT_FN(destroy) (TT_TABLE* table);
+int TT_FN(add) (TT_TABLE* table, char* name, TT_VALUE value);
+int TT_FN(lookup) (TT_TABLE* table, char* name, TT_VALUE* value);
+int TT_FN(remove) (TT_TABLE* table, char* name);
+int TT_FN(get_ith) (TT_TABLE* table, size_t ith, char** name, TT_VALUE* value);
+int TT_FN(remove_ith) (TT_TABLE* table, size_t ith);
+size_t TT_FN(number_elements) (TT_TABLE* table);
+size_t TT_FN(max_elements) (TT_TABLE* table);
+void TT_FN(sort) (TT_TABLE* table, int ascending);
+void TT_FN(sort_by_value) (TT_TABLE* table, int ascending);
+int TT_FN(remove_first) (TT_TABLE* table);
+int TT_FN(remove_last) (TT_TABLE* table);
+int TT_FN(insert_first) (TT_TABLE* table, char* name, TT_VALUE value);
+int TT_FN(insert_last) (TT_TABLE* table, char* name, TT_VALUE value);
+void TT_FN(print) (TT_TABLE* table);
+int TT_FN(save) (TT_TABLE* table, char* file_name);
+int TT_FN(read) (TT_TABLE* table, char* file_name);
+void TT_FN(use_huge_pages) (TT_TABLE* table, int hugePages);
+
+#undef TT_TABLE
+#undef TT_PREFIX
+#undef TT_VALUE
@@ -0,0 +1,580 @@
+//
+// Definitions of one typed table. Not a normal header: it is included by typed_table.c
+// once per value type, with the macros of typed_table_decl.h and these defined:
+//
+// TT_VALUE_STORE(table, value)    copy of value the table can keep
+// TT_VALUE_STORED(value)          1 if TT_VALUE_STORE returned value, or 0 if memory ran out
+// TT_VALUE_RELEASE(table, value)  gives back a value stored with TT_VALUE_STORE
+// TT_VALUE_COMPARE(a, b)          <0, 0 or >0, like strcmp
+// TT_VALUE_PRINT(fout, value)     writes value in the text form of the save files
+// TT_VALUE_SHOW(value)            prints value the way rtable_print_str/_int do
+// TT_VALUE_PARSE(table, line, valuePtr)  reads a value written by TT_VALUE_PRINT,
+//                                 returns 1 if successful, or 0 otherwise
+// TT_VALUES_IN_ARENA              1 if stored values point into the table's arena
+//
+
+#define TT_ENTRY TT_CONCAT(TT_TABLE, _SORT_ENTRY)
+
+/* Name and value of one entry, used while sorting the two parallel arrays. */
+typedef struct TT_ENTRY
+{
+    char* name;
+    TT_VALUE value;
+} TT_ENTRY;
+
+//
+// It returns a new empty table, or NULL if memory runs out.
+// The initial maximum size of the arrays is INITIAL_SIZE_RESIZABLE_TABLE.
+//
+TT_TABLE* TT_FN(create) ()
+{
+    TT_TABLE* table = malloc (sizeof (TT_TABLE));
+    if (table == NULL)
+    {
+        return NULL;
+    }
+
+    table->maxElements = INITIAL_SIZE_RESIZABLE_TABLE;
+    table->currentElements = 0;
+    table->hugePages = 0;
+    table->names = harray_alloc (table->maxElements * sizeof (char*), table->hugePages);
+    table->values = harray_alloc (table->maxElements * sizeof (TT_VALUE), table->hugePages);
+    arena_init (&(table->arena));
+
+    if ((table->names == NULL) || (table->values == NULL))
+    {
+        harray_free (table->names, table->maxElements * sizeof (char*));
+        harray_free (table->values, table->maxElements * sizeof (TT_VALUE));
+        free (table);
+        return NULL;
+    }
+
+    return table;
+}
+
+//
+// It frees the table, its arrays and every name and value it owns.
+//
+void TT_FN(destroy) (TT_TABLE* table)
+{
+    arena_free (&(table->arena));
+    harray_free (table->names, table->maxElements * sizeof (char*));
+    harray_free (table->values, table->maxElements * sizeof (TT_VALUE));
+    free (table);
+}
+
+/* Doubles the capacity of both arrays. It fails without touching the table if the
+size in bytes would overflow or memory runs out. */
+static int TT_FN(grow) (TT_TABLE* table)
+{
+    size_t oldMax = table->maxElements;
+    size_t largest = (sizeof (char*) > sizeof (TT_VALUE)) ? sizeof (char*) : sizeof (TT_VALUE);
+
+    if (oldMax > (SIZE_MAX / 2) / largest)
+    {
+        return FAILURE;
+    }
+
+    char** names = harray_realloc (table->names, oldMax * sizeof (char*), 2 * oldMax * sizeof (char*), table->hugePages);
+    if (names == NULL)
+    {
+        return FAILURE;
+    }
+
+    TT_VALUE* values = harray_realloc (table->values, oldMax * sizeof (TT_VALUE), 2 * oldMax * sizeof (TT_VALUE), table->hugePages);
+    if (values == NULL)
+    {
+        // Shrink names back so that both arrays keep the same capacity. Shrinking does not
+        // really fail, but if it does the larger array is still usable.
+        char** shrunk = harray_realloc (names, 2 * oldMax * sizeof (char*), oldMax * sizeof (char*), table->hugePages);
+        table->names = (shrunk != NULL) ? shrunk : names;
+        return FAILURE;
+    }
+
+    table->names = names;
+    table->values = values;
+    table->maxElements = 2 * oldMax;
+
+    return SUCCESS;
+}
+
+/* Copies the live strings into a fresh arena once most of the old one is dead. */
+static void TT_FN(compact) (TT_TABLE* table)
+{
+    size_t i; // Array index
+    size_t perEntry = TT_VALUES_IN_ARENA ? 2 : 1; // Strings in the arena per entry
+    STRING_ARENA fresh;
+    char** copies;
+
+    if ((table->arena.deadBytes < STRING_ARENA_CHUNK_SIZE) || (table->arena.deadBytes < table->arena.liveBytes))
+    {
+        return;
+    }
+
+    // The copies are only put in place once they all exist, so that running out of memory
+    // leaves the table on the old arena, just not compacted
+    copies = malloc (table->currentElements * perEntry * sizeof (char*));
+    if ((copies == NULL) && (table->currentElements > 0))
+    {
+        return;
+    }
+
+    arena_init (&fresh);
+
+    for (i = 0; i < table->currentElements; i ++)
+    {
+        copies[i * perEntry] = arena_strdup (&fresh, table->names[i]);
+#if TT_VALUES_IN_ARENA
+        copies[i * perEntry + 1] = arena_strdup (&fresh, table->values[i]);
+        if (copies[i * perEntry + 1] == NULL)
+        {
+            break;
+        }
+#endif
+        if (copies[i * perEntry] == NULL)
+        {
+            break;
+        }
+    }
+
+    if (i < table->currentElements)
+    {
+        arena_free (&fresh);
+        free (copies);
+        return;
+    }
+
+    for (i = 0; i < table->currentElements; i ++)
+    {
+        table->names[i] = copies[i * perEntry];
+#if TT_VALUES_IN_ARENA
+        table->values[i] = copies[i * perEntry + 1];
+#endif
+    }
+
+    free (copies);
+    arena_free (&(table->arena));
+    table->arena = fresh;
+}
+
+/* Copies name and value for a new entry. It will return 1 if successful, or 0 if memory runs out, with nothing kept. */
+static int TT_FN(copy_entry) (TT_TABLE* table, char* name, TT_VALUE value, char** nameCopy, TT_VALUE* valueCopy)
+{
+    *nameCopy = arena_strdup (&(table->arena), name);
+    if (*nameCopy == NULL)
+    {
+        return FAILURE;
+    }
+
+    *valueCopy = TT_VALUE_STORE (table, value);
+    if (!TT_VALUE_STORED (*valueCopy))
+    {
+        arena_release (&(table->arena), *nameCopy);
+        return FAILURE;
+    }
+
+    return SUCCESS;
+}
+
+/* Returns the index of name or -1 if the name does not exist in the table. */
+static long TT_FN(lookup_index) (TT_TABLE* table, char* name)
+{
+    size_t i; // Array index
+
+    for (i = 0; i < table->currentElements; i ++)
+    {
+        if (strcmp (table->names[i], name) == 0)
+        {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+//
+// Adds one pair name/value to the table. If the name already exists it will
+// substitute its value. Otherwise, it will store name/value in a new entry at the end.
+//
+int TT_FN(add) (TT_TABLE* table, char* name, TT_VALUE value)
+{
+    long nameIndex = TT_FN(lookup_index) (table, name);
+
+    if (nameIndex != -1) // Name already exists
+    {
+        TT_VALUE copy = TT_VALUE_STORE (table, value);
+
+        if (!TT_VALUE_STORED (copy))
+        {
+            return FAILURE;
+        }
+
+        TT_VALUE_RELEASE (table, table->values[nameIndex]);
+        table->values[nameIndex] = copy;
+        TT_FN(compact) (table);
+
+        return SUCCESS;
+    }
+
+    return TT_FN(insert_last) (table, name, value);
+}
+
+//
+// It stores in *value the value that corresponds to the name. It returns 1 if the
+// name exists, or 0 otherwise.
+//
+int TT_FN(lookup) (TT_TABLE* table, char* name, TT_VALUE* value)
+{
+    long nameIndex = TT_FN(lookup_index) (table, name);
+
+    if (nameIndex == -1)
+    {
+        return FAILURE;
+    }
+
+    *value = table->values[nameIndex];
+
+    return SUCCESS;
+}
+
+//
+// It removes the entry with that name from the table. The entries after the entry
+// removed will shift upwards.
+//
+int TT_FN(remove) (TT_TABLE* table, char* name)
+{
+    long nameIndex = TT_FN(lookup_index) (table, name);
+
+    if (nameIndex == -1)
+    {
+        return FAILURE;
+    }
+
+    return TT_FN(remove_ith) (table, nameIndex);
+}
+
+//
+// It returns in *name and *value the name and value that correspond to
+// the ith entry. It will return 1 if successful, or 0 otherwise.
+//
+int TT_FN(get_ith) (TT_TABLE* table, size_t ith, char** name, TT_VALUE* value)
+{
+    if (ith >= table->currentElements)
+    {
+        return FAILURE;
+    }
+
+    *name = table->names[ith];
+    *value = table->values[ith];
+
+    return SUCCESS;
+}
+
+//
+// It removes the ith entry from the table. The entries after the entry removed are
+// moved upwards to use the empty space.
+//
+int TT_FN(remove_ith) (TT_TABLE* table, size_t ith)
+{
+    if (ith >= table->currentElements)
+    {
+        return FAILURE;
+    }
+
+    arena_release (&(table->arena), table->names[ith]);
+    TT_VALUE_RELEASE (table, table->values[ith]);
+
+    memmove (table->names + ith, table->names + ith + 1, (table->currentElements - ith - 1) * sizeof (char*));
+    memmove (table->values + ith, table->values + ith + 1, (table->currentElements - ith - 1) * sizeof (TT_VALUE));
+
+    (table->currentElements) --;
+
+    TT_FN(compact) (table);
+
+    return SUCCESS;
+}
+
+//
+// It returns the number of elements in the table.
+//
+size_t TT_FN(number_elements) (TT_TABLE* table)
+{
+    return table->currentElements;
+}
+
+//
+// It returns the maximum number of elements in the table.
+//
+size_t TT_FN(max_elements) (TT_TABLE* table)
+{
+    return table->maxElements;
+}
+
+static int TT_FN(name_asc) (const void* entry1, const void* entry2)
+{
+    return strcmp (((TT_ENTRY*) entry1)->name, ((TT_ENTRY*) entry2)->name);
+}
+
+static int TT_FN(name_desc) (const void* entry1, const void* entry2)
+{
+    return TT_FN(name_asc) (entry2, entry1);
+}
+
+static int TT_FN(value_asc) (const void* entry1, const void* entry2)
+{
+    return TT_VALUE_COMPARE (((TT_ENTRY*) entry1)->value, ((TT_ENTRY*) entry2)->value);
+}
+
+static int TT_FN(value_desc) (const void* entry1, const void* entry2)
+{
+    return TT_FN(value_asc) (entry2, entry1);
+}
+
+/* Sorts names and values together with the given comparator. */
+static void TT_FN(sort_entries) (TT_TABLE* table, int (*compare) (const void*, const void*))
+{
+    size_t i; // Array index
+
+    TT_ENTRY* entries = malloc ((table->currentElements + 1) * sizeof (TT_ENTRY));
+    if (entries == NULL)
+    {
+        return;
+    }
+
+    for (i = 0; i < table->currentElements; i ++)
+    {
+        entries[i].name = table->names[i];
+        entries[i].value = table->values[i];
+    }
+
+    qsort (entries, table->currentElements, sizeof (TT_ENTRY), compare);
+
+    for (i = 0; i < table->currentElements; i ++)
+    {
+        table->names[i] = entries[i].name;
+        table->values[i] = entries[i].value;
+    }
+
+    free (entries);
+}
+
+//
+// It sorts the table according to the name. The parameter 'ascending' determines if the
+// order is ascending (1) or descending(0).
+//
+void TT_FN(sort) (TT_TABLE* table, int ascending)
+{
+    if ((ascending != 0) && (ascending != 1)) // Invalid input!
+    {
+        return;
+    }
+
+    TT_FN(sort_entries) (table, ascending ? TT_FN(name_asc) : TT_FN(name_desc));
+}
+
+//
+// It sorts the table according to the value. The parameter 'ascending' determines if the
+// order is ascending (1) or descending(0).
+//
+void TT_FN(sort_by_value) (TT_TABLE* table, int ascending)
+{
+    if ((ascending != 0) && (ascending != 1)) // Invalid input!
+    {
+        return;
+    }
+
+    TT_FN(sort_entries) (table, ascending ? TT_FN(value_asc) : TT_FN(value_desc));
+}
+
+//
+// It removes the first entry in the table.
+// All entries are moved down one position.
+//
+int TT_FN(remove_first) (TT_TABLE* table)
+{
+    return TT_FN(remove_ith) (table, 0);
+}
+
+//
+// It removes the last entry in the table.
+//
+int TT_FN(remove_last) (TT_TABLE* table)
+{
+    if (table->currentElements == 0)
+    {
+        return FAILURE;
+    }
+
+    return TT_FN(remove_ith) (table, table->currentElements - 1);
+}
+
+//
+// Insert a name/value pair at the beginning of the table.
+// The entries are moved one position downwards.
+// There is no check if the name already exists.
+//
+int TT_FN(insert_first) (TT_TABLE* table, char* name, TT_VALUE value)
+{
+    char* nameCopy;
+    TT_VALUE valueCopy;
+
+    if ((table->currentElements == table->maxElements) && (TT_FN(grow) (table) == FAILURE))
+    {
+        return FAILURE;
+    }
+
+    if (TT_FN(copy_entry) (table, name, value, &nameCopy, &valueCopy) == FAILURE)
+    {
+        return FAILURE;
+    }
+
+    memmove (table->names + 1, table->names, table->currentElements * sizeof (char*));
+    memmove (table->values + 1, table->values, table->currentElements * sizeof (TT_VALUE));
+
+    table->names[0] = nameCopy;
+    table->values[0] = valueCopy;
+
+    (table->currentElements) ++;
+
+    return SUCCESS;
+}
+
+//
+// Insert a name/value pair at the end of the table.
+// There is no check if the name already exists.
+//
+int TT_FN(insert_last) (TT_TABLE* table, char* name, TT_VALUE value)
+{
+    char* nameCopy;
+    TT_VALUE valueCopy;
+
+    if ((table->currentElements == table->maxElements) && (TT_FN(grow) (table) == FAILURE))
+    {
+        return FAILURE;
+    }
+
+    if (TT_FN(copy_entry) (table, name, value, &nameCopy, &valueCopy) == FAILURE)
+    {
+        return FAILURE;
+    }
+
+    table->names[table->currentElements] = nameCopy;
+    table->values[table->currentElements] = valueCopy;
+
+    (table->currentElements) ++;
+
+    return SUCCESS;
+}
+
+//
+// It prints the elements in the same form as rtable_print_str and rtable_print_int.
+//
+void TT_FN(print) (TT_TABLE* table)
+{
+    size_t i; // Array index
+
+    printf ("\n======== Table =======\n");
+    printf ("currentElements=%zu maxElements=%zu\n", table->currentElements, table->maxElements);
+
+    for (i = 0; i < table->currentElements; i ++)
+    {
+        printf ("%zu: \"%s\" ", i, table->names[i]);
+        TT_VALUE_SHOW (table->values[i]);
+        printf ("\n");
+    }
+
+    printf ("======== End Table =======\n");
+}
+
+//
+// It saves the table in a file called file_name, in the same format as rtable_save_str
+// and rtable_save_int: name, value and an empty line for every entry.
+//
+int TT_FN(save) (TT_TABLE* table, char* file_name)
+{
+    size_t i; // Array index
+
+    FILE* fout = fopen (file_name, WRITE_MODE);
+    if (fout == NULL) // fopen failed
+    {
+        return FAILURE;
+    }
+
+    for (i = 0; i < table->currentElements; i ++)
+    {
+        fprintf (fout, "%s\n", table->names[i]);
+        TT_VALUE_PRINT (fout, table->values[i]);
+        fprintf (fout, "\n\n");
+    }
+
+    fclose (fout);
+
+    return SUCCESS;
+}
+
+//
+// It reads the table from the file_name indicated. If the table already has entries,
+// it will clear the entries.
+//
+int TT_FN(read) (TT_TABLE* table, char* file_name)
+{
+    char name[MAXLINE + 1]; // Buffer for the name read in from file
+    char line[MAXLINE + 1]; // Buffer for the value, which a string value points into
+    char separator[MAXLINE + 1]; // Buffer for the empty line
+    TT_VALUE value;
+
+    FILE* fin = fopen (file_name, READ_MODE);
+    if (fin == NULL) // fopen failed
+    {
+        return FAILURE;
+    }
+
+    // Clearing is just forgetting the entries and dropping the whole arena
+    table->currentElements = 0;
+    arena_free (&(table->arena));
+
+    while (fgets (name, MAXLINE + 1, fin) != NULL)
+    {
+        name[strcspn (name, "\n")] = TERMINATING_NULL_BYTE;
+
+        // Read in the value and the empty line separating name/value pairs
+        if ((fgets (line, MAXLINE + 1, fin) == NULL) || (TT_VALUE_PARSE (table, line, &value) == FAILURE) ||
+            (fgets (separator, MAXLINE + 1, fin) == NULL))
+        {
+            fclose (fin);
+            return FAILURE;
+        }
+
+        if (TT_FN(insert_last) (table, name, value) == FAILURE)
+        {
+            fclose (fin);
+            return FAILURE;
+        }
+    }
+
+    fclose (fin);
+
+    return SUCCESS;
+}
+
+//
+// It asks for transparent huge pages for the arrays that are large enough to be mapped.
+// It takes effect from the next time the arrays grow.
+//
+void TT_FN(use_huge_pages) (TT_TABLE* table, int hugePages)
+{
+    table->hugePages = hugePages;
+}
+
+#undef TT_ENTRY
+#undef TT_TABLE
+#undef TT_PREFIX
+#undef TT_VALUE
+#undef TT_VALUE_STORE
+#undef TT_VALUE_STORED
+#undef TT_VALUE_RELEASE
+#undef TT_VALUE_COMPARE
+#undef TT_VALUE_PRINT
+#undef TT_VALUE_SHOW
+#undef TT_VALUE_PARSE
+#undef TT_VALUES_IN_ARENA
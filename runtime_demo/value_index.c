@@ -0,0 +1,427 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "value_index.h"
+
+#define SUCCESS 1
+#define FAILURE 0
+
+/* Orders (value, name) pairs: by value, then by name, then by the address of the name. */
+static int compare (long value, char* name, VALUE_INDEX_NODE* node)
+{
+    if (value != node->value)
+    {
+        return (value > node->value) - (value < node->value);
+    }
+
+    int order = strcmp (name, node->name);
+    if (order != 0)
+    {
+        return order;
+    }
+
+    return (name > node->name) - (name < node->name);
+}
+
+static size_t size_of (VALUE_INDEX_NODE* node)
+{
+    return (node == NULL) ? 0 : node->size;
+}
+
+static void update_size (VALUE_INDEX_NODE* node)
+{
+    node->size = 1 + size_of (node->left) + size_of (node->right);
+}
+
+static VALUE_INDEX_NODE* rotate_right (VALUE_INDEX_NODE* node)
+{
+    VALUE_INDEX_NODE* left = node->left;
+
+    node->left = left->right;
+    left->right = node;
+    update_size (node);
+    update_size (left);
+
+    return left;
+}
+
+static VALUE_INDEX_NODE* rotate_left (VALUE_INDEX_NODE* node)
+{
+    VALUE_INDEX_NODE* right = node->right;
+
+    node->right = right->left;
+    right->left = node;
+    update_size (node);
+    update_size (right);
+
+    return right;
+}
+
+/* Inserts a node under root and returns the new root of the subtree. */
+static VALUE_INDEX_NODE* attach (VALUE_INDEX_NODE* root, VALUE_INDEX_NODE* node)
+{
+    if (root == NULL)
+    {
+        node->left = NULL;
+        node->right = NULL;
+        node->size = 1;
+
+        return node;
+    }
+
+    if (compare (node->value, node->name, root) < 0)
+    {
+        root->left = attach (root->left, node);
+
+        if (root->left->priority > root->priority)
+        {
+            return rotate_right (root);
+        }
+    }
+
+    else
+    {
+        root->right = attach (root->right, node);
+
+        if (root->right->priority > root->priority)
+        {
+            return rotate_left (root);
+        }
+    }
+
+    update_size (root);
+    return root;
+}
+
+/* Takes the node of (value, name) out of the subtree without freeing it, and stores it in *found.
+It returns the new root of the subtree. */
+static VALUE_INDEX_NODE* detach (VALUE_INDEX_NODE* root, char* name, long value, VALUE_INDEX_NODE** found)
+{
+    if (root == NULL) // Not in the index
+    {
+        return NULL;
+    }
+
+    int order = compare (value, name, root);
+
+    if (order < 0)
+    {
+        root->left = detach (root->left, name, value, found);
+    }
+
+    else if (order > 0)
+    {
+        root->right = detach (root->right, name, value, found);
+    }
+
+    else if ((root->left == NULL) || (root->right == NULL))
+    {
+        *found = root;
+        return (root->left != NULL) ? root->left : root->right;
+    }
+
+    else
+    {
+        // Rotate the node down below its child with the higher priority, then continue there
+        if (root->left->priority > root->right->priority)
+        {
+            root = rotate_right (root);
+            root->right = detach (root->right, name, value, found);
+        }
+
+        else
+        {
+            root = rotate_left (root);
+            root->left = detach (root->left, name, value, found);
+        }
+    }
+
+    update_size (root);
+    return root;
+}
+
+static uint32_t next_priority (VALUE_INDEX* index)
+{
+    // xorshift64*
+    index->seed ^= index->seed >> 12;
+    index->seed ^= index->seed << 25;
+    index->seed ^= index->seed >> 27;
+
+    return (uint32_t) ((index->seed * 0x2545f4914f6cdd1dULL) >> 32);
+}
+
+static void free_nodes (VALUE_INDEX_NODE* node)
+{
+    if (node == NULL)
+    {
+        return;
+    }
+
+    free_nodes (node->left);
+    free_nodes (node->right);
+    free (node);
+}
+
+/* Sets the subtree sizes of a tree built without them. */
+static size_t fix_sizes (VALUE_INDEX_NODE* node)
+{
+    if (node == NULL)
+    {
+        return 0;
+    }
+
+    node->size = 1 + fix_sizes (node->left) + fix_sizes (node->right);
+
+    return node->size;
+}
+
+/* Stores the nodes of the subtree from the largest value down, until *k is 0. */
+static void collect_largest (VALUE_INDEX_NODE* node, size_t* k, size_t* n, char** names, long* values)
+{
+    if ((node == NULL) || (*k == 0))
+    {
+        return;
+    }
+
+    collect_largest (node->right, k, n, names, values);
+
+    if (*k > 0)
+    {
+        names[*n] = node->name;
+        values[*n] = node->value;
+        (*n) ++;
+        (*k) --;
+
+        collect_largest (node->left, k, n, names, values);
+    }
+}
+
+/* Stores the nodes of the subtree with low <= value <= high in order, up to maxResults. */
+static void collect_range (VALUE_INDEX_NODE* node, long low, long high, char** names, long* values, size_t* n, size_t maxResults)
+{
+    if ((node == NULL) || (*n == maxResults))
+    {
+        return;
+    }
+
+    if (node->value >= low) // There may be values in range on the left
+    {
+        collect_range (node->left, low, high, names, values, n, maxResults);
+    }
+
+    if ((node->value >= low) && (node->value <= high) && (*n < maxResults))
+    {
+        names[*n] = node->name;
+        values[*n] = node->value;
+        (*n) ++;
+    }
+
+    if (node->value <= high) // There may be values in range on the right
+    {
+        collect_range (node->right, low, high, names, values, n, maxResults);
+    }
+}
+
+//
+// It returns a new empty index, or NULL if memory runs out.
+//
+VALUE_INDEX* vindex_create ()
+{
+    VALUE_INDEX* index = malloc (sizeof (VALUE_INDEX));
+    if (index == NULL)
+    {
+        return NULL;
+    }
+
+    index->root = NULL;
+    index->seed = 0x9e3779b97f4a7c15ULL;
+
+    return index;
+}
+
+//
+// It frees the index and its nodes, but not the names.
+//
+void vindex_free (VALUE_INDEX* index)
+{
+    free_nodes (index->root);
+    free (index);
+}
+
+//
+// It adds the pair (value, name). It will return 1 if successful, or 0 if memory runs out.
+//
+int vindex_insert (VALUE_INDEX* index, char* name, long value)
+{
+    VALUE_INDEX_NODE* node = malloc (sizeof (VALUE_INDEX_NODE));
+    if (node == NULL)
+    {
+        return FAILURE;
+    }
+
+    node->name = name;
+    node->value = value;
+    node->priority = next_priority (index);
+    index->root = attach (index->root, node);
+
+    return SUCCESS;
+}
+
+//
+// It removes the pair (value, name). It will return 1 if successful, or 0 if it is not there.
+//
+int vindex_remove (VALUE_INDEX* index, char* name, long value)
+{
+    VALUE_INDEX_NODE* node = NULL;
+
+    index->root = detach (index->root, name, value, &node);
+    if (node == NULL)
+    {
+        return FAILURE;
+    }
+
+    free (node);
+    return SUCCESS;
+}
+
+//
+// It changes the value of name from oldValue to newValue, reusing its node, so it cannot
+// run out of memory. It will return 1 if successful, or 0 if the pair is not there.
+//
+int vindex_update (VALUE_INDEX* index, char* name, long oldValue, long newValue)
+{
+    VALUE_INDEX_NODE* node = NULL;
+
+    index->root = detach (index->root, name, oldValue, &node);
+    if (node == NULL)
+    {
+        return FAILURE;
+    }
+
+    node->value = newValue;
+    index->root = attach (index->root, node);
+
+    return SUCCESS;
+}
+
+//
+// It returns the number of pairs in the index.
+//
+size_t vindex_count (VALUE_INDEX* index)
+{
+    return size_of (index->root);
+}
+
+//
+// It returns the number of pairs whose value is smaller than value. O(log n).
+//
+size_t vindex_count_less (VALUE_INDEX* index, long value)
+{
+    VALUE_INDEX_NODE* node = index->root;
+    size_t count = 0;
+
+    while (node != NULL)
+    {
+        if (node->value < value) // The node and its left subtree are smaller
+        {
+            count += size_of (node->left) + 1;
+            node = node->right;
+        }
+
+        else
+        {
+            node = node->left;
+        }
+    }
+
+    return count;
+}
+
+//
+// It stores in names and values the k pairs with the largest values, from the largest
+// down, and returns how many it stored (fewer than k if the index is smaller).
+//
+size_t vindex_largest (VALUE_INDEX* index, size_t k, char** names, long* values)
+{
+    size_t n = 0;
+
+    collect_largest (index->root, &k, &n, names, values);
+
+    return n;
+}
+
+//
+// It stores in names and values, in ascending order, the pairs with low <= value <= high,
+// up to maxResults of them, and returns how many it stored.
+//
+size_t vindex_range (VALUE_INDEX* index, long low, long high, char** names, long* values, size_t maxResults)
+{
+    size_t n = 0;
+
+    collect_range (index->root, low, high, names, values, &n, maxResults);
+
+    return n;
+}
+
+//
+// It fills an empty index with n pairs that are already in index order (by value, then
+// name, then address of the name), in O(n): each node is linked as the right child of the
+// last node with a higher priority on a stack, which is the treap of those priorities.
+// It will return 1 if successful, or 0 if the index is not empty or memory runs out.
+//
+int vindex_build (VALUE_INDEX* index, char** names, long* values, size_t n)
+{
+    size_t i; // Pair index
+    size_t depth = 0; // Nodes on the stack
+
+    if (index->root != NULL)
+    {
+        return FAILURE;
+    }
+
+    // The right spine of the tree built so far, from the root down
+    VALUE_INDEX_NODE** spine = malloc ((n + 1) * sizeof (VALUE_INDEX_NODE*));
+    if (spine == NULL)
+    {
+        return FAILURE;
+    }
+
+    for (i = 0; i < n; i ++)
+    {
+        VALUE_INDEX_NODE* node = malloc (sizeof (VALUE_INDEX_NODE));
+        VALUE_INDEX_NODE* last = NULL;
+
+        if (node == NULL)
+        {
+            index->root = (depth > 0) ? spine[0] : NULL; // Keep what was built, so that it can be freed
+            fix_sizes (index->root);
+            free (spine);
+            return FAILURE;
+        }
+
+        node->name = names[i];
+        node->value = values[i];
+        node->priority = next_priority (index);
+        node->right = NULL;
+
+        while ((depth > 0) && (spine[depth - 1]->priority < node->priority))
+        {
+            last = spine[-- depth];
+        }
+
+        node->left = last;
+
+        if (depth > 0)
+        {
+            spine[depth - 1]->right = node;
+        }
+
+        spine[depth ++] = node;
+    }
+
+    index->root = (depth > 0) ? spine[0] : NULL;
+    fix_sizes (index->root);
+    free (spine);
+
+    return SUCCESS;
+}
@@ -0,0 +1,40 @@
+#if !defined VALUE_INDEX_H
+#define VALUE_INDEX_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct VALUE_INDEX_NODE
+{
+	long value;
+	char* name; // Not owned: the address of the name in the table
+	uint32_t priority; // Random heap key that keeps the tree balanced
+	size_t size; // Nodes in this subtree, for ranks
+	struct VALUE_INDEX_NODE* left;
+	struct VALUE_INDEX_NODE* right;
+} VALUE_INDEX_NODE;
+
+//
+// An order-statistic treap over the (value, name) pairs of an int table. The nodes are
+// ordered by value, then by name, and every node knows the size of its subtree, so
+// inserting, removing and counting the values below a bound all take O(log n), and
+// listing k values in order takes O(log n + k). Equal names are told apart by address.
+//
+typedef struct VALUE_INDEX
+{
+	VALUE_INDEX_NODE* root;
+	uint64_t seed; // State of the priority generator
+} VALUE_INDEX;
+
+VALUE_INDEX* vindex_create ();
+void vindex_free (VALUE_INDEX* index);
+int vindex_insert (VALUE_INDEX* index, char* name, long value);
+int vindex_build (VALUE_INDEX* index, char** names, long* values, size_t n);
+int vindex_remove (VALUE_INDEX* index, char* name, long value);
+int vindex_update (VALUE_INDEX* index, char* name, long oldValue, long newValue);
+size_t vindex_count (VALUE_INDEX* index);
+size_t vindex_count_less (VALUE_INDEX* index, long value);
+size_t vindex_largest (VALUE_INDEX* index, size_t k, char** names, long* values);
+size_t vindex_range (VALUE_INDEX* index, long low, long high, char** names, long* values, size_t maxResults);
+
+#endif